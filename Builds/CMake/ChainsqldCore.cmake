@@ -78,9 +78,11 @@ install (
   DESTINATION include/ripple/crypto/impl)
 install (
   FILES
+    src/ripple/json/Arena.h
     src/ripple/json/JsonPropertyStream.h
     src/ripple/json/Object.h
     src/ripple/json/Output.h
+    src/ripple/json/SaxParser.h
     src/ripple/json/Writer.h
     src/ripple/json/json_forwards.h
     src/ripple/json/json_reader.h
@@ -127,6 +129,7 @@ install (
     src/ripple/protocol/STParsedJSON.h
     src/ripple/protocol/STPathSet.h
     src/ripple/protocol/STTx.h
+    src/ripple/protocol/STTxView.h
     src/ripple/protocol/STValidation.h
     src/ripple/protocol/STVector256.h
     src/ripple/protocol/SecretKey.h
@@ -270,6 +273,7 @@ target_sources (chainsqld PRIVATE
     main sources:
       subdir: json
   #]===============================]
+  src/ripple/json/impl/Arena.cpp
   src/ripple/json/impl/JsonPropertyStream.cpp
   src/ripple/json/impl/Object.cpp
   src/ripple/json/impl/Output.cpp
@@ -309,6 +313,7 @@ target_sources (chainsqld PRIVATE
   src/ripple/protocol/impl/STParsedJSON.cpp
   src/ripple/protocol/impl/STPathSet.cpp
   src/ripple/protocol/impl/STTx.cpp
+  src/ripple/protocol/impl/STTxView.cpp
   src/ripple/protocol/impl/STValidation.cpp
   src/ripple/protocol/impl/STVar.cpp
   src/ripple/protocol/impl/STVector256.cpp
@@ -359,6 +364,7 @@ target_sources (chainsqld PRIVATE
   src/ripple/app/ledger/impl/LedgerToJson.cpp
   src/ripple/app/ledger/impl/LocalTxs.cpp
   src/ripple/app/ledger/impl/OpenLedger.cpp
+  src/ripple/app/ledger/impl/StateSnapshotSync.cpp
   src/ripple/app/ledger/impl/TransactionAcquire.cpp
   src/ripple/app/ledger/impl/TransactionMaster.cpp
   src/ripple/app/main/Application.cpp
@@ -522,6 +528,7 @@ target_sources (chainsqld PRIVATE
   src/ripple/overlay/impl/PeerSet.cpp
   src/ripple/overlay/impl/ProtocolVersion.cpp
   src/ripple/overlay/impl/TrafficCount.cpp
+  src/ripple/overlay/impl/TxDictionary.cpp
   #[===============================[
      main sources:
        subdir: peerfinder
@@ -634,6 +641,7 @@ target_sources (chainsqld PRIVATE
   src/ripple/shamap/impl/SHAMap.cpp
   src/ripple/shamap/impl/SHAMapDelta.cpp
   src/ripple/shamap/impl/SHAMapItem.cpp
+  src/ripple/shamap/impl/SHAMapLeafBuilder.cpp
   src/ripple/shamap/impl/SHAMapNodeID.cpp
   src/ripple/shamap/impl/SHAMapSync.cpp
   src/ripple/shamap/impl/SHAMapTreeNode.cpp
@@ -646,23 +654,27 @@ target_sources (chainsqld PRIVATE
   src/peersafe/app/misc/impl/CertList.cpp
   src/peersafe/app/misc/impl/ContractHelper.cpp
   src/peersafe/app/misc/impl/Executive.cpp
+  src/peersafe/app/misc/impl/MemoryGovernor.cpp
   src/peersafe/app/misc/impl/ExtVM.cpp
   src/peersafe/app/misc/impl/SleOps.cpp
   src/peersafe/app/misc/impl/StateManager.cpp
   src/peersafe/app/misc/impl/TxPool.cpp
   src/peersafe/app/sql/SQLConditionTree.cpp
   src/peersafe/app/sql/STTx2SQL.cpp
+  src/peersafe/app/sql/TxIndex.cpp
   src/peersafe/app/sql/TxStore.cpp
   src/peersafe/app/storage/impl/TableStorage.cpp
   src/peersafe/app/storage/impl/TableStorageItem.cpp
   src/peersafe/app/table/impl/TableAuditItem.cpp
   src/peersafe/app/table/impl/TableDumpItem.cpp
+  src/peersafe/app/table/impl/TableSnapshot.cpp
   src/peersafe/app/table/impl/TableStatusDB.cpp
   src/peersafe/app/table/impl/TableStatusDBMySQL.cpp
   src/peersafe/app/table/impl/TableStatusDBSQLite.cpp
   src/peersafe/app/table/impl/TableSync.cpp
   src/peersafe/app/table/impl/TableSyncItem.cpp
   src/peersafe/app/table/impl/TableTxAccumulator.cpp
+  src/peersafe/app/table/impl/TableColumnCache.cpp
   src/peersafe/app/table/impl/TokenProcess.cpp
   src/peersafe/app/tx/impl/ChainSqlTx.cpp
   src/peersafe/app/tx/impl/DirectApply.cpp
@@ -761,8 +773,10 @@ target_sources (chainsqld PRIVATE
   src/peersafe/rpc/handlers/TableDump.cpp
   src/peersafe/rpc/handlers/TableHandler.cpp
   src/peersafe/rpc/handlers/TableName.cpp
+  src/peersafe/rpc/handlers/TableSnapshot.cpp
   src/peersafe/rpc/handlers/LedgerObjects.cpp
   src/peersafe/rpc/handlers/MallocTrim.cpp
+  src/peersafe/rpc/handlers/CacheUsage.cpp
   src/peersafe/rpc/handlers/NodeSize.cpp
   src/peersafe/rpc/handlers/MonitorStatis.cpp
   src/peersafe/rpc/handlers/ShamapDump.cpp
@@ -827,7 +841,9 @@ if(enableTest)
    src/test/app/LedgerReplay_test.cpp
    src/test/app/LoadFeeTrack_test.cpp
    src/test/app/Manifest_test.cpp
+   src/test/app/MemoryGovernor_test.cpp
    src/test/app/MultiSign_test.cpp
+   src/test/app/NodeRequestSizes_test.cpp
    src/test/app/OfferStream_test.cpp
    src/test/app/Offer_test.cpp
    src/test/app/OversizeMeta_test.cpp
@@ -842,12 +858,16 @@ if(enableTest)
    src/test/app/SetAuth_test.cpp
    src/test/app/SetRegularKey_test.cpp
    src/test/app/SetTrust_test.cpp
+   src/test/app/TableColumnCache_test.cpp
+   src/test/app/TableSnapshot_test.cpp
    src/test/app/Taker_test.cpp
    #src/test/app/TheoreticalQuality_test.cpp
    src/test/app/Ticket_test.cpp
    src/test/app/Transaction_ordering_test.cpp
    src/test/app/TrustAndBalance_test.cpp
+   src/test/app/TxIndex_test.cpp
    src/test/app/TxQ_test.cpp
+   src/test/app/TxSetIds_test.cpp
    #src/test/app/ValidatorKeys_test.cpp
    #src/test/app/ValidatorList_test.cpp
    #src/test/app/ValidatorSite_test.cpp
@@ -863,6 +883,7 @@ if(enableTest)
    src/test/basics/KeyCache_test.cpp
    src/test/basics/PerfLog_test.cpp
    src/test/basics/RangeSet_test.cpp
+   src/test/basics/ShardedTaggedCache_test.cpp
    src/test/basics/Slice_test.cpp
    src/test/basics/StringUtilities_test.cpp
    src/test/basics/TaggedCache_test.cpp
@@ -939,8 +960,10 @@ if(enableTest)
       test sources:
         subdir: json
    #]===============================]
+   src/test/json/Arena_test.cpp
    src/test/json/Object_test.cpp
    src/test/json/Output_test.cpp
+   src/test/json/SaxParser_test.cpp
    src/test/json/Writer_test.cpp
    src/test/json/json_value_test.cpp
    #[===============================[
@@ -1010,6 +1033,7 @@ if(enableTest)
    src/test/nodestore/Basics_test.cpp
    src/test/nodestore/DatabaseShard_test.cpp
    src/test/nodestore/Database_test.cpp
+   src/test/nodestore/Replay_test.cpp
    src/test/nodestore/Timing_test.cpp
    src/test/nodestore/import_test.cpp
    src/test/nodestore/varint_test.cpp
@@ -1040,6 +1064,7 @@ if(enableTest)
    src/test/protocol/STAmount_test.cpp
    src/test/protocol/STObject_test.cpp
    src/test/protocol/STTx_test.cpp
+   src/test/protocol/STTxView_test.cpp
    src/test/protocol/STValidation_test.cpp
    src/test/protocol/SecretKey_test.cpp
    src/test/protocol/Seed_test.cpp
@@ -1108,6 +1133,7 @@ if(enableTest)
         subdir: shamap
    #]===============================]
    src/test/shamap/FetchPack_test.cpp
+   src/test/shamap/SHAMapLeafBuilder_test.cpp
    src/test/shamap/SHAMapSync_test.cpp
    src/test/shamap/SHAMap_test.cpp
    #[===============================[
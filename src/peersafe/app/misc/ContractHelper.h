@@ -2,12 +2,18 @@
 #define __H_CHAINSQL_CONTRACT_HELPER_H__
 
 #include <vector>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
 #include <boost/bind.hpp>
 #include <ripple/protocol/STTx.h>
 #include <ripple/basics/TaggedCache.h>
+#include <ripple/basics/UnorderedContainers.h>
 #include <ripple/json/json_value.h>
 #include <ripple/basics/base_uint.h>
 #include <ripple/protocol/TER.h>
+#include <ripple/protocol/STLedgerEntry.h>
 
 namespace ripple {
 
@@ -15,8 +21,11 @@ struct ContractValueType
 {
     uint256 value;
     bool existInDB;
+    // value in the storage map when existInDB, a write back to it is a no-op
+    uint256 original;
 
-    ContractValueType() : value(uint256(0)), existInDB(false)
+    ContractValueType()
+        : value(uint256(0)), existInDB(false), original(uint256(0))
     {
     }
 };
@@ -83,8 +92,14 @@ public:
         uint256 const& key,
         uint256 const& value);
 
+    // Drop the per-ledger SHAMaps, called before every ledger is built.
+    // Storage slots are kept, they are versioned by storage root.
     void clearCache();
 
+    // Percentage of storage reads answered by the slot cache
+    float getStorageHitRate() const;
+    std::size_t getStorageCacheSize();
+
     //apply cached modification to SHAMap and modify storage_overlay in contract SLE
     void apply(OpenView& openView);
 
@@ -92,12 +107,69 @@ public:
     getOpType(ContractValueType const& value);
 
 private:
+    // A contract whose storage changed in the ledger being built
+    struct DirtyStorage
+    {
+        AccountID contract;
+        map256Contract const* changes = nullptr;
+        std::shared_ptr<SLE> sle;
+        boost::optional<uint256> oldRoot;
+        std::shared_ptr<SHAMap> map;
+        boost::optional<uint256> newRoot;
+        // Thrown while flushing on a job, rethrown by apply
+        std::exception_ptr error;
+    };
+
+    // Call f for 0 .. count - 1, spread over the job queue
+    void
+    parallelFor(std::size_t count, std::function<void(std::size_t)> const& f);
+
+    // Slot values of one contract as found under root, none meaning
+    // the slot is not in the storage map.
+    struct StorageSlots
+    {
+        uint256 root;
+        hash_map<uint256, boost::optional<uint256>> values;
+        std::uint64_t lastUsed = 0;
+    };
+
+    boost::optional<boost::optional<uint256>>
+    fetchFromSlotCache(
+        AccountID const& contract,
+        uint256 const& root,
+        uint256 const& key);
+
+    void
+    addToSlotCache(
+        AccountID const& contract,
+        uint256 const& root,
+        uint256 const& key,
+        boost::optional<uint256> const& value,
+        bool displace);
+
+    // Move the cached slots of contract to the root apply produced
+    void
+    updateSlotCache(
+        AccountID const& contract,
+        boost::optional<uint256> const& oldRoot,
+        uint256 const& newRoot,
+        map256Contract const& changes);
+
 	Schema&									app_;
 	TaggedCache<uint256, std::vector<STTx>>	mTxCache;
 	TaggedCache<uint256, std::vector<std::vector<Json::Value>>>		
 											mRecordCache;
 
     std::map<AccountID, std::shared_ptr<SHAMap>> mShaMapCache;
+
+    std::mutex                      mSlotMutex;
+    std::map<AccountID, StorageSlots> mSlotCache;
+    std::size_t                     mSlotCount;
+    // bumped by clearCache, i.e. once per ledger built
+    std::uint64_t                   mGeneration;
+    std::atomic<std::uint64_t>      mSlotHits;
+    std::atomic<std::uint64_t>      mSlotMisses;
+
     beast::Journal                  mJournal;
 };
 
@@ -0,0 +1,115 @@
+//------------------------------------------------------------------------------
+/*
+ This file is part of chainsqld: https://github.com/chainsql/chainsqld
+ Copyright (c) 2016-2018 Peersafe Technology Co., Ltd.
+
+	chainsqld is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	chainsqld is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//==============================================================================
+
+#ifndef PEERSAFE_APP_MISC_MEMORYGOVERNOR_H_INCLUDED
+#define PEERSAFE_APP_MISC_MEMORYGOVERNOR_H_INCLUDED
+
+#include <ripple/basics/Log.h>
+#include <ripple/basics/TaggedCache.h>
+#include <ripple/json/json_value.h>
+#include <peersafe/schema/SchemaParams.h>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace ripple {
+
+class Config;
+
+/*
+    Process wide budget for the caches every schema keeps.
+
+    Each schema registers its large caches with the target size node_size
+    gives them. When [memory_budget] allows the caches the memory of fewer
+    schemas than are running, the budget of each kind of cache is split
+    again on every sweep: a cache always keeps a quarter of its even share,
+    the rest goes to the caches that served the most hits recently.
+*/
+class MemoryGovernor
+{
+public:
+    struct Cache
+    {
+        // The target size node_size gives the cache
+        int baseSize;
+        // Entries held, none if the cache can't tell
+        std::function<int()> size;
+        std::function<void(int)> setTargetSize;
+        // Lookups since the cache was created and hit rate in percent
+        std::function<std::uint64_t()> lookups;
+        std::function<float()> hitRate;
+    };
+
+    // Works for TaggedCache and ShardedTaggedCache
+    template <class TaggedCacheType>
+    static Cache
+    fromTaggedCache(TaggedCacheType& cache, int baseSize)
+    {
+        return {
+            baseSize,
+            [&cache] { return cache.getCacheSize(); },
+            [&cache](int size) { cache.setTargetSize(size); },
+            [&cache] { return cache.getLookups(); },
+            [&cache] { return cache.getHitRate(); }};
+    }
+
+    MemoryGovernor(Config const& config, beast::Journal journal);
+
+    // The functions of cache must stay valid until remove(schema).
+    void
+    add(SchemaID const& schema,
+        std::string const& schemaName,
+        std::string const& cacheName,
+        Cache cache);
+
+    void
+    remove(SchemaID const& schema);
+
+    // Split the budget again, called on every sweep.
+    void
+    rebalance();
+
+    Json::Value
+    getJson() const;
+
+private:
+    struct Governed
+    {
+        Cache cache;
+        std::string schemaName;
+        int target = 0;
+        std::uint64_t lastLookups = 0;
+        // Hits per sweep, halved on every sweep
+        double weight = 0;
+    };
+
+    beast::Journal j_;
+    // Caches get the memory of this many schemas, 0 means no limit
+    int budgetSchemas_;
+
+    mutable std::mutex mutex_;
+    // cache name -> schema -> cache
+    std::map<std::string, std::map<SchemaID, Governed>> caches_;
+};
+
+}  // namespace ripple
+
+#endif
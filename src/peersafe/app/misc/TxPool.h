@@ -138,6 +138,16 @@ public:
         return mTxsSet.size() - mAvoidByHash.size();
     }
 
+    // Visit every Tx in the pool, under the pool's read lock.
+    template <class F>
+    void
+    forEachTx(F&& f) const
+    {
+        std::shared_lock read_lock{mutexSet_};
+        for (auto const& tx : mTxsSet)
+            f(tx);
+    }
+
     inline Json::Value
     syncStatusJson() const
     {
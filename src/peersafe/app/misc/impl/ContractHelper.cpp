@@ -5,6 +5,9 @@
 #include <ripple/shamap/SHAMap.h>
 #include <ripple/ledger/OpenView.h>
 #include <ripple/protocol/digest.h>
+#include <peersafe/core/Tuning.h>
+#include <ripple/core/JobQueue.h>
+#include <algorithm>
 
 namespace ripple {
 
@@ -22,6 +25,10 @@ namespace ripple {
               std::chrono::seconds{60},
               stopwatch(),
               app.journal("ContractHelper"))
+        , mSlotCount(0)
+        , mGeneration(0)
+        , mSlotHits(0)
+        , mSlotMisses(0)
         , mJournal(app_.journal("ContractHelper"))
     {
     }
@@ -155,6 +162,9 @@ namespace ripple {
         if (!root || *root == uint256(0))
             return boost::none;
 
+        if (auto cached = fetchFromSlotCache(contract, *root, key))
+            return *cached;
+
         std::shared_ptr<SHAMap> mapPtr = getSHAMap(contract, root, bQuery);
         if (mapPtr == nullptr)
             return boost::none;
@@ -162,10 +172,15 @@ namespace ripple {
         {
             auto realKey = sha512Half(contract, key);
             auto const& item = mapPtr->peekItem(realKey);
-            if (!item)
-                return boost::none;
-            uint256 ret;
-            std::memcpy(&ret, item->data(), item->size());
+            boost::optional<uint256> ret;
+            if (item)
+            {
+                ret.emplace();
+                std::memcpy(ret->data(), item->data(), item->size());
+            }
+            // the cached map of a contract may already be past root
+            if (mapPtr->getHash().as_uint256() == *root)
+                addToSlotCache(contract, *root, key, ret, !bQuery);
             return ret;
         }
         catch (SHAMapMissingNode const& mn)
@@ -196,6 +211,138 @@ namespace ripple {
     ContractHelper::clearCache()
     {
         mShaMapCache.clear();
+
+        std::lock_guard lock(mSlotMutex);
+        ++mGeneration;
+        if (mSlotCount < CONTRACT_STORAGE_CACHE_SLOTS)
+            return;
+
+        // Full, drop the contracts not read for the longest time
+        std::vector<std::pair<std::uint64_t, AccountID>> byAge;
+        byAge.reserve(mSlotCache.size());
+        for (auto const& [contract, slots] : mSlotCache)
+            byAge.emplace_back(slots.lastUsed, contract);
+        std::sort(byAge.begin(), byAge.end());
+
+        auto const target = CONTRACT_STORAGE_CACHE_SLOTS / 4 * 3;
+        for (auto const& entry : byAge)
+        {
+            if (mSlotCount <= target)
+                break;
+            auto it = mSlotCache.find(entry.second);
+            mSlotCount -= it->second.values.size();
+            mSlotCache.erase(it);
+        }
+        JLOG(mJournal.debug()) << "Storage slot cache trimmed to "
+                               << mSlotCount << " slots";
+    }
+
+    float
+    ContractHelper::getStorageHitRate() const
+    {
+        auto const hits = mSlotHits.load();
+        auto const total = static_cast<float>(hits + mSlotMisses.load());
+        return hits * (100.0f / std::max(1.0f, total));
+    }
+
+    std::size_t
+    ContractHelper::getStorageCacheSize()
+    {
+        std::lock_guard lock(mSlotMutex);
+        return mSlotCount;
+    }
+
+    boost::optional<boost::optional<uint256>>
+    ContractHelper::fetchFromSlotCache(
+        AccountID const& contract,
+        uint256 const& root,
+        uint256 const& key)
+    {
+        std::lock_guard lock(mSlotMutex);
+        auto it = mSlotCache.find(contract);
+        if (it != mSlotCache.end() && it->second.root == root)
+        {
+            auto const slot = it->second.values.find(key);
+            if (slot != it->second.values.end())
+            {
+                it->second.lastUsed = mGeneration;
+                ++mSlotHits;
+                return slot->second;
+            }
+        }
+        ++mSlotMisses;
+        return boost::none;
+    }
+
+    void
+    ContractHelper::addToSlotCache(
+        AccountID const& contract,
+        uint256 const& root,
+        uint256 const& key,
+        boost::optional<uint256> const& value,
+        bool displace)
+    {
+        std::lock_guard lock(mSlotMutex);
+        auto it = mSlotCache.find(contract);
+        if (it == mSlotCache.end())
+        {
+            it = mSlotCache.emplace(contract, StorageSlots()).first;
+            it->second.root = root;
+        }
+        auto& slots = it->second;
+        if (slots.root != root)
+        {
+            // queries on other ledgers don't push out the current root
+            if (!displace)
+                return;
+            mSlotCount -= slots.values.size();
+            slots.values.clear();
+            slots.root = root;
+        }
+        slots.lastUsed = mGeneration;
+        if (mSlotCount >= CONTRACT_STORAGE_CACHE_SLOTS)
+            return;
+        if (slots.values.emplace(key, value).second)
+            ++mSlotCount;
+    }
+
+    void
+    ContractHelper::updateSlotCache(
+        AccountID const& contract,
+        boost::optional<uint256> const& oldRoot,
+        uint256 const& newRoot,
+        map256Contract const& changes)
+    {
+        std::lock_guard lock(mSlotMutex);
+        auto it = mSlotCache.find(contract);
+        if (it == mSlotCache.end())
+            return;
+        auto& slots = it->second;
+        if (!oldRoot || slots.root != *oldRoot)
+        {
+            mSlotCount -= slots.values.size();
+            mSlotCache.erase(it);
+            return;
+        }
+
+        for (auto const& [key, change] : changes)
+        {
+            boost::optional<uint256> value;
+            switch (getOpType(change))
+            {
+                case ValueOpType::insert:
+                case ValueOpType::modify:
+                    value = change.value;
+                    break;
+                case ValueOpType::erase:
+                    break;
+                default:
+                    continue;
+            }
+            if (slots.values.insert_or_assign(key, value).second)
+                ++mSlotCount;
+        }
+        slots.root = newRoot;
     }
 
     void
@@ -216,15 +363,16 @@ namespace ripple {
             data != boost::none)
         {
             ctx.setDirtyValue(contract, key, value);
-            ctx.setDirtyExistInDB(contract, key, data->existInDB);
+            ctx.setDirtyOriginal(
+                contract,
+                key,
+                data->existInDB ? boost::make_optional(data->original)
+                                : boost::none);
             return;
         }
 
         ctx.setDirtyValue(contract, key, value);
-        if (fetchFromDB(contract,root,key)) 
-            ctx.setDirtyExistInDB(contract, key, true);
-        else
-            ctx.setDirtyExistInDB(contract, key, false);
+        ctx.setDirtyOriginal(contract, key, fetchFromDB(contract, root, key));
     }
 
     std::shared_ptr<SHAMapItem const>
@@ -246,10 +394,10 @@ namespace ripple {
         }
         else
         {
-            if (value.existInDB)
-                type = ValueOpType::modify;
-            else
+            if (!value.existInDB)
                 type = ValueOpType::insert;
+            else if (value.value != value.original)
+                type = ValueOpType::modify;
         }
         return type;
     }
@@ -260,65 +408,128 @@ namespace ripple {
         auto& stateCache = open.getStateCache();
         if (stateCache.empty())
             return;
-        try
+
+        std::vector<DirtyStorage> dirty;
+        for (auto it = stateCache.begin(); it != stateCache.end(); it++)
         {
-            for (auto it = stateCache.begin(); it != stateCache.end(); it++)
+            AccountID const& contract = it->first;
+            auto const k = keylet::account(contract);
+            auto pSle = open.read(k);
+            if (pSle == nullptr)
+                continue;
+
+            // For a contract SLE
+            DirtyStorage storage;
+            storage.contract = contract;
+            storage.changes = &it->second;
+            storage.sle = std::make_shared<SLE>(*pSle);
+            storage.oldRoot =
+                storage.sle->peekFieldM256(sfStorageOverlay).rootHash();
+
+            // Slots only written back to the value they had leave the
+            // storage root as it is. A contract without a root still gets
+            // one, that is part of the SLE.
+            if (storage.oldRoot &&
+                std::none_of(
+                    it->second.begin(),
+                    it->second.end(),
+                    [this](auto const& slot) {
+                        return getOpType(slot.second) !=
+                            ValueOpType::invalid;
+                    }))
+                continue;
+
+            try
+            {
+                storage.map = getSHAMap(contract, storage.oldRoot);
+            }
+            catch (SHAMapMissingNode const& mn)
+            {
+                JLOG(mJournal.warn())
+                    << "ContractHelper::apply failed:" << mn.what();
+            }
+            if (storage.map == nullptr)
+                continue;
+            dirty.push_back(std::move(storage));
+        }
+
+        // Every contract has a SHAMap of its own, only the dirty slots of
+        // each are rehashed and flushed, contracts in parallel.
+        auto const seq = open.seq();
+        parallelFor(dirty.size(), [&](std::size_t i) {
+            auto& storage = dirty[i];
+            try
             {
-                AccountID const& contract = it->first;
-                auto const k = keylet::account(contract);
-                auto pSle = open.read(k);
-                if (pSle != nullptr)
+                // Modify SHAMap
+                for (auto const& [slot, value] : *storage.changes)
                 {
-                    // For a contract SLE
-                    auto newSle = std::make_shared<SLE>(*pSle);
-                    auto& mapStore = newSle->peekFieldM256(sfStorageOverlay);
-                    std::shared_ptr<SHAMap> mapPtr =
-                        getSHAMap(contract, mapStore.rootHash());
-                    if (mapPtr == nullptr)
-                        continue;
-
-                    // Modify SHAMap
-                    auto iter = it->second.begin();
-                    while (iter != it->second.end())
+                    auto key = sha512Half(storage.contract, slot);
+                    switch (getOpType(value))
                     {
-                        auto key = sha512Half(contract, iter->first);
-                        auto type = getOpType(iter->second);
-                        switch (type)
-                        {
-                            case ValueOpType::insert: {
-                                auto item =
-                                    makeSHAMapItem(key, iter->second.value);
-                                mapPtr->addGiveItem(item, false, false);
-                                break;
-                            }
-                            case ValueOpType::modify: {
-                                auto item =
-                                    makeSHAMapItem(key, iter->second.value);
-                                mapPtr->updateGiveItem(item, false, false);
-                                break;
-                            }
-                            case ValueOpType::erase:
-                                mapPtr->delItem(key);
-                                break;
-                            default:
-                                break;
+                        case ValueOpType::insert: {
+                            auto item = makeSHAMapItem(key, value.value);
+                            storage.map->addGiveItem(item, false, false);
+                            break;
                         }
-                        iter++;
+                        case ValueOpType::modify: {
+                            auto item = makeSHAMapItem(key, value.value);
+                            storage.map->updateGiveItem(item, false, false);
+                            break;
+                        }
+                        case ValueOpType::erase:
+                            storage.map->delItem(key);
+                            break;
+                        default:
+                            break;
                     }
-                    // Store to disk
-                    mapPtr->flushDirty(hotACCOUNT_NODE, open.seq());
-                    mapStore.updateRoot(mapPtr->getHash().as_uint256());
-
-                    // Update SLE
-                    newSle->setFieldM256(sfStorageOverlay, mapStore);
-                    open.rawReplace(newSle);
                 }
+                // Store to disk
+                storage.map->flushDirty(hotACCOUNT_NODE, seq);
+                storage.newRoot = storage.map->getHash().as_uint256();
             }
+            catch (SHAMapMissingNode const& mn)
+            {
+                JLOG(mJournal.warn())
+                    << "ContractHelper::apply failed:" << mn.what();
+            }
+            catch (std::exception const&)
+            {
+                storage.error = std::current_exception();
+            }
+        });
+
+        // Anything else failed the apply when it ran serially, so it still
+        // does, on the calling thread and before the view is touched.
+        for (auto const& storage : dirty)
+        {
+            if (storage.error)
+                std::rethrow_exception(storage.error);
         }
-        catch (SHAMapMissingNode const& mn)
+
+        for (auto& storage : dirty)
         {
-            JLOG(mJournal.warn()) << "ContractHelper::apply failed:" << mn.what();
-        }        
+            if (!storage.newRoot)
+                continue;
+            auto& mapStore = storage.sle->peekFieldM256(sfStorageOverlay);
+            mapStore.updateRoot(*storage.newRoot);
+            updateSlotCache(
+                storage.contract,
+                storage.oldRoot,
+                *storage.newRoot,
+                *storage.changes);
+
+            // Update SLE
+            storage.sle->setFieldM256(sfStorageOverlay, mapStore);
+            open.rawReplace(storage.sle);
+        }
     }
-}
 
+    void
+    ContractHelper::parallelFor(
+        std::size_t count,
+        std::function<void(std::size_t)> const& f)
+    {
+        app_.getJobQueue().parallelFor(
+            jtCONTRACT_FLUSH, "contractFlush", count, f, app_.doJobCounter());
+    }
+}
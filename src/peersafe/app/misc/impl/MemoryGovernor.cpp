@@ -0,0 +1,157 @@
+//------------------------------------------------------------------------------
+/*
+ This file is part of chainsqld: https://github.com/chainsql/chainsqld
+ Copyright (c) 2016-2018 Peersafe Technology Co., Ltd.
+
+	chainsqld is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	chainsqld is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//==============================================================================
+
+#include <peersafe/app/misc/MemoryGovernor.h>
+#include <ripple/core/Config.h>
+#include <ripple/core/ConfigSections.h>
+#include <algorithm>
+#include <cstdlib>
+
+namespace ripple {
+
+MemoryGovernor::MemoryGovernor(Config const& config, beast::Journal journal)
+    : j_(journal), budgetSchemas_(0)
+{
+    get_if_exists(
+        config.section(ConfigSection::memoryBudget()),
+        "schemas",
+        budgetSchemas_);
+    budgetSchemas_ = std::max(budgetSchemas_, 0);
+}
+
+void
+MemoryGovernor::add(
+    SchemaID const& schema,
+    std::string const& schemaName,
+    std::string const& cacheName,
+    Cache cache)
+{
+    std::lock_guard lock(mutex_);
+
+    Governed& governed = caches_[cacheName][schema];
+    governed.cache = std::move(cache);
+    governed.schemaName = schemaName;
+    governed.target = governed.cache.baseSize;
+    governed.lastLookups = governed.cache.lookups();
+    governed.weight = 0;
+}
+
+void
+MemoryGovernor::remove(SchemaID const& schema)
+{
+    std::lock_guard lock(mutex_);
+
+    for (auto it = caches_.begin(); it != caches_.end();)
+    {
+        it->second.erase(schema);
+        if (it->second.empty())
+            it = caches_.erase(it);
+        else
+            ++it;
+    }
+}
+
+void
+MemoryGovernor::rebalance()
+{
+    std::lock_guard lock(mutex_);
+
+    for (auto& [cacheName, schemas] : caches_)
+    {
+        double totalBase = 0;
+        double totalWeight = 0;
+        for (auto& [schema, governed] : schemas)
+        {
+            auto const lookups = governed.cache.lookups();
+            auto const recent = lookups >= governed.lastLookups
+                ? lookups - governed.lastLookups
+                : lookups;
+            governed.lastLookups = lookups;
+
+            double const hits = recent * governed.cache.hitRate() / 100.0;
+            governed.weight = governed.weight / 2 + hits / 2;
+
+            totalBase += governed.cache.baseSize;
+            totalWeight += governed.weight;
+        }
+
+        if (budgetSchemas_ == 0 || totalBase <= 0)
+            continue;
+
+        // All the schemas fit, every cache gets what node_size gives it
+        double budget = totalBase;
+        if (schemas.size() > static_cast<std::size_t>(budgetSchemas_))
+            budget = totalBase * budgetSchemas_ / schemas.size();
+
+        double const rest = budget * 3 / 4;
+        for (auto& [schema, governed] : schemas)
+        {
+            double const even = budget * governed.cache.baseSize / totalBase;
+            double share = even;
+            if (budget < totalBase)
+            {
+                share = even / 4 +
+                    (totalWeight > 0 ? rest * governed.weight / totalWeight
+                                     : even * 3 / 4);
+            }
+
+            int const target = std::max(static_cast<int>(share), 1);
+
+            // Resizing rehashes the cache, skip small changes
+            if (std::abs(target - governed.target) * 10 < governed.target)
+                continue;
+
+            JLOG(j_.debug()) << cacheName << " of " << governed.schemaName
+                             << " target size " << governed.target << " -> "
+                             << target;
+            governed.target = target;
+            governed.cache.setTargetSize(target);
+        }
+    }
+}
+
+Json::Value
+MemoryGovernor::getJson() const
+{
+    Json::Value ret(Json::objectValue);
+
+    std::lock_guard lock(mutex_);
+
+    ret["budget_schemas"] = budgetSchemas_;
+
+    Json::Value& schemas = ret["schemas"];
+    schemas = Json::objectValue;
+    for (auto const& [cacheName, caches] : caches_)
+    {
+        for (auto const& [schema, governed] : caches)
+        {
+            Json::Value& c = schemas[governed.schemaName][cacheName];
+            if (governed.cache.size)
+                c["size"] = governed.cache.size();
+            c["target_size"] = governed.target;
+            c["base_size"] = governed.cache.baseSize;
+            c["hit_rate"] = governed.cache.hitRate();
+            c["recent_hits"] = static_cast<Json::UInt>(governed.weight);
+        }
+    }
+
+    return ret;
+}
+
+}  // namespace ripple
@@ -23,6 +23,11 @@
 
 #include <boost/format.hpp> // boost::format
 #include <boost/algorithm/string.hpp> // boost::iequals
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
 
 namespace ripple {
 
@@ -1130,4 +1135,459 @@ namespace conditionParse {
 	}
 } // namespace helper
 
+namespace {
+
+	bool isAscii(const std::string& s) {
+		return std::all_of(s.begin(), s.end(), [](char c) {
+			return static_cast<unsigned char>(c) < 0x80;
+		});
+	}
+
+	// mysql default collations ignore case. Whether they also ignore
+	// trailing spaces depends on the collation (PAD SPACE for utf8mb4_general_ci,
+	// NO PAD for the utf8mb4_0900 ones of mysql 8), text that ends with one is
+	// left to the database.
+	bool paddingMatters(const std::string& s) {
+		return !s.empty() && s.back() == ' ';
+	}
+
+	std::string foldText(std::string s) {
+		std::transform(s.begin(), s.end(), s.begin(), [](char c) {
+			return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+		});
+		return s;
+	}
+
+	// LIKE without ESCAPE, ASCII case-insensitive as sqlite and mysql do it.
+	bool likeMatch(const std::string& s, const std::string& p) {
+		auto lower = [](char c) {
+			return std::tolower(static_cast<unsigned char>(c));
+		};
+		std::size_t si = 0, pi = 0;
+		std::size_t star = std::string::npos, mark = 0;
+		while (si < s.size()) {
+			if (pi < p.size() && p[pi] == '%') {
+				star = pi++;
+				mark = si;
+			}
+			else if (pi < p.size() && lower(p[pi]) == lower(s[si])) {
+				++si;
+				++pi;
+			}
+			else if (star != std::string::npos) {
+				pi = star + 1;
+				si = ++mark;
+			}
+			else
+				return false;
+		}
+		while (pi < p.size() && p[pi] == '%')
+			++pi;
+		return pi == p.size();
+	}
+
+	// same rewriting format_conditions applies to a bound $regex value
+	std::string regexToLike(std::string fv) {
+		if (fv.size() < 2)
+			return fv;
+		if (fv[0] == '/' && fv[1] == '^' && fv.back() == '/')
+			return "%" + fv.substr(2, fv.size() - 3);
+		if (fv.size() >= 3 && fv[0] == '/' && fv[fv.size() - 2] == '^' && fv.back() == '/')
+			return fv.substr(1, fv.size() - 3) + "%";
+		if (fv[0] == '/' && fv.back() == '/') {
+			fv.front() = '%';
+			fv.back() = '%';
+		}
+		return fv;
+	}
+
+	enum class CmpOp { eq, ne, lt, le, gt, ge };
+
+	boost::optional<CmpOp> cmpOp(const std::string& op) {
+		if (boost::iequals(op, "$eq"))
+			return CmpOp::eq;
+		if (boost::iequals(op, "$ne"))
+			return CmpOp::ne;
+		if (boost::iequals(op, "$lt"))
+			return CmpOp::lt;
+		if (boost::iequals(op, "$le"))
+			return CmpOp::le;
+		if (boost::iequals(op, "$gt"))
+			return CmpOp::gt;
+		if (boost::iequals(op, "$ge"))
+			return CmpOp::ge;
+		return boost::none;
+	}
+
+	template <class T, class U>
+	bool compare(CmpOp op, const T& a, const U& b) {
+		switch (op) {
+		case CmpOp::eq:
+			return a == b;
+		case CmpOp::ne:
+			return a != b;
+		case CmpOp::lt:
+			return a < b;
+		case CmpOp::le:
+			return a <= b;
+		case CmpOp::gt:
+			return a > b;
+		case CmpOp::ge:
+			return a >= b;
+		}
+		return false;
+	}
+
+	// tight loop over one column, NULL never satisfies a comparison
+	template <class T, class Pred>
+	void scan(const std::vector<T>& data, const std::vector<std::uint8_t>& nulls, std::size_t rows,
+		Pred&& pred, std::vector<std::uint8_t>& out) {
+		for (std::size_t i = 0; i < rows; ++i)
+			out[i] = !nulls[i] && pred(data[i]);
+	}
+
+} // namespace
+
+bool conditionProgram::integer_literal(const std::string& s, std::int64_t& out) {
+	if (s.empty())
+		return false;
+	std::size_t i = (s[0] == '-' || s[0] == '+') ? 1 : 0;
+	if (i == s.size())
+		return false;
+	for (std::size_t j = i; j < s.size(); ++j)
+		if (!std::isdigit(static_cast<unsigned char>(s[j])))
+			return false;
+	try {
+		out = std::stoll(s);
+	}
+	catch (std::exception const&) {
+		return false;
+	}
+	return true;
+}
+
+bool conditionProgram::real_literal(const std::string& s, double& out) {
+	if (s.empty() || std::isspace(static_cast<unsigned char>(s[0])))
+		return false;
+	char* end = nullptr;
+	out = std::strtod(s.c_str(), &end);
+	return end == s.c_str() + s.size() && std::isfinite(out);
+}
+
+std::pair<int, std::string> conditionProgram::compile(const Json::Value& conditions) {
+	code_.clear();
+	if (conditions.isArray() == false)
+		return { -1, "conditions must be an array." };
+	// no condition selects every row
+	if (conditions.size() == 0)
+		return { 0, "success" };
+
+	auto root = conditionTree::createRoot(conditions);
+	if (root.first != 0)
+		return { -1, (boost::format("conditions are malformed. [%s]") % Json::jsonAsString(conditions)).str() };
+	auto result = conditionParse::parse_conditions(conditions, root.second);
+	if (result.first != 0)
+		return result;
+	if (emit(root.second) != 0) {
+		code_.clear();
+		return { -1, "empty logical node in conditions." };
+	}
+	return { 0, "success" };
+}
+
+int conditionProgram::emit(conditionTree& node) {
+	if (node.node_type() == conditionTree::NodeType::Expression) {
+		auto expression = node.parse_expression();
+		instruction leaf;
+		leaf.code = instruction::Leaf;
+		leaf.arity = 0;
+		leaf.field = std::get<0>(expression);
+		leaf.op = std::get<1>(expression);
+		leaf.values = std::get<2>(expression);
+		code_.push_back(std::move(leaf));
+		return 0;
+	}
+
+	if (node.size() == 0)
+		return -1;
+	for (auto it = node.begin(); it != node.end(); ++it) {
+		if (emit(*it) != 0)
+			return -1;
+	}
+	instruction logical;
+	logical.code = node.node_type() == conditionTree::NodeType::Logical_And ? instruction::And : instruction::Or;
+	logical.arity = node.size();
+	code_.push_back(std::move(logical));
+	return 0;
+}
+
+std::vector<std::string> conditionProgram::fields() const {
+	std::vector<std::string> names;
+	for (auto const& ins : code_) {
+		if (ins.code == instruction::Leaf &&
+			std::find(names.begin(), names.end(), ins.field) == names.end())
+			names.push_back(ins.field);
+	}
+	return names;
+}
+
+bool conditionProgram::eval(std::size_t rows, const columnLookup& lookup, bool mysqlSemantics, Mask& out) const {
+	if (code_.empty()) {
+		out.assign(rows, 1);
+		return true;
+	}
+
+	std::vector<Mask> stack;
+	for (auto const& ins : code_) {
+		if (ins.code == instruction::Leaf) {
+			const Column* col = lookup(ins.field);
+			if (col == nullptr || col->nulls.size() < rows)
+				return false;
+			stack.emplace_back();
+			if (!eval_leaf(ins, rows, *col, mysqlSemantics, stack.back()))
+				return false;
+			continue;
+		}
+
+		assert(stack.size() >= ins.arity);
+		if (stack.size() < ins.arity)
+			return false;
+		Mask& first = stack[stack.size() - ins.arity];
+		for (std::size_t k = stack.size() - ins.arity + 1; k < stack.size(); ++k) {
+			const Mask& m = stack[k];
+			if (ins.code == instruction::And) {
+				for (std::size_t i = 0; i < rows; ++i)
+					first[i] &= m[i];
+			}
+			else {
+				for (std::size_t i = 0; i < rows; ++i)
+					first[i] |= m[i];
+			}
+		}
+		stack.resize(stack.size() - ins.arity + 1);
+	}
+
+	if (stack.size() != 1)
+		return false;
+	out = std::move(stack.back());
+	return true;
+}
+
+bool conditionProgram::eval_leaf(const instruction& leaf, std::size_t rows, const Column& col,
+	bool mysqlSemantics, Mask& out) const {
+	const std::vector<BindValue>& values = leaf.values;
+	const std::string& op = leaf.op;
+	if (values.empty() || col.kind == ColumnKind::Opaque)
+		return false;
+
+	out.assign(rows, 0);
+	const auto& nulls = col.nulls;
+
+	if (values.size() == 1 && values[0].isNull()) {
+		// `$eq: null` is turned into `is null` by format_conditions
+		if (!boost::iequals(op, "$eq") && !boost::iequals(op, "$is") && !boost::iequals(op, "$isnot"))
+			return false;
+		bool const wantNull = !boost::iequals(op, "$isnot");
+		for (std::size_t i = 0; i < rows; ++i)
+			out[i] = (nulls[i] != 0) == wantNull;
+		return true;
+	}
+
+	if (!col.declared && !guessed_column_usable(leaf, rows, col, mysqlSemantics))
+		return false;
+
+	if (boost::iequals(op, "$regex")) {
+		if (col.kind != ColumnKind::Text || !values[0].isString())
+			return false;
+		auto const pattern = regexToLike(values[0].asString());
+		if (pattern.find('_') != std::string::npos)
+			return false;
+		if (mysqlSemantics && (pattern.find('\\') != std::string::npos || !isAscii(pattern)))
+			return false;
+		for (std::size_t i = 0; i < rows; ++i) {
+			if (nulls[i])
+				continue;
+			if (mysqlSemantics && !isAscii(col.texts[i]))
+				return false;
+			out[i] = likeMatch(col.texts[i], pattern);
+		}
+		return true;
+	}
+
+	bool const in = boost::iequals(op, "$in");
+	bool const nin = boost::iequals(op, "$nin");
+	auto const cmp = cmpOp(op);
+	if (!in && !nin && (!cmp || values.size() != 1))
+		return false;
+
+	// each candidate is tested with `=`, $in/$nin or them together
+	Mask one(rows, 0);
+	for (auto const& value : values) {
+		CmpOp const c = (in || nin) ? CmpOp::eq : *cmp;
+		if (value.isNull())
+			return false;
+
+		switch (col.kind) {
+		case ColumnKind::Integer:
+		case ColumnKind::Real: {
+			bool const isInt = col.kind == ColumnKind::Integer;
+			if (value.isInt() || value.isUint()) {
+				std::int64_t const lit = value.isInt() ? std::int64_t(value.asInt()) : std::int64_t(value.asUint());
+				if (isInt)
+					scan(col.ints, nulls, rows, [&](std::int64_t x) { return compare(c, x, lit); }, one);
+				else
+					scan(col.reals, nulls, rows, [&](double x) { return compare(c, x, double(lit)); }, one);
+			}
+			else if (value.isDouble()) {
+				double const lit = value.asDouble();
+				if (isInt)
+					scan(col.ints, nulls, rows, [&](std::int64_t x) { return compare(c, double(x), lit); }, one);
+				else
+					scan(col.reals, nulls, rows, [&](double x) { return compare(c, x, lit); }, one);
+			}
+			else if (value.isString()) {
+				// a numeric string is converted by both engines
+				std::int64_t lit = 0;
+				if (!isInt || !integer_literal(value.asString(), lit))
+					return false;
+				scan(col.ints, nulls, rows, [&](std::int64_t x) { return compare(c, x, lit); }, one);
+			}
+			else
+				return false;
+			break;
+		}
+		case ColumnKind::Text: {
+			if (!value.isString())
+				return false;
+			if (!mysqlSemantics) {
+				// sqlite's default BINARY collation
+				const std::string& lit = value.asString();
+				scan(col.texts, nulls, rows, [&](const std::string& x) { return compare(c, x, lit); }, one);
+				break;
+			}
+			if ((c != CmpOp::eq && c != CmpOp::ne) || !isAscii(value.asString()) ||
+				paddingMatters(value.asString()))
+				return false;
+			auto const lit = foldText(value.asString());
+			for (std::size_t i = 0; i < rows; ++i) {
+				if (nulls[i])
+					continue;
+				if (!isAscii(col.texts[i]) || paddingMatters(col.texts[i]))
+					return false;
+				one[i] = compare(c, foldText(col.texts[i]), lit);
+			}
+			break;
+		}
+		case ColumnKind::Opaque:
+			return false;
+		}
+
+		for (std::size_t i = 0; i < rows; ++i)
+			out[i] |= one[i];
+	}
+
+	if (nin) {
+		for (std::size_t i = 0; i < rows; ++i)
+			out[i] = !nulls[i] && !out[i];
+	}
+	return true;
+}
+
+bool conditionProgram::guessed_column_usable(const instruction& leaf, std::size_t rows, const Column& col,
+	bool mysqlSemantics) const {
+	// A number may have been written into a text column or the other way
+	// round, only tests that give the same answer either way are kept.
+	double d = 0;
+	bool const regex = boost::iequals(leaf.op, "$regex");
+	bool const equality = boost::iequals(leaf.op, "$eq") || boost::iequals(leaf.op, "$in");
+	bool const inequality = boost::iequals(leaf.op, "$ne") || boost::iequals(leaf.op, "$nin");
+	if (!regex && !equality && !inequality)
+		return false;
+
+	if (col.kind == ColumnKind::Integer) {
+		return !regex && std::all_of(leaf.values.begin(), leaf.values.end(),
+			[](const BindValue& v) { return v.isInt() || v.isUint(); });
+	}
+	if (col.kind != ColumnKind::Text)
+		return false;
+	// the column's collation is unknown, folding may only add matches
+	if (mysqlSemantics && inequality)
+		return false;
+	for (auto const& v : leaf.values) {
+		if (!v.isString() || (!regex && real_literal(v.asString(), d)))
+			return false;
+	}
+	for (std::size_t i = 0; i < rows; ++i) {
+		if (!col.nulls[i] && real_literal(col.texts[i], d))
+			return false;
+	}
+	return true;
+}
+
+conditionRows::conditionRows(const Json::Value& rows)
+: rows_(0) {
+	if (rows.isArray() == false)
+		return;
+	for (auto const& row : rows) {
+		if (row.isObject() == false) {
+			columns_.clear();
+			return;
+		}
+	}
+	rows_ = rows.size();
+	if (rows_ == 0)
+		return;
+
+	std::vector<std::string> names = rows[0u].getMemberNames();
+	for (auto const& name : names) {
+		// The declared type of the column is unknown: a value is taken as it
+		// was written and only kept when all rows agree on its kind.
+		boost::optional<conditionProgram::ColumnKind> kind;
+		bool usable = true;
+		for (auto const& row : rows) {
+			if (row.isMember(name) == false) {
+				usable = false;
+				break;
+			}
+			const Json::Value& v = row[name];
+			if (v.isNull())
+				continue;
+			conditionProgram::ColumnKind k;
+			if (v.type() == Json::intValue || v.type() == Json::uintValue)
+				k = conditionProgram::ColumnKind::Integer;
+			else if (v.type() == Json::stringValue)
+				k = conditionProgram::ColumnKind::Text;
+			else {
+				usable = false;
+				break;
+			}
+			if (kind && *kind != k) {
+				usable = false;
+				break;
+			}
+			kind = k;
+		}
+		if (!usable)
+			continue;
+
+		conditionProgram::Column col;
+		col.kind = kind ? *kind : conditionProgram::ColumnKind::Text;
+		col.declared = false;
+		for (auto const& row : rows) {
+			const Json::Value& v = row[name];
+			col.nulls.push_back(v.isNull() ? 1 : 0);
+			if (col.kind == conditionProgram::ColumnKind::Integer)
+				col.ints.push_back(v.isNull() ? 0 : v.asLargestInt());
+			else
+				col.texts.push_back(v.isNull() ? std::string() : v.asString());
+		}
+		columns_[name] = std::move(col);
+	}
+}
+
+const conditionProgram::Column* conditionRows::column(const std::string& name) const {
+	auto it = columns_.find(name);
+	return it == columns_.end() ? nullptr : &it->second;
+}
+
 } // namespace ripple
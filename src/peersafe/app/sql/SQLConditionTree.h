@@ -23,6 +23,8 @@
 #include <vector>
 #include <functional>
 #include <tuple>
+#include <cstdint>
+#include <map>
 
 #include <peersafe/app/sql/SQLDataType.h>
 
@@ -136,6 +138,101 @@ private:
     soci::indicator indi_null_;
 };
 
+/*
+ * A conditionTree compiled into a postfix program that runs in memory over a
+ * batch of rows stored column by column. Every leaf produces a mask for the
+ * whole batch at once and and/or instructions combine the masks on a stack,
+ * so a batch costs one pass per leaf instead of one tree walk per row.
+ *
+ * Comparisons follow what sqlite (or mysql with mysqlSemantics) would return
+ * for the same conditions; when that can not be told for sure, eval returns
+ * false and the caller has to ask the database.
+ */
+class conditionProgram {
+public:
+	enum class ColumnKind {
+		Integer,
+		Real,
+		Text,
+		Opaque
+	};
+
+	struct Column {
+		ColumnKind kind = ColumnKind::Opaque;
+		// false when the kind was guessed from written values, the column
+		// may then hold them converted and only equality is trusted
+		bool declared = true;
+		std::vector<std::int64_t> ints;
+		std::vector<double> reals;
+		std::vector<std::string> texts;
+		std::vector<std::uint8_t> nulls;
+	};
+
+	typedef std::vector<std::uint8_t> Mask;
+	// field name to its column in the batch, nullptr if the batch lacks it
+	typedef std::function<const Column*(const std::string&)> columnLookup;
+
+	/*
+	 * description				compile conditions as accepted by conditionParse::parse_conditions
+	 * @param conditions		values of raw that `$limit`,`$order` and tables' fields have been exluded out original raw
+	 * @return					result.first is zero that indicates success,otherwise is failure.
+	*/
+	std::pair<int, std::string> compile(const Json::Value& conditions);
+
+	// fill out with one flag per row, false if the result can't be told
+	bool eval(std::size_t rows, const columnLookup& lookup, bool mysqlSemantics, Mask& out) const;
+
+	// field names the program reads
+	std::vector<std::string> fields() const;
+
+	// numeric text converted the way both engines do on integer/real columns
+	static bool integer_literal(const std::string& s, std::int64_t& out);
+	static bool real_literal(const std::string& s, double& out);
+
+private:
+	struct instruction {
+		enum {
+			Leaf,
+			And,
+			Or
+		} code;
+		std::size_t arity;
+		std::string field;
+		std::string op;
+		std::vector<BindValue> values;
+	};
+
+	int emit(conditionTree& node);
+	bool eval_leaf(const instruction& leaf, std::size_t rows, const Column& col, bool mysqlSemantics, Mask& out) const;
+	bool guessed_column_usable(const instruction& leaf, std::size_t rows, const Column& col, bool mysqlSemantics) const;
+
+	std::vector<instruction> code_;
+};
+
+/*
+ * Rows given as Json objects (the Raw of an insert, a result set) turned
+ * into columns for conditionProgram. A field is only exposed when every row
+ * carries it with values of one kind.
+ */
+class conditionRows {
+public:
+	explicit conditionRows(const Json::Value& rows);
+
+	std::size_t size() const {
+		return rows_;
+	}
+
+	const conditionProgram::Column* column(const std::string& name) const;
+
+	conditionProgram::columnLookup lookup() const {
+		return [this](const std::string& name) { return column(name); };
+	}
+
+private:
+	std::size_t rows_;
+	std::map<std::string, conditionProgram::Column> columns_;
+};
+
 namespace conditionParse {
 
 	/*
@@ -0,0 +1,510 @@
+//------------------------------------------------------------------------------
+/*
+ This file is part of chainsqld: https://github.com/chainsql/chainsqld
+ Copyright (c) 2016-2018 Peersafe Technology Co., Ltd.
+
+	chainsqld is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	chainsqld is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//==============================================================================
+
+#include <peersafe/app/sql/TxIndex.h>
+#include <ripple/basics/ByteUtilities.h>
+#include <ripple/basics/contract.h>
+#include <ripple/unity/rocksdb.h>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace ripple {
+
+namespace {
+
+/*  Keys, all numbers big endian so they sort by ledger:
+
+    'a' account ledgerSeq txnSeq -> txid
+    't' txid                     -> ledgerSeq txnSeq
+    'l' ledgerSeq                -> (txid txnSeq count account...)...
+    'f'                          -> first ledger covered
+
+    The 'l' entry lists what a ledger added, so a ledger can be saved
+    again or deleted without a scan.
+*/
+char const accountPrefix = 'a';
+char const txPrefix = 't';
+char const ledgerPrefix = 'l';
+std::string const firstKey(1, 'f');
+
+void
+put32(std::string& s, std::uint32_t v)
+{
+    s.push_back(static_cast<char>(v >> 24));
+    s.push_back(static_cast<char>(v >> 16));
+    s.push_back(static_cast<char>(v >> 8));
+    s.push_back(static_cast<char>(v));
+}
+
+std::uint32_t
+get32(char const* p)
+{
+    auto const u = reinterpret_cast<unsigned char const*>(p);
+    return (std::uint32_t(u[0]) << 24) | (std::uint32_t(u[1]) << 16) |
+        (std::uint32_t(u[2]) << 8) | std::uint32_t(u[3]);
+}
+
+std::string
+accountKey(AccountID const& account, LedgerIndex seq, std::uint32_t txnSeq)
+{
+    std::string key(1, accountPrefix);
+    key.append(reinterpret_cast<char const*>(account.data()), account.size());
+    put32(key, seq);
+    put32(key, txnSeq);
+    return key;
+}
+
+std::string
+txKey(uint256 const& id)
+{
+    std::string key(1, txPrefix);
+    key.append(reinterpret_cast<char const*>(id.data()), id.size());
+    return key;
+}
+
+std::string
+ledgerKey(LedgerIndex seq)
+{
+    std::string key(1, ledgerPrefix);
+    put32(key, seq);
+    return key;
+}
+
+std::size_t const accountKeySize = 1 + 20 + 4 + 4;
+
+// Ordered key/value store under the index.
+class Store
+{
+public:
+    // none deletes the key
+    using Batch =
+        std::vector<std::pair<std::string, boost::optional<std::string>>>;
+    // Return false to stop the scan
+    using Visitor =
+        std::function<bool(std::string const& key, std::string const& value)>;
+
+    virtual ~Store() = default;
+
+    virtual boost::optional<std::string>
+    get(std::string const& key) = 0;
+
+    virtual void
+    write(Batch const& batch) = 0;
+
+    // Visit the keys from 'from' on, upwards or downwards.
+    virtual void
+    scan(std::string const& from, bool forward, Visitor const& visit) = 0;
+};
+
+class MemoryStore : public Store
+{
+    std::mutex mutex_;
+    std::map<std::string, std::string> map_;
+
+public:
+    boost::optional<std::string>
+    get(std::string const& key) override
+    {
+        std::lock_guard lock(mutex_);
+        auto it = map_.find(key);
+        if (it == map_.end())
+            return boost::none;
+        return it->second;
+    }
+
+    void
+    write(Batch const& batch) override
+    {
+        std::lock_guard lock(mutex_);
+        for (auto const& [key, value] : batch)
+        {
+            if (value)
+                map_[key] = *value;
+            else
+                map_.erase(key);
+        }
+    }
+
+    void
+    scan(std::string const& from, bool forward, Visitor const& visit) override
+    {
+        std::lock_guard lock(mutex_);
+        if (forward)
+        {
+            for (auto it = map_.lower_bound(from); it != map_.end(); ++it)
+            {
+                if (!visit(it->first, it->second))
+                    break;
+            }
+        }
+        else
+        {
+            for (auto it = std::make_reverse_iterator(map_.upper_bound(from));
+                 it != map_.rend();
+                 ++it)
+            {
+                if (!visit(it->first, it->second))
+                    break;
+            }
+        }
+    }
+};
+
+#if RIPPLE_ROCKSDB_AVAILABLE
+
+class RocksDBStore : public Store
+{
+    std::unique_ptr<rocksdb::DB> db_;
+
+public:
+    RocksDBStore(Section const& section, std::string const& path)
+    {
+        rocksdb::Options options;
+        options.create_if_missing = true;
+        options.compression = rocksdb::kSnappyCompression;
+
+        rocksdb::BlockBasedTableOptions table;
+        table.block_cache = rocksdb::NewLRUCache(
+            get<int>(section, "cache_mb", 64) * megabytes(1));
+        table.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10, false));
+        options.table_factory.reset(NewBlockBasedTableFactory(table));
+
+        rocksdb::DB* db = nullptr;
+        auto const status = rocksdb::DB::Open(options, path, &db);
+        if (!status.ok() || !db)
+            Throw<std::runtime_error>(
+                "Unable to open/create tx index: " + status.ToString());
+        db_.reset(db);
+    }
+
+    boost::optional<std::string>
+    get(std::string const& key) override
+    {
+        std::string value;
+        auto const status = db_->Get(rocksdb::ReadOptions(), key, &value);
+        if (status.IsNotFound())
+            return boost::none;
+        if (!status.ok())
+            Throw<std::runtime_error>(
+                "tx index read failed: " + status.ToString());
+        return value;
+    }
+
+    void
+    write(Batch const& batch) override
+    {
+        rocksdb::WriteBatch wb;
+        for (auto const& [key, value] : batch)
+        {
+            if (value)
+                wb.Put(key, *value);
+            else
+                wb.Delete(key);
+        }
+        auto const status = db_->Write(rocksdb::WriteOptions(), &wb);
+        if (!status.ok())
+            Throw<std::runtime_error>(
+                "tx index write failed: " + status.ToString());
+    }
+
+    void
+    scan(std::string const& from, bool forward, Visitor const& visit) override
+    {
+        std::unique_ptr<rocksdb::Iterator> it(
+            db_->NewIterator(rocksdb::ReadOptions()));
+        if (forward)
+            it->Seek(from);
+        else
+            it->SeekForPrev(from);
+
+        for (; it->Valid(); forward ? it->Next() : it->Prev())
+        {
+            if (!visit(it->key().ToString(), it->value().ToString()))
+                break;
+        }
+    }
+};
+
+#endif
+
+//------------------------------------------------------------------------------
+
+class TxIndexImp : public TxIndex
+{
+    std::unique_ptr<Store> store_;
+    beast::Journal j_;
+    // Writers of one ledger's keys, reads don't need it
+    std::mutex writeMutex_;
+
+    // Cache of the 'f' key, guarded by firstMutex_
+    std::mutex firstMutex_;
+    boost::optional<LedgerIndex> first_;
+
+    void
+    putFirst(LedgerIndex seq, Store::Batch& batch)
+    {
+        std::string value;
+        put32(value, seq);
+        batch.emplace_back(firstKey, std::move(value));
+    }
+
+    void
+    eraseLedger(LedgerIndex seq, Store::Batch& batch)
+    {
+        auto const value = store_->get(ledgerKey(seq));
+        if (!value)
+            return;
+
+        char const* p = value->data();
+        char const* const end = p + value->size();
+        while (end - p >= 32 + 4 + 4)
+        {
+            uint256 const id = uint256::fromVoid(p);
+            auto const txnSeq = get32(p + 32);
+            auto const count = get32(p + 36);
+            p += 40;
+
+            batch.emplace_back(txKey(id), boost::none);
+            for (std::uint32_t i = 0; i < count && end - p >= 20; ++i)
+            {
+                AccountID account;
+                std::memcpy(account.data(), p, 20);
+                p += 20;
+                batch.emplace_back(
+                    accountKey(account, seq, txnSeq), boost::none);
+            }
+        }
+        batch.emplace_back(ledgerKey(seq), boost::none);
+    }
+
+public:
+    TxIndexImp(std::unique_ptr<Store> store, beast::Journal journal)
+        : store_(std::move(store)), j_(journal)
+    {
+        auto const value = store_->get(firstKey);
+        if (value && value->size() == 4)
+            first_ = get32(value->data());
+    }
+
+    void
+    saveLedger(LedgerIndex seq, std::vector<Transaction> const& txs) override
+    {
+        std::lock_guard lock(writeMutex_);
+
+        Store::Batch batch;
+        eraseLedger(seq, batch);
+        {
+            // Never set, nothing older than this was seen
+            std::lock_guard firstLock(firstMutex_);
+            if (!first_)
+            {
+                first_ = seq;
+                putFirst(seq, batch);
+            }
+        }
+
+        std::string ledger;
+        std::string location;
+        put32(location, seq);
+        for (auto const& tx : txs)
+        {
+            std::string const id(
+                reinterpret_cast<char const*>(tx.id.data()), tx.id.size());
+
+            ledger += id;
+            put32(ledger, tx.txnSeq);
+            put32(ledger, static_cast<std::uint32_t>(tx.accounts.size()));
+
+            std::string txLocation = location;
+            put32(txLocation, tx.txnSeq);
+            batch.emplace_back(txKey(tx.id), std::move(txLocation));
+
+            for (auto const& account : tx.accounts)
+            {
+                ledger.append(
+                    reinterpret_cast<char const*>(account.data()),
+                    account.size());
+                batch.emplace_back(accountKey(account, seq, tx.txnSeq), id);
+            }
+        }
+        batch.emplace_back(ledgerKey(seq), std::move(ledger));
+
+        store_->write(batch);
+        JLOG(j_.trace()) << "Indexed ledger " << seq << ", " << txs.size()
+                         << " transactions";
+    }
+
+    boost::optional<Location>
+    getLocation(uint256 const& id) override
+    {
+        auto const value = store_->get(txKey(id));
+        if (!value || value->size() != 8)
+            return boost::none;
+        return Location{get32(value->data()), get32(value->data() + 4)};
+    }
+
+    std::vector<Entry>
+    getAccountTxs(
+        AccountID const& account,
+        LedgerIndex minLedger,
+        LedgerIndex maxLedger,
+        bool forward,
+        boost::optional<Location>& marker,
+        std::uint32_t limit) override
+    {
+        std::vector<Entry> ret;
+
+        std::string from;
+        if (marker)
+            from = accountKey(account, marker->ledgerSeq, marker->txnSeq);
+        else if (forward)
+            from = accountKey(account, minLedger, 0);
+        else
+            from = accountKey(
+                account, maxLedger, std::numeric_limits<std::uint32_t>::max());
+        std::string const prefix = from.substr(0, 1 + 20);
+
+        marker.reset();
+        store_->scan(
+            from,
+            forward,
+            [&](std::string const& key, std::string const& value) {
+                if (key.size() != accountKeySize ||
+                    key.compare(0, prefix.size(), prefix) != 0)
+                    return false;
+
+                auto const ledgerSeq = get32(key.data() + 21);
+                if (ledgerSeq < minLedger || ledgerSeq > maxLedger)
+                    return false;
+                if (value.size() != 32)
+                    return true;
+
+                Entry entry{
+                    ledgerSeq,
+                    get32(key.data() + 25),
+                    uint256::fromVoid(value.data())};
+
+                if (ret.size() == limit)
+                {
+                    marker = Location{entry.ledgerSeq, entry.txnSeq};
+                    return false;
+                }
+                ret.push_back(entry);
+                return true;
+            });
+        return ret;
+    }
+
+    void
+    deleteBefore(LedgerIndex seq) override
+    {
+        std::vector<LedgerIndex> ledgers;
+        store_->scan(
+            ledgerKey(0),
+            true,
+            [&](std::string const& key, std::string const&) {
+                if (key.size() != 5 || key[0] != ledgerPrefix)
+                    return false;
+                auto const ledger = get32(key.data() + 1);
+                if (ledger >= seq)
+                    return false;
+                ledgers.push_back(ledger);
+                return true;
+            });
+
+        // One batch per ledger keeps the batches small
+        for (auto const ledger : ledgers)
+        {
+            std::lock_guard lock(writeMutex_);
+            Store::Batch batch;
+            eraseLedger(ledger, batch);
+            store_->write(batch);
+        }
+        {
+            std::lock_guard lock(writeMutex_);
+            std::lock_guard firstLock(firstMutex_);
+            if (first_ && *first_ < seq)
+            {
+                first_ = seq;
+                Store::Batch batch;
+                putFirst(seq, batch);
+                store_->write(batch);
+            }
+        }
+        JLOG(j_.debug()) << "Removed " << ledgers.size()
+                         << " ledgers from the tx index";
+    }
+
+    boost::optional<LedgerIndex>
+    firstLedger() override
+    {
+        std::lock_guard lock(firstMutex_);
+        return first_;
+    }
+
+    void
+    setFirstLedger(LedgerIndex seq) override
+    {
+        std::lock_guard lock(writeMutex_);
+        std::lock_guard firstLock(firstMutex_);
+        first_ = seq;
+        Store::Batch batch;
+        putFirst(seq, batch);
+        store_->write(batch);
+        JLOG(j_.info()) << "Transactions before ledger " << seq
+                        << " are not in the tx index";
+    }
+};
+
+}  // namespace
+
+std::unique_ptr<TxIndex>
+make_TxIndex(
+    Section const& section,
+    std::string const& path,
+    beast::Journal journal)
+{
+    if (section.empty())
+        return nullptr;
+
+    auto const type = get<std::string>(section, "type", "RocksDB");
+    if (boost::iequals(type, "memory"))
+        return std::make_unique<TxIndexImp>(
+            std::make_unique<MemoryStore>(), journal);
+
+#if RIPPLE_ROCKSDB_AVAILABLE
+    if (boost::iequals(type, "RocksDB"))
+    {
+        boost::filesystem::create_directories(path);
+        return std::make_unique<TxIndexImp>(
+            std::make_unique<RocksDBStore>(section, path), journal);
+    }
+#endif
+
+    Throw<std::runtime_error>("Unsupported [tx_index] type: " + type);
+    return nullptr;
+}
+
+}  // namespace ripple
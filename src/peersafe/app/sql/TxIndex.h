@@ -0,0 +1,120 @@
+//------------------------------------------------------------------------------
+/*
+ This file is part of chainsqld: https://github.com/chainsql/chainsqld
+ Copyright (c) 2016-2018 Peersafe Technology Co., Ltd.
+
+	chainsqld is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	chainsqld is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//==============================================================================
+
+#ifndef PEERSAFE_APP_SQL_TXINDEX_H_INCLUDED
+#define PEERSAFE_APP_SQL_TXINDEX_H_INCLUDED
+
+#include <ripple/basics/BasicConfig.h>
+#include <ripple/basics/Log.h>
+#include <ripple/basics/base_uint.h>
+#include <ripple/protocol/AccountID.h>
+#include <ripple/protocol/Protocol.h>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ripple {
+
+/*
+    Ledger ordered index of the validated transactions, kept in an
+    embedded key/value store next to transaction.db when [tx_index] is
+    configured.
+
+    It answers the lookups AccountTransactions and Transactions serve
+    for account_tx and tx without SQL: the keys of an account are sorted
+    by ledger and position in the ledger, so a page is one seek and a
+    short scan however deep into history it starts.
+
+    Ledgers saved before the index was enabled are not in it, lookups
+    below firstLedger() are left to SQL.
+*/
+class TxIndex
+{
+public:
+    struct Location
+    {
+        LedgerIndex ledgerSeq;
+        std::uint32_t txnSeq;
+    };
+
+    struct Transaction
+    {
+        uint256 id;
+        std::uint32_t txnSeq;
+        std::vector<AccountID> accounts;
+    };
+
+    struct Entry
+    {
+        LedgerIndex ledgerSeq;
+        std::uint32_t txnSeq;
+        uint256 id;
+    };
+
+    virtual ~TxIndex() = default;
+
+    // Replace everything indexed for ledger seq.
+    virtual void
+    saveLedger(LedgerIndex seq, std::vector<Transaction> const& txs) = 0;
+
+    virtual boost::optional<Location>
+    getLocation(uint256 const& id) = 0;
+
+    /*  Transactions of account with a ledger in [minLedger, maxLedger].
+
+        A page starts at marker, if set, and holds at most limit entries.
+        marker is set to the first entry of the next page, or reset if
+        there is none.
+    */
+    virtual std::vector<Entry>
+    getAccountTxs(
+        AccountID const& account,
+        LedgerIndex minLedger,
+        LedgerIndex maxLedger,
+        bool forward,
+        boost::optional<Location>& marker,
+        std::uint32_t limit) = 0;
+
+    // Drop the ledgers before seq, used by online delete.
+    virtual void
+    deleteBefore(LedgerIndex seq) = 0;
+
+    /*  The first ledger the index holds every transaction of, later
+        ledgers included. Older ledgers are only in SQL. None until it is
+        set or a ledger is saved.
+    */
+    virtual boost::optional<LedgerIndex>
+    firstLedger() = 0;
+
+    // Set by the first open, to the ledger after the last one in SQL
+    virtual void
+    setFirstLedger(LedgerIndex seq) = 0;
+};
+
+// None if section is empty, throws if it can't be opened.
+std::unique_ptr<TxIndex>
+make_TxIndex(
+    Section const& section,
+    std::string const& path,
+    beast::Journal journal);
+
+}  // namespace ripple
+
+#endif
@@ -21,6 +21,7 @@
 #define RIPPLE_APP_MISC_TXNDBCONN_H_INCLUDED
 
 #include <ripple/core/DatabaseCon.h>
+#include <peersafe/app/sql/TxIndex.h>
 
 
 namespace ripple {
@@ -82,9 +83,36 @@ public:
         return *conn_write_;
     }
 
+    // A new index starts after the ledgers SQL already holds, lookups of
+    // those keep going to SQL.
+    void
+    setTxIndex(std::unique_ptr<TxIndex> index)
+    {
+        if (index && !index->firstLedger())
+        {
+            boost::optional<std::uint64_t> maxSeq;
+            {
+                auto db = checkoutDbRead();
+                *db << "SELECT MAX(LedgerSeq) FROM Transactions;",
+                    soci::into(maxSeq);
+            }
+            index->setFirstLedger(
+                maxSeq ? static_cast<LedgerIndex>(*maxSeq + 1) : 0);
+        }
+        txIndex_ = std::move(index);
+    }
+
+    // The [tx_index] kept next to the SQL tables, null if not configured
+    TxIndex*
+    txIndex()
+    {
+        return txIndex_.get();
+    }
+
 private:
     std::unique_ptr<DatabaseCon> conn_read_;
     std::unique_ptr<DatabaseCon> conn_write_;
+    std::unique_ptr<TxIndex> txIndex_;
     bool hasTxResult_ = false;
 };
 }  // namespace ripple
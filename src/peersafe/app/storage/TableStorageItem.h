@@ -80,6 +80,7 @@ private:
     std::unique_ptr <TxStoreTransaction>                                        uTxStoreTrans_;
     std::string                                                                 sTableNameInDB_;
     std::string                                                                 sTableName_;
+    std::string                                                                 sNewTableName_;
     AccountID                                                                   accountID_;
 
     std::unique_ptr <TxStoreDBConn>                                             conn_;
@@ -23,6 +23,7 @@
 #include <ripple/json/json_reader.h>
 #include <ripple/app/misc/NetworkOPs.h>
 #include <ripple/app/misc/Transaction.h>
+#include <peersafe/app/table/TableColumnCache.h>
 #include <peersafe/app/table/TableSync.h>
 #include <peersafe/app/table/TableStatusDBMySQL.h>
 #include <peersafe/app/table/TableStatusDBSQLite.h>
@@ -144,6 +145,7 @@ namespace ripple {
 			{
 				auto newTableName = strCopy(tables[0].getFieldVL(sfTableNewName));
 				getTableStatusDB().RenameRecord(accountID_, sTableNameInDB_, newTableName);
+				sNewTableName_ = newTableName;
 			}
 		}
 
@@ -317,6 +319,17 @@ namespace ripple {
             stTran.commit();
         }
 
+        // The cache never saw these writes, it reloads the table from the DB
+        auto& cache = app_.getTableColumnCache();
+        if (bDropped_)
+            cache.erase(sTableNameInDB_);
+        else
+        {
+            cache.invalidate(sTableNameInDB_);
+            if (!sNewTableName_.empty())
+                cache.track(accountID_, sNewTableName_, sTableNameInDB_);
+        }
+
         app_.getTableSync().ReStartOneTable(accountID_, sTableNameInDB_, sTableName_, bDropped_, true);
         
 
@@ -36,6 +36,7 @@ public:
 private:	
     bool isTxNeededOutput(const STTx& tx, std::vector<STTx>& vecTxs) override;    
     void ConstructCheckJson();   
+    std::pair<bool, std::string> BuildCheckSql(const Json::Value& jsonRaw, const std::string& sRealTableName);
     void issuesAfterStop() override;
     bool checkSqlValid(std::string sSql);
 
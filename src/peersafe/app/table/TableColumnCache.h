@@ -0,0 +1,290 @@
+//------------------------------------------------------------------------------
+/*
+ This file is part of chainsqld: https://github.com/chainsql/chainsqld
+ Copyright (c) 2016-2018 Peersafe Technology Co., Ltd.
+
+	chainsqld is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	chainsqld is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//==============================================================================
+
+#ifndef RIPPLE_APP_TABLE_TABLECOLUMNCACHE_H_INCLUDED
+#define RIPPLE_APP_TABLE_TABLECOLUMNCACHE_H_INCLUDED
+
+#include <ripple/basics/Log.h>
+#include <ripple/json/json_value.h>
+#include <ripple/protocol/AccountID.h>
+#include <ripple/protocol/Protocol.h>
+#include <peersafe/protocol/TableDefines.h>
+#include <peersafe/app/sql/SQLConditionTree.h>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace ripple {
+
+class Schema;
+class Config;
+class STTx;
+class DatabaseCon;
+struct SyncParam;
+
+/*
+    In-memory, column-wise copy of the tables listed in [cache_tables].
+
+    A table is loaded from the sync database the first time it is queried
+    and is then kept up to date from the transactions TableSyncItem commits,
+    so simple r_get requests (one table, plain conditions, order/limit and
+    count/min/max/sum/avg) can be answered without a round trip to the DB.
+    Every operation the cache cannot mirror exactly (alter, auto-fill into
+    an unknown column, an unsupported condition ...) drops the cached copy,
+    and it is reloaded on the next query.
+*/
+class TableColumnCache
+{
+    struct Entry;
+
+public:
+    using ColumnKind = conditionProgram::ColumnKind;
+
+    // One operation committed to the sync database, replayed into the cache.
+    struct Op
+    {
+        TableOpType type;
+        Json::Value raw;
+        bool exact;
+    };
+
+    class ColumnTable
+    {
+    public:
+        // The typed vectors are scanned by conditionProgram in place.
+        struct Column : conditionProgram::Column
+        {
+            std::string name;
+            // Writes into this column can be mirrored without asking the DB
+            bool exact = false;
+            bool hasDefault = false;
+            bool primaryKey = false;
+        };
+
+        using Mask = conditionProgram::Mask;
+
+        // mysql compares text with a case-insensitive collation
+        explicit ColumnTable(bool mysqlSemantics = false);
+
+        void
+        clear();
+
+        // Build an empty table from the Raw of a T_CREATE/T_RECREATE.
+        bool
+        define(Json::Value const& createRaw);
+
+        // Set columns inferred from the DB, rows are then added by appendRow.
+        void
+        defineLoaded(std::vector<std::pair<std::string, ColumnKind>> const& cols);
+
+        // Cells are given in column order, null Json means SQL NULL.
+        void
+        appendRow(std::vector<Json::Value> const& cells);
+
+        bool
+        insert(Json::Value const& rows);
+        bool
+        update(Json::Value const& raw);
+        bool
+        erase(Json::Value const& conditions);
+
+        // Evaluate a condition array as used in Raw; none when the
+        // conditions can not be evaluated with the DB's exact semantics.
+        boost::optional<Mask>
+        match(Json::Value const& conditions) const;
+
+        // Answer a parsed r_get Raw in the shape helper::query_result returns.
+        boost::optional<Json::Value>
+        select(Json::Value const& raw, int selectLimit) const;
+
+        // Same in the shape of helper::query_result_2d, fields keep the
+        // order they were asked in.
+        boost::optional<std::vector<std::vector<Json::Value>>>
+        select2d(Json::Value const& raw, int selectLimit) const;
+
+        std::size_t
+        rows() const
+        {
+            return rows_;
+        }
+
+        std::size_t
+        bytes() const;
+
+        bool
+        defined() const
+        {
+            return !columns_.empty();
+        }
+
+    private:
+        int
+        findColumn(std::string const& name) const;
+        bool
+        setCell(Column& col, std::size_t row, Json::Value const& v) const;
+        Json::Value
+        cellJson(Column const& col, std::size_t row) const;
+        int
+        compareCells(Column const& col, std::size_t a, std::size_t b) const;
+
+        bool mysql_;
+        bool schemaKnown_;
+        // Column the DB returns rows in the order of when a query gives
+        // none, -1 for insertion order, none when that can't be told.
+        boost::optional<int> naturalOrder_;
+        std::size_t rows_;
+        std::vector<Column> columns_;
+        std::map<std::string, int> index_;
+    };
+
+    TableColumnCache(Schema& app, Config& cfg, beast::Journal journal);
+
+    // Whether owner/tableName is listed in [cache_tables]
+    bool
+    configured(AccountID const& owner, std::string const& tableName) const;
+
+    // Register nameInDB for a configured table, drop it otherwise.
+    void
+    track(
+        AccountID const& owner,
+        std::string const& tableName,
+        std::string const& nameInDB);
+
+    // Build the cache-side form of a transaction that was just disposed.
+    static Op
+    makeOp(STTx const& tx, SyncParam const& param);
+
+    void
+    erase(std::string const& nameInDB);
+
+    // Drop the cached rows of nameInDB after a write the cache did not see,
+    // they are reloaded on the next query.
+    void
+    invalidate(std::string const& nameInDB);
+
+    // Try to answer an r_get tx_json, none means ask the DB.
+    boost::optional<Json::Value>
+    query(
+        std::string const& nameInDB,
+        Json::Value const& tx_json,
+        DatabaseCon* conn);
+
+    // Same for the contract path, which reads rows as doGetRecord2D does.
+    boost::optional<std::vector<std::vector<Json::Value>>>
+    query2d(
+        std::string const& nameInDB,
+        Json::Value const& tx_json,
+        DatabaseCon* conn);
+
+    // Holds off reloads of one table while TableSyncItem runs a soci
+    // transaction on it; the staged ops are applied only if committed.
+    class UpdateGuard
+    {
+    public:
+        UpdateGuard(TableColumnCache& cache, std::string const& nameInDB);
+        ~UpdateGuard();
+
+        UpdateGuard(UpdateGuard const&) = delete;
+        UpdateGuard&
+        operator=(UpdateGuard const&) = delete;
+
+        bool
+        active() const
+        {
+            return entry_ != nullptr;
+        }
+
+        void
+        commit(std::vector<Op> const& ops);
+
+    private:
+        TableColumnCache& cache_;
+        std::shared_ptr<Entry> entry_;
+    };
+
+private:
+    struct Entry
+    {
+        explicit Entry(bool mysql) : table(mysql)
+        {
+        }
+
+        mutable std::shared_mutex mutex;
+        ColumnTable table;
+        bool loaded = false;
+        // too many rows, not cached until the table is dropped
+        bool disabled = false;
+        // soci transactions in flight, a reload would apply them twice
+        int pending = 0;
+        // bumped by every committed write, a failed load is only retried
+        // once the table changed
+        std::uint64_t version = 0;
+        boost::optional<std::uint64_t> loadFailedAt;
+    };
+
+    std::shared_ptr<Entry>
+    getEntry(std::string const& nameInDB) const;
+
+    bool
+    load(Entry& entry, std::string const& nameInDB, DatabaseCon* conn);
+
+    // Run fn on the cached copy of nameInDB, false if it isn't cached or
+    // tx_json isn't a plain r_get on it.
+    bool
+    withTable(
+        std::string const& nameInDB,
+        Json::Value const& tx_json,
+        DatabaseCon* conn,
+        std::function<void(ColumnTable const&, Json::Value const&)> const& fn);
+
+    // The Raw of a plain r_get on one table
+    static boost::optional<Json::Value>
+    parseRaw(Json::Value const& tx_json);
+
+    void
+    apply(Entry& entry, std::vector<Op> const& ops);
+
+    // Mirror one row operation, false if it can't be done exactly.
+    static bool
+    replay(ColumnTable& table, Op const& op);
+
+    void
+    invalidate(Entry& entry);
+
+    Schema& app_;
+    beast::Journal journal_;
+    bool mysql_;
+    int selectLimit_;
+    std::size_t maxRows_;
+    std::set<std::pair<std::string, std::string>> tables_;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<Entry>> entries_;
+};
+
+}  // namespace ripple
+
+#endif
@@ -21,6 +21,7 @@
 #define RIPPLE_APP_TABLE_TABLEDUMP_ITEM_H_INCLUDED
 
 #include <peersafe/app/table/TableSyncItem.h>
+#include <peersafe/app/sql/SQLConditionTree.h>
 
 
 namespace ripple {
@@ -35,6 +36,8 @@ public:
     virtual ~TableDumpItem();
 
 	std::pair<bool, std::string> SetDumpPara(std::string sPath, funDumpCB funCB);
+    //only dump statements that may touch rows matching conditions given as in Raw
+    std::pair<bool, std::string> SetDumpFilter(std::string sFilter);
     std::pair<bool, std::string> StopTask();    
 
     void GetCurrentPos(taskInfo &info);
@@ -47,6 +50,8 @@ protected:
     void SetStopInfo(FILE *fileTarget, std::string sMsg);
     void SetErroeInfo2FileEnd(FILE *fileTarget);
     bool DealWithEveryLedgerData(const std::vector<protocol::TMTableData> &aData) override;
+    //false only if every statement inserts rows that the filter rejects
+    bool MayMatchFilter(const std::vector<STTx>& vecTxs);
 
 private:		
     static Json::Value TransRaw2Json(const STTx & tx);
@@ -66,6 +71,9 @@ protected:
     LedgerIndex                                                  uLedgerStart_;
     LedgerIndex                                                  uLedgerStop_;
 
+    bool                                                         bFilter_;
+    conditionProgram                                             filter_;
+
 private:	
 	funDumpCB                                                    funDumpCB_;    
     std::mutex                                                   mutexFileOperate_;
@@ -0,0 +1,180 @@
+//------------------------------------------------------------------------------
+/*
+ This file is part of chainsqld: https://github.com/chainsql/chainsqld
+ Copyright (c) 2016-2018 Peersafe Technology Co., Ltd.
+
+	chainsqld is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	chainsqld is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//==============================================================================
+
+#ifndef RIPPLE_APP_TABLE_TABLESNAPSHOT_H_INCLUDED
+#define RIPPLE_APP_TABLE_TABLESNAPSHOT_H_INCLUDED
+
+#include <ripple/basics/Log.h>
+#include <ripple/basics/base_uint.h>
+#include <ripple/json/json_value.h>
+#include <ripple/protocol/AccountID.h>
+#include <ripple/protocol/Protocol.h>
+#include <ripple/protocol/digest.h>
+#include <peersafe/schema/Schema.h>
+#include <boost/optional.hpp>
+#include <fstream>
+#include <functional>
+
+namespace ripple {
+
+// A snapshot is a file of JSON lines. The first line describes the table:
+// its owner and names, the columns and the SyncTableState position
+// (LedgerSeq, TxnLedgerSeq and TxnUpdateHash) the rows were read at. Every
+// following line is one row, an array holding a string or null per column,
+// and the last line is a trailer with the number of rows and the
+// sha512-half of all the lines before it.
+//
+// A node that already synced the table writes it with Make(), an admin
+// copies the file to a new node, and Load() there creates the table from
+// its T_CREATE transaction, bulk inserts the rows and writes the
+// SyncTableState record, so the ordinary table sync resumes from the
+// snapshot position instead of the ledger the table was created in.
+// Confidential tables are neither written nor loaded, the rows would be
+// in plain text; they sync through [sync_tables] only.
+class TableSnapshot
+{
+public:
+    static constexpr int version = 2;
+    // rows inserted per transaction while loading
+    static constexpr std::size_t batchRows = 10000;
+
+    struct Header
+    {
+        std::string sDBType;
+        AccountID owner;
+        std::string sTableName;
+        std::string sNameInDB;
+        LedgerIndex uLedgerSeq = 0;
+        uint256 uLedgerHash;
+        LedgerIndex uTxnLedgerSeq = 0;
+        uint256 uTxnLedgerHash;
+        uint256 uTxnUpdateHash;
+        std::string sTxnLedgerTime;
+        std::vector<std::string> vecColumns;
+        // soci::data_type of the columns
+        std::vector<int> vecTypes;
+    };
+
+    // Writes the header line, the rows and the trailer of a snapshot
+    class Writer
+    {
+    public:
+        Writer(std::ostream& out, Header const& header);
+
+        void
+        add(Json::Value const& row);
+
+        // writes the trailer, returns the number of rows
+        std::size_t
+        finish();
+
+    private:
+        void
+        line(std::string const& s);
+
+        std::ostream& out_;
+        sha512_half_hasher hasher_;
+        std::size_t rows_ = 0;
+    };
+
+    // Reads a snapshot written by Writer. The rows can be read more than
+    // once, every pass checks them against the trailer again.
+    class Reader
+    {
+    public:
+        explicit Reader(std::istream& in);
+
+        std::pair<bool, std::string>
+        readHeader(Header& header);
+
+        // onRow is called for every row and returns an error, or an empty
+        // string to go on; it may be empty to only check the file
+        std::pair<bool, std::string>
+        readRows(
+            std::size_t nColumns,
+            std::function<std::string(Json::Value const&)> const& onRow,
+            std::size_t& rows);
+
+    private:
+        std::istream& in_;
+        std::string headerLine_;
+        std::istream::pos_type rowsPos_;
+    };
+
+    TableSnapshot(Schema& app, beast::Journal journal);
+
+    // write the rows of the synced table owner.sTableName to sPath
+    std::pair<bool, std::string>
+    Make(AccountID const& owner, std::string const& sTableName, std::string const& sPath);
+
+    // read and check the header of the snapshot in sPath
+    std::pair<bool, std::string>
+    Open(std::string const& sPath);
+
+    Header const&
+    header() const
+    {
+        return header_;
+    }
+
+    // check the file, create the table, insert the rows and record the
+    // sync position; Open() must have succeeded, returns the number of
+    // rows loaded
+    std::pair<bool, std::string>
+    Load(bool bAutoSync, std::size_t& rows);
+
+    // Checks the snapshot position against the chain. validIndex is the
+    // validated ledger, nameInDB and createSeq describe the table in it.
+    // ledgerHash and txnLgrSeq come from the ledger at header.uLedgerSeq
+    // when this node has it.
+    static std::pair<bool, std::string>
+    checkPosition(
+        Header const& header,
+        LedgerIndex validIndex,
+        std::string const& nameInDB,
+        LedgerIndex createSeq,
+        boost::optional<uint256> const& ledgerHash,
+        boost::optional<LedgerIndex> const& txnLgrSeq);
+
+    // whether values of a column of this soci::data_type are hex coded in
+    // the file, text too as it may hold bytes json can't carry
+    static bool
+    hexCoded(int type);
+
+private:
+    std::string
+    dbType() const;
+
+    std::pair<bool, std::string>
+    CheckLedger();
+
+    std::pair<bool, std::string>
+    CreateTable();
+
+private:
+    Schema& app_;
+    beast::Journal journal_;
+
+    Header header_;
+    std::ifstream in_;
+    Reader reader_;
+};
+
+}  // namespace ripple
+#endif
@@ -29,6 +29,7 @@
 #include <peersafe/app/table/TableSyncItem.h>
 #include <peersafe/app/table/TableDumpItem.h>
 #include <peersafe/app/table/TableAuditItem.h>
+#include <set>
 
 
 namespace ripple {
@@ -48,9 +49,13 @@ public:
 
     //receiver find the ledger which includes the tableNode TX
     void SeekTableTxLedger(std::shared_ptr <protocol::TMGetTable> const& m, std::weak_ptr<Peer> const& wPeer);
+    //receiver answers a bulk request with one TMTableRange
+    void SeekTableRange(std::shared_ptr <protocol::TMGetTable> const& m, std::weak_ptr<Peer> const& wPeer);
 
     //send sync request to peers        
-    bool SendSyncRequest(AccountID accountID, std::string sNameInDB, LedgerIndex iStartSeq, uint256 iStartHash, LedgerIndex iCheckSeq, uint256 iCheckHash, LedgerIndex iStopSeq, bool bGetLost, std::shared_ptr <TableSyncItem> pItem);
+    bool SendSyncRequest(AccountID accountID, std::string sNameInDB, LedgerIndex iStartSeq, uint256 iStartHash, LedgerIndex iCheckSeq, uint256 iCheckHash, LedgerIndex iStopSeq, bool bGetLost, std::shared_ptr <TableSyncItem> pItem, bool bBulk = false);
+    //keep up to rangePipeline_ bulk requests in flight, each to another peer
+    void SendRangeRequests(TableSyncItem::BaseInfo const& stItem, std::shared_ptr <TableSyncItem> pItem);
     
     bool isExist(std::list<std::shared_ptr <TableSyncItem>>  listTableInfo_, AccountID accountID, std::string sTableName, TableSyncItem::SyncTargetType eTargeType);
 
@@ -59,6 +64,7 @@ public:
 
     //get reply
     bool GotSyncReply(std::shared_ptr <protocol::TMTableData> const& m, std::weak_ptr<Peer> const& wPeer);
+    bool GotSyncRange(std::shared_ptr <protocol::TMTableRange> const& m, std::weak_ptr<Peer> const& wPeer);
     bool SendSeekResultReply(std::string sAccountID, bool bStop, uint32_t time, std::weak_ptr<Peer> const& wPeer, std::string sNickName , TableSyncItem::SyncTargetType eTargeType, LedgerIndex TxnLgrSeq, uint256 TxnLgrHash, LedgerIndex PreviousTxnLgrSeq, uint256 PrevTxnLedgerHash, std::string sNameInDB);
     bool SendSeekEndReply(LedgerIndex iSeq, uint256 hash, LedgerIndex iLastSeq, uint256 lastHash, uint256 checkHash, std::string account, std::string tablename, std::string nickName, uint32_t time, TableSyncItem::SyncTargetType eTargeType, std::weak_ptr<Peer> const& wPeer);
 
@@ -72,7 +78,7 @@ public:
     bool ReStartOneTable(AccountID accountID, std::string sNameInDB, std::string sTableName, bool bDrop, bool bCommit);
     bool StopOneTable(AccountID accountID, std::string sNameInDB, bool bNewTable);
 
-	std::pair<bool, std::string> StartDumpTable(std::string sPara, std::string sPath, TableDumpItem::funDumpCB funCB);
+	std::pair<bool, std::string> StartDumpTable(std::string sPara, std::string sPath, TableDumpItem::funDumpCB funCB, std::string sFilter = "");
 	std::pair<bool, std::string> StopDumpTable(AccountID accountID, std::string sTableName);
     bool GetCurrentDumpPos(AccountID accountID, std::string sTableName, TableSyncItem::taskInfo &info);
 
@@ -80,6 +86,10 @@ public:
     std::pair<bool, std::string> StopAuditTable(std::string sNickName);
     bool GetCurrentAuditPos(std::string sNickName, TableSyncItem::taskInfo &info);
 
+    //write the synced rows of a table to a file, or bootstrap the sync of a table from one
+    std::pair<bool, std::string> MakeTableSnapshot(AccountID accountID, std::string sTableName, std::string sPath);
+    std::pair<bool, std::string> LoadTableSnapshot(std::string sPath);
+
     void TryTableSync();
     void TableSyncThread();
 
@@ -159,11 +169,20 @@ private:
     TaggedCache <LedgerIndex, Blob>             checkSkipNode_;
 
     std::mutex                                  mutexCreateTable_;
+
+    // owner + tableName of the tables a snapshot is being loaded into
+    std::mutex                                  mutexSnapshot_;
+    std::set<std::string>                       setLoadingSnapshot_;
     bool                                        bAutoLoadTable_;
 
     bool                                        bIsHaveSync_;
     bool                                        bRemoteSync_;
 
+    // ledgers asked for by one bulk request, and bulk requests kept in
+    // flight; no bulk requests are sent when rangePipeline_ is 0
+    LedgerIndex                                 rangeLedgers_;
+    std::size_t                                 rangePipeline_;
+
     bool bInitTableItems_{false};
     // if the sync thread is running
     std::atomic_bool bTableSyncThread_{false};
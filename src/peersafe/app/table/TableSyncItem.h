@@ -30,6 +30,7 @@
 #include <ripple/protocol/SecretKey.h>
 #include <peersafe/app/table/TokenProcess.h>
 #include <peersafe/app/misc/ConnectionPool.h>
+#include <peersafe/app/table/TableColumnCache.h>
 
 namespace ripple {
 
@@ -196,6 +197,13 @@ public:
     LedgerSyncState GetCheckLedgerState();
      
     void SendTableMessage(Message::pointer const& m);
+    //send to the slot-th peer after the current one, to spread range requests
+    void SendTableMessage(Message::pointer const& m, std::size_t slot);
+
+    //range requests in flight, by the last ledger they ask for
+    bool AddRangeRequest(LedgerIndex iStopSeq);
+    void SweepRangeRequests(LedgerIndex iCurSeq);
+    void OnRangeReply(LedgerIndex iFirstSeq, LedgerIndex iLastSeq);
 
     void SetTableName(std::string sName);
     void SetSyncLedger(LedgerIndex iSeq, uint256 uHash);
@@ -289,12 +297,28 @@ private:
     std::vector<std::vector<std::shared_ptr<STTx>>>
     fetchLedgerTxSlices(const protocol::TMTableData& tableData);
 
+    // Table transactions of tx, decrypted
+    std::vector<STTx>
+    PrepareTx(STTx const& tx, std::uint32_t seq);
+
+    // Slices of every ledger of aData and the prepared transactions of
+    // each of their txs, computed in parallel
+    void
+    PrepareLedgerData(
+        const std::vector<protocol::TMTableData>& aData,
+        std::vector<std::vector<std::vector<std::shared_ptr<STTx>>>>&
+            ledgerSlices,
+        std::map<STTx const*, std::vector<STTx>>& prepared);
+
 	virtual bool DealWithEveryLedgerData(const std::vector<protocol::TMTableData> &aData);
     bool WaitChildThread(std::condition_variable &cv, bool const& bCheck, bool bForce);
 
+    void TrackColumnCache();
+
     std::pair<bool, bool>
     DealWithEveryTx(
-        STTx& tx, 
+        STTx& tx,
+        std::vector<STTx> const& vecTxs,
         std::vector<protocol::TMTableData>::const_iterator iter,
         std::map<uint256, std::tuple<STTx, int, std::pair<bool, std::string>>>&
             tmpPubMap);
@@ -349,6 +373,8 @@ private:
     std::list <beast::IP::Endpoint>                              lfailList_;
     bool                                                         bIsChange_;
 
+    std::map<LedgerIndex, std::chrono::steady_clock::time_point> mapRangeRequests_;
+
     bool                                                         bIsAutoSync_;
 
     std::unique_ptr <TxStoreDBConn>                              conn_;
@@ -359,6 +385,11 @@ private:
 
 	SyncTargetType                                               eSyncTargetType_;
 
+    // ops of the running soci transaction, replayed into TableColumnCache
+    // once it is committed
+    bool                                                         bStageCacheOps_;
+    std::vector<TableColumnCache::Op>                            aCacheOps_;
+
     std::mutex                                                   mutexWaitStop_;
     std::condition_variable                                      cvReadData_;
     std::condition_variable                                      cvOperateSql_;
@@ -21,6 +21,8 @@ namespace ripple {
 		~TokenProcess();
 		bool setSymmertryKey(const Blob& cipherBlob, const SecretKey& secret_key);
 		Blob symmertryDecrypt(Blob rawEncrept, const PublicKey& publicKey);
+		// false when decryption goes through the key held in the card
+		bool concurrentDecrypt() const;
 	};
 
 }
@@ -92,12 +92,22 @@ std::pair<bool, std::string> TableAuditItem::SetAuditPara(std::string sSql, std:
     sNickName_ = to_string(uNewTableNameInDB_);
     std::string sRealTableName = "t_" + sNickName_;
 
-    if (!checkSqlValid(sSql))
+    Json::Value jsonRaw;
+    if (!sSql.empty() && sSql[0] == '[' && Json::Reader().parse(sSql, jsonRaw))
     {
-        return std::make_pair(false, "sql error , or table name is different form  the one in first para.");
+        auto retRaw = BuildCheckSql(jsonRaw, sRealTableName);
+        if (!retRaw.first)
+            return retRaw;
     }
+    else
+    {
+        if (!checkSqlValid(sSql))
+        {
+            return std::make_pair(false, "sql error , or table name is different form  the one in first para.");
+        }
 
-    sCheckSQL_ = sSql.replace(sSql.find(sTableName_), sTableName_.length(), sRealTableName);
+        sCheckSQL_ = sSql.replace(sSql.find(sTableName_), sTableName_.length(), sRealTableName);
+    }
 
     fs::path sFullPath(sDumpPath_);
     auto filePath = sFullPath.parent_path();
@@ -130,6 +140,49 @@ std::pair<bool, std::string> TableAuditItem::SetAuditPara(std::string sSql, std:
     return std::make_pair(true, sNickName_);
 }
 
+std::pair<bool, std::string> TableAuditItem::BuildCheckSql(const Json::Value& jsonRaw, const std::string& sRealTableName)
+{
+    if (!jsonRaw.isArray() || jsonRaw.size() == 0 || !jsonRaw[0u].isArray())
+    {
+        return std::make_pair(false, "raw must be an array beginning with the fields.");
+    }
+
+    std::string sFields;
+    for (auto const& field : jsonRaw[0u])
+    {
+        if (!field.isString())
+            return std::make_pair(false, "field name must be a string.");
+        if (!sFields.empty())
+            sFields += ",";
+        sFields += field.asString();
+    }
+    if (sFields.empty())
+        sFields = "*";
+
+    Json::Value conditions(Json::arrayValue);
+    for (Json::UInt idx = 1; idx < jsonRaw.size(); idx++)
+    {
+        conditions.append(jsonRaw[idx]);
+    }
+
+    //the same conditions filter inserted rows before the check query is run
+    auto ret = filter_.compile(conditions);
+    if (ret.first != 0)
+    {
+        return std::make_pair(false, ret.second);
+    }
+
+    sCheckSQL_ = "select " + sFields + " from " + sRealTableName;
+    if (conditions.size() > 0)
+    {
+        auto root = conditionTree::createRoot(conditions);
+        conditionParse::parse_conditions(conditions, root.second);
+        sCheckSQL_ += " where " + root.second.asString();
+    }
+    bFilter_ = true;
+    return std::make_pair(true, "");
+}
+
 void TableAuditItem::ConstructCheckJson()
 {
     Json::Value aField, aIn, conditionJson,tableJson,rawJson;
@@ -189,6 +242,14 @@ bool TableAuditItem::isTxNeededOutput(const STTx& tx, std::vector<STTx>& vecTxs)
         }
         tableItem.setFieldH160(sfNameInDB, uNameInDBOld);
     }
+
+    //rows inserted outside the audited conditions can't change the result
+    if (bFilter_ && !MayMatchFilter(vecTxs))
+    {
+        ReleaseConnectionUnit();
+        return false;
+    }
+
     //Json::Value  jsonRet = getTxStore().txHistory(jsonCheck_);    
     Json::Value  jsonRet = getTxStore().txHistory(sCheckSQL_);
     ReleaseConnectionUnit();
@@ -0,0 +1,1183 @@
+//------------------------------------------------------------------------------
+/*
+ This file is part of chainsqld: https://github.com/chainsql/chainsqld
+ Copyright (c) 2016-2018 Peersafe Technology Co., Ltd.
+
+	chainsqld is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	chainsqld is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//==============================================================================
+
+#include <peersafe/app/table/TableColumnCache.h>
+#include <peersafe/app/util/TableSyncUtil.h>
+#include <peersafe/schema/Schema.h>
+#include <ripple/basics/StringUtilities.h>
+#include <ripple/core/ConfigSections.h>
+#include <ripple/core/DatabaseCon.h>
+#include <ripple/json/json_reader.h>
+#include <ripple/protocol/STTx.h>
+#include <ripple/protocol/jss.h>
+#include <boost/algorithm/string.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace ripple {
+
+//------------------------------------------------------------------------------
+
+TableColumnCache::ColumnTable::ColumnTable(bool mysqlSemantics)
+    : mysql_(mysqlSemantics), schemaKnown_(false), rows_(0)
+{
+}
+
+void
+TableColumnCache::ColumnTable::clear()
+{
+    schemaKnown_ = false;
+    naturalOrder_ = boost::none;
+    rows_ = 0;
+    columns_.clear();
+    index_.clear();
+}
+
+bool
+TableColumnCache::ColumnTable::define(Json::Value const& createRaw)
+{
+    clear();
+    if (!createRaw.isArray() || createRaw.size() == 0)
+        return false;
+
+    std::vector<int> keys;
+    bool indexed = false;
+    for (auto const& v : createRaw)
+    {
+        if (!v.isObject() || !v["field"].isString() || !v["type"].isString())
+        {
+            clear();
+            return false;
+        }
+        Column col;
+        col.name = v["field"].asString();
+        auto const type = v["type"].asString();
+        if (boost::iequals(type, "int") || boost::iequals(type, "integer"))
+        {
+            col.kind = ColumnKind::Integer;
+            col.exact = true;
+        }
+        else if (boost::iequals(type, "double"))
+        {
+            col.kind = ColumnKind::Real;
+            col.exact = true;
+        }
+        else if (
+            boost::iequals(type, "text") || boost::iequals(type, "varchar") ||
+            boost::iequals(type, "longtext"))
+        {
+            col.kind = ColumnKind::Text;
+            col.exact = true;
+        }
+        else
+        {
+            // float, decimal, char, blob and dates are stored by the DB in
+            // a form we can't reproduce, writes and queries on them go to
+            // the DB.
+            col.kind = ColumnKind::Opaque;
+            col.exact = false;
+        }
+        col.hasDefault = v.isMember("default");
+        col.primaryKey = v.isMember("PK") && v["PK"].asInt() == 1;
+        if (index_.count(col.name))
+        {
+            clear();
+            return false;
+        }
+        if (col.primaryKey)
+            keys.push_back(static_cast<int>(columns_.size()));
+        indexed = indexed || (v.isMember("UQ") && v["UQ"].asInt() == 1) ||
+            (v.isMember("index") && v["index"].asInt() == 1);
+        index_[col.name] = static_cast<int>(columns_.size());
+        columns_.push_back(std::move(col));
+    }
+    schemaKnown_ = true;
+
+    // Both DBs scan a table in the order of a single integer primary key,
+    // or in insertion order if it has none. Another key or index may be
+    // used to answer the conditions, and then the order is its own.
+    if (!indexed && keys.empty())
+        naturalOrder_ = -1;
+    else if (
+        !indexed && keys.size() == 1 &&
+        columns_[keys[0]].kind == ColumnKind::Integer)
+        naturalOrder_ = keys[0];
+    return true;
+}
+
+void
+TableColumnCache::ColumnTable::defineLoaded(
+    std::vector<std::pair<std::string, ColumnKind>> const& cols)
+{
+    clear();
+    for (auto const& c : cols)
+    {
+        Column col;
+        col.name = c.first;
+        col.kind = c.second;
+        // The declared type of a REAL column (float, double, decimal) is
+        // unknown here, so writes into it, as into opaque columns,
+        // invalidate the cache.
+        col.exact =
+            c.second == ColumnKind::Integer || c.second == ColumnKind::Text;
+        index_[col.name] = static_cast<int>(columns_.size());
+        columns_.push_back(std::move(col));
+    }
+}
+
+void
+TableColumnCache::ColumnTable::appendRow(std::vector<Json::Value> const& cells)
+{
+    for (std::size_t i = 0; i < columns_.size(); ++i)
+    {
+        auto& col = columns_[i];
+        Json::Value const& v = i < cells.size() ? cells[i] : Json::Value();
+        col.nulls.push_back(v.isNull() ? 1 : 0);
+        switch (col.kind)
+        {
+            case ColumnKind::Integer: {
+                std::int64_t i = 0;
+                if (v.isUInt())
+                    i = static_cast<std::int64_t>(v.asLargestUInt());
+                else if (v.isInt())
+                    i = v.asLargestInt();
+                col.ints.push_back(i);
+                break;
+            }
+            case ColumnKind::Real:
+                col.reals.push_back(v.isNull() ? 0 : v.asDouble());
+                break;
+            case ColumnKind::Text:
+                col.texts.push_back(v.isNull() ? std::string() : v.asString());
+                break;
+            case ColumnKind::Opaque:
+                break;
+        }
+    }
+    ++rows_;
+}
+
+int
+TableColumnCache::ColumnTable::findColumn(std::string const& name) const
+{
+    auto const it = index_.find(name);
+    return it == index_.end() ? -1 : it->second;
+}
+
+std::size_t
+TableColumnCache::ColumnTable::bytes() const
+{
+    std::size_t total = 0;
+    for (auto const& col : columns_)
+    {
+        total += col.nulls.capacity() + col.ints.capacity() * sizeof(std::int64_t) +
+            col.reals.capacity() * sizeof(double);
+        for (auto const& s : col.texts)
+            total += sizeof(std::string) + s.capacity();
+    }
+    return total;
+}
+
+// Convert one written value the way the DB would store it, false if the
+// stored form can't be predicted.
+bool
+TableColumnCache::ColumnTable::setCell(
+    Column& col,
+    std::size_t row,
+    Json::Value const& v) const
+{
+    if (v.isObject() || v.isArray())
+        return false;
+    if (!col.exact)
+        return false;
+
+    if (v.isNull())
+    {
+        col.nulls[row] = 1;
+        return true;
+    }
+
+    switch (col.kind)
+    {
+        case ColumnKind::Integer: {
+            std::int64_t i = 0;
+            if (v.isInt() || v.isBool())
+                i = v.asInt();
+            else if (v.isUInt())
+                i = v.asUInt();
+            else if (v.isDouble())
+            {
+                double const d = v.asDouble();
+                if (std::trunc(d) != d || std::abs(d) > 9.0e15)
+                    return false;
+                i = static_cast<std::int64_t>(d);
+            }
+            else if (!v.isString() || !conditionProgram::integer_literal(v.asString(), i))
+                return false;
+            col.ints[row] = i;
+            break;
+        }
+        case ColumnKind::Real: {
+            double d = 0;
+            if (v.isInt() || v.isBool())
+                d = v.asInt();
+            else if (v.isUInt())
+                d = v.asUInt();
+            else if (v.isDouble())
+                d = v.asDouble();
+            else if (!v.isString() || !conditionProgram::real_literal(v.asString(), d))
+                return false;
+            col.reals[row] = d;
+            break;
+        }
+        case ColumnKind::Text:
+            if (v.isString())
+                col.texts[row] = v.asString();
+            else if (v.isInt())
+                col.texts[row] = std::to_string(v.asInt());
+            else if (v.isUInt())
+                col.texts[row] = std::to_string(v.asUInt());
+            else
+                return false;
+            break;
+        case ColumnKind::Opaque:
+            break;
+    }
+    col.nulls[row] = 0;
+    return true;
+}
+
+Json::Value
+TableColumnCache::ColumnTable::cellJson(Column const& col, std::size_t row) const
+{
+    if (col.nulls[row])
+        return Json::Value();
+    switch (col.kind)
+    {
+        case ColumnKind::Integer:
+            // helper::query_result narrows every integer column to int
+            return static_cast<int>(col.ints[row]);
+        case ColumnKind::Real:
+            return col.reals[row];
+        case ColumnKind::Text:
+            return col.texts[row];
+        case ColumnKind::Opaque:
+            break;
+    }
+    return Json::Value();
+}
+
+bool
+TableColumnCache::ColumnTable::insert(Json::Value const& rows)
+{
+    if (!rows.isArray())
+        return false;
+
+    for (auto const& v : rows)
+    {
+        if (!v.isObject())
+            return false;
+        for (auto const& name : v.getMemberNames())
+        {
+            if (findColumn(name) < 0)
+                return false;
+        }
+        // A column left out takes its default or NULL, or an auto value
+        // for an integer primary key; only the plain NULL case is known.
+        for (auto const& col : columns_)
+        {
+            if (!v.isMember(col.name) &&
+                (!schemaKnown_ || col.hasDefault || col.primaryKey))
+                return false;
+        }
+
+        std::size_t const row = rows_;
+        for (auto& col : columns_)
+        {
+            col.nulls.push_back(1);
+            switch (col.kind)
+            {
+                case ColumnKind::Integer:
+                    col.ints.push_back(0);
+                    break;
+                case ColumnKind::Real:
+                    col.reals.push_back(0);
+                    break;
+                case ColumnKind::Text:
+                    col.texts.emplace_back();
+                    break;
+                case ColumnKind::Opaque:
+                    break;
+            }
+        }
+        ++rows_;
+
+        for (auto const& name : v.getMemberNames())
+        {
+            if (!setCell(columns_[findColumn(name)], row, v[name]))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool
+TableColumnCache::ColumnTable::update(Json::Value const& raw)
+{
+    if (!raw.isArray() || raw.size() == 0 || !raw[0u].isObject())
+        return false;
+
+    Json::Value conditions(Json::arrayValue);
+    for (Json::UInt i = 1; i < raw.size(); ++i)
+        conditions.append(raw[i]);
+
+    auto const mask = match(conditions);
+    if (!mask)
+        return false;
+
+    auto const& set = raw[0u];
+    for (auto const& name : set.getMemberNames())
+    {
+        int const idx = findColumn(name);
+        if (idx < 0)
+            return false;
+        auto& col = columns_[idx];
+        for (std::size_t row = 0; row < rows_; ++row)
+        {
+            if ((*mask)[row] && !setCell(col, row, set[name]))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool
+TableColumnCache::ColumnTable::erase(Json::Value const& conditions)
+{
+    auto const mask = match(
+        conditions.isNull() ? Json::Value(Json::arrayValue) : conditions);
+    if (!mask)
+        return false;
+
+    std::size_t kept = 0;
+    for (auto& col : columns_)
+    {
+        kept = 0;
+        for (std::size_t row = 0; row < rows_; ++row)
+        {
+            if ((*mask)[row])
+                continue;
+            col.nulls[kept] = col.nulls[row];
+            switch (col.kind)
+            {
+                case ColumnKind::Integer:
+                    col.ints[kept] = col.ints[row];
+                    break;
+                case ColumnKind::Real:
+                    col.reals[kept] = col.reals[row];
+                    break;
+                case ColumnKind::Text:
+                    col.texts[kept] = std::move(col.texts[row]);
+                    break;
+                case ColumnKind::Opaque:
+                    break;
+            }
+            ++kept;
+        }
+        col.nulls.resize(kept);
+        if (col.kind == ColumnKind::Integer)
+            col.ints.resize(kept);
+        else if (col.kind == ColumnKind::Real)
+            col.reals.resize(kept);
+        else if (col.kind == ColumnKind::Text)
+            col.texts.resize(kept);
+    }
+    if (!columns_.empty())
+        rows_ = kept;
+    return true;
+}
+
+boost::optional<TableColumnCache::ColumnTable::Mask>
+TableColumnCache::ColumnTable::match(Json::Value const& conditions) const
+{
+    conditionProgram program;
+    if (program.compile(conditions).first != 0)
+        return boost::none;
+
+    Mask mask;
+    auto const lookup =
+        [this](std::string const& name) -> conditionProgram::Column const* {
+        int const idx = findColumn(name);
+        return idx < 0 ? nullptr : &columns_[idx];
+    };
+    if (!program.eval(rows_, lookup, mysql_, mask))
+        return boost::none;
+    return mask;
+}
+
+int
+TableColumnCache::ColumnTable::compareCells(
+    Column const& col,
+    std::size_t a,
+    std::size_t b) const
+{
+    // NULL sorts first in both engines
+    if (col.nulls[a] || col.nulls[b])
+        return int(col.nulls[b] != 0) - int(col.nulls[a] != 0);
+    switch (col.kind)
+    {
+        case ColumnKind::Integer:
+            return col.ints[a] < col.ints[b] ? -1 : col.ints[a] > col.ints[b];
+        case ColumnKind::Real:
+            return col.reals[a] < col.reals[b] ? -1
+                                                : col.reals[a] > col.reals[b];
+        case ColumnKind::Text:
+            return col.texts[a].compare(col.texts[b]);
+        case ColumnKind::Opaque:
+            break;
+    }
+    return 0;
+}
+
+boost::optional<std::vector<std::vector<Json::Value>>>
+TableColumnCache::ColumnTable::select2d(
+    Json::Value const& raw,
+    int selectLimit) const
+{
+    if (!raw.isArray() || raw.size() == 0 || !raw[0u].isArray())
+        return boost::none;
+
+    Json::Value conditions(Json::arrayValue);
+    Json::Value limit;
+    std::vector<std::pair<int, bool>> orders;  // column, descending
+    for (Json::UInt i = 1; i < raw.size(); ++i)
+    {
+        auto const& v = raw[i];
+        if (!v.isObject())
+            return boost::none;
+        auto const keys = v.getMemberNames();
+        bool const extra = std::any_of(keys.begin(), keys.end(), [](auto& k) {
+            return !k.empty() && k[0] == '$' && !boost::iequals(k, "$and") &&
+                !boost::iequals(k, "$or");
+        });
+        if (!extra)
+        {
+            conditions.append(v);
+            continue;
+        }
+        for (auto const& k : keys)
+        {
+            if (boost::iequals(k, "$limit"))
+            {
+                if (!v[k]["index"].isInt() || !v[k]["total"].isInt() ||
+                    v[k]["index"].asInt() < 0 || v[k]["total"].asInt() < 0)
+                    return boost::none;
+                limit = v[k];
+            }
+            else if (boost::iequals(k, "$order") && v[k].isArray())
+            {
+                for (auto const& o : v[k])
+                {
+                    if (!o.isObject() || o.size() == 0)
+                        return boost::none;
+                    auto const name = o.getMemberNames()[0];
+                    int const idx = findColumn(name);
+                    if (idx < 0 || columns_[idx].kind == ColumnKind::Opaque ||
+                        (mysql_ && columns_[idx].kind == ColumnKind::Text))
+                        return boost::none;
+                    auto const& dir = o[name];
+                    bool desc = false;
+                    if (dir.isString())
+                        desc = boost::iequals(dir.asString(), "desc");
+                    else if (dir.isNumeric())
+                        desc = dir.asInt() == -1;
+                    orders.emplace_back(idx, desc);
+                }
+            }
+            else
+                return boost::none;  // $join, $group, $having ...
+        }
+    }
+
+    // Fields: nothing means every column, otherwise all plain columns or
+    // all aggregates.
+    struct Field
+    {
+        std::string label;
+        std::string func;
+        int column;  // -1 for count(*)
+    };
+    std::vector<Field> fields;
+    for (auto const& f : raw[0u])
+    {
+        if (!f.isString())
+            return boost::none;
+        auto const label = f.asString();
+        auto const open = label.find('(');
+        if (open == std::string::npos)
+        {
+            int const idx = findColumn(label);
+            if (idx < 0)
+                return boost::none;
+            fields.push_back({label, "", idx});
+            continue;
+        }
+        if (label.back() != ')')
+            return boost::none;
+        auto const func = boost::to_lower_copy(label.substr(0, open));
+        auto const arg = label.substr(open + 1, label.size() - open - 2);
+        if (func == "count" && arg == "*")
+        {
+            fields.push_back({label, func, -1});
+            continue;
+        }
+        int const idx = findColumn(arg);
+        if (idx < 0)
+            return boost::none;
+        if (func != "count" && func != "min" && func != "max" &&
+            // mysql sums into DECIMAL, which comes back in another type
+            (mysql_ || (func != "sum" && func != "avg")))
+            return boost::none;
+        fields.push_back({label, func, idx});
+    }
+    if (fields.empty())
+    {
+        for (std::size_t i = 0; i < columns_.size(); ++i)
+            fields.push_back({columns_[i].name, "", static_cast<int>(i)});
+    }
+    bool const aggregate = !fields[0].func.empty();
+    for (auto const& f : fields)
+    {
+        if (f.func.empty() == aggregate)
+            return boost::none;
+        if (f.column < 0)
+            continue;
+        auto const kind = columns_[f.column].kind;
+        if (f.func == "count")
+            continue;
+        if (kind == ColumnKind::Opaque)
+            return boost::none;
+        if ((f.func == "sum" || f.func == "avg") && kind == ColumnKind::Text)
+            return boost::none;
+        if ((f.func == "min" || f.func == "max") && mysql_ &&
+            kind == ColumnKind::Text)
+            return boost::none;
+    }
+
+    auto const mask = match(conditions);
+    if (!mask)
+        return boost::none;
+
+    std::vector<std::size_t> selected;
+    for (std::size_t row = 0; row < rows_; ++row)
+    {
+        if ((*mask)[row])
+            selected.push_back(row);
+    }
+
+    // the DB query always carries a limit capped at select_limit
+    std::size_t offset = 0;
+    std::size_t total = selectLimit > 0 ? selectLimit : 0;
+    if (limit.isObject())
+    {
+        offset = limit["index"].asInt();
+        total = std::min<std::size_t>(total, limit["total"].asInt());
+    }
+
+    auto cell = [](std::string const& label, Json::Value const& v) {
+        Json::Value e;
+        e[label] = v;
+        return e;
+    };
+
+    std::vector<std::vector<Json::Value>> lines;
+    if (aggregate)
+    {
+        std::vector<Json::Value> e;
+        for (auto const& f : fields)
+        {
+            if (f.column < 0)
+            {
+                e.push_back(cell(f.label, static_cast<int>(selected.size())));
+                continue;
+            }
+            auto const& col = columns_[f.column];
+            std::size_t nonNull = 0;
+            boost::optional<std::size_t> best;
+            double sum = 0;
+            std::int64_t isum = 0;
+            for (auto row : selected)
+            {
+                if (col.nulls[row])
+                    continue;
+                ++nonNull;
+                if (f.func == "min" || f.func == "max")
+                {
+                    int const c = best ? compareCells(col, row, *best) : -1;
+                    if (!best || (f.func == "min" ? c < 0 : c > 0))
+                        best = row;
+                }
+                else if (col.kind == ColumnKind::Integer)
+                {
+                    isum += col.ints[row];
+                    sum += static_cast<double>(col.ints[row]);
+                }
+                else if (col.kind == ColumnKind::Real)
+                    sum += col.reals[row];
+            }
+
+            if (f.func == "count")
+                e.push_back(cell(f.label, static_cast<int>(nonNull)));
+            else if (nonNull == 0)
+                e.push_back(cell(f.label, Json::Value()));
+            else if (f.func == "min" || f.func == "max")
+                e.push_back(cell(f.label, cellJson(col, *best)));
+            else if (f.func == "avg")
+                e.push_back(cell(f.label, sum / nonNull));
+            else if (col.kind == ColumnKind::Integer)
+                e.push_back(cell(f.label, static_cast<int>(isum)));
+            else
+                e.push_back(cell(f.label, sum));
+        }
+        if (offset == 0 && total > 0)
+            lines.push_back(std::move(e));
+    }
+    else
+    {
+        for (auto const& f : fields)
+        {
+            if (columns_[f.column].kind == ColumnKind::Opaque)
+                return boost::none;
+        }
+        // Rows tied under $order, or all of them without it, come back in
+        // the DB's own order.
+        if (selected.size() > 1 && naturalOrder_ && *naturalOrder_ >= 0)
+        {
+            auto const& key = columns_[*naturalOrder_];
+            std::stable_sort(
+                selected.begin(),
+                selected.end(),
+                [&](std::size_t a, std::size_t b) {
+                    return compareCells(key, a, b) < 0;
+                });
+        }
+        auto const byOrders = [&](std::size_t a, std::size_t b) {
+            for (auto const& o : orders)
+            {
+                int c = compareCells(columns_[o.first], a, b);
+                if (c != 0)
+                    return o.second ? c > 0 : c < 0;
+            }
+            return false;
+        };
+        if (!orders.empty())
+            std::stable_sort(selected.begin(), selected.end(), byOrders);
+        if (selected.size() > 1 && !naturalOrder_ &&
+            std::adjacent_find(
+                selected.begin(),
+                selected.end(),
+                [&](std::size_t a, std::size_t b) {
+                    return !byOrders(a, b);
+                }) != selected.end())
+            return boost::none;
+        for (std::size_t i = offset; i < selected.size() && i - offset < total;
+             ++i)
+        {
+            std::vector<Json::Value> e;
+            for (auto const& f : fields)
+                e.push_back(
+                    cell(f.label, cellJson(columns_[f.column], selected[i])));
+            lines.push_back(std::move(e));
+        }
+    }
+    return lines;
+}
+
+boost::optional<Json::Value>
+TableColumnCache::ColumnTable::select(Json::Value const& raw, int selectLimit)
+    const
+{
+    auto const rows = select2d(raw, selectLimit);
+    if (!rows)
+        return boost::none;
+
+    Json::Value lines(Json::arrayValue);
+    for (auto const& row : *rows)
+    {
+        Json::Value e;
+        for (auto const& c : row)
+        {
+            for (auto const& name : c.getMemberNames())
+                e[name] = c[name];
+        }
+        lines.append(e);
+    }
+    Json::Value obj;
+    obj[jss::lines] = lines;
+    return obj;
+}
+
+
+//------------------------------------------------------------------------------
+
+TableColumnCache::UpdateGuard::UpdateGuard(
+    TableColumnCache& cache,
+    std::string const& nameInDB)
+    : cache_(cache), entry_(cache.getEntry(nameInDB))
+{
+    if (entry_)
+    {
+        std::unique_lock lock(entry_->mutex);
+        ++entry_->pending;
+    }
+}
+
+TableColumnCache::UpdateGuard::~UpdateGuard()
+{
+    if (entry_)
+    {
+        std::unique_lock lock(entry_->mutex);
+        --entry_->pending;
+    }
+}
+
+void
+TableColumnCache::UpdateGuard::commit(std::vector<Op> const& ops)
+{
+    if (!entry_)
+        return;
+    std::unique_lock lock(entry_->mutex);
+    --entry_->pending;
+    if (!ops.empty())
+    {
+        ++entry_->version;
+        cache_.apply(*entry_, ops);
+    }
+    lock.unlock();
+    entry_.reset();
+}
+
+//------------------------------------------------------------------------------
+
+TableColumnCache::TableColumnCache(
+    Schema& app,
+    Config& cfg,
+    beast::Journal journal)
+    : app_(app)
+    , journal_(journal)
+    , mysql_(false)
+    , selectLimit_(200)
+    , maxRows_(100000)
+{
+    auto const& syncDB = cfg.section("sync_db");
+    auto const type = syncDB.find("type");
+    mysql_ = type.second &&
+        (boost::iequals(type.first, "mysql") ||
+         boost::iequals(type.first, "mycat"));
+
+    auto const& select_limit = cfg.section("select_limit");
+    if (select_limit.values().size() > 0)
+        selectLimit_ = atoi(select_limit.values().at(0).c_str());
+
+    auto const& section = cfg.section(ConfigSection::cacheTables());
+    if (auto const rows = section.get<std::size_t>("max_rows"))
+        maxRows_ = *rows;
+    for (auto const& line : section.values())
+    {
+        std::vector<std::string> words;
+        boost::split(
+            words, line, boost::is_any_of(" \t"), boost::token_compress_on);
+        if (words.size() != 2)
+        {
+            JLOG(journal_.warn())
+                << "Ignoring malformed [cache_tables] line: " << line;
+            continue;
+        }
+        tables_.emplace(words[0], words[1]);
+    }
+}
+
+bool
+TableColumnCache::configured(
+    AccountID const& owner,
+    std::string const& tableName) const
+{
+    if (tables_.empty())
+        return false;
+    return tables_.count(std::make_pair(to_string(owner), tableName)) > 0;
+}
+
+void
+TableColumnCache::track(
+    AccountID const& owner,
+    std::string const& tableName,
+    std::string const& nameInDB)
+{
+    if (nameInDB.empty())
+        return;
+    if (!configured(owner, tableName))
+    {
+        erase(nameInDB);
+        return;
+    }
+
+    std::lock_guard lock(mutex_);
+    if (entries_.count(nameInDB) == 0)
+    {
+        JLOG(journal_.info()) << "Caching table " << tableName << " ("
+                              << nameInDB << ") in memory";
+        entries_.emplace(nameInDB, std::make_shared<Entry>(mysql_));
+    }
+}
+
+void
+TableColumnCache::erase(std::string const& nameInDB)
+{
+    std::lock_guard lock(mutex_);
+    entries_.erase(nameInDB);
+}
+
+void
+TableColumnCache::invalidate(std::string const& nameInDB)
+{
+    auto const entry = getEntry(nameInDB);
+    if (!entry)
+        return;
+
+    // A load holds the entry lock, so none that read the rows from before
+    // the write can finish after this
+    std::unique_lock lock(entry->mutex);
+    ++entry->version;
+    invalidate(*entry);
+}
+
+std::shared_ptr<TableColumnCache::Entry>
+TableColumnCache::getEntry(std::string const& nameInDB) const
+{
+    std::lock_guard lock(mutex_);
+    auto const it = entries_.find(nameInDB);
+    return it == entries_.end() ? nullptr : it->second;
+}
+
+TableColumnCache::Op
+TableColumnCache::makeOp(STTx const& tx, SyncParam const& param)
+{
+    Op op{static_cast<TableOpType>(tx.getFieldU16(sfOpType)),
+          Json::Value(),
+          true};
+
+    auto const sRaw = tx.buildRaw(param.rules);
+    if (!sRaw.empty() && !Json::Reader().parse(sRaw, op.raw))
+        op.exact = false;
+
+    if (op.type != R_INSERT && op.type != R_UPDATE)
+        return op;
+
+    // STTx2SQL fills these columns from the transaction itself
+    std::map<std::string, Json::Value> autoFill;
+    auto fill = [&](SF_Blob const& field, Json::Value const& value) {
+        if (tx.isFieldPresent(field))
+            autoFill[strCopy(tx.getFieldVL(field))] = value;
+    };
+    fill(sfAutoFillField, to_string(tx.getRealTxID()));
+    fill(sfLedgerSeqField, std::to_string(param.ledgerSeq));
+    fill(sfLedgerTimeField, param.ledgerTime);
+
+    if (op.type == R_INSERT)
+    {
+        fill(sfTxsHashFillField, to_string(tx.getRealTxID()));
+        for (auto& row : op.raw)
+        {
+            for (auto const& kv : autoFill)
+                row[kv.first] = kv.second;
+        }
+    }
+    else if (tx.isFieldPresent(sfTxsHashFillField))
+    {
+        // appended with concat() by the DB
+        op.exact = false;
+    }
+    else if (op.raw.isArray() && op.raw.size() > 0)
+    {
+        for (auto const& kv : autoFill)
+            op.raw[0u][kv.first] = kv.second;
+    }
+    return op;
+}
+
+void
+TableColumnCache::invalidate(Entry& entry)
+{
+    entry.table.clear();
+    entry.loaded = false;
+}
+
+void
+TableColumnCache::apply(Entry& entry, std::vector<Op> const& ops)
+{
+    for (auto const& op : ops)
+    {
+        switch (op.type)
+        {
+            case T_CREATE:
+            case T_RECREATE:
+                entry.disabled = false;
+                entry.loaded = op.exact && entry.table.define(op.raw);
+                break;
+            case T_DROP:
+                entry.disabled = false;
+                invalidate(entry);
+                break;
+            case R_INSERT:
+            case R_UPDATE:
+            case R_DELETE:
+                if (entry.loaded && !replay(entry.table, op))
+                    invalidate(entry);
+                break;
+            case T_ADD_FIELDS:
+            case T_DELETE_FIELDS:
+            case T_MODIFY_FIELDS:
+                invalidate(entry);
+                break;
+            default:
+                // rename, grant, assert, index ... leave the rows alone
+                break;
+        }
+    }
+
+    if (entry.loaded && entry.table.rows() > maxRows_)
+    {
+        JLOG(journal_.warn()) << "Cached table exceeds " << maxRows_
+                              << " rows, no longer cached";
+        invalidate(entry);
+        entry.disabled = true;
+    }
+}
+
+bool
+TableColumnCache::replay(ColumnTable& table, Op const& op)
+{
+    if (!op.exact)
+        return false;
+    switch (op.type)
+    {
+        case R_INSERT:
+            return table.insert(op.raw);
+        case R_UPDATE:
+            return table.update(op.raw);
+        case R_DELETE:
+            return table.erase(op.raw);
+        default:
+            return false;
+    }
+}
+
+bool
+TableColumnCache::load(
+    Entry& entry,
+    std::string const& nameInDB,
+    DatabaseCon* conn)
+{
+    if (entry.loaded)
+        return true;
+    if (entry.disabled || entry.pending > 0 || conn == nullptr ||
+        entry.loadFailedAt == entry.version)
+        return false;
+
+    entry.loadFailedAt = entry.version;
+    try
+    {
+        LockedSociSession sql = conn->checkoutDb();
+        soci::rowset<soci::row> records =
+            (sql->prepare << "select * from t_" + nameInDB);
+
+        bool first = true;
+        std::vector<Json::Value> cells;
+        for (auto const& r : records)
+        {
+            if (first)
+            {
+                std::vector<std::pair<std::string, ColumnKind>> cols;
+                for (std::size_t i = 0; i < r.size(); ++i)
+                {
+                    auto const& p = r.get_properties(i);
+                    ColumnKind kind = ColumnKind::Opaque;
+                    switch (p.get_data_type())
+                    {
+                        case soci::dt_string:
+                            kind = ColumnKind::Text;
+                            break;
+                        case soci::dt_integer:
+                        case soci::dt_long_long:
+                        case soci::dt_unsigned_long_long:
+                            kind = ColumnKind::Integer;
+                            break;
+                        case soci::dt_double:
+                            kind = ColumnKind::Real;
+                            break;
+                        default:
+                            break;
+                    }
+                    cols.emplace_back(p.get_name(), kind);
+                }
+                entry.table.defineLoaded(cols);
+                first = false;
+            }
+
+            if (entry.table.rows() >= maxRows_)
+            {
+                JLOG(journal_.warn()) << "Table " << nameInDB << " exceeds "
+                                      << maxRows_ << " rows, not cached";
+                entry.table.clear();
+                entry.disabled = true;
+                return false;
+            }
+
+            cells.assign(r.size(), Json::Value());
+            for (std::size_t i = 0; i < r.size(); ++i)
+            {
+                if (r.get_indicator(i) != soci::i_ok)
+                    continue;
+                switch (r.get_properties(i).get_data_type())
+                {
+                    case soci::dt_string:
+                        cells[i] = r.get<std::string>(i);
+                        break;
+                    case soci::dt_integer:
+                        cells[i] = r.get<int>(i);
+                        break;
+                    case soci::dt_long_long:
+                        cells[i] = Json::Int64(r.get<long long>(i));
+                        break;
+                    case soci::dt_unsigned_long_long:
+                        cells[i] = Json::UInt64(r.get<unsigned long long>(i));
+                        break;
+                    case soci::dt_double:
+                        cells[i] = r.get<double>(i);
+                        break;
+                    default:
+                        // not read back, the column is never served
+                        cells[i] = 0;
+                        break;
+                }
+            }
+            entry.table.appendRow(cells);
+        }
+
+        // An empty table tells us nothing about its columns, wait until
+        // it is written.
+        if (first)
+            return false;
+    }
+    catch (std::exception const& e)
+    {
+        JLOG(journal_.warn()) << "Loading table " << nameInDB
+                              << " into cache failed: " << e.what();
+        entry.table.clear();
+        return false;
+    }
+
+    entry.loadFailedAt = boost::none;
+    entry.loaded = true;
+    JLOG(journal_.debug()) << "Loaded table " << nameInDB << " into cache, "
+                           << entry.table.rows() << " rows";
+    return true;
+}
+
+bool
+TableColumnCache::withTable(
+    std::string const& nameInDB,
+    Json::Value const& tx_json,
+    DatabaseCon* conn,
+    std::function<void(ColumnTable const&, Json::Value const&)> const& fn)
+{
+    auto const entry = getEntry(nameInDB);
+    if (!entry)
+        return false;
+
+    auto const raw = parseRaw(tx_json);
+    if (!raw)
+        return false;
+
+    {
+        std::shared_lock lock(entry->mutex);
+        if (entry->loaded)
+        {
+            fn(entry->table, *raw);
+            return true;
+        }
+    }
+
+    std::unique_lock lock(entry->mutex);
+    if (!load(*entry, nameInDB, conn))
+        return false;
+    fn(entry->table, *raw);
+    return true;
+}
+
+boost::optional<Json::Value>
+TableColumnCache::parseRaw(Json::Value const& tx_json)
+{
+    if (!tx_json["Tables"].isArray() || tx_json["Tables"].size() != 1)
+        return boost::none;
+
+    // Raw is still a string unless an r_get rule was merged into it
+    Json::Value raw = tx_json["Raw"];
+    if (raw.isString() && !Json::Reader().parse(raw.asString(), raw))
+        return boost::none;
+    if (!raw.isArray())
+        return boost::none;
+    return raw;
+}
+
+boost::optional<Json::Value>
+TableColumnCache::query(
+    std::string const& nameInDB,
+    Json::Value const& tx_json,
+    DatabaseCon* conn)
+{
+    boost::optional<Json::Value> result;
+    withTable(
+        nameInDB,
+        tx_json,
+        conn,
+        [&](ColumnTable const& table, Json::Value const& raw) {
+            result = table.select(raw, selectLimit_);
+        });
+    return result;
+}
+
+boost::optional<std::vector<std::vector<Json::Value>>>
+TableColumnCache::query2d(
+    std::string const& nameInDB,
+    Json::Value const& tx_json,
+    DatabaseCon* conn)
+{
+    boost::optional<std::vector<std::vector<Json::Value>>> result;
+    withTable(
+        nameInDB,
+        tx_json,
+        conn,
+        [&](ColumnTable const& table, Json::Value const& raw) {
+            result = table.select2d(raw, selectLimit_);
+        });
+    return result;
+}
+
+}  // namespace ripple
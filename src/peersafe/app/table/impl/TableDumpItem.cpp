@@ -48,6 +48,7 @@ TableDumpItem::TableDumpItem(Schema& app, beast::Journal journal, Config& cfg, S
     sLedgerHashRecord_    = "";
     uLedgerStart_         = 0;
     uLedgerStop_          = 0;
+    bFilter_              = false;
 }
 
 void TableDumpItem::GetCurrentPos(taskInfo &info)
@@ -190,6 +191,44 @@ std::pair<bool, std::string> TableDumpItem::SetDumpPara(std::string sPath, funDu
 	return std::make_pair(true, "");
 }
 
+std::pair<bool, std::string> TableDumpItem::SetDumpFilter(std::string sFilter)
+{
+    Json::Value conditions;
+    if (!Json::Reader().parse(sFilter, conditions) || !conditions.isArray())
+    {
+        return std::make_pair(false, "filter must be an array of conditions.");
+    }
+
+    auto ret = filter_.compile(conditions);
+    if (ret.first != 0)
+    {
+        return std::make_pair(false, ret.second);
+    }
+    bFilter_ = true;
+    return std::make_pair(true, "");
+}
+
+bool TableDumpItem::MayMatchFilter(const std::vector<STTx>& vecTxs)
+{
+    for (auto const& tx : vecTxs)
+    {
+        if (!tx.isFieldPresent(sfOpType) || tx.getFieldU16(sfOpType) != R_INSERT)
+            return true;
+
+        //rows are checked as written, under both engines' comparison rules
+        conditionRows rows(TransRaw2Json(tx));
+        for (bool mysql : {false, true})
+        {
+            conditionProgram::Mask mask;
+            if (!filter_.eval(rows.size(), rows.lookup(), mysql, mask))
+                return true;
+            if (std::find(mask.begin(), mask.end(), 1) != mask.end())
+                return true;
+        }
+    }
+    return false;
+}
+
 Json::Value TableDumpItem::TransRaw2Json(const STTx & tx)
 {
 	Json::Value jsonRaw;
@@ -364,7 +403,7 @@ void TableDumpItem::issuesAfterStop()
 }
 bool TableDumpItem::isTxNeededOutput(const STTx& tx, std::vector<STTx>& vecTxs)
 {
-    return true;
+    return !bFilter_ || MayMatchFilter(vecTxs);
 }
 void TableDumpItem::SetStopInfo(FILE *fileTarget, std::string sMsg)
 {
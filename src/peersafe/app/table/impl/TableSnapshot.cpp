@@ -0,0 +1,701 @@
+//------------------------------------------------------------------------------
+/*
+ This file is part of chainsqld: https://github.com/chainsql/chainsqld
+ Copyright (c) 2016-2018 Peersafe Technology Co., Ltd.
+
+	chainsqld is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	chainsqld is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//==============================================================================
+
+#include <ripple/app/ledger/LedgerMaster.h>
+#include <ripple/app/ledger/TransactionMaster.h>
+#include <ripple/app/misc/Transaction.h>
+#include <ripple/basics/StringUtilities.h>
+#include <ripple/core/DatabaseCon.h>
+#include <ripple/json/json_reader.h>
+#include <ripple/json/json_writer.h>
+#include <peersafe/app/sql/STTx2SQL.h>
+#include <peersafe/app/sql/TxStore.h>
+#include <peersafe/app/table/TableSnapshot.h>
+#include <peersafe/app/table/TableStatusDB.h>
+#include <peersafe/app/util/TableSyncUtil.h>
+#include <peersafe/protocol/STEntry.h>
+#include <peersafe/rpc/TableUtils.h>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+
+namespace ripple {
+
+namespace fs = boost::filesystem;
+
+TableSnapshot::Writer::Writer(std::ostream& out, Header const& header)
+    : out_(out)
+{
+    Json::Value jv(Json::objectValue);
+    jv["version"] = version;
+    jv["db_type"] = header.sDBType;
+    jv["owner"] = toBase58(header.owner);
+    jv["table_name"] = header.sTableName;
+    jv["name_in_db"] = header.sNameInDB;
+    jv["ledger_seq"] = header.uLedgerSeq;
+    jv["ledger_hash"] = to_string(header.uLedgerHash);
+    jv["txn_ledger_seq"] = header.uTxnLedgerSeq;
+    jv["txn_ledger_hash"] = to_string(header.uTxnLedgerHash);
+    jv["txn_update_hash"] = to_string(header.uTxnUpdateHash);
+    jv["txn_ledger_time"] = header.sTxnLedgerTime;
+
+    Json::Value& columns = (jv["columns"] = Json::arrayValue);
+    for (std::size_t i = 0; i < header.vecColumns.size(); i++)
+    {
+        Json::Value column(Json::objectValue);
+        column["name"] = header.vecColumns[i];
+        column["type"] = header.vecTypes[i];
+        columns.append(column);
+    }
+    line(Json::FastWriter().write(jv));
+}
+
+void
+TableSnapshot::Writer::line(std::string const& s)
+{
+    out_ << s << '\n';
+    hasher_(s.data(), s.size());
+    hasher_("\n", 1);
+}
+
+void
+TableSnapshot::Writer::add(Json::Value const& row)
+{
+    line(Json::FastWriter().write(row));
+    ++rows_;
+}
+
+std::size_t
+TableSnapshot::Writer::finish()
+{
+    Json::Value jv(Json::objectValue);
+    jv["rows"] = static_cast<Json::UInt>(rows_);
+    jv["hash"] = to_string(static_cast<uint256>(hasher_));
+    out_ << Json::FastWriter().write(jv) << '\n';
+    return rows_;
+}
+
+TableSnapshot::Reader::Reader(std::istream& in) : in_(in)
+{
+}
+
+std::pair<bool, std::string>
+TableSnapshot::Reader::readHeader(Header& header)
+{
+    header = Header{};
+    Json::Value jv;
+    if (!std::getline(in_, headerLine_) ||
+        !Json::Reader().parse(headerLine_, jv) || !jv.isObject() ||
+        jv["version"].asInt() != version || !jv["columns"].isArray())
+        return std::make_pair(false, "the file is not a table snapshot.");
+    rowsPos_ = in_.tellg();
+
+    auto const owner = parseBase58<AccountID>(jv["owner"].asString());
+    if (!owner)
+        return std::make_pair(false, "bad owner in the snapshot.");
+    header.sDBType = jv["db_type"].asString();
+    header.owner = *owner;
+    header.sTableName = jv["table_name"].asString();
+    header.sNameInDB = jv["name_in_db"].asString();
+    header.uLedgerSeq = jv["ledger_seq"].asUInt();
+    header.uTxnLedgerSeq = jv["txn_ledger_seq"].asUInt();
+    header.sTxnLedgerTime = jv["txn_ledger_time"].asString();
+    if (!header.uLedgerHash.SetHexExact(jv["ledger_hash"].asString()) ||
+        !header.uTxnLedgerHash.SetHexExact(
+            jv["txn_ledger_hash"].asString()) ||
+        !header.uTxnUpdateHash.SetHexExact(
+            jv["txn_update_hash"].asString()))
+        return std::make_pair(false, "bad ledger position in the snapshot.");
+
+    uint160 nameInDB;
+    if (header.sTableName.empty() || !nameInDB.SetHexExact(header.sNameInDB))
+        return std::make_pair(false, "bad table name in the snapshot.");
+
+    for (auto const& column : jv["columns"])
+    {
+        auto const name = column["name"].asString();
+        if (name.empty() || name.find_first_of("`\"'") != std::string::npos ||
+            !column["type"].isIntegral())
+            return std::make_pair(false, "bad column " + name + ".");
+        header.vecColumns.push_back(name);
+        header.vecTypes.push_back(column["type"].asInt());
+    }
+    if (header.vecColumns.empty())
+        return std::make_pair(false, "the snapshot has no column.");
+    return std::make_pair(true, "");
+}
+
+std::pair<bool, std::string>
+TableSnapshot::Reader::readRows(
+    std::size_t nColumns,
+    std::function<std::string(Json::Value const&)> const& onRow,
+    std::size_t& rows)
+{
+    rows = 0;
+    in_.clear();
+    in_.seekg(rowsPos_);
+
+    sha512_half_hasher hasher;
+    hasher(headerLine_.data(), headerLine_.size());
+    hasher("\n", 1);
+
+    std::string line;
+    Json::Value jv;
+    while (std::getline(in_, line))
+    {
+        if (line.empty())
+            continue;
+        if (!Json::Reader().parse(line, jv))
+            return std::make_pair(
+                false, "bad row after " + std::to_string(rows) + " rows.");
+        if (jv.isObject())
+        {
+            uint256 hash;
+            if (jv["rows"].asUInt() != rows ||
+                !hash.SetHexExact(jv["hash"].asString()) ||
+                hash != static_cast<uint256>(hasher))
+                return std::make_pair(false, "the snapshot doesn't match its trailer.");
+            while (std::getline(in_, line))
+            {
+                if (!line.empty())
+                    return std::make_pair(false, "data after the end of the snapshot.");
+            }
+            return std::make_pair(true, "");
+        }
+        if (!jv.isArray() || jv.size() != nColumns)
+            return std::make_pair(
+                false, "bad row after " + std::to_string(rows) + " rows.");
+
+        hasher(line.data(), line.size());
+        hasher("\n", 1);
+        if (onRow)
+        {
+            auto const err = onRow(jv);
+            if (!err.empty())
+                return std::make_pair(false, err);
+        }
+        ++rows;
+    }
+    return std::make_pair(false, "the snapshot is truncated.");
+}
+
+TableSnapshot::TableSnapshot(Schema& app, beast::Journal journal)
+    : app_(app), journal_(journal), reader_(in_)
+{
+}
+
+std::string
+TableSnapshot::dbType() const
+{
+    DatabaseCon::Setup setup = ripple::setup_SyncDatabaseCon(app_.config());
+    auto const type = setup.sync_db.find("type");
+    if (type.second && boost::iequals(type.first, "sqlite"))
+        return "sqlite";
+    return "mysql";
+}
+
+bool
+TableSnapshot::hexCoded(int type)
+{
+    return type == soci::dt_string || type == soci::dt_blob;
+}
+
+std::pair<bool, std::string>
+TableSnapshot::Make(
+    AccountID const& owner,
+    std::string const& sTableName,
+    std::string const& sPath)
+{
+    auto const ledger = app_.getLedgerMaster().getValidatedLedger();
+    if (!ledger)
+        return std::make_pair(false, "no validated ledger.");
+    auto const tup = getTableEntry(*ledger, owner, sTableName);
+    auto const pEntry = std::get<1>(tup);
+    if (pEntry == nullptr)
+        return std::make_pair(false, "can't find the table in the validated ledger.");
+    if (isConfidential(*ledger, owner, sTableName))
+        return std::make_pair(false, "a confidential table can't be written to a snapshot.");
+
+    header_ = Header{};
+    header_.sDBType = dbType();
+    header_.owner = owner;
+    header_.sTableName = sTableName;
+    header_.sNameInDB = to_string(pEntry->getFieldH160(sfNameInDB));
+    std::string const sTable = "t_" + header_.sNameInDB;
+
+    TxStoreDBConn conn(app_.config());
+    if (conn.GetDBConn() == nullptr)
+        return std::make_pair(false, "can't connect to the database.");
+
+    fs::path const fullPath(sPath);
+    if (fullPath.has_parent_path() && !fs::exists(fullPath.parent_path()))
+        return std::make_pair(false, "path is invalid.");
+    // sPath only appears once the snapshot is complete
+    std::string const sTmpPath = sPath + ".tmp";
+    std::ofstream out(sTmpPath, std::ios::out | std::ios::trunc);
+    if (!out)
+        return std::make_pair(false, "fail to open the file.");
+    auto const fail = [&](std::string const& sErr) {
+        out.close();
+        boost::system::error_code ec;
+        fs::remove(sTmpPath, ec);
+        return std::make_pair(false, sErr);
+    };
+
+    std::size_t rows = 0;
+    try
+    {
+        LockedSociSession session = conn.GetDBConn()->checkoutDb();
+        // one transaction for the position and the rows: InnoDB reads both
+        // from the snapshot taken by the first select, SQLite holds the
+        // shared lock until the rollback below
+        soci::transaction tr(*session);
+
+        std::string const sOwner = to_string(owner);
+        boost::optional<std::string> TxnLedgerHash, TxnLedgerSeq, LedgerHash,
+            LedgerSeq, TxnUpdateHash, TxnLedgerTime;
+        soci::statement st =
+            (session->prepare
+                 << "select TxnLedgerHash,TxnLedgerSeq,LedgerHash,LedgerSeq,"
+                    "TxnUpdateHash,TxnLedgerTime from SyncTableState "
+                    "where TableNameInDB = :name and Owner = :owner",
+             soci::use(header_.sNameInDB),
+             soci::use(sOwner),
+             soci::into(TxnLedgerHash),
+             soci::into(TxnLedgerSeq),
+             soci::into(LedgerHash),
+             soci::into(LedgerSeq),
+             soci::into(TxnUpdateHash),
+             soci::into(TxnLedgerTime));
+        if (!st.execute(true) || !LedgerSeq || LedgerSeq->empty())
+            return fail("the table is not synced by this node.");
+
+        header_.uLedgerSeq = std::stoul(*LedgerSeq);
+        if (TxnLedgerSeq && !TxnLedgerSeq->empty())
+            header_.uTxnLedgerSeq = std::stoul(*TxnLedgerSeq);
+        if (LedgerHash && !LedgerHash->empty())
+            header_.uLedgerHash = from_hex_text<uint256>(*LedgerHash);
+        if (TxnLedgerHash && !TxnLedgerHash->empty())
+            header_.uTxnLedgerHash = from_hex_text<uint256>(*TxnLedgerHash);
+        if (TxnUpdateHash && !TxnUpdateHash->empty())
+            header_.uTxnUpdateHash = from_hex_text<uint256>(*TxnUpdateHash);
+        if (TxnLedgerTime)
+            header_.sTxnLedgerTime = *TxnLedgerTime;
+        if (header_.uTxnLedgerSeq == 0)
+            return fail("the table has no synced transaction yet.");
+
+        soci::row r;
+        soci::statement rowsSt =
+            (session->prepare << "select * from " + sTable, soci::into(r));
+        rowsSt.execute();
+
+        for (std::size_t i = 0; i < r.size(); i++)
+        {
+            auto const& props = r.get_properties(i);
+            header_.vecColumns.push_back(props.get_name());
+            header_.vecTypes.push_back(props.get_data_type());
+        }
+        Writer writer(out, header_);
+
+        char buf[32];
+        while (rowsSt.fetch())
+        {
+            Json::Value row(Json::arrayValue);
+            for (std::size_t i = 0; i < r.size(); i++)
+            {
+                if (r.get_indicator(i) != soci::i_ok)
+                {
+                    row.append(Json::Value::null);
+                    continue;
+                }
+                switch (r.get_properties(i).get_data_type())
+                {
+                    case soci::dt_string:
+                    case soci::dt_blob:
+                        row.append(strHex(r.get<std::string>(i)));
+                        break;
+                    case soci::dt_integer:
+                        row.append(std::to_string(r.get<int>(i)));
+                        break;
+                    case soci::dt_long_long:
+                        row.append(std::to_string(r.get<long long>(i)));
+                        break;
+                    case soci::dt_unsigned_long_long:
+                        row.append(
+                            std::to_string(r.get<unsigned long long>(i)));
+                        break;
+                    case soci::dt_double:
+                        snprintf(buf, sizeof(buf), "%.17g", r.get<double>(i));
+                        row.append(std::string(buf));
+                        break;
+                    case soci::dt_date: {
+                        std::tm tm = r.get<std::tm>(i);
+                        snprintf(
+                            buf,
+                            sizeof(buf),
+                            "%04d-%02d-%02d %02d:%02d:%02d",
+                            tm.tm_year + 1900,
+                            tm.tm_mon + 1,
+                            tm.tm_mday,
+                            tm.tm_hour,
+                            tm.tm_min,
+                            tm.tm_sec);
+                        row.append(std::string(buf));
+                        break;
+                    }
+                    default:
+                        row.append(Json::Value::null);
+                        break;
+                }
+            }
+            writer.add(row);
+        }
+        rows = writer.finish();
+        tr.rollback();
+    }
+    catch (std::exception const& e)
+    {
+        JLOG(journal_.error()) << "TableSnapshot::Make " << sTable
+                               << " failed: " << e.what();
+        return fail(e.what());
+    }
+
+    out.close();
+    if (!out)
+        return fail("fail to write the file.");
+    boost::system::error_code ec;
+    fs::rename(sTmpPath, sPath, ec);
+    if (ec)
+        return fail("fail to rename the file: " + ec.message());
+
+    JLOG(journal_.info()) << "TableSnapshot::Make " << sTable << " wrote "
+                          << rows << " rows at ledger " << header_.uLedgerSeq
+                          << " to " << sPath;
+    return std::make_pair(true, "");
+}
+
+std::pair<bool, std::string>
+TableSnapshot::Open(std::string const& sPath)
+{
+    in_.open(sPath);
+    if (!in_)
+        return std::make_pair(false, "fail to open the file.");
+
+    auto ret = reader_.readHeader(header_);
+    if (!ret.first)
+        return ret;
+    if (header_.sDBType != dbType())
+        return std::make_pair(false, "the snapshot was made from another type of database.");
+
+    ret = CheckLedger();
+    if (!ret.first)
+        return ret;
+
+    if (app_.getTableStatusDB().IsExist(header_.owner, header_.sNameInDB))
+        return std::make_pair(false, "the table is already synced by this node.");
+    TxStoreDBConn conn(app_.config());
+    if (conn.GetDBConn() == nullptr)
+        return std::make_pair(false, "can't connect to the database.");
+    if (STTx2SQL::IsTableExistBySelect(
+            conn.GetDBConn(), "t_" + header_.sNameInDB))
+        return std::make_pair(false, "the table already exists in the database.");
+
+    return std::make_pair(true, "");
+}
+
+std::pair<bool, std::string>
+TableSnapshot::checkPosition(
+    Header const& header,
+    LedgerIndex validIndex,
+    std::string const& nameInDB,
+    LedgerIndex createSeq,
+    boost::optional<uint256> const& ledgerHash,
+    boost::optional<LedgerIndex> const& txnLgrSeq)
+{
+    if (validIndex == 0)
+        return std::make_pair(false, "no validated ledger.");
+    if (header.uLedgerSeq > validIndex)
+        return std::make_pair(false, "the snapshot is ahead of the validated ledger.");
+    if (nameInDB != header.sNameInDB)
+        return std::make_pair(false, "the table in the snapshot was deleted or recreated.");
+    if (header.uTxnLedgerSeq < createSeq ||
+        header.uLedgerSeq < header.uTxnLedgerSeq)
+        return std::make_pair(false, "the snapshot is older than the table.");
+
+    // the rows are checked against the trailer, the position against the
+    // chain when this node has the ledger
+    if (ledgerHash && *ledgerHash != header.uLedgerHash)
+        return std::make_pair(false, "the ledger hash in the snapshot is different from the local one.");
+
+    // with a partly applied ledger TxnLedgerSeq lags behind the entry
+    if (txnLgrSeq && header.uTxnUpdateHash.isZero() &&
+        *txnLgrSeq != header.uTxnLedgerSeq)
+        return std::make_pair(false, "the snapshot misses transactions of the table.");
+    return std::make_pair(true, "");
+}
+
+std::pair<bool, std::string>
+TableSnapshot::CheckLedger()
+{
+    auto& ledgerMaster = app_.getLedgerMaster();
+    auto const validated = ledgerMaster.getValidatedLedger();
+    if (!validated)
+        return std::make_pair(false, "no validated ledger.");
+    auto const validIndex = validated->info().seq;
+    if (isConfidential(*validated, header_.owner, header_.sTableName))
+        return std::make_pair(false, "a confidential table can't be loaded from a snapshot.");
+
+    auto const baseInfo = ledgerMaster.getTableBaseInfo(
+        validIndex, header_.owner, header_.sTableName);
+
+    boost::optional<uint256> ledgerHash;
+    boost::optional<LedgerIndex> txnLgrSeq;
+    if (auto const ledger = ledgerMaster.getLedgerBySeq(header_.uLedgerSeq))
+    {
+        ledgerHash = ledger->info().hash;
+        auto const tup = getTableEntryByNameInDB(
+            *ledger, header_.owner, header_.sNameInDB);
+        auto const pEntry = std::get<1>(tup);
+        if (pEntry != nullptr && pEntry->isFieldPresent(sfTxnLgrSeq))
+            txnLgrSeq = pEntry->getFieldU32(sfTxnLgrSeq);
+    }
+    else
+    {
+        JLOG(journal_.warn())
+            << "TableSnapshot ledger " << header_.uLedgerSeq
+            << " is not available, the snapshot position is not checked.";
+    }
+
+    return checkPosition(
+        header_,
+        validIndex,
+        to_string(baseInfo.nameInDB),
+        baseInfo.createLgrSeq,
+        ledgerHash,
+        txnLgrSeq);
+}
+
+std::pair<bool, std::string>
+TableSnapshot::CreateTable()
+{
+    auto const ledger = app_.getLedgerMaster().getValidatedLedger();
+    if (!ledger)
+        return std::make_pair(false, "no validated ledger.");
+    auto const tup =
+        getTableEntryByNameInDB(*ledger, header_.owner, header_.sNameInDB);
+    auto const pEntry = std::get<1>(tup);
+    if (pEntry == nullptr)
+        return std::make_pair(false, "can't find the table in the validated ledger.");
+
+    // the same statement the table sync would run for the T_CREATE
+    auto const pTransaction = app_.getMasterTransaction().fetch(
+        pEntry->getFieldH256(sfCreatedTxnHash));
+    if (pTransaction)
+    {
+        auto const vecTxs = app_.getMasterTransaction().getTxs(
+            *pTransaction->getSTransaction(), header_.sNameInDB);
+        for (auto const& tx : vecTxs)
+        {
+            if (tx.isFieldPresent(sfOpType) &&
+                tx.getFieldU16(sfOpType) == T_CREATE)
+                return app_.getTxStore().Dispose(
+                    tx,
+                    SyncParam{STEntry::getOperationRule(*pEntry, T_CREATE)});
+        }
+    }
+    return std::make_pair(false, "the transaction that created the table is not available on this node.");
+}
+
+std::pair<bool, std::string>
+TableSnapshot::Load(bool bAutoSync, std::size_t& rows)
+{
+    rows = 0;
+    std::string const sTable = "t_" + header_.sNameInDB;
+    bool const bSQLite = dbType() == "sqlite";
+    std::size_t const nColumns = header_.vecColumns.size();
+
+    // nothing is created from a file that doesn't match its trailer
+    auto ret = reader_.readRows(nColumns, {}, rows);
+    if (!ret.first)
+        return ret;
+    rows = 0;
+
+    std::string sql = "insert into " + sTable + " (";
+    for (std::size_t i = 0; i < nColumns; i++)
+    {
+        if (i > 0)
+            sql += ",";
+        sql += bSQLite ? "\"" + header_.vecColumns[i] + "\""
+                       : "`" + header_.vecColumns[i] + "`";
+    }
+    sql += ") values (";
+    for (std::size_t i = 0; i < nColumns; i++)
+        sql += (i > 0 ? ",:v" : ":v") + std::to_string(i);
+    sql += ")";
+
+    TxStoreDBConn conn(app_.config());
+    if (conn.GetDBConn() == nullptr)
+        return std::make_pair(false, "can't connect to the database.");
+
+    ret = CreateTable();
+    if (!ret.first)
+    {
+        app_.getTxStore().DropTable(header_.sNameInDB);
+        return ret;
+    }
+
+    std::string sErr;
+    try
+    {
+        LockedSociSession session = conn.GetDBConn()->checkoutDb();
+
+        // a table altered after it was created has other columns than the
+        // T_CREATE gives it
+        {
+            soci::row r;
+            soci::statement st =
+                (session->prepare << "select * from " + sTable + " where 1 = 0",
+                 soci::into(r));
+            st.execute(true);
+            bool bSame = r.size() == nColumns;
+            for (std::size_t i = 0; bSame && i < nColumns; i++)
+            {
+                auto const& props = r.get_properties(i);
+                bSame = props.get_name() == header_.vecColumns[i] &&
+                    props.get_data_type() == header_.vecTypes[i];
+            }
+            if (!bSame)
+                sErr = "the columns of the table changed after it was created.";
+        }
+
+        std::vector<std::vector<std::string>> values(nColumns);
+        std::vector<std::vector<soci::indicator>> indicators(nColumns);
+        std::size_t inserted = 0;
+        auto const flush = [&]() {
+            if (values[0].empty())
+                return;
+            soci::transaction tr(*session);
+            soci::statement st(*session);
+            st.alloc();
+            st.prepare(sql);
+            for (std::size_t i = 0; i < nColumns; i++)
+                st.exchange(soci::use(values[i], indicators[i]));
+            st.define_and_bind();
+            st.execute(true);
+            tr.commit();
+
+            inserted += values[0].size();
+            for (std::size_t i = 0; i < nColumns; i++)
+            {
+                values[i].clear();
+                indicators[i].clear();
+            }
+            JLOG(journal_.debug())
+                << "TableSnapshot::Load " << sTable << " " << inserted
+                << " rows loaded";
+        };
+
+        auto const onRow = [&](Json::Value const& row) -> std::string {
+            for (std::size_t i = 0; i < nColumns; i++)
+            {
+                auto const& v = row[static_cast<Json::UInt>(i)];
+                if (v.isNull())
+                {
+                    values[i].emplace_back();
+                    indicators[i].push_back(soci::i_null);
+                    continue;
+                }
+                if (!hexCoded(header_.vecTypes[i]))
+                {
+                    values[i].push_back(v.asString());
+                }
+                else if (auto const blob = strUnHex(v.asString()))
+                {
+                    values[i].emplace_back(blob->begin(), blob->end());
+                }
+                else
+                {
+                    return "bad value in column " + header_.vecColumns[i] + ".";
+                }
+                indicators[i].push_back(soci::i_ok);
+            }
+            if (values[0].size() >= batchRows)
+                flush();
+            return "";
+        };
+
+        // the file is checked again while it is inserted, it may have
+        // changed since the first pass
+        if (sErr.empty())
+        {
+            ret = reader_.readRows(nColumns, onRow, rows);
+            if (ret.first)
+                flush();
+            else
+                sErr = ret.second;
+        }
+    }
+    catch (std::exception const& e)
+    {
+        sErr = e.what();
+    }
+
+    if (!sErr.empty())
+    {
+        JLOG(journal_.error()) << "TableSnapshot::Load " << sTable
+                               << " failed: " << sErr;
+        app_.getTxStore().DropTable(header_.sNameInDB);
+        return std::make_pair(false, sErr);
+    }
+
+    // from here the table sync goes on as if it had synced the rows itself
+    auto& statusDB = app_.getTableStatusDB();
+    auto chainId = TableSyncUtil::GetChainId(
+        app_.getLedgerMaster().getValidatedLedger().get());
+    if (!statusDB.InsertSnycDB(
+            header_.sTableName,
+            header_.sNameInDB,
+            to_string(header_.owner),
+            header_.uLedgerSeq,
+            header_.uLedgerHash,
+            bAutoSync,
+            header_.sTxnLedgerTime,
+            chainId))
+    {
+        app_.getTxStore().DropTable(header_.sNameInDB);
+        return std::make_pair(false, "fail to insert into SyncTableState.");
+    }
+    statusDB.UpdateSyncDB(
+        to_string(header_.owner),
+        header_.sNameInDB,
+        to_string(header_.uTxnLedgerHash),
+        std::to_string(header_.uTxnLedgerSeq),
+        to_string(header_.uLedgerHash),
+        std::to_string(header_.uLedgerSeq),
+        header_.uTxnUpdateHash.isZero() ? std::string()
+                                        : to_string(header_.uTxnUpdateHash),
+        header_.sTxnLedgerTime,
+        "");
+
+    JLOG(journal_.info()) << "TableSnapshot::Load " << sTable << " loaded "
+                          << rows << " rows, sync resumes from ledger "
+                          << header_.uLedgerSeq;
+    return std::make_pair(true, "");
+}
+
+}  // namespace ripple
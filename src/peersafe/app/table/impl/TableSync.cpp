@@ -23,13 +23,16 @@
 #include <ripple/core/JobQueue.h>
 #include <ripple/core/ConfigSections.h>
 #include <ripple/overlay/Overlay.h>
+#include <ripple/protocol/digest.h>
 #include <boost/optional/optional_io.hpp>
 #include <ripple/core/DatabaseCon.h>
+#include <ripple/json/Arena.h>
 #include <ripple/json/json_reader.h>
 #include <ripple/app/misc/NetworkOPs.h>
 #include <peersafe/protocol/STEntry.h>
 #include <peersafe/app/table/TableSync.h>
 #include <peersafe/app/table/TableStatusDB.h>
+#include <peersafe/app/table/TableSnapshot.h>
 #include <peersafe/app/sql/STTx2SQL.h>
 #include <peersafe/app/sql/TxStore.h>
 #include <peersafe/protocol/TableDefines.h>
@@ -42,6 +45,10 @@ namespace ripple {
 
 //int32_t const SYNC_JUMP_TIME = 120;
 
+// Bounds on the work and the size of one TMTableRange
+LedgerIndex constexpr TABLE_RANGE_MAX_LEDGERS = 4096;
+std::size_t constexpr TABLE_RANGE_MAX_BYTES = 16 * 1024 * 1024;
+
 TableSync::TableSync(Schema& app, Config& cfg, beast::Journal journal)
     : app_(app)
     , journal_(journal)
@@ -84,6 +91,16 @@ TableSync::TableSync(Schema& app, Config& cfg, beast::Journal journal)
 	}
 	else
 		bPressSwitchOn_ = false;
+
+    rangeLedgers_ = 1024;
+    rangePipeline_ = 4;
+    auto const& table_sync_section = cfg_.section(ConfigSection::tableSync());
+    get_if_exists(table_sync_section, "range_ledgers", rangeLedgers_);
+    get_if_exists(table_sync_section, "range_pipeline", rangePipeline_);
+    // ranges end on the 256th ledgers replies are checked against
+    rangeLedgers_ = std::min(
+        std::max<LedgerIndex>((rangeLedgers_ + 255) & ~255, 256),
+        TABLE_RANGE_MAX_LEDGERS);
 }
 
 TableSync::~TableSync()
@@ -435,6 +452,12 @@ void TableSync::SeekTableTxLedger(TableSyncItem::BaseInfo &stItemInfo)
 
 void TableSync::SeekTableTxLedger(std::shared_ptr <protocol::TMGetTable> const& m, std::weak_ptr<Peer> const& wPeer)
 {
+    if (m->has_bulk() && m->bulk())
+    {
+        SeekTableRange(m, wPeer);
+        return;
+    }
+
     bool bGetLost = m->getlost();
 
     LedgerIndex checkIndex = m->ledgerseq();
@@ -509,7 +532,157 @@ void TableSync::SeekTableTxLedger(std::shared_ptr <protocol::TMGetTable> const&
         }
     }
 }
-bool TableSync::SendSyncRequest(AccountID accountID, std::string sNameInDB, LedgerIndex iStartSeq, uint256 iStartHash, LedgerIndex iCheckSeq, uint256 iCheckHash, LedgerIndex iStopSeq, bool bGetLost, std::shared_ptr <TableSyncItem> pItem)
+void TableSync::SeekTableRange(std::shared_ptr <protocol::TMGetTable> const& m, std::weak_ptr<Peer> const& wPeer)
+{
+    LedgerIndex const startIndex = m->ledgerseq();
+    TableSyncItem::SyncTargetType eTargetType = (TableSyncItem::SyncTargetType)(m->etargettype());
+    std::string sNickName = m->has_nickname() ? m->nickname() : "";
+
+    auto startLedger = app_.getLedgerMaster().getLedgerBySeq(startIndex);
+    if (!startLedger) return;
+    if (m->has_ledgerhash())
+    {
+        uint256 startHash(m->ledgerhash());
+        if (startHash.isNonZero() && startHash != startLedger->info().hash) return;
+    }
+
+    auto const ownerID = ripple::parseBase58<AccountID>(m->account());
+    if (!ownerID) return;
+
+    LedgerIndex lastTxChangeIndex = m->ledgercheckseq();
+    uint256 lastTxChangeHash(m->ledgercheckhash());
+    if (!m->has_ledgercheckhash())
+    {
+        //a window ahead of the requester, continue the tx chain from the table entry
+        auto tup = getTableEntryByNameInDB(*startLedger, *ownerID, m->nameindb());
+        auto pEntry = std::get<1>(tup);
+        lastTxChangeIndex = pEntry ? pEntry->getFieldU32(sfTxnLgrSeq) : 0;
+        lastTxChangeHash = pEntry ? pEntry->getFieldH256(sfTxnLedgerHash) : uint256();
+    }
+
+    LedgerIndex stopIndex = m->ledgerstopseq();
+    if (stopIndex == 0) stopIndex = getCandidateLedger(startIndex + 1);
+    stopIndex = std::min(stopIndex, startIndex + TABLE_RANGE_MAX_LEDGERS);
+
+    LedgerIndex iLastFindSeq = startIndex;
+    uint256 uLastFindHash = startLedger->info().hash;
+    std::vector<protocol::TMTableData> replies;
+    std::size_t bytes = 0;
+
+    auto addEnd = [&](std::shared_ptr<Ledger const> const& ledger) {
+        auto time = ledger->info().closeTime.time_since_epoch().count();
+        replies.emplace_back();
+        MakeSeekEndReply(ledger->info().seq, ledger->info().hash, iLastFindSeq, uLastFindHash, lastTxChangeHash, m->account(), m->nameindb(), sNickName, time, eTargetType, replies.back());
+        replies.back().set_seekstop(false);
+        iLastFindSeq = ledger->info().seq;
+        uLastFindHash = ledger->info().hash;
+    };
+    auto addData = [&](std::shared_ptr<Ledger const> const& ledger, STObject* pEntry) {
+        auto time = ledger->info().closeTime.time_since_epoch().count();
+        auto txnLgrHash = pEntry->getFieldH256(sfTxnLedgerHash);
+        replies.emplace_back();
+        if (!MakeTableDataReply(m->account(), false, time, sNickName, eTargetType, ledger->info().seq, txnLgrHash, lastTxChangeIndex, lastTxChangeHash, m->nameindb(), replies.back()))
+        {
+            replies.pop_back();
+            return false;
+        }
+        for (auto const& node : replies.back().txnodes())
+            bytes += node.nodedata().size();
+        iLastFindSeq = ledger->info().seq;
+        uLastFindHash = ledger->info().hash;
+        lastTxChangeIndex = ledger->info().seq;
+        lastTxChangeHash = txnLgrHash;
+        return true;
+    };
+
+    bool bEnd = false;
+    LedgerIndex i = startIndex + 1;
+    while (i <= stopIndex && !bEnd)
+    {
+        LedgerIndex const blockEnd = std::min(getCandidateLedger(i), stopIndex);
+
+        //one reply covers a block the table did not change in
+        if (app_.getLedgerMaster().haveLedger(i, blockEnd))
+        {
+            auto ledger = app_.getLedgerMaster().getLedgerBySeq(blockEnd);
+            if (ledger)
+            {
+                auto tup = getTableEntryByNameInDB(*ledger, *ownerID, m->nameindb());
+                auto pEntry = std::get<1>(tup);
+                if (pEntry && !isTableSLEChanged(pEntry, lastTxChangeIndex, false))
+                {
+                    addEnd(ledger);
+                    i = blockEnd + 1;
+                    continue;
+                }
+            }
+        }
+
+        for (; i <= blockEnd; i++)
+        {
+            auto ledger = app_.getLedgerMaster().getLedgerBySeq(i);
+            if (!ledger)
+            {
+                bEnd = true;
+                break;
+            }
+            auto tup = getTableEntryByNameInDB(*ledger, *ownerID, m->nameindb());
+            auto pEntry = std::get<1>(tup);
+
+            if (isTableSLEChanged(pEntry, lastTxChangeIndex, true))
+            {
+                if (!addData(ledger, pEntry) || bytes > TABLE_RANGE_MAX_BYTES)
+                {
+                    bEnd = true;
+                    break;
+                }
+            }
+            else if (pEntry == nullptr)
+            {
+                //table dropped
+                addEnd(ledger);
+                bEnd = true;
+                break;
+            }
+            else if (i == blockEnd)
+            {
+                addEnd(ledger);
+            }
+        }
+    }
+
+    if (replies.empty())
+        return;
+    replies.back().set_seekstop(true);
+
+    protocol::TMTableRange range;
+    range.set_nameindb(m->nameindb());
+    range.set_account(m->account());
+    range.set_firstseq(startIndex);
+    range.set_lastseq(replies.back().ledgerseq());
+    range.set_etargettype(eTargetType);
+    range.set_nickname(sNickName);
+    range.set_schemaid(app_.schemaId().begin(), uint256::size());
+
+    sha512_half_hasher checksum;
+    for (auto const& data : replies)
+    {
+        auto s = range.add_replies();
+        data.SerializeToString(s);
+        checksum(s->data(), s->size());
+    }
+    auto const sum = static_cast<uint256>(checksum);
+    range.set_checksum(sum.begin(), sum.size());
+
+    JLOG(journal_.debug()) << "SeekTableRange nameInDB " << m->nameindb()
+        << " ledgers " << startIndex + 1 << "-" << range.lastseq()
+        << " replies " << replies.size();
+
+    if (auto peer = wPeer.lock())
+        peer->send(std::make_shared<Message>(range, protocol::mtTABLE_RANGE));
+}
+
+bool TableSync::SendSyncRequest(AccountID accountID, std::string sNameInDB, LedgerIndex iStartSeq, uint256 iStartHash, LedgerIndex iCheckSeq, uint256 iCheckHash, LedgerIndex iStopSeq, bool bGetLost, std::shared_ptr <TableSyncItem> pItem, bool bBulk)
 {
     protocol::TMGetTable tmGT;
     tmGT.set_account(to_string(accountID));
@@ -523,11 +696,57 @@ bool TableSync::SendSyncRequest(AccountID accountID, std::string sNameInDB, Ledg
 	tmGT.set_etargettype(pItem->TargetType());
     tmGT.set_nickname(pItem->GetNickName());
 	tmGT.set_schemaid(app_.schemaId().begin(),uint256::size());
+    if (bBulk)
+        tmGT.set_bulk(true);
 
     pItem->SendTableMessage(std::make_shared<Message>(tmGT, protocol::mtGET_TABLE));
     return true;
 }
 
+void TableSync::SendRangeRequests(TableSyncItem::BaseInfo const& stItem, std::shared_ptr <TableSyncItem> pItem)
+{
+    LedgerIndex const validIndex = app_.getLedgerMaster().getValidLedgerIndex();
+    LedgerIndex iStart = stItem.u32SeqLedger;
+
+    pItem->SweepRangeRequests(iStart);
+    for (std::size_t slot = 0; slot < rangePipeline_ && iStart < validIndex; slot++)
+    {
+        //windows end on multiples of rangeLedgers_, so a window keeps its
+        //end wherever in it the sync point is
+        LedgerIndex iStop = std::min((iStart / rangeLedgers_ + 1) * rangeLedgers_, validIndex);
+        if (pItem->AddRangeRequest(iStop))
+        {
+            protocol::TMGetTable tmGT;
+            tmGT.set_account(to_string(stItem.accountID));
+            tmGT.set_nameindb(stItem.sTableNameInDB);
+            tmGT.set_ledgerseq(iStart);
+            tmGT.set_ledgerstopseq(iStop);
+            if (slot == 0)
+            {
+                tmGT.set_ledgerhash(stItem.uHash.begin(), stItem.uHash.size());
+                tmGT.set_ledgercheckseq(stItem.uTxSeq);
+                tmGT.set_ledgercheckhash(stItem.uTxHash.begin(), stItem.uTxHash.size());
+            }
+            else
+            {
+                //the peer continues the tx chain from its own ledger
+                tmGT.set_ledgercheckseq(0);
+            }
+            tmGT.set_getlost(false);
+            tmGT.set_etargettype(pItem->TargetType());
+            tmGT.set_nickname(pItem->GetNickName());
+            tmGT.set_schemaid(app_.schemaId().begin(), uint256::size());
+            tmGT.set_bulk(true);
+
+            pItem->SendTableMessage(std::make_shared<Message>(tmGT, protocol::mtGET_TABLE), slot);
+
+            JLOG(journal_.trace()) << "SendRangeRequests sTableName " << stItem.sTableName
+                << " ledgers " << iStart + 1 << "-" << iStop << " slot " << slot;
+        }
+        iStart = iStop;
+    }
+}
+
 bool TableSync::InsertSnycDB(std::string TableName, std::string TableNameInDB, std::string Owner,LedgerIndex LedgerSeq, uint256 LedgerHash, bool IsAutoSync, std::string time,uint256 chainId)
 {
     if (!app_.checkGlobalConnection())
@@ -1057,6 +1276,8 @@ TableSync::SendData(
         if (preLedgerSeq == iCurSeq && preLedgerHash == iCurHash)
         {
             pItem->PushDataToWholeDataQueue(tmp);
+            //ranges of later windows may already be waiting
+            pItem->TransBlock2Whole(ledgerSeq);
             pItem->TryOperateSQL();
         }
         else
@@ -1088,6 +1309,15 @@ bool TableSync::GotSyncReply(std::shared_ptr <protocol::TMTableData> const& m, s
     pItem->GetSyncLedger(iCurSeq, iCurHash);
     if (ledgerSeq <= iCurSeq)  return false;
 
+    //a peer without bulk support answers a window ahead of us from tx ledger 0, it never links up
+    if (data.txnodes().size() > 0 && data.lastledgerseq() == 0)
+    {
+        LedgerIndex iTxSeq;
+        uint256 iTxHash;
+        pItem->GetSyncTxLedger(iTxSeq, iTxHash);
+        if (iTxSeq != 0)  return false;
+    }
+
     auto peer = wPeer.lock();
     if (peer != NULL)
     {
@@ -1134,6 +1364,36 @@ bool TableSync::GotSyncReply(std::shared_ptr <protocol::TMTableData> const& m, s
     return true;
 }
 
+bool TableSync::GotSyncRange(std::shared_ptr <protocol::TMTableRange> const& m, std::weak_ptr<Peer> const& wPeer)
+{
+    sha512_half_hasher checksum;
+    for (auto const& s : m->replies())
+        checksum(s.data(), s.size());
+    if (static_cast<uint256>(checksum) != uint256(m->checksum()))
+    {
+        JLOG(journal_.warn()) << "GotSyncRange checksum mismatch, nameInDB " << m->nameindb()
+            << " ledgers " << m->firstseq() + 1 << "-" << m->lastseq();
+        return false;
+    }
+
+    auto const accountID = ripple::parseBase58<AccountID>(m->account());
+    if (!accountID)  return false;
+
+    std::string sNickName = m->has_nickname() ? m->nickname() : "";
+    auto pItem = GetRightItem(*accountID, m->nameindb(), sNickName, (TableSyncItem::SyncTargetType)m->etargettype());
+    if (pItem == NULL)   return true;
+    pItem->OnRangeReply(m->firstseq(), m->lastseq());
+
+    for (auto const& s : m->replies())
+    {
+        auto data = std::make_shared<protocol::TMTableData>();
+        if (!data->ParseFromString(s) || data->nameindb() != m->nameindb() || data->account() != m->account())
+            return false;
+        GotSyncReply(data, wPeer);
+    }
+    return true;
+}
+
 bool TableSync::ReStartOneTable(AccountID accountID, std::string sNameInDB,std::string sTableName, bool bDrop, bool bCommit)
 {
     auto pItem = GetRightItem(accountID, sNameInDB, "", TableSyncItem::SyncTarget_db);
@@ -1213,6 +1473,12 @@ bool TableSync::IsNeedSyn(std::shared_ptr <TableSyncItem> pItem)
     }
     
     if (pItem->GetSyncState() == TableSyncItem::SYNC_STOP)              return false;
+
+    {
+        std::lock_guard lock(mutexSnapshot_);
+        if (setLoadingSnapshot_.count(to_string(pItem->GetAccount()) + pItem->GetTableName()) > 0)
+            return false;
+    }
        
     return true;
 }
@@ -1270,7 +1536,11 @@ void TableSync::TableSyncThread()
     while (iter != tmList.end())
     {
 		auto pItem = *iter;
-        if (!IsNeedSyn(pItem))   continue;
+        if (!IsNeedSyn(pItem))
+        {
+            iter++;
+            continue;
+        }
 
         pItem->GetBaseInfo(stItem);         
         switch (stItem.eState)
@@ -1456,13 +1726,20 @@ void TableSync::TableSyncThread()
             }            
             else if (bRemoteSync_)
             {
-                LedgerIndex refIndex = getCandidateLedger(stItem.u32SeqLedger+1);
-                refIndex = std::min(refIndex, app_.getLedgerMaster().getValidLedgerIndex());
-                
-                if (SendSyncRequest(stItem.accountID, stItem.sTableNameInDB, stItem.u32SeqLedger, stItem.uHash, stItem.uTxSeq, stItem.uTxHash, refIndex, false, pItem))
+                if (rangePipeline_ > 0)
                 {
-                    JLOG(journal_.trace()) <<
-                        "In SYNC_BLOCK_STOP,SendSyncRequest sTableName " << stItem.sTableName << " LedgerSeq " << stItem.u32SeqLedger;
+                    SendRangeRequests(stItem, pItem);
+                }
+                else
+                {
+                    LedgerIndex refIndex = getCandidateLedger(stItem.u32SeqLedger+1);
+                    refIndex = std::min(refIndex, app_.getLedgerMaster().getValidLedgerIndex());
+
+                    if (SendSyncRequest(stItem.accountID, stItem.sTableNameInDB, stItem.u32SeqLedger, stItem.uHash, stItem.uTxSeq, stItem.uTxHash, refIndex, false, pItem))
+                    {
+                        JLOG(journal_.trace()) <<
+                            "In SYNC_BLOCK_STOP,SendSyncRequest sTableName " << stItem.sTableName << " LedgerSeq " << stItem.u32SeqLedger;
+                    }
                 }
 
                 pItem->UpdateDataTm();
@@ -1494,7 +1771,7 @@ void TableSync::TableSyncThread()
                     //{
                         //stRange.u32SeqLedger/0;
                     //}
-                    SendSyncRequest(stItem.accountID, stItem.sTableNameInDB, stRange.u32SeqLedger, stRange.uHash, stRange.uTxSeq, stRange.uTxHash, stRange.uStopSeq, bGetLost, pItem);
+                    SendSyncRequest(stItem.accountID, stItem.sTableNameInDB, stRange.u32SeqLedger, stRange.uHash, stRange.uTxSeq, stRange.uTxHash, stRange.uStopSeq, bGetLost, pItem, rangePipeline_ > 0);
                 }                
                 pItem->UpdateDataTm();
             }
@@ -2017,12 +2294,21 @@ void TableSync::Sweep()
     checkSkipNode_.sweep();
 }
 
-std::pair<bool, std::string> TableSync::StartDumpTable(std::string sPara, std::string sPath, TableDumpItem::funDumpCB funCB)
+std::pair<bool, std::string> TableSync::StartDumpTable(std::string sPara, std::string sPath, TableDumpItem::funDumpCB funCB, std::string sFilter)
 {
+    // The dump task outlives the t_dump call, keep it out of the request arena
+    Json::HeapScope heap;
+
     auto ret = CreateOneItem(TableSyncItem::SyncTarget_dump, sPara);
     if (ret.first != NULL)
     {
         std::shared_ptr<TableDumpItem> pDumpItem = std::static_pointer_cast<TableDumpItem>(ret.first);
+        if (!sFilter.empty())
+        {
+            auto retFilter = pDumpItem->SetDumpFilter(sFilter);
+            if (!retFilter.first)
+                return std::make_pair(false, retFilter.second);
+        }
         auto retPair = pDumpItem->SetDumpPara(sPath, funCB);
 		if (!retPair.first)   
             return std::make_pair(false, retPair.second);
@@ -2110,6 +2396,10 @@ std::pair<bool, std::string> TableSync::StartAuditTable(std::string sPara, std::
         }
     }
 
+    // The audit task and its check query outlive the t_audit call, keep
+    // them out of the request arena
+    Json::HeapScope heap;
+
     auto ret = CreateOneItem(TableSyncItem::SyncTarget_audit, sPara);
     if (ret.first != NULL)
     {
@@ -2169,6 +2459,74 @@ bool TableSync::GetCurrentAuditPos(std::string sNickName, TableSyncItem::taskInf
     return true;
 }
 
+std::pair<bool, std::string> TableSync::MakeTableSnapshot(AccountID accountID, std::string sTableName, std::string sPath)
+{
+    if (!app_.checkGlobalConnection())
+        return std::make_pair(false, "can't connect to the database.");
+
+    auto validIndex = app_.getLedgerMaster().getValidLedgerIndex();
+    if (validIndex == 0)
+        return std::make_pair(false, "no validated ledger.");
+    auto stBaseInfo = app_.getLedgerMaster().getTableBaseInfo(validIndex, accountID, sTableName);
+    if (stBaseInfo.nameInDB.isZero())
+        return std::make_pair(false, "can't find the table in the validated ledger.");
+    if (!app_.getTableStatusDB().IsExist(accountID, to_string(stBaseInfo.nameInDB)))
+        return std::make_pair(false, "the table is not synced by this node.");
+    auto ledger = app_.getLedgerMaster().getValidatedLedger();
+    if (ledger && isConfidential(*ledger, accountID, sTableName))
+        return std::make_pair(false, "a confidential table can't be written to a snapshot.");
+
+    auto pSnapshot = std::make_shared<TableSnapshot>(app_, journal_);
+    app_.getJobQueue().addJob(jtTABLE_SNAPSHOT, "tableSnapshot", [this, pSnapshot, accountID, sTableName, sPath](Job&) {
+        auto ret = pSnapshot->Make(accountID, sTableName, sPath);
+        if (!ret.first)
+            JLOG(journal_.error()) << "MakeTableSnapshot " << sTableName << " failed: " << ret.second;
+    }, app_.doJobCounter());
+
+    return std::make_pair(true, "");
+}
+
+std::pair<bool, std::string> TableSync::LoadTableSnapshot(std::string sPath)
+{
+    if (!app_.checkGlobalConnection())
+        return std::make_pair(false, "can't connect to the database.");
+
+    auto pSnapshot = std::make_shared<TableSnapshot>(app_, journal_);
+    auto ret = pSnapshot->Open(sPath);
+    if (!ret.first)
+        return ret;
+
+    auto const& header = pSnapshot->header();
+    std::string sKey = to_string(header.owner) + header.sTableName;
+    {
+        std::lock_guard lock(mutexSnapshot_);
+        if (!setLoadingSnapshot_.insert(sKey).second)
+            return std::make_pair(false, "a snapshot of the table is being loaded.");
+    }
+    // the sync thread may have started the table before it was marked
+    if (app_.getTableStatusDB().IsExist(header.owner, header.sNameInDB))
+    {
+        std::lock_guard lock(mutexSnapshot_);
+        setLoadingSnapshot_.erase(sKey);
+        return std::make_pair(false, "the table is already synced by this node.");
+    }
+
+    bool bAutoSync = setTableInCfg_.count(sKey) == 0;
+    app_.getJobQueue().addJob(jtTABLE_SNAPSHOT, "tableSnapshotLoad", [this, pSnapshot, sKey, bAutoSync](Job&) {
+        std::size_t rows = 0;
+        auto ret = pSnapshot->Load(bAutoSync, rows);
+        if (!ret.first)
+            JLOG(journal_.error()) << "LoadTableSnapshot " << pSnapshot->header().sTableName << " failed: " << ret.second;
+        {
+            std::lock_guard lock(mutexSnapshot_);
+            setLoadingSnapshot_.erase(sKey);
+        }
+        TryTableSync();
+    }, app_.doJobCounter());
+
+    return std::make_pair(true, "");
+}
+
 Json::Value
 TableSync::SyncInfo(std::string const& nameInDB)
 {
@@ -46,6 +46,9 @@
 using namespace std::chrono;
 auto constexpr TABLE_DATA_OVERTM = 30s;
 auto constexpr LEDGER_DATA_OVERTM = 30s;
+// Bounds on how far the sync point may lag behind a run of empty ledgers
+auto constexpr SYNC_CHECKPOINT_LEDGERS = 1024;
+auto constexpr SYNC_CHECKPOINT_INTERVAL = 5s;
 auto const TXID_LENGTH = 64;
 
 #define OPTYPELEN 6
@@ -71,6 +74,7 @@ TableSyncItem::TableSyncItem(Schema& app, beast::Journal journal, Config& cfg, S
     sNickName_            = "";
     uCreateLedgerSequence_ = 0;
 	deleted_			  = false;
+    bStageCacheOps_       = false;
 }
 
 TableSyncItem::cond const & TableSyncItem::GetCondition()
@@ -167,6 +171,8 @@ void TableSyncItem::SetPara(std::string sNameInDB,LedgerIndex iSeq, uint256 hash
 
     uTxHash_ = Txnhash;
     uTxDBUpdateHash_ = TxnUpdateHash;    
+
+    TrackColumnCache();
 }
 
 ConnectionUnit&
@@ -234,6 +240,10 @@ void TableSyncItem::ReSetContex()
         std::lock_guard lock(mutexWaitCheckQueue_);
         aWaitCheckData_.clear();
     }
+    {
+        std::lock_guard lock(mutexInfo_);
+        mapRangeRequests_.clear();
+    }
 }
 
 void TableSyncItem::ReSetContexAfterDrop()
@@ -257,36 +267,12 @@ void TableSyncItem::SetIsDataFromLocal(bool bLocal)
 }
 void TableSyncItem::PushDataByOrder(std::list <sqldata_type> &aData, sqldata_type &sqlData)
 {
-    if (aData.size() == 0)
-    {
-        aData.push_back(sqlData);
-        return;
-    }
-    else if (sqlData.first > aData.rbegin()->first)
-    {
-        aData.push_back(sqlData);
-        return;
-    }
-    else
-    {
-        if (aData.size() == 1)
-        {
-            aData.push_front(sqlData);
-            return;
-        }
-        else
-        {
-            for (auto it = aData.begin(); it != aData.end(); it++)
-            {
-                if (sqlData.first == it->first)  return;
-                else if (sqlData.first > it->first)
-                {
-                    aData.insert(it++, sqlData);
-                    return;
-                }
-            }
-        }
-    }
+    auto it = std::find_if(aData.begin(), aData.end(),
+        [&sqlData](sqldata_type const& item) {
+        return item.first >= sqlData.first;
+    });
+    if (it != aData.end() && it->first == sqlData.first)  return;
+    aData.insert(it, sqlData);
 }
 
 void TableSyncItem::DealWithWaitCheckQueue(std::function<bool (sqldata_type const&)> f)
@@ -599,6 +585,67 @@ void TableSyncItem::SendTableMessage(Message::pointer const& m)
         peer->send(m);
 }
 
+void TableSyncItem::SendTableMessage(Message::pointer const& m, std::size_t slot)
+{
+    if (slot == 0)
+    {
+        SendTableMessage(m);
+        return;
+    }
+
+    std::vector<std::shared_ptr<Peer>> peers;
+    for (auto const& peer : app_.peerManager().getActivePeers())
+    {
+        auto addr = peer->getRemoteAddress();
+        if (!IsInFailList(addr))
+            peers.push_back(peer);
+    }
+    if (peers.empty())
+    {
+        SendTableMessage(m);
+        return;
+    }
+
+    auto it = std::find_if(peers.begin(), peers.end(),
+        [this](std::shared_ptr<Peer> const& peer) {
+        return peer->getRemoteAddress() == uPeerAddr_;
+    });
+    std::size_t base = it != peers.end() ? it - peers.begin() : 0;
+    peers[(base + slot) % peers.size()]->send(m);
+}
+
+bool TableSyncItem::AddRangeRequest(LedgerIndex iStopSeq)
+{
+    std::lock_guard lock(mutexInfo_);
+    return mapRangeRequests_.emplace(iStopSeq, steady_clock::now()).second;
+}
+
+void TableSyncItem::SweepRangeRequests(LedgerIndex iCurSeq)
+{
+    std::lock_guard lock(mutexInfo_);
+    auto const now = steady_clock::now();
+    for (auto it = mapRangeRequests_.begin(); it != mapRangeRequests_.end();)
+    {
+        if (it->first <= iCurSeq || now - it->second > TABLE_DATA_OVERTM)
+            it = mapRangeRequests_.erase(it);
+        else
+            ++it;
+    }
+}
+
+void TableSyncItem::OnRangeReply(LedgerIndex iFirstSeq, LedgerIndex iLastSeq)
+{
+    if (iLastSeq <= iFirstSeq)  return;
+
+    std::lock_guard lock(mutexInfo_);
+    //the window holding the reply, it may end after iLastSeq if the peer cut the range short
+    auto first = mapRangeRequests_.upper_bound(iFirstSeq);
+    auto last = mapRangeRequests_.lower_bound(iLastSeq);
+    if (last != mapRangeRequests_.end())
+        ++last;
+    mapRangeRequests_.erase(first, last);
+}
+
 TableSyncItem::LedgerSyncState TableSyncItem::GetCheckLedgerState()
 {
     std::lock_guard lock(mutexInfo_);
@@ -622,11 +669,19 @@ TableSyncItem::SyncTargetType TableSyncItem::TargetType()
 void  TableSyncItem::SetTableNameInDB(uint160 NameInDB)
 {
     sTableNameInDB_ = to_string(NameInDB);
+    TrackColumnCache();
 }
 
 void  TableSyncItem::SetTableNameInDB(std::string sNameInDB)
 {
     sTableNameInDB_ = sNameInDB;
+    TrackColumnCache();
+}
+
+void TableSyncItem::TrackColumnCache()
+{
+    if (eSyncTargetType_ == SyncTarget_db)
+        app_.getTableColumnCache().track(accountID_, sTableName_, sTableNameInDB_);
 }
 
 void TableSyncItem::TryOperateSQL()
@@ -949,6 +1004,8 @@ TableSyncItem::DealTranCommonTx(
 		if (ret.first)
 		{
 			JLOG(journal_.trace()) << "Dispose success";
+            if (bStageCacheOps_)
+                aCacheOps_.push_back(TableColumnCache::makeOp(tx, param));
 		}
         else
         {
@@ -960,6 +1017,7 @@ TableSyncItem::DealTranCommonTx(
 	{
 		if (T_DROP == op_type)
 		{
+			app_.getTableColumnCache().erase(sTableNameInDB_);
 			this->ReSetContexAfterDrop();
 		}
 		else if (T_RENAME == op_type)
@@ -970,6 +1028,7 @@ TableSyncItem::DealTranCommonTx(
 				auto newTableName = strCopy(tables[0].getFieldVL(sfTableNewName));
 				sTableName_ = newTableName;
 				getTableStatusDB().RenameRecord(accountID_, sTableNameInDB_, newTableName);
+				TrackColumnCache();
 			}
 		}
 	}
@@ -1026,8 +1085,113 @@ TableSyncItem::fetchLedgerTxSlices(const protocol::TMTableData& tableData)
     return vecTxSlices;
 }
 
+std::vector<STTx>
+TableSyncItem::PrepareTx(STTx const& tx, std::uint32_t seq)
+{
+    std::vector<STTx> vecTxs = app_.getMasterTransaction().getTxs(
+        tx, sTableNameInDB_, nullptr, seq);
+    TryDecryptRaw(vecTxs);
+    return vecTxs;
+}
+
+void
+TableSyncItem::PrepareLedgerData(
+    const std::vector<protocol::TMTableData>& aData,
+    std::vector<std::vector<std::vector<std::shared_ptr<STTx>>>>& ledgerSlices,
+    std::map<STTx const*, std::vector<STTx>>& prepared)
+{
+    auto& jobQueue = app_.getJobQueue();
+
+    ledgerSlices.resize(aData.size());
+    jobQueue.parallelFor(
+        jtTABLE_PREPARE,
+        "tablePrepare",
+        aData.size(),
+        [&](std::size_t i) {
+            if (aData[i].txnodes().size() > 0)
+                ledgerSlices[i] = fetchLedgerTxSlices(aData[i]);
+        },
+        app_.doJobCounter());
+
+    // The entries are created up front, so the workers only fill them in
+    std::vector<std::tuple<STTx const*, std::uint32_t, std::vector<STTx>*>>
+        work;
+    for (std::size_t i = 0; i < aData.size(); ++i)
+    {
+        for (auto const& slice : ledgerSlices[i])
+        {
+            for (auto const& pTx : slice)
+                work.emplace_back(
+                    pTx.get(), aData[i].ledgerseq(), &prepared[pTx.get()]);
+        }
+    }
+
+    auto prepare = [&](std::size_t i) {
+        auto const& [tx, seq, vecTxs] = work[i];
+        *vecTxs = PrepareTx(*tx, seq);
+    };
+
+    // The key in a card is used by one thread at a time
+    if (!tokenProcObj_.isValidate || tokenProcObj_.concurrentDecrypt())
+    {
+        jobQueue.parallelFor(
+            jtTABLE_PREPARE,
+            "tablePrepare",
+            work.size(),
+            prepare,
+            app_.doJobCounter());
+    }
+    else
+    {
+        for (std::size_t i = 0; i < work.size(); ++i)
+            prepare(i);
+    }
+}
+
 bool TableSyncItem::DealWithEveryLedgerData(const std::vector<protocol::TMTableData>& aData)
 {
+    // An empty ledger only moves the sync point forward, so the status
+    // updates of a run of them are coalesced: the last one is written before
+    // a ledger with transactions, at the end of the reply and at least every
+    // SYNC_CHECKPOINT_LEDGERS ledgers or SYNC_CHECKPOINT_INTERVAL. After a
+    // crash the sync resumes from the last written one and goes over the
+    // empty ledgers after it again, which doesn't touch the table.
+    std::string checkpointHash;
+    std::string checkpointSeq;
+    int checkpointLedgers = 0;
+    auto checkpointStart = steady_clock::now();
+
+    // Parsing, expanding and decrypting the transactions needs no database,
+    // so it is done for the whole reply up front, spread over the job
+    // queue. Disposing them below stays in ledger and transaction order.
+    std::vector<std::vector<std::vector<std::shared_ptr<STTx>>>> ledgerSlices;
+    std::map<STTx const*, std::vector<STTx>> prepared;
+    auto const preparedNameInDB = sTableNameInDB_;
+    PrepareLedgerData(aData, ledgerSlices, prepared);
+
+    auto flushCheckpoint = [&]() {
+        if (checkpointLedgers == 0)
+            return true;
+        checkpointLedgers = 0;
+
+        if (getTableStatusDB().GetDatabaseConn() == nullptr)
+        {
+            for (int countTry = 0; countTry <= MAX_CONN_RETRY_COUNT; countTry++)
+            {
+                if (getTableStatusDB().GetDatabaseConn() == nullptr)
+                    OnConnectionError(countTry < MAX_CONN_RETRY_COUNT);
+                else
+                    break;
+            }
+            if (getTableStatusDB().GetDatabaseConn() == nullptr)
+                return false;
+        }
+
+        std::string PreviousCommit;
+        soci_ret ret = getTableStatusDB().UpdateSyncDB(to_string(accountID_), sTableNameInDB_, checkpointHash, checkpointSeq, PreviousCommit);
+        return ret != soci_exception;
+    };
+
     for (auto iter = aData.begin(); iter != aData.end(); iter++)
     {
         std::string LedgerHash = to_string(uint256(iter->ledgerhash()));
@@ -1041,38 +1205,38 @@ bool TableSyncItem::DealWithEveryLedgerData(const std::vector<protocol::TMTableD
         if (checkRet == CHECK_JUMP)     continue;
         else if (checkRet == CHECK_REJECT)
         {
+            flushCheckpoint();
             SetSyncState(SYNC_STOP);
             break;
         }
 
         if (iter->txnodes().size() <= 0)
         {
-            if (getTableStatusDB().GetDatabaseConn() == nullptr)
+            checkpointHash = LedgerHash;
+            checkpointSeq = LedgerSeq;
+            if (checkpointLedgers++ == 0)
+                checkpointStart = steady_clock::now();
+
+            if (checkpointLedgers >= SYNC_CHECKPOINT_LEDGERS ||
+                steady_clock::now() - checkpointStart >= SYNC_CHECKPOINT_INTERVAL)
             {
-                for (int countTry = 0; countTry <= MAX_CONN_RETRY_COUNT; countTry++)
-                {
-                    if (getTableStatusDB().GetDatabaseConn() == nullptr)
-                        OnConnectionError(countTry < MAX_CONN_RETRY_COUNT);
-                    else
-                        break;
-                }
-                if (getTableStatusDB().GetDatabaseConn() == nullptr)
+                if (!flushCheckpoint())
                 {
                     SetSyncState(SYNC_STOP);
                     break;
                 }
             }
-            
-            soci_ret ret = getTableStatusDB().UpdateSyncDB(to_string(accountID_), sTableNameInDB_, LedgerHash, LedgerSeq, PreviousCommit);
-            if (ret == soci_exception) {
-                SetSyncState(SYNC_STOP);
-                break;
-            }
             continue;
         }
 
+        if (!flushCheckpoint())
+        {
+            SetSyncState(SYNC_STOP);
+            break;
+        }
+
         // Make ledger-txs to slices,every slice will run a soci::transaction.
-        auto vecTxSlices = fetchLedgerTxSlices(*iter);
+        auto const& vecTxSlices = ledgerSlices[iter - aData.begin()];
         int countTry = 0;
         for (countTry = 0; countTry <= MAX_CONN_RETRY_COUNT; countTry++)
         {
@@ -1088,6 +1252,10 @@ bool TableSyncItem::DealWithEveryLedgerData(const std::vector<protocol::TMTableD
                 {
                     uint256 lastTxHash = beast::zero;
                     bool isLastOne = i == vecTxSlices.size() - 1;
+                    TableColumnCache::UpdateGuard cacheGuard(
+                        app_.getTableColumnCache(), sTableNameInDB_);
+                    bStageCacheOps_ = cacheGuard.active();
+                    aCacheOps_.clear();
                     auto stTran = TxStoreTransaction(&getTxStoreDBConn());
                     if (!stTran.GetTransaction())
                     {
@@ -1119,7 +1287,18 @@ bool TableSyncItem::DealWithEveryLedgerData(const std::vector<protocol::TMTableD
                             continue;
                         }
                         
-                        auto ret = DealWithEveryTx(tx, iter, tmpPubMap);
+                        // A drop earlier in the reply changes what the
+                        // transaction expands to
+                        auto const it = prepared.find(&tx);
+                        auto const ret =
+                            it != prepared.end() &&
+                                preparedNameInDB == sTableNameInDB_
+                            ? DealWithEveryTx(tx, it->second, iter, tmpPubMap)
+                            : DealWithEveryTx(
+                                  tx,
+                                  PrepareTx(tx, iter->ledgerseq()),
+                                  iter,
+                                  tmpPubMap);
                         rollback = ret.first;
                         if(connectionErr = ret.second; connectionErr)
                             break;
@@ -1146,7 +1325,9 @@ bool TableSyncItem::DealWithEveryLedgerData(const std::vector<protocol::TMTableD
                     {
                         UpdateSyncDB(isLastOne, lastTxHash, *iter);
                         stTran.commit();
+                        cacheGuard.commit(aCacheOps_);
                     }
+                    bStageCacheOps_ = false;
                     // deal with subscribe
                     if (app_.getOPs().hasChainSQLTxListener())
                     {
@@ -1184,6 +1365,11 @@ bool TableSyncItem::DealWithEveryLedgerData(const std::vector<protocol::TMTableD
         }
     }
 
+    if (!flushCheckpoint())
+        SetSyncState(SYNC_STOP);
+
+    bStageCacheOps_ = false;
+
     //release connection lock
     ReleaseConnectionUnit();
 
@@ -1193,17 +1379,15 @@ bool TableSyncItem::DealWithEveryLedgerData(const std::vector<protocol::TMTableD
 std::pair<bool, bool>
 TableSyncItem::DealWithEveryTx(
     STTx& tx,
+    std::vector<STTx> const& vecTxs,
     std::vector<protocol::TMTableData>::const_iterator iter,
     std::map<uint256, std::tuple<STTx, int, std::pair<bool, std::string>>>& tmpPubMap)
 {
     std::uint32_t closeTime = iter->closetime();
     std::uint32_t seq = iter->ledgerseq();
-    std::vector<STTx> vecTxs = app_.getMasterTransaction().getTxs(
-        tx, sTableNameInDB_, nullptr, iter->ledgerseq());
 
     if (vecTxs.size() > 0)
     {
-        TryDecryptRaw(vecTxs);
         for (auto& tx : vecTxs)
         {
             if (tx.isFieldPresent(sfOpType) && T_CREATE == tx.getFieldU16(sfOpType))
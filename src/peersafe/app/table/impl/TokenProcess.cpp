@@ -67,6 +67,11 @@ namespace ripple {
 		return false;
 	}
 
+	bool TokenProcess::concurrentDecrypt() const
+	{
+		return sm4Handle == nullptr;
+	}
+
 	Blob TokenProcess::symmertryDecrypt(Blob rawEncrept, const PublicKey& publicKey)
 	{
 		if (isValidate)
@@ -65,6 +65,9 @@ namespace ripple {
     std::string const BLOOM_START_LEDGER_KEY = "start-ledger-key";
     std::string const BLOOM_SAVED_SECTION_COUNT = "saved_section_count";
 
+    // contract storage slots kept by ContractHelper across ledgers
+    std::size_t const CONTRACT_STORAGE_CACHE_SLOTS = 256 * 1024;
+
 } // ripple
 
 #endif
\ No newline at end of file
@@ -0,0 +1,35 @@
+//------------------------------------------------------------------------------
+/*
+This file is part of chainsqld: https://github.com/chainsql/chainsqld
+Copyright (c) 2016-2018 Peersafe Technology Co., Ltd.
+
+chainsqld is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+chainsqld is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+You should have received a copy of the GNU General Public License
+along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+//==============================================================================
+
+#include <peersafe/app/misc/MemoryGovernor.h>
+#include <peersafe/schema/Schema.h>
+#include <ripple/app/main/Application.h>
+#include <ripple/json/json_value.h>
+#include <ripple/rpc/Context.h>
+
+namespace ripple {
+
+// Size, target and hit rate of the caches of every schema
+Json::Value
+doCacheUsage(RPC::JsonContext& context)
+{
+    return context.app.app().getMemoryGovernor().getJson();
+}
+
+}  // namespace ripple
@@ -55,9 +55,9 @@ namespace ripple {
 	{
 		Json::Value ret(context.params);
        
-        if (ret[jss::tx_json].size() != 2)
+        if (ret[jss::tx_json].size() != 2 && ret[jss::tx_json].size() != 3)
         {
-			std::string errMsg = "must follow 2 params,in format:\"owner tableName secret\" \"path\".";
+			std::string errMsg = "must follow 2 or 3 params,in format:\"owner tableName secret\" \"path\" [\"conditions\"].";
 			ret.removeMember(jss::tx_json);
 			return RPC::make_error(rpcINVALID_PARAMS, errMsg);
         }	
@@ -66,8 +66,12 @@ namespace ripple {
         std::string sNormal = ret[jss::tx_json][uint32_t(0)].asString();        
         //2.path 
         std::string sFullPath = ret[jss::tx_json][uint32_t(1)].asString();
+        //3.optional conditions in Raw format, e.g. [{"age":{"$gt":20}}]
+        std::string sFilter;
+        if (ret[jss::tx_json].size() == 3)
+            sFilter = ret[jss::tx_json][uint32_t(2)].asString();
 
-		auto retPair = context.app.getTableSync().StartDumpTable(sNormal, sFullPath, NULL);        
+		auto retPair = context.app.getTableSync().StartDumpTable(sNormal, sFullPath, NULL, sFilter);        
 
 		if(!retPair.first)
 		{
@@ -39,6 +39,7 @@
 #include <peersafe/rpc/TableUtils.h>
 #include <peersafe/app/table/TableStatusDB.h>
 #include <peersafe/app/misc/ConnectionPool.h>
+#include <peersafe/app/table/TableColumnCache.h>
 #include <iostream> 
 #include <fstream>
 #include <regex>
@@ -755,7 +756,16 @@ doGetRecord(RPC::JsonContext& context)
     //}
     try
     {
-        ret = pTxStore->txHistory(context);
+        // hot tables configured in [cache_tables] are answered from memory,
+        // checkForSelect has replaced TableName with the nameInDB
+        Json::Value const& tx_json = context.params[jss::tx_json];
+        boost::optional<Json::Value> cached;
+        if (tx_json["Tables"].size() == 1)
+            cached = context.app.getTableColumnCache().query(
+                tx_json["Tables"][0u]["Table"]["TableName"].asString(),
+                tx_json,
+                unit->conn_->GetDBConn());
+        ret = cached ? *cached : pTxStore->txHistory(context);
         if (!ret.isMember(jss::error))
         {
             // diff between the latest ledgerseq in db and the real newest
@@ -987,6 +997,22 @@ std::pair<std::vector<std::vector<Json::Value>>,std::string> doGetRecord2D(RPC::
 	//}
     try
     {
+        // Contracts reading a table in [cache_tables] are served from
+        // memory, checkForSelect has replaced TableName with the nameInDB
+        Json::Value const& tx_json = context.params[jss::tx_json];
+        if (tx_json["Tables"].size() == 1)
+        {
+            auto cached = context.app.getTableColumnCache().query2d(
+                tx_json["Tables"][0u]["Table"]["TableName"].asString(),
+                tx_json,
+                unit->conn_->GetDBConn());
+            if (cached)
+            {
+                context.app.getConnectionPool().releaseConnection(unit);
+                return std::make_pair(std::move(*cached), std::string());
+            }
+        }
+
         auto retVec = pTxStore->txHistory2d(context);
         context.app.getConnectionPool().releaseConnection(unit);
         return retVec;
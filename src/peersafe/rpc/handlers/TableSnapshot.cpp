@@ -0,0 +1,87 @@
+//------------------------------------------------------------------------------
+/*
+ This file is part of chainsqld: https://github.com/chainsql/chainsqld
+ Copyright (c) 2016-2018 Peersafe Technology Co., Ltd.
+
+	chainsqld is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	chainsqld is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//==============================================================================
+
+#include <ripple/json/json_value.h>
+#include <ripple/net/RPCErr.h>
+#include <ripple/protocol/ErrorCodes.h>
+#include <ripple/protocol/jss.h>
+#include <ripple/rpc/Context.h>
+#include <ripple/rpc/handlers/Handlers.h>
+#include <ripple/rpc/impl/RPCHelpers.h>
+#include <peersafe/app/table/TableSync.h>
+#include <peersafe/basics/characterUtilities.h>
+
+namespace ripple {
+
+    // t_snapshot owner tableName path
+    Json::Value doTableSnapshot(RPC::JsonContext& context)
+    {
+        Json::Value ret(context.params);
+
+        if (ret[jss::tx_json].size() != 3)
+        {
+            std::string errMsg = "must follow 3 params,in format:owner tableName path.";
+            ret.removeMember(jss::tx_json);
+            return RPC::make_error(rpcINVALID_PARAMS, errMsg);
+        }
+
+        AccountID ownerID;
+        auto jvAccepted = RPC::accountFromString(ownerID, ret[jss::tx_json][0U].asString(), true);
+        if (jvAccepted)
+            return jvAccepted;
+        std::string tableName = ret[jss::tx_json][1U].asString();
+        std::string sPath = ret[jss::tx_json][2U].asString();
+
+        auto retPair = context.app.getTableSync().MakeTableSnapshot(ownerID, tableName, sPath);
+        if (!retPair.first)
+        {
+            std::string sErrorMsg;
+            TransGBK_UTF8(retPair.second, sErrorMsg, false);
+            ret.removeMember(jss::tx_json);
+            return RPC::make_error(rpcGENERAL, sErrorMsg);
+        }
+
+        return ret;
+    }
+
+    // t_snapshot_load path
+    Json::Value doTableSnapshotLoad(RPC::JsonContext& context)
+    {
+        Json::Value ret(context.params);
+
+        if (ret[jss::tx_json].size() != 1)
+        {
+            std::string errMsg = "must follow 1 param,in format:path.";
+            ret.removeMember(jss::tx_json);
+            return RPC::make_error(rpcINVALID_PARAMS, errMsg);
+        }
+
+        std::string sPath = ret[jss::tx_json][0U].asString();
+        auto retPair = context.app.getTableSync().LoadTableSnapshot(sPath);
+        if (!retPair.first)
+        {
+            std::string sErrorMsg;
+            TransGBK_UTF8(retPair.second, sErrorMsg, false);
+            ret.removeMember(jss::tx_json);
+            return RPC::make_error(rpcGENERAL, sErrorMsg);
+        }
+
+        return ret;
+    }
+} // ripple
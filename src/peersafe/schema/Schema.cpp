@@ -49,9 +49,11 @@
 #include <peersafe/app/storage/TableStorage.h>
 #include <peersafe/rpc/impl/TableAssistant.h>
 #include <peersafe/app/misc/ContractHelper.h>
+#include <peersafe/app/misc/MemoryGovernor.h>
 #include <peersafe/app/misc/CACertSite.h>
 #include <peersafe/app/misc/CertList.h>
 #include <peersafe/app/table/TableTxAccumulator.h>
+#include <peersafe/app/table/TableColumnCache.h>
 #include <peersafe/app/table/TableSync.h>
 #include <peersafe/app/table/TableStatusDBMySQL.h>
 #include <peersafe/app/table/TableStatusDBSQLite.h>
@@ -143,7 +145,7 @@ private:
     std::unique_ptr<LedgerMaster> m_ledgerMaster;
     std::unique_ptr<InboundLedgers> m_inboundLedgers;
     std::unique_ptr<InboundTransactions> m_inboundTransactions;
-    TaggedCache<uint256, AcceptedLedger> m_acceptedLedgerCache;
+    ShardedTaggedCache<uint256, AcceptedLedger> m_acceptedLedgerCache;
     std::unique_ptr<NetworkOPs> m_networkOPs;
     std::unique_ptr<Cluster> cluster_;
     std::unique_ptr<PeerReservationTable> peerReservations_;
@@ -167,6 +169,7 @@ private:
     std::unique_ptr<TableAssistant> m_pTableAssistant;
     std::unique_ptr<ContractHelper> m_pContractHelper;
     std::unique_ptr<TableTxAccumulator> m_pTableTxAccumulator;
+    std::unique_ptr<TableColumnCache> m_pTableColumnCache;
     std::unique_ptr<TxPool> m_pTxPool;
     std::unique_ptr<StateManager> m_pStateManager;
     std::unique_ptr<BloomManager> m_pBloomManager;
@@ -348,6 +351,11 @@ public:
 
         , m_pTableTxAccumulator(std::make_unique<TableTxAccumulator>(*this))
 
+        , m_pTableColumnCache(std::make_unique<TableColumnCache>(
+              *this,
+              *config_,
+              SchemaImp::journal("TableColumnCache")))
+
         , m_pTxPool(
               std::make_unique<TxPool>(*this, SchemaImp::journal("TxPool")))
 
@@ -368,6 +376,28 @@ public:
               SchemaImp::journal("PrometheusClient")))
 
     {
+        auto const& section = config_->section(ConfigSection::jobQueue());
+        int weight = 1;
+        int maxRunning = 0;
+        get_if_exists(section, "weight", weight);
+        get_if_exists(section, "max_running", maxRunning);
+        app_.getJobQueue().addSchema(
+            jobCounter(), displayName(), weight, maxRunning);
+    }
+
+    ~SchemaImp() override
+    {
+        app_.getMemoryGovernor().remove(schema_params_.schemaId());
+        app_.getJobQueue().removeSchema(jobCounter());
+    }
+
+    // How the schema is named in process wide statistics
+    std::string
+    displayName()
+    {
+        return schema_params_.schemaId() == beast::zero
+            ? "main"
+            : to_string(schema_params_.schemaId());
     }
 
     Application&
@@ -522,6 +552,12 @@ public:
         return *m_pTableTxAccumulator;
     }
 
+    TableColumnCache&
+    getTableColumnCache() override
+    {
+        return *m_pTableColumnCache;
+    }
+
     TxPool&
     getTxPool() override
     {
@@ -569,7 +605,7 @@ public:
         return *m_inboundTransactions;
     }
 
-    TaggedCache<uint256, AcceptedLedger>&
+    ShardedTaggedCache<uint256, AcceptedLedger>&
     getAcceptedLedgerCache() override
     {
         return m_acceptedLedgerCache;
@@ -909,6 +945,10 @@ public:
                     }
                 }
 
+                mTxnDB->setTxIndex(make_TxIndex(
+                    config_->section(ConfigSection::txIndex()),
+                    (setup.dataDir / "txindex").string(),
+                    journal("TxIndex")));
             }
 
             // ledger database
@@ -1030,6 +1070,50 @@ public:
         m_txMaster.tune (
             config_->getValueFor(SizedItem::transactionSize), 
             config_->getValueFor(SizedItem::transactionAge));
+
+        // Let the caches share the process wide budget with other schemas
+        auto& governor = app_.getMemoryGovernor();
+        auto const id = schema_params_.schemaId();
+        governor.add(
+            id,
+            displayName(),
+            "tree_node",
+            MemoryGovernor::fromTaggedCache(
+                *nodeFamily_.getTreeNodeCache(0),
+                config_->getValueFor(SizedItem::treeCacheSize)));
+        governor.add(
+            id,
+            displayName(),
+            "node_store",
+            {config_->getValueFor(SizedItem::nodeCacheSize),
+             nullptr,
+             [this, age = seconds{config_->getValueFor(
+                        SizedItem::nodeCacheAge)}](int size) {
+                 m_nodeStore->tune(size, age);
+             },
+             [this] { return m_nodeStore->getFetchTotalCount(); },
+             [this] { return m_nodeStore->getCacheHitRate(); }});
+        governor.add(
+            id,
+            displayName(),
+            "ledger_history",
+            {config_->getValueFor(SizedItem::ledgerSize),
+             [this] {
+                 return m_ledgerMaster->getLedgerHistory().getCacheSize();
+             },
+             [this, age = seconds{config_->getValueFor(SizedItem::ledgerAge)}](
+                 int size) { m_ledgerMaster->tune(size, age); },
+             [this] {
+                 return m_ledgerMaster->getLedgerHistory().getCacheLookups();
+             },
+             [this] { return m_ledgerMaster->getCacheHitRate(); }});
+        governor.add(
+            id,
+            displayName(),
+            "accepted_ledger",
+            MemoryGovernor::fromTaggedCache(
+                m_acceptedLedgerCache,
+                m_acceptedLedgerCache.getTargetSize()));
         return true;
     }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ripple/shamap/TreeNodeCache.h>
+#include <ripple/basics/ShardedTaggedCache.h>
 #include <ripple/basics/TaggedCache.h>
 #include <ripple/core/Config.h>
 #include <peersafe/schema/SchemaParams.h>
@@ -64,6 +65,7 @@ class TableStorage;
 class TableAssistant;
 class ContractHelper;
 class TableTxAccumulator;
+class TableColumnCache;
 class TxPool;
 class StateManager;
 class LoadManager;
@@ -186,7 +188,7 @@ public:
     getInboundLedgers() = 0;
     virtual InboundTransactions&
     getInboundTransactions() = 0;
-    virtual TaggedCache<uint256, AcceptedLedger>&
+    virtual ShardedTaggedCache<uint256, AcceptedLedger>&
     getAcceptedLedgerCache() = 0;
     virtual LedgerMaster&
     getLedgerMaster() = 0;
@@ -216,6 +218,8 @@ public:
     getContractHelper() = 0;
     virtual TableTxAccumulator&
     getTableTxAccumulator() = 0;
+    virtual TableColumnCache&
+    getTableColumnCache() = 0;
     virtual TxPool&
     getTxPool() = 0;
     virtual StateManager&
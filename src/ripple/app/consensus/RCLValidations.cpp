@@ -76,7 +76,7 @@ RCLValidationsPolicy::onStale(RCLValidation&& v)
                 app_.getJobQueue().makeLoadEvent(jtDISK, "ValidationWrite");
             ScopedLockType sl(staleLock_);
             doStaleWrite(sl);
-        });
+        }, app_.doJobCounter());
 }
 
 void
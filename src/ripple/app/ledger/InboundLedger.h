@@ -21,6 +21,7 @@
 #define RIPPLE_APP_LEDGER_INBOUNDLEDGER_H_INCLUDED
 
 #include <ripple/app/ledger/Ledger.h>
+#include <ripple/app/ledger/NodeRequestSizes.h>
 #include <ripple/app/main/Application.h>
 #include <ripple/basics/CountedObject.h>
 #include <peersafe/schema/Schema.h>
@@ -31,6 +32,8 @@
 
 namespace ripple {
 
+class StateSnapshotSync;
+
 // A ledger we are trying to acquire
 class InboundLedger final : public PeerSet,
                             public std::enable_shared_from_this<InboundLedger>,
@@ -106,6 +109,12 @@ public:
         std::weak_ptr<Peer>,
         std::shared_ptr<protocol::TMLedgerData> const&);
 
+    /** Take leaves for the maps being rebuilt from them. */
+    void
+    gotStateLeaves(
+        std::weak_ptr<Peer>,
+        std::shared_ptr<protocol::TMStateLeaves> const&);
+
     using neededHash_t =
         std::pair<protocol::TMGetObjectByHash::ObjectType, uint256>;
 
@@ -131,17 +140,66 @@ public:
 private:
     enum class TriggerReason { added, reply, timeout };
 
+    using NodeList = std::vector<std::pair<SHAMapNodeID, uint256>>;
+    using DecodedNodes = std::vector<std::shared_ptr<SHAMapAbstractNode>>;
+
     void
-    filterNodes(
-        std::vector<std::pair<SHAMapNodeID, uint256>>& nodes,
-        TriggerReason reason);
+    filterNodes(NodeList& nodes, TriggerReason reason, std::size_t limit);
 
     void
     trigger(std::shared_ptr<Peer> const&, TriggerReason);
 
+    // Request more nodes, splitting them between the peers
+    void
+    trigger(std::vector<std::shared_ptr<Peer>> const&, TriggerReason);
+
+    // How many nodes to ask the peers for at once
+    std::size_t
+    nodeLimit(
+        std::vector<std::shared_ptr<Peer>> const& peers,
+        TriggerReason reason);
+
+    void
+    sendNodeRequest(
+        protocol::TMGetLedger& tmGL,
+        NodeList const& nodes,
+        std::vector<std::shared_ptr<Peer>> const& peers,
+        TriggerReason reason);
+
+    // Resize the next request to a peer by how fast it answered this one
+    void
+    onPeerReply(Peer::id_t id, std::size_t received);
+
+    void
+    decodeNodes(
+        std::vector<PeerDataPairType> const& data,
+        std::vector<DecodedNodes>& nodes);
+
     std::vector<neededHash_t>
     getNeededHashes();
 
+    // Whether to rebuild the state map from its leaves
+    bool
+    wantSnapshot();
+
+    // Drive the rebuild of the state map from its leaves, returns true
+    // while it is still going. The top of the map is asked for with tmGL.
+    bool
+    triggerSnapshot(
+        protocol::TMGetLedger const& tmGL,
+        std::vector<std::shared_ptr<Peer>> const& peers,
+        TriggerReason reason);
+
+    // Rebuild the missing contract storage maps from their leaves too
+    void
+    triggerSnapshotContracts(
+        protocol::TMGetLedger const& tmGL,
+        std::vector<std::shared_ptr<Peer>> const& peers,
+        TriggerReason reason);
+
+    std::vector<std::shared_ptr<Peer>>
+    snapshotPeers(std::vector<std::shared_ptr<Peer>> const& peers) const;
+
     void
     addPeers();
 
@@ -173,13 +231,19 @@ private:
     pmDowncast() override;
 
     int
-    processData(std::shared_ptr<Peer> peer, protocol::TMLedgerData& data);
+    processData(
+        std::shared_ptr<Peer> peer,
+        protocol::TMLedgerData& data,
+        DecodedNodes const& nodes);
 
     bool
     takeHeader(std::string const& data);
 
     void
-    receiveNode(protocol::TMLedgerData& packet, SHAMapAddNode&);
+    receiveNode(
+        protocol::TMLedgerData& packet,
+        DecodedNodes const& nodes,
+        SHAMapAddNode&);
 
     bool
     takeTxRootNode(Slice const& data, SHAMapAddNode&);
@@ -226,6 +290,9 @@ private:
 
     std::set<uint256> mRecentNodes;
 
+    // How many nodes to ask each peer for
+    NodeRequestSizes mRequestSizes;
+
     SHAMapAddNode mStats;
 
     // Data we have received from peers
@@ -235,6 +302,10 @@ private:
     std::atomic_bool mContractRootLoaded;
     std::map<uint256, std::shared_ptr<SHAMap>> mContractMapInfo;
     std::atomic_bool mCheckingContract{false};
+
+    // Set once the state map is being rebuilt from its leaves
+    std::unique_ptr<StateSnapshotSync> mSnapshot;
+    bool mSnapshotChecked = false;
 };
 
 /** Deserialize a ledger header from a byte array. */
@@ -54,6 +54,13 @@ public:
         std::shared_ptr<Peer>,
         std::shared_ptr<protocol::TMLedgerData>) = 0;
 
+    /** Leaves of a map of a ledger being rebuilt from them. */
+    virtual bool
+    gotStateLeaves(
+        LedgerHash const& ledgerHash,
+        std::shared_ptr<Peer>,
+        std::shared_ptr<protocol::TMStateLeaves>) = 0;
+
     virtual void
     gotStaleData(std::shared_ptr<protocol::TMLedgerData> packet) = 0;
 
@@ -20,9 +20,11 @@
 #ifndef RIPPLE_APP_LEDGER_INBOUNDTRANSACTIONS_H_INCLUDED
 #define RIPPLE_APP_LEDGER_INBOUNDTRANSACTIONS_H_INCLUDED
 
+#include <ripple/basics/UnorderedContainers.h>
 #include <ripple/beast/clock/abstract_clock.h>
 #include <ripple/core/Stoppable.h>
 #include <ripple/overlay/Peer.h>
+#include <ripple/protocol/STTx.h>
 #include <ripple/shamap/SHAMap.h>
 #include <memory>
 
@@ -68,6 +70,18 @@ public:
         std::shared_ptr<Peer> peer,
         std::shared_ptr<protocol::TMLedgerData> message) = 0;
 
+    /** Add the short ids or transactions of a set from a TxSetIds message.
+     *
+     * @param setHash The transaction set ID (digest of the SHAMap root node).
+     * @param peer The peer that sent the message.
+     * @param message The TxSetIds message.
+     */
+    virtual void
+    gotTxSetIds(
+        uint256 const& setHash,
+        std::shared_ptr<Peer> peer,
+        std::shared_ptr<protocol::TMTxSetIds> message) = 0;
+
     /** Add a transaction set.
      *
      * @param setHash The transaction set ID (should match set.getHash()).
@@ -87,6 +101,71 @@ public:
     newRound(std::uint32_t seq) = 0;
 };
 
+/** The short id of a transaction in a transaction set.
+ *
+ * A 64 bit hash of the transaction id keyed by the set hash, so ids that
+ * collide in one set don't collide in the next.
+ */
+std::uint64_t
+txSetShortId(uint256 const& setHash, uint256 const& txID);
+
+/** The transactions of a set by short id, null while we don't have them. */
+using TxSetTxs = hash_map<std::uint64_t, std::shared_ptr<STTx const>>;
+
+/** Fill in the transactions of a set from the ones we have.
+ *
+ * A short id that two of our transactions share is left empty, as there is
+ * no telling which of them is in the set.
+ *
+ * @param forEachTx Calls its argument with each transaction we have.
+ * @return The number of transactions of the set still missing.
+ */
+template <class ForEachTx>
+std::size_t
+matchTxSetIds(uint256 const& setHash, TxSetTxs& txs, ForEachTx&& forEachTx)
+{
+    std::size_t missing = 0;
+    for (auto const& p : txs)
+    {
+        if (!p.second)
+            ++missing;
+    }
+
+    hash_set<std::uint64_t> seen;
+    forEachTx([&](std::shared_ptr<STTx const> const& tx) {
+        auto const id = txSetShortId(setHash, tx->getTransactionID());
+        auto const it = txs.find(id);
+        if (it == txs.end())
+            return;
+
+        if (!seen.insert(id).second)
+        {
+            if (it->second && it->second != tx)
+            {
+                it->second.reset();
+                ++missing;
+            }
+            return;
+        }
+
+        if (!it->second)
+        {
+            it->second = tx;
+            --missing;
+        }
+    });
+
+    return missing;
+}
+
+/** Build a transaction set from all of its transactions.
+ *
+ * @return The set, or nullptr if its hash is not setHash because a short
+ *         id was matched with the wrong transaction.
+ */
+std::shared_ptr<SHAMap>
+buildTxSet(uint256 const& setHash, TxSetTxs const& txs, Family& family);
+
 std::unique_ptr<InboundTransactions>
 make_InboundTransactions(
     Schema& app,
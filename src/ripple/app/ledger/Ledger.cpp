@@ -67,9 +67,50 @@ namespace ripple {
 
 create_genesis_t const create_genesis {};
 
-bool
-storePeersafeSql(
-    LockedSociSession& db,
+namespace {
+
+// The rows saveValidatedLedger writes to the transaction database for one
+// ledger. They are built before the write connection is checked out, so
+// the connection is only held while the prepared statements run.
+struct TxnDBRows
+{
+    struct Transaction
+    {
+        std::string id;
+        std::string type;
+        std::string account;
+        std::uint32_t seq;
+        std::string result;
+        Blob raw;
+        Blob meta;
+    };
+
+    struct AccountTransaction
+    {
+        std::string id;
+        std::string account;
+        std::uint32_t txnSeq;
+    };
+
+    struct TraceTransaction
+    {
+        std::string id;
+        std::string type;
+        std::int64_t txSeq;
+        std::string owner;
+        std::string name;
+    };
+
+    std::vector<Transaction> transactions;
+    std::vector<AccountTransaction> accountTransactions;
+    std::vector<TraceTransaction> traceTransactions;
+};
+
+}  // namespace
+
+static void
+getTraceRows(
+    std::vector<TxnDBRows::TraceTransaction>& rows,
     std::shared_ptr<const ripple::STTx> pTx,
     std::uint64_t SeqInLedger,
     std::uint32_t inLedger,
@@ -1096,14 +1137,6 @@ saveValidatedLedger(
                     << seq;
     boost::format deleteLedger(
         "DELETE FROM Ledgers WHERE LedgerSeq = %u;");
-    boost::format deleteTrans1(
-        "DELETE FROM Transactions WHERE LedgerSeq = %u;");
-    boost::format deleteTrans2(
-        "DELETE FROM AccountTransactions WHERE LedgerSeq = %u;");
-    boost::format deleteAcctTrans(
-        "DELETE FROM AccountTransactions WHERE TransID = '%s';");
-	boost::format deleteTrans3(
-		"DELETE FROM TraceTransactions WHERE LedgerSeq = %u;");
     boost::format deleteLastValidations(
             "DELETE FROM LastValidations;");
 
@@ -1190,15 +1223,15 @@ saveValidatedLedger(
 
     if (app.config().useTxTables())
     {
-        auto db = app.getTxnDB().checkoutDb();
+        using namespace std::chrono;
+        auto const collectStart = steady_clock::now();
+
+        TxnDBRows rows;
+        rows.transactions.reserve(aLedger->getTxnCount());
+
+        auto const txIndex = app.getTxnDB().txIndex();
+        std::vector<TxIndex::Transaction> indexed;
 
-        soci::transaction tr(*db);
-        
-        *db << boost::str(deleteTrans1 % seq);
-        *db << boost::str(deleteTrans2 % seq);
-        *db << boost::str(deleteTrans3 % seq);
-        std::string const ledgerSeq(std::to_string(seq));
-		
         std::uint64_t iTxSeq = uint64_t(seq) * 100000;
         for (auto const& [_, acceptedLedgerTx] : aLedger->getMap())
         {
@@ -1214,92 +1247,206 @@ saveValidatedLedger(
                 transaction->setMeta(metaBlob);
             }
 
+            auto const& txn = acceptedLedgerTx->getTxn();
             std::string const txnId(to_string(transactionID));
-            std::string const txnSeq(
-                std::to_string(acceptedLedgerTx->getTxnSeq()));
-
-            *db << boost::str(deleteAcctTrans % transactionID);
 
             auto const& accts = acceptedLedgerTx->getAffected();
 
+            if (txIndex)
+                indexed.push_back(
+                    {transactionID,
+                     acceptedLedgerTx->getTxnSeq(),
+                     {accts.begin(), accts.end()}});
+
             if (!accts.empty())
             {
-                std::string sql(
-                    "INSERT INTO AccountTransactions "
-                    "(TransID, Account, LedgerSeq, TxnSeq) VALUES ");
-
-                // Try to make an educated guess on how much space we'll need
-                // for our arguments. In argument order we have:
-                // 64 + 34 + 10 + 10 = 118 + 10 extra = 128 bytes
-                sql.reserve(sql.length() + (accts.size() * 128));
-
-                bool first = true;
                 for (auto const& account : accts)
-                {
-                    if (!first)
-                        sql += ", ('";
-                    else
-                    {
-                        sql += "('";
-                        first = false;
-                    }
-
-                    sql += txnId;
-                    sql += "','";
-                    sql += app.accountIDCache().toBase58(account);
-                    sql += "',";
-                    sql += ledgerSeq;
-                    sql += ",";
-                    sql += txnSeq;
-                    sql += ")";
-                }
-                sql += ";";
-                JLOG(j.trace()) << "ActTx: " << sql;
-                *db << sql;
+                    rows.accountTransactions.push_back(
+                        {txnId,
+                         app.accountIDCache().toBase58(account),
+                         acceptedLedgerTx->getTxnSeq()});
             }
             else
             {
                 JLOG(j.warn()) << "Transaction in ledger " << seq
                                << " affects no accounts";
-                JLOG(j.warn())
-                    << acceptedLedgerTx->getTxn()->getJson(JsonOptions::none);
+                JLOG(j.warn()) << txn->getJson(JsonOptions::none);
             }
-			std::string token, human;
+
+            std::string token, human;
             transResultInfo(acceptedLedgerTx->getResult(), token, human);
 
-            if (app.getTxnDB().hasTxResult())
+            auto const format =
+                TxFormats::getInstance().findByType(txn->getTxnType());
+            assert(format != nullptr);
+
+            TxnDBRows::Transaction row{
+                txnId,
+                format->getName(),
+                toBase58(txn->getAccountID(sfAccount)),
+                txn->getSequence(),
+                token,
+                {},
+                {}};
+            if (app.config().SAVE_TX_RAW)
             {
-                *db
-                    << (STTx::getMetaSQLInsertReplaceHeader(true) +
-                        acceptedLedgerTx->getTxn()->getMetaSQL(
-                            seq,
-                            acceptedLedgerTx->getEscMeta(),
-                            token,
-                            app.config().SAVE_TX_RAW,
-                            true) +
-                        ";");
+                Serializer s;
+                txn->add(s);
+                row.raw = std::move(s.modData());
+                row.meta = acceptedLedgerTx->getMetaBlob();
             }
-            else
+            rows.transactions.push_back(std::move(row));
+
+            if (app.config().USE_TRACE_TABLE)
+                getTraceRows(rows.traceTransactions, txn, iTxSeq, seq, app);
+
+            iTxSeq++;
+        }
+
+        auto const writeStart = steady_clock::now();
+
+        // The index goes first. A crash before SQL commits leaves the
+        // ledger unsaved and it is saved again, replacing what the index
+        // holds for it; the other way round the index would miss it.
+        if (txIndex)
+            txIndex->saveLedger(seq, indexed);
+        {
+            auto db = app.getTxnDB().checkoutDb();
+            bool const hasTxResult = app.getTxnDB().hasTxResult();
+
+            soci::transaction tr(*db);
+
+            *db << "DELETE FROM Transactions WHERE LedgerSeq = :seq;",
+                soci::use(seq);
+            *db << "DELETE FROM AccountTransactions WHERE LedgerSeq = :seq;",
+                soci::use(seq);
+            *db << "DELETE FROM TraceTransactions WHERE LedgerSeq = :seq;",
+                soci::use(seq);
+
+            // Every statement is prepared once per ledger and executed
+            // with the bound variables set to the next row.
+            std::string id, type, account, status(1, txnSqlValidated), result;
+            std::uint32_t txSeq = 0;
+            soci::blob raw(*db), meta(*db);
+
+            // An empty blob binds as NULL, the column keeps X'' as before
+            static std::string const insTxn(
+                "INSERT OR REPLACE INTO Transactions "
+                "(TransID, TransType, FromAcct, FromSeq, LedgerSeq, "
+                "Status, RawTxn, TxnMeta) VALUES "
+                "(:id, :type, :account, :txSeq, :seq, "
+                ":status, COALESCE(:raw, X''), COALESCE(:meta, X''));");
+            static std::string const insTxnResult(
+                "INSERT OR REPLACE INTO Transactions "
+                "(TransID, TransType, FromAcct, FromSeq, LedgerSeq, "
+                "Status, TxResult, RawTxn, TxnMeta) VALUES "
+                "(:id, :type, :account, :txSeq, :seq, "
+                ":status, :result, COALESCE(:raw, X''), "
+                "COALESCE(:meta, X''));");
+
+            soci::statement delAcctTxn =
+                (db->prepare
+                     << "DELETE FROM AccountTransactions WHERE TransID = :id;",
+                 soci::use(id));
+            soci::statement txnStmt = hasTxResult
+                ? (db->prepare << insTxnResult,
+                   soci::use(id),
+                   soci::use(type),
+                   soci::use(account),
+                   soci::use(txSeq),
+                   soci::use(seq),
+                   soci::use(status),
+                   soci::use(result),
+                   soci::use(raw),
+                   soci::use(meta))
+                : (db->prepare << insTxn,
+                   soci::use(id),
+                   soci::use(type),
+                   soci::use(account),
+                   soci::use(txSeq),
+                   soci::use(seq),
+                   soci::use(status),
+                   soci::use(raw),
+                   soci::use(meta));
+
+            for (auto const& row : rows.transactions)
             {
-                *db
-                    << (STTx::getMetaSQLInsertReplaceHeader(false) +
-                        acceptedLedgerTx->getTxn()->getMetaSQL(
-                            seq,
-                            acceptedLedgerTx->getEscMeta(),
-                            token,
-                            app.config().SAVE_TX_RAW,
-                            false) +
-                        ";");
+                id = row.id;
+                type = row.type;
+                account = row.account;
+                txSeq = row.seq;
+                result = row.result;
+                raw.trim(0);
+                convert(row.raw, raw);
+                meta.trim(0);
+                convert(row.meta, meta);
+
+                delAcctTxn.execute(true);
+                txnStmt.execute(true);
             }
-            if (app.config().USE_TRACE_TABLE)
+
+            if (!rows.accountTransactions.empty())
             {
-                storePeersafeSql(db, acceptedLedgerTx->getTxn(), iTxSeq, seq, app);
+                soci::statement acctTxnStmt =
+                    (db->prepare << "INSERT INTO AccountTransactions "
+                                    "(TransID, Account, LedgerSeq, TxnSeq) "
+                                    "VALUES (:id, :account, :seq, :txnSeq);",
+                     soci::use(id),
+                     soci::use(account),
+                     soci::use(seq),
+                     soci::use(txSeq));
+
+                for (auto const& row : rows.accountTransactions)
+                {
+                    id = row.id;
+                    account = row.account;
+                    txSeq = row.txnSeq;
+                    acctTxnStmt.execute(true);
+                }
             }
-            
-			iTxSeq++;
+
+            if (!rows.traceTransactions.empty())
+            {
+                std::int64_t traceSeq = 0;
+                std::string name;
+                soci::statement traceStmt =
+                    (db->prepare
+                         << "INSERT OR REPLACE INTO TraceTransactions "
+                            "(TransID, TransType, TxSeq, LedgerSeq, Owner, "
+                            "Name) VALUES "
+                            "(:id, :type, :txSeq, :seq, :owner, :name);",
+                     soci::use(id),
+                     soci::use(type),
+                     soci::use(traceSeq),
+                     soci::use(seq),
+                     soci::use(account),
+                     soci::use(name));
+
+                for (auto const& row : rows.traceTransactions)
+                {
+                    id = row.id;
+                    type = row.type;
+                    traceSeq = row.txSeq;
+                    account = row.owner;
+                    name = row.name;
+                    traceStmt.execute(true);
+                }
+            }
+
+            tr.commit();
         }
+        auto const writeEnd = steady_clock::now();
 
-        tr.commit();
+        auto const collectTime =
+            duration_cast<milliseconds>(writeStart - collectStart);
+        auto const writeTime = duration_cast<milliseconds>(writeEnd - writeStart);
+        app.pendingSaves().recordSave(
+            rows.transactions.size(), collectTime, writeTime);
+        JLOG(j.debug()) << "saveValidatedLedger " << seq << " wrote "
+                        << rows.transactions.size() << " transactions, "
+                        << rows.accountTransactions.size()
+                        << " account rows in " << collectTime.count() << "ms + "
+                        << writeTime.count() << "ms";
     }
 
     {
@@ -1723,29 +1870,21 @@ getHashesByIndex (std::uint32_t minSeq, std::uint32_t maxSeq,
 }
 
 
-bool
-storePeersafeSql(
-    LockedSociSession& db,
+static void
+getTraceRows(
+    std::vector<TxnDBRows::TraceTransaction>& rows,
     std::shared_ptr<const ripple::STTx> pTx,
     std::uint64_t SeqInLedger,
     std::uint32_t inLedger,
     Schema& app)
 {
-    std::string retSql = "";
     if (pTx == nullptr)
-        return false;
+        return;
     TxType txType = pTx->getTxnType();
     if (!pTx->isChainSqlTableType() &&
         txType != ttCONTRACT &&
         txType != ttETH_TX)
-        return false;
-
-    static std::string const sqlHeader =
-        "INSERT OR REPLACE INTO TraceTransactions "
-        "(TransID, TransType, TxSeq, LedgerSeq, Owner, Name)"
-        " VALUES ";
-
-    boost::format bfTrans("('%s', '%s', '%lld', '%d', '%s', '%s')");
+        return;
 
     auto format = TxFormats::getInstance().findByType(txType);
     assert(format != nullptr);
@@ -1778,9 +1917,9 @@ storePeersafeSql(
             txsNoRepeat.push_back(std::move(*itA));
     }
 
+    std::string const txnId(to_string(pTx->getTransactionID()));
     AccountID ownerID;
     ripple::uint160 uDBName;
-    std::string sqlBody = "", sqlExe = "";
     for (auto tx : txsNoRepeat)
     {
         if (tx.isFieldPresent(sfOwner))
@@ -1799,14 +1938,12 @@ storePeersafeSql(
         auto format2 = TxFormats::getInstance().findByType(tx.getTxnType());
         assert(format2 != nullptr);
 
-        sqlBody = boost::str(
-            boost::format(bfTrans) % to_string(pTx->getTransactionID()) %
-            format2->getName() % SeqInLedger % inLedger % toBase58(ownerID) %
-            to_string(uDBName));
-
-        sqlExe = sqlHeader + sqlBody;
-
-        *db << sqlExe;
+        rows.push_back(
+            {txnId,
+             format2->getName(),
+             static_cast<std::int64_t>(SeqInLedger),
+             toBase58(ownerID),
+             to_string(uDBName)});
     }
     if (txType == ttCONTRACT || txType == ttETH_TX)
     {
@@ -1814,16 +1951,13 @@ storePeersafeSql(
         std::string sAddress = txType == ttCONTRACT
             ? to_string(addrContract)
             : "0x" + to_string(uint160(addrContract));
-        sqlBody = boost::str(
-            boost::format(bfTrans) % to_string(pTx->getTransactionID()) %
-            format->getName() % SeqInLedger % inLedger % sAddress % "");
-
-        sqlExe = sqlHeader + sqlBody;
-
-        *db << sqlExe;
+        rows.push_back(
+            {txnId,
+             format->getName(),
+             static_cast<std::int64_t>(SeqInLedger),
+             sAddress,
+             ""});
     }
-
-    return true;
 }
 
 }  // namespace ripple
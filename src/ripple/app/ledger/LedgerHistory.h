@@ -60,6 +60,12 @@ public:
         return m_ledgers_by_hash.getCacheSize();
     }
 
+    std::uint64_t
+    getCacheLookups()
+    {
+        return m_ledgers_by_hash.getLookups();
+    }
+
     /** Get a ledger given its sequence number */
     std::shared_ptr<Ledger const>
     getLedgerBySeq(LedgerIndex ledgerIndex);
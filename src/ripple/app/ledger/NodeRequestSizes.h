@@ -0,0 +1,120 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_APP_LEDGER_NODEREQUESTSIZES_H_INCLUDED
+#define RIPPLE_APP_LEDGER_NODEREQUESTSIZES_H_INCLUDED
+
+#include <ripple/beast/clock/abstract_clock.h>
+#include <ripple/overlay/Peer.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+namespace ripple {
+
+/** How many ledger nodes to ask each peer for at once.
+
+    Every peer starts at the initial size. A peer that answers a request in
+    full faster than `fast` is asked for twice as many nodes next time, up
+    to the maximum, and one that takes longer than `slow` for half as many,
+    down to the minimum.
+
+    Not thread safe, InboundLedger uses it under its lock.
+*/
+class NodeRequestSizes
+{
+public:
+    using clock_type = beast::abstract_clock<std::chrono::steady_clock>;
+
+    NodeRequestSizes(
+        std::size_t initial,
+        std::size_t minimum,
+        std::size_t maximum,
+        clock_type::duration fast,
+        clock_type::duration slow)
+        : initial_(initial)
+        , minimum_(minimum)
+        , maximum_(maximum)
+        , fast_(fast)
+        , slow_(slow)
+    {
+    }
+
+    /** The number of nodes to ask the peer for next. */
+    std::size_t
+    limit(Peer::id_t id) const
+    {
+        auto const it = peers_.find(id);
+        return it == peers_.end() ? initial_ : it->second.limit;
+    }
+
+    /** Record a request to the peer.
+
+        @param available The number of nodes there are to ask for.
+        @return The number of them to ask the peer for.
+    */
+    std::size_t
+    request(Peer::id_t id, std::size_t available, clock_type::time_point now)
+    {
+        auto& entry = peers_.emplace(id, Entry{initial_}).first->second;
+        entry.requested = std::min(entry.limit, available);
+        entry.sent = now;
+        return entry.requested;
+    }
+
+    /** Resize the next request to the peer by how it answered this one.
+
+        @return `false` if the peer had no request outstanding.
+    */
+    bool
+    reply(Peer::id_t id, std::size_t received, clock_type::time_point now)
+    {
+        auto const it = peers_.find(id);
+        if (it == peers_.end() || it->second.requested == 0)
+            return false;
+
+        auto& entry = it->second;
+        auto const elapsed = now - entry.sent;
+        if (elapsed < fast_ && received >= entry.requested)
+            entry.limit = std::min(entry.limit * 2, maximum_);
+        else if (elapsed > slow_)
+            entry.limit = std::max(entry.limit / 2, minimum_);
+        entry.requested = 0;
+        return true;
+    }
+
+private:
+    struct Entry
+    {
+        std::size_t limit;
+        std::size_t requested = 0;
+        clock_type::time_point sent;
+    };
+
+    std::size_t const initial_;
+    std::size_t const minimum_;
+    std::size_t const maximum_;
+    clock_type::duration const fast_;
+    clock_type::duration const slow_;
+    std::map<Peer::id_t, Entry> peers_;
+};
+
+}  // namespace ripple
+
+#endif
@@ -20,7 +20,9 @@
 #ifndef RIPPLE_APP_PENDINGSAVES_H_INCLUDED
 #define RIPPLE_APP_PENDINGSAVES_H_INCLUDED
 
+#include <ripple/json/json_value.h>
 #include <ripple/protocol/Protocol.h>
+#include <chrono>
 #include <condition_variable>
 #include <map>
 #include <mutex>
@@ -40,6 +42,14 @@ private:
     std::map<LedgerIndex, bool> map_;
     std::condition_variable await_;
 
+    // Transaction database writes of saveValidatedLedger
+    std::uint64_t saves_ = 0;
+    std::uint64_t savedTxs_ = 0;
+    std::chrono::milliseconds collectTime_{0};
+    std::chrono::milliseconds writeTime_{0};
+    std::chrono::milliseconds lastTime_{0};
+    std::chrono::milliseconds maxTime_{0};
+
 public:
     /** Start working on a ledger
 
@@ -140,6 +150,50 @@ public:
 
         return map_;
     }
+
+    /** Record the time a ledger took to reach the transaction database
+
+        @param txs Transactions written
+        @param collect Time spent building the rows
+        @param write Time the write connection was held
+    */
+    void
+    recordSave(
+        std::size_t txs,
+        std::chrono::milliseconds collect,
+        std::chrono::milliseconds write)
+    {
+        std::lock_guard lock(mutex_);
+
+        ++saves_;
+        savedTxs_ += txs;
+        collectTime_ += collect;
+        writeTime_ += write;
+        lastTime_ = collect + write;
+        if (lastTime_ > maxTime_)
+            maxTime_ = lastTime_;
+    }
+
+    Json::Value
+    getJson() const
+    {
+        std::lock_guard lock(mutex_);
+
+        Json::Value ret(Json::objectValue);
+        ret["pending"] = static_cast<Json::UInt>(map_.size());
+        ret["saved"] = static_cast<Json::UInt>(saves_);
+        ret["transactions"] = static_cast<Json::UInt>(savedTxs_);
+        if (saves_ != 0)
+        {
+            ret["avg_collect_ms"] =
+                static_cast<Json::UInt>(collectTime_.count() / saves_);
+            ret["avg_write_ms"] =
+                static_cast<Json::UInt>(writeTime_.count() / saves_);
+        }
+        ret["last_ms"] = static_cast<Json::UInt>(lastTime_.count());
+        ret["max_ms"] = static_cast<Json::UInt>(maxTime_.count());
+        return ret;
+    }
 };
 
 }  // namespace ripple
@@ -22,6 +22,7 @@
 #include <ripple/app/ledger/InboundLedgers.h>
 #include <ripple/app/ledger/LedgerMaster.h>
 #include <ripple/app/ledger/TransactionStateSF.h>
+#include <ripple/app/ledger/impl/StateSnapshotSync.h>
 #include <peersafe/schema/Schema.h>
 #include <peersafe/schema/PeerManager.h>
 #include <peersafe/schema/SchemaParams.h>
@@ -71,11 +72,34 @@ enum {
     // Number of nodes to request blindly
     ,
     reqNodes = 8
+
+    // Bounds for the nodes requested from one peer as it keeps replying
+    ,
+    reqNodesReplyMin = 32,
+    reqNodesReplyMax = 512
+
+    // Most peers one round of node requests is split between
+    ,
+    fetchPeersMax = 6
+
+    // Nodes in a batch of replies worth decoding on several threads
+    ,
+    decodeNodesParallel = 256
+
+    // How far behind the validated ledger the one acquired has to be for
+    // its state map to be rebuilt from the leaves
+    ,
+    snapshotLedgersBehind = 16384
 };
 
 // millisecond for each ledger timeout
 auto constexpr ledgerAcquireTimeout = 2500ms;
 
+// A peer answering faster than this is asked for more nodes next time,
+// one answering slower than peerReplySlow for fewer
+auto constexpr peerReplyFast = 500ms;
+auto constexpr peerReplySlow = 1500ms;
+
 InboundLedger::InboundLedger(
     Schema& app,
     uint256 const& hash,
@@ -93,6 +117,12 @@ InboundLedger::InboundLedger(
     , mByHash(true)
     , mSeq(seq)
     , mReason(reason)
+    , mRequestSizes(
+          reqNodesReply,
+          reqNodesReplyMin,
+          reqNodesReplyMax,
+          peerReplyFast,
+          peerReplySlow)
     , mReceiveDispatched(false)
     , mContractRootLoaded(false)
 {
@@ -518,6 +548,11 @@ InboundLedger::onTimer(bool wasProgress, ScopedLockType&)
         return;
     }
 
+    // Ranges of the state map a peer stopped answering for go to the
+    // other peers, even while they make progress
+    if (wasProgress && mSnapshot)
+        mSnapshot->trigger(snapshotPeers({}), true);
+
     if (!wasProgress)
     {
         checkLocal();
@@ -616,8 +651,24 @@ InboundLedger::done()
  */
 void
 InboundLedger::trigger(std::shared_ptr<Peer> const& peer, TriggerReason reason)
+{
+    std::vector<std::shared_ptr<Peer>> peers;
+    if (peer)
+        peers.push_back(peer);
+    trigger(peers, reason);
+}
+
+/** Request more nodes from the given peers, or all peers if none given.
+    State and transaction nodes are split between the peers, the rest of
+    the requests go to the first one.
+ */
+void
+InboundLedger::trigger(
+    std::vector<std::shared_ptr<Peer>> const& peers,
+    TriggerReason reason)
 {
     ScopedLockType sl(mLock);
+    std::shared_ptr<Peer> const peer = peers.empty() ? nullptr : peers.front();
 
     if (isDone())
     {
@@ -751,7 +802,8 @@ InboundLedger::trigger(std::shared_ptr<Peer> const& peer, TriggerReason reason)
 
     // Get the state data first because it's the most likely to be useful
     // if we wind up abandoning this fetch.
-    if (mHaveHeader && !mHaveState && !mFailed)
+    if (mHaveHeader && !mHaveState && !mFailed &&
+        !triggerSnapshot(tmGL, peers, reason))
     {
         assert(mLedger);
 
@@ -774,10 +826,12 @@ InboundLedger::trigger(std::shared_ptr<Peer> const& peer, TriggerReason reason)
             AccountStateSF filter(
                 mLedger->stateMap().family().db(), app_.getLedgerMaster());
 
+            auto const limit = nodeLimit(peers, reason);
+
             // Release the lock while we process the large state map
             sl.unlock();
-            auto nodes =
-                mLedger->stateMap().getMissingNodes(missingNodesFind, &filter);
+            auto nodes = mLedger->stateMap().getMissingNodes(
+                std::max<int>(missingNodesFind, limit), &filter);
             sl.lock();
 
             //// Try insert contract storage tree root
@@ -800,21 +854,18 @@ InboundLedger::trigger(std::shared_ptr<Peer> const& peer, TriggerReason reason)
                 }
                 else
                 {
-                    filterNodes(nodes, reason);
+                    filterNodes(nodes, reason, limit);
 
                     if (!nodes.empty())
                     {
                         tmGL.set_itype(protocol::liAS_NODE);
-                        for (auto const& id : nodes)
-                        {
-                            *(tmGL.add_nodeids()) = id.first.getRawString();
-                        }
 
                         JLOG(m_journal.trace())
                             << "Sending AS node request (" << nodes.size()
                             << ") to "
-                            << (peer ? "selected peer" : "all peers");
-                        sendRequest(tmGL, peer);
+                            << (peer ? std::to_string(peers.size()) + " peers"
+                                     : std::string("all peers"));
+                        sendNodeRequest(tmGL, nodes, peers, reason);
                         return;
                     }
                     else
@@ -849,8 +900,9 @@ InboundLedger::trigger(std::shared_ptr<Peer> const& peer, TriggerReason reason)
             TransactionStateSF filter(
                 mLedger->txMap().family().db(), app_.getLedgerMaster());
 
-            auto nodes =
-                mLedger->txMap().getMissingNodes(missingNodesFind, &filter);
+            auto const limit = nodeLimit(peers, reason);
+            auto nodes = mLedger->txMap().getMissingNodes(
+                std::max<int>(missingNodesFind, limit), &filter);
 
             if (nodes.empty())
             {
@@ -866,19 +918,17 @@ InboundLedger::trigger(std::shared_ptr<Peer> const& peer, TriggerReason reason)
             }
             else
             {
-                filterNodes(nodes, reason);
+                filterNodes(nodes, reason, limit);
 
                 if (!nodes.empty())
                 {
                     tmGL.set_itype(protocol::liTX_NODE);
-                    for (auto const& n : nodes)
-                    {
-                        *(tmGL.add_nodeids()) = n.first.getRawString();
-                    }
                     JLOG(m_journal.trace())
                         << "Sending TX node request (" << nodes.size()
-                        << ") to " << (peer ? "selected peer" : "all peers");
-                    sendRequest(tmGL, peer);
+                        << ") to "
+                        << (peer ? std::to_string(peers.size()) + " peers"
+                                 : std::string("all peers"));
+                    sendNodeRequest(tmGL, nodes, peers, reason);
                     return;
                 }
                 else
@@ -899,6 +949,9 @@ InboundLedger::trigger(std::shared_ptr<Peer> const& peer, TriggerReason reason)
         {
             assert(mLedger);
 
+            if (mSnapshot)
+                triggerSnapshotContracts(tmGL, peers, reason);
+
             std::shared_ptr<SHAMap> pMap = nullptr;
             uint256 rootHash = beast::zero;
             std::vector<uint256> vecKeysDel;
@@ -918,6 +971,14 @@ InboundLedger::trigger(std::shared_ptr<Peer> const& peer, TriggerReason reason)
                 rootHash = it->first;
                 assert(pMap != nullptr);
 
+                if (mSnapshot &&
+                    mSnapshot->status(rootHash) ==
+                        StateSnapshotSync::Status::pending)
+                {
+                    it++;
+                    continue;
+                }
+
                 tmGL.set_itype(protocol::liCONTRACT_NODE);
                 tmGL.set_roothash(rootHash.begin(), rootHash.size());
                 tmGL.clear_nodeids();
@@ -967,7 +1028,11 @@ InboundLedger::trigger(std::shared_ptr<Peer> const& peer, TriggerReason reason)
                         }
                         else
                         {
-                            filterNodes(nodes, reason);
+                            filterNodes(
+                                nodes,
+                                reason,
+                                reason == TriggerReason::reply ? reqNodesReply
+                                                               : reqNodes);
 
                             if (!nodes.empty())
                             {
@@ -1074,6 +1139,203 @@ InboundLedger::checkLoadContractRoots()
     return true;
 }
 
+bool
+InboundLedger::wantSnapshot()
+{
+    if (!app_.config().STATE_SNAPSHOT_SYNC)
+        return false;
+
+    if (mReason != Reason::GENERIC && mReason != Reason::CONSENSUS)
+        return false;
+
+    // A node with a recent validated ledger has most of the state map
+    // already and only fetches the nodes that changed
+    auto& ledgerMaster = app_.getLedgerMaster();
+    return !ledgerMaster.haveValidated() ||
+        mSeq > ledgerMaster.getValidLedgerIndex() + snapshotLedgersBehind;
+}
+
+bool
+InboundLedger::triggerSnapshot(
+    protocol::TMGetLedger const& tmGL,
+    std::vector<std::shared_ptr<Peer>> const& peers,
+    TriggerReason reason)
+{
+    auto const& rootHash = mLedger->info().accountHash;
+
+    if (!mSnapshotChecked)
+    {
+        mSnapshotChecked = true;
+        if (wantSnapshot())
+        {
+            JLOG(m_journal.info())
+                << "Rebuilding the state map of ledger " << mSeq
+                << " from its leaves";
+            mSnapshot = std::make_unique<StateSnapshotSync>(
+                app_, mHash, mSeq, m_journal);
+            mSnapshot->addMap(rootHash, false);
+        }
+    }
+
+    if (!mSnapshot)
+        return false;
+
+    // The root and the nodes below it name the hash of every range, they
+    // are fetched like any other node
+    auto const top = mSnapshot->missingTop(rootHash);
+    if (!top.empty())
+    {
+        protocol::TMGetLedger tmAS = tmGL;
+        tmAS.set_itype(protocol::liAS_NODE);
+        if (top.front().isRoot())
+            tmAS.set_querydepth(1);
+        for (auto const& nodeID : top)
+            *tmAS.add_nodeids() = nodeID.getRawString();
+        JLOG(m_journal.trace())
+            << "Sending AS top request (" << top.size() << ") to "
+            << (peers.empty() ? "all peers" : "selected peer");
+        sendRequest(tmAS, peers.empty() ? nullptr : peers.front());
+        return true;
+    }
+
+    switch (mSnapshot->status(rootHash))
+    {
+        case StateSnapshotSync::Status::pending:
+            mSnapshot->trigger(
+                snapshotPeers(peers), reason == TriggerReason::timeout);
+            return true;
+
+        case StateSnapshotSync::Status::done:
+            // Every node is in the store now, walking the map finds them
+            if (mLedger->stateMap().getHash().isZero())
+            {
+                AccountStateSF filter(
+                    mLedger->stateMap().family().db(),
+                    app_.getLedgerMaster());
+                mLedger->stateMap().fetchRoot(SHAMapHash{rootHash}, &filter);
+            }
+            return false;
+
+        default:
+            return false;
+    }
+}
+
+void
+InboundLedger::triggerSnapshotContracts(
+    protocol::TMGetLedger const& tmGL,
+    std::vector<std::shared_ptr<Peer>> const& peers,
+    TriggerReason reason)
+{
+    for (auto const& [rootHash, map] : mContractMapInfo)
+    {
+        auto status = mSnapshot->status(rootHash);
+        if (status == StateSnapshotSync::Status::none)
+        {
+            // A map with its root here is fetched by nodes
+            if (map->getHash().isNonZero())
+                continue;
+            mSnapshot->addMap(rootHash, true);
+            status = StateSnapshotSync::Status::pending;
+        }
+
+        switch (status)
+        {
+            case StateSnapshotSync::Status::pending:
+                // The root names the hash of every range
+                if (!mSnapshot->missingTop(rootHash).empty())
+                {
+                    protocol::TMGetLedger tmCN = tmGL;
+                    tmCN.set_itype(protocol::liCONTRACT_NODE);
+                    tmCN.set_roothash(rootHash.begin(), rootHash.size());
+                    tmCN.clear_nodeids();
+                    *tmCN.add_nodeids() = SHAMapNodeID().getRawString();
+                    JLOG(m_journal.debug())
+                        << "Sending CONTRACT root request to "
+                        << (peers.empty() ? "all peers" : "selected peer");
+                    sendRequest(tmCN, peers.empty() ? nullptr : peers.front());
+                }
+                break;
+
+            case StateSnapshotSync::Status::done:
+                if (map->getHash().isZero())
+                    map->fetchRoot(SHAMapHash(rootHash), nullptr);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    mSnapshot->trigger(snapshotPeers(peers), reason == TriggerReason::timeout);
+}
+
+std::vector<std::shared_ptr<Peer>>
+InboundLedger::snapshotPeers(
+    std::vector<std::shared_ptr<Peer>> const& peers) const
+{
+    if (!peers.empty())
+        return peers;
+
+    std::vector<std::shared_ptr<Peer>> ret;
+    for (auto id : mPeers)
+    {
+        if (auto peer = app_.peerManager().findPeerByShortID(id))
+            ret.push_back(std::move(peer));
+    }
+    return ret;
+}
+
+/** Take leaves for the maps being rebuilt from them
+    Replies are taken in parallel, without the ledger lock
+*/
+void
+InboundLedger::gotStateLeaves(
+    std::weak_ptr<Peer> wPeer,
+    std::shared_ptr<protocol::TMStateLeaves> const& packet)
+{
+    auto peer = wPeer.lock();
+    if (!peer)
+        return;
+
+    {
+        ScopedLockType sl(mLock);
+        if (isDone() || !mSnapshot)
+            return;
+    }
+
+    bool finished = false;
+    bool retry = false;
+    auto const taken = mSnapshot->takeLeaves(peer, *packet, finished, retry);
+    if (taken < 0)
+    {
+        JLOG(m_journal.warn()) << "Got invalid state leaves";
+        peer->charge(Resource::feeInvalidRequest);
+        return;
+    }
+
+    if (taken > 0)
+    {
+        ScopedLockType sl(mLock);
+        mProgress = true;
+    }
+
+    // A range that didn't build to its hash goes to another peer
+    if (retry)
+    {
+        std::vector<std::shared_ptr<Peer>> peers;
+        {
+            ScopedLockType sl(mLock);
+            peers = snapshotPeers({});
+        }
+        mSnapshot->trigger(peers, false);
+    }
+
+    // A map is done, carry on with the rest of the ledger
+    if (finished)
+        trigger(peer, TriggerReason::reply);
+}
+
 //void
 //InboundLedger::insertContractRoots(std::set<uint256>& setHashes)
 //{
@@ -1092,8 +1354,9 @@ InboundLedger::checkLoadContractRoots()
 
 void
 InboundLedger::filterNodes(
-    std::vector<std::pair<SHAMapNodeID, uint256>>& nodes,
-    TriggerReason reason)
+    NodeList& nodes,
+    TriggerReason reason,
+    std::size_t limit)
 {
     // Sort nodes so that the ones we haven't recently
     // requested come before the ones we have.
@@ -1122,9 +1385,6 @@ InboundLedger::filterNodes(
         nodes.erase(dup, nodes.end());
     }
 
-    std::size_t const limit =
-        (reason == TriggerReason::reply) ? reqNodesReply : reqNodes;
-
     if (nodes.size() > limit)
         nodes.resize(limit);
 
@@ -1132,6 +1392,117 @@ InboundLedger::filterNodes(
         mRecentNodes.insert(n.second);
 }
 
+std::size_t
+InboundLedger::nodeLimit(
+    std::vector<std::shared_ptr<Peer>> const& peers,
+    TriggerReason reason)
+{
+    // If we're querying blind, don't query much
+    if (reason != TriggerReason::reply || peers.empty())
+        return reqNodes;
+
+    std::size_t limit = 0;
+    for (auto const& peer : peers)
+        limit += mRequestSizes.limit(peer->id());
+    return limit;
+}
+
+void
+InboundLedger::sendNodeRequest(
+    protocol::TMGetLedger& tmGL,
+    NodeList const& nodes,
+    std::vector<std::shared_ptr<Peer>> const& peers,
+    TriggerReason reason)
+{
+    // Blind requests go to everyone with the same nodes
+    if (reason != TriggerReason::reply || peers.empty())
+    {
+        for (auto const& n : nodes)
+            *(tmGL.add_nodeids()) = n.first.getRawString();
+        sendRequest(tmGL, peers.empty() ? nullptr : peers.front());
+        return;
+    }
+
+    // Each peer gets its own run of the nodes, as many as it can take
+    std::size_t next = 0;
+    for (auto const& peer : peers)
+    {
+        if (next == nodes.size())
+            break;
+
+        auto const count = mRequestSizes.request(
+            peer->id(), nodes.size() - next, m_clock.now());
+
+        tmGL.clear_nodeids();
+        for (auto i = next; i < next + count; ++i)
+            *(tmGL.add_nodeids()) = nodes[i].first.getRawString();
+        next += count;
+
+        sendRequest(tmGL, peer);
+    }
+}
+
+void
+InboundLedger::onPeerReply(Peer::id_t id, std::size_t received)
+{
+    if (mRequestSizes.reply(id, received, m_clock.now()))
+        JLOG(m_journal.trace()) << "Peer " << id << " answered, next request "
+                                << mRequestSizes.limit(id) << " nodes";
+}
+
+void
+InboundLedger::decodeNodes(
+    std::vector<PeerDataPairType> const& data,
+    std::vector<DecodedNodes>& nodes)
+{
+    nodes.assign(data.size(), {});
+
+    std::vector<std::pair<std::size_t, int>> work;
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        auto const& packet = *data[i].second;
+        if (packet.type() != protocol::liTX_NODE &&
+            packet.type() != protocol::liAS_NODE &&
+            packet.type() != protocol::liCONTRACT_NODE)
+            continue;
+
+        nodes[i].resize(packet.nodes_size());
+        for (int j = 0; j < packet.nodes_size(); ++j)
+        {
+            if (packet.nodes(j).has_nodedata())
+                work.emplace_back(i, j);
+        }
+    }
+
+    // A node that can't be built stays null and is rejected as corrupt
+    auto decode = [&](std::size_t k) {
+        auto const [i, j] = work[k];
+        try
+        {
+            nodes[i][j] = SHAMapAbstractNode::makeFromWire(
+                makeSlice(data[i].second->nodes(j).nodedata()));
+        }
+        catch (std::exception const&)
+        {
+        }
+    };
+
+    if (work.size() >= decodeNodesParallel)
+    {
+        app_.getJobQueue().parallelFor(
+            jtLEDGER_DECODE,
+            "ledgerDecode",
+            work.size(),
+            decode,
+            app_.doJobCounter());
+    }
+    else
+    {
+        for (std::size_t k = 0; k < work.size(); ++k)
+            decode(k);
+    }
+}
+
 /** Take ledger header data
     Call with a lock
 */
@@ -1185,7 +1556,10 @@ InboundLedger::takeHeader(std::string const& data)
     Call with a lock
 */
 void
-InboundLedger::receiveNode(protocol::TMLedgerData& packet, SHAMapAddNode& san)
+InboundLedger::receiveNode(
+    protocol::TMLedgerData& packet,
+    DecodedNodes const& nodes,
+    SHAMapAddNode& san)
 {
     if (!mHaveHeader)
     {
@@ -1257,13 +1631,16 @@ InboundLedger::receiveNode(protocol::TMLedgerData& packet, SHAMapAddNode& san)
     auto& map = *pMap;
     try
     {
-        for (auto const& node : packet.nodes())
+        for (int i = 0; i < packet.nodes_size(); ++i)
         {
+            auto const& node = packet.nodes(i);
             SHAMapNodeID const nodeID(
                 node.nodeid().data(), node.nodeid().size());
             if (nodeID.isRoot())
                 san += map.addRootNode(
                     rootHash, makeSlice(node.nodedata()), filter.get());
+            else if (i < nodes.size())
+                san += map.addKnownNode(nodeID, nodes[i], filter.get());
             else
                 san += map.addKnownNode(
                     nodeID, makeSlice(node.nodedata()), filter.get());
@@ -1458,7 +1835,8 @@ InboundLedger::gotData(
 int
 InboundLedger::processData(
     std::shared_ptr<Peer> peer,
-    protocol::TMLedgerData& packet)
+    protocol::TMLedgerData& packet,
+    DecodedNodes const& nodes)
 {
     ScopedLockType sl(mLock);
     
@@ -1536,8 +1914,10 @@ InboundLedger::processData(
             }
         }
 
+        onPeerReply(peer->id(), packet.nodes_size());
+
         SHAMapAddNode san;
-        receiveNode(packet, san);
+        receiveNode(packet, nodes, san);
 
         if (packet.type() == protocol::liTX_NODE)
         {
@@ -1567,15 +1947,18 @@ InboundLedger::processData(
 }
 
 /** Process pending TMLedgerData
-    Query the 'best' peer
+    Query the peers that gave us useful nodes, best first
 */
 void
 InboundLedger::runData()
 {
     std::shared_ptr<Peer> chosenPeer;
     int chosenPeerCount = -1;
+    // useful nodes each peer gave us, in the order they responded
+    std::vector<std::pair<int, std::shared_ptr<Peer>>> useful;
 
     std::vector<PeerDataPairType> data;
+    std::vector<DecodedNodes> nodes;
 
     for (;;)
     {
@@ -1592,13 +1975,29 @@ InboundLedger::runData()
             data.swap(mReceivedData);
         }
 
+        // Building the nodes hashes them, which is most of the work of
+        // taking a reply, so it is done for the whole batch without the
+        // ledger lock. Only hooking them into the maps needs it.
+        decodeNodes(data, nodes);
+
         // Select the peer that gives us the most nodes that are useful,
         // breaking ties in favor of the peer that responded first.
-        for (auto& entry : data)
+        for (std::size_t i = 0; i < data.size(); ++i)
         {
-            if (auto peer = entry.first.lock())
+            if (auto peer = data[i].first.lock())
             {
-                int count = processData(peer, *(entry.second));
+                int count = processData(peer, *(data[i].second), nodes[i]);
+                if (count > 0)
+                {
+                    auto it = std::find_if(
+                        useful.begin(), useful.end(), [&](auto const& u) {
+                            return u.second == peer;
+                        });
+                    if (it == useful.end())
+                        useful.emplace_back(count, peer);
+                    else
+                        it->first += count;
+                }
                 if (count > chosenPeerCount)
                 {
                     chosenPeerCount = count;
@@ -1608,8 +2007,25 @@ InboundLedger::runData()
         }
     }
 
-    if (chosenPeer)
-        trigger(chosenPeer, TriggerReason::reply);
+    if (useful.empty())
+    {
+        if (chosenPeer)
+            trigger(chosenPeer, TriggerReason::reply);
+        return;
+    }
+
+    // Keep every peer that is delivering busy, each with its own nodes
+    std::stable_sort(
+        useful.begin(), useful.end(), [](auto const& a, auto const& b) {
+            return a.first > b.first;
+        });
+    if (useful.size() > fetchPeersMax)
+        useful.resize(fetchPeersMax);
+
+    std::vector<std::shared_ptr<Peer>> peers;
+    for (auto& u : useful)
+        peers.push_back(std::move(u.second));
+    trigger(peers, TriggerReason::reply);
 }
 
 Json::Value
@@ -1646,6 +2062,9 @@ InboundLedger::getJson(int)
 
     ret[jss::timeouts] = mTimeouts;
 
+    if (mSnapshot)
+        ret["snapshot"] = mSnapshot->getJson();
+
     if (mHaveHeader && !mHaveState)
     {
         Json::Value hv(Json::arrayValue);
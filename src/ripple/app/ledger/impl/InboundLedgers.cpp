@@ -204,6 +204,32 @@ public:
         return true;
     }
 
+    bool
+    gotStateLeaves(
+        LedgerHash const& hash,
+        std::shared_ptr<Peer> peer,
+        std::shared_ptr<protocol::TMStateLeaves> packet) override
+    {
+        JLOG(j_.trace()) << "Got " << packet->leaves_size()
+                         << " state leaves for acquiring ledger: " << hash;
+
+        auto ledger = find(hash);
+        if (!ledger)
+            return false;
+
+        // Replies for different ranges are taken in parallel, building a
+        // range when its last leaves arrive
+        app_.getJobQueue().addJob(
+            jtLEDGER_DECODE,
+            "processStateLeaves",
+            [ledger, wPeer = std::weak_ptr<Peer>(peer), packet](Job&) {
+                ledger->gotStateLeaves(wPeer, packet);
+            },
+            app_.doJobCounter());
+
+        return true;
+    }
+
     void
     logFailure(uint256 const& h, std::uint32_t seq) override
     {
@@ -23,6 +23,7 @@
 #include <peersafe/schema/Schema.h>
 #include <ripple/app/misc/NetworkOPs.h>
 #include <ripple/basics/Log.h>
+#include <ripple/beast/hash/xxhasher.h>
 #include <ripple/core/JobQueue.h>
 #include <ripple/protocol/RippleLedgerHash.h>
 #include <ripple/resource/Fees.h>
@@ -176,6 +177,27 @@ public:
             peer->charge(Resource::feeUnwantedData);
     }
 
+    void
+    gotTxSetIds(
+        uint256 const& hash,
+        std::shared_ptr<Peer> peer,
+        std::shared_ptr<protocol::TMTxSetIds> packet) override
+    {
+        TransactionAcquire::pointer ta = getAcquire(hash);
+
+        if (ta == nullptr)
+        {
+            peer->charge(Resource::feeUnwantedData);
+            return;
+        }
+
+        auto const result = ta->takeTxSetIds(*packet, peer);
+        if (result.isInvalid())
+            peer->charge(Resource::feeInvalidRequest);
+        else if (!result.isUseful())
+            peer->charge(Resource::feeUnwantedData);
+    }
+
     void
     giveSet(
         uint256 const& hash,
@@ -260,6 +282,38 @@ private:
 
 InboundTransactions::~InboundTransactions() = default;
 
+std::uint64_t
+txSetShortId(uint256 const& setHash, uint256 const& txID)
+{
+    // The same on every host, whatever its byte order
+    std::uint64_t seed = 0;
+    for (int i = 0; i < 8; ++i)
+        seed = (seed << 8) | setHash.data()[i];
+
+    beast::xxhasher h(seed);
+    h(txID.data(), txID.size());
+    return static_cast<std::uint64_t>(h);
+}
+
+std::shared_ptr<SHAMap>
+buildTxSet(uint256 const& setHash, TxSetTxs const& txs, Family& family)
+{
+    auto map = std::make_shared<SHAMap>(SHAMapType::TRANSACTION, family);
+    map->setUnbacked();
+
+    for (auto const& [id, tx] : txs)
+    {
+        Serializer s(2048);
+        tx->add(s);
+        map->addItem(
+            SHAMapItem(tx->getTransactionID(), std::move(s)), true, false);
+    }
+
+    if (map->getHash().as_uint256() != setHash)
+        return nullptr;
+    return map;
+}
+
 std::unique_ptr<InboundTransactions>
 make_InboundTransactions(
     Schema& app,
@@ -0,0 +1,488 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/app/ledger/impl/StateSnapshotSync.h>
+#include <ripple/basics/contract.h>
+#include <ripple/nodestore/Database.h>
+#include <ripple/overlay/Message.h>
+#include <ripple/protocol/jss.h>
+#include <ripple/resource/Fees.h>
+#include <ripple/shamap/Family.h>
+
+namespace ripple {
+
+enum {
+    // Ranges one peer works on at once, which bounds the leaves held
+    snapshotRangesPerPeer = 4
+
+    // Leaves asked for in one request
+    ,
+    snapshotLeavesRequest = 16384
+
+    // Peers that may get a range wrong before the map is given up
+    ,
+    snapshotBadPeersMax = 3
+};
+
+static bool
+isHashSized(std::string const& s)
+{
+    return s.size() == uint256::size();
+}
+
+StateSnapshotSync::StateSnapshotSync(
+    Schema& app,
+    uint256 const& ledgerHash,
+    std::uint32_t seq,
+    beast::Journal journal)
+    : app_(app), mHash(ledgerHash), mSeq(seq), j_(journal)
+{
+}
+
+void
+StateSnapshotSync::addMap(uint256 const& rootHash, bool contract)
+{
+    std::lock_guard sl(mLock);
+
+    // The state map is split by the first two nibbles, contract storage
+    // maps are usually small and split by the first one
+    mMaps.try_emplace(
+        rootHash, contract ? 1 : 2, [this](SHAMapAbstractNode const& node) {
+            write(node);
+        });
+}
+
+StateSnapshotSync::Status
+StateSnapshotSync::status(uint256 const& rootHash) const
+{
+    std::lock_guard sl(mLock);
+
+    auto const it = mMaps.find(rootHash);
+    if (it == mMaps.end())
+        return Status::none;
+    return it->second.status;
+}
+
+std::vector<SHAMapNodeID>
+StateSnapshotSync::missingTop(uint256 const& rootHash)
+{
+    // Maps are never removed, so the map outlives the lock
+    Map* map;
+    {
+        std::lock_guard sl(mLock);
+
+        auto const it = mMaps.find(rootHash);
+        if (it == mMaps.end() || it->second.status != Status::pending ||
+            !it->second.expected.empty())
+            return {};
+        map = &it->second;
+    }
+
+    // No range is built before the top is known, reading it needs no lock
+    auto& db = app_.getNodeFamily().db();
+    std::vector<SHAMapHash> hashes;
+    std::vector<SHAMapNodeID> missing;
+    bool valid;
+    try
+    {
+        valid = map->builder.rangeHashes(
+            SHAMapHash{rootHash},
+            [&](SHAMapHash const& hash) -> std::shared_ptr<SHAMapAbstractNode> {
+                auto const obj = db.fetch(hash.as_uint256(), mSeq);
+                if (!obj)
+                    return nullptr;
+                return SHAMapAbstractNode::makeFromPrefix(
+                    makeSlice(obj->getData()), hash);
+            },
+            hashes,
+            missing);
+    }
+    catch (std::exception const& e)
+    {
+        JLOG(j_.warn()) << "Can't read the top of " << rootHash << ": "
+                        << e.what();
+        valid = false;
+    }
+
+    std::lock_guard sl(mLock);
+    if (map->status != Status::pending)
+        return {};
+
+    if (!valid)
+    {
+        JLOG(j_.warn()) << "The top of " << rootHash << " in ledger " << mSeq
+                        << " isn't that of a map, fetching it by nodes";
+        map->status = Status::failed;
+        return {};
+    }
+
+    if (missing.empty())
+        map->expected.swap(hashes);
+    return missing;
+}
+
+void
+StateSnapshotSync::trigger(
+    std::vector<std::shared_ptr<Peer>> const& peers,
+    bool timeout)
+{
+    std::lock_guard sl(mLock);
+
+    if (peers.empty())
+        return;
+
+    std::map<Peer::id_t, std::size_t> busy;
+    for (auto& [rootHash, map] : mMaps)
+    {
+        if (map.status != Status::pending || map.expected.empty())
+            continue;
+
+        for (auto& range : map.ranges)
+        {
+            if (range.complete || range.peer == 0)
+                continue;
+
+            if (timeout && !range.progress)
+                range.peer = 0;
+            else
+                ++busy[range.peer];
+
+            if (timeout)
+                range.progress = false;
+        }
+    }
+
+    // Hand the idle ranges out in turn to the peers that have room and
+    // didn't get the range wrong before
+    std::size_t next = 0;
+    auto const pick = [&](Range const& range) -> std::shared_ptr<Peer> {
+        for (std::size_t i = 0; i < peers.size(); ++i)
+        {
+            auto const& peer = peers[(next + i) % peers.size()];
+            if (busy[peer->id()] < snapshotRangesPerPeer &&
+                range.bad.count(peer->id()) == 0)
+            {
+                next = (next + i + 1) % peers.size();
+                return peer;
+            }
+        }
+        return nullptr;
+    };
+
+    for (auto& [rootHash, map] : mMaps)
+    {
+        if (map.status != Status::pending || map.expected.empty())
+            continue;
+
+        for (std::size_t i = 0; i < map.ranges.size(); ++i)
+        {
+            auto& range = map.ranges[i];
+            if (range.complete || range.peer != 0)
+                continue;
+
+            auto const peer = pick(range);
+            if (!peer)
+                continue;
+
+            ++busy[peer->id()];
+            request(rootHash, map, i, peer);
+        }
+    }
+}
+
+int
+StateSnapshotSync::takeLeaves(
+    std::shared_ptr<Peer> const& peer,
+    protocol::TMStateLeaves const& packet,
+    bool& finished,
+    bool& retry)
+{
+    finished = false;
+    retry = false;
+
+    if (!isHashSized(packet.roothash()) ||
+        !isHashSized(packet.last()) ||
+        (packet.has_after() && !isHashSized(packet.after())))
+        return -1;
+
+    uint256 const rootHash{packet.roothash()};
+    uint256 const last{packet.last()};
+    boost::optional<uint256> after;
+    if (packet.has_after())
+        after = uint256{packet.after()};
+
+    uint256 first;
+    std::size_t index;
+    {
+        std::lock_guard sl(mLock);
+
+        auto const it = mMaps.find(rootHash);
+        if (it == mMaps.end() || it->second.status != Status::pending ||
+            it->second.expected.empty())
+            return 0;
+
+        auto& map = it->second;
+        index = map.builder.rangeOf(last);
+        if (map.builder.last(index) != last)
+            return -1;
+
+        auto& range = map.ranges[index];
+        if (range.complete || range.after != after ||
+            range.bad.count(peer->id()) != 0)
+        {
+            // Asked again elsewhere and already answered, or from a peer
+            // that got the range wrong
+            return 0;
+        }
+
+        if (packet.has_error())
+        {
+            JLOG(j_.debug()) << "Peer " << peer->id() << " can't give range "
+                             << index << " of " << rootHash;
+            if (range.peer == peer->id())
+                range.peer = 0;
+            return 0;
+        }
+
+        first = map.builder.first(index);
+    }
+
+    if (packet.leaves_size() == 0 && !packet.complete())
+        return -1;
+
+    // The leaves must follow on from the ones taken and stay in the range
+    std::vector<SHAMapLeafBuilder::Leaf> leaves;
+    leaves.reserve(packet.leaves_size());
+    for (auto const& leaf : packet.leaves())
+    {
+        if (!isHashSized(leaf.key()) ||
+            (leaf.has_storageroot() &&
+             !isHashSized(leaf.storageroot())) ||
+            leaf.data().size() < 12)
+            return -1;
+
+        uint256 const key{leaf.key()};
+        if (key > last || key < first)
+            return -1;
+        if (leaves.empty() ? (after && key <= *after)
+                           : key <= leaves.back().item->key())
+            return -1;
+
+        SHAMapLeafBuilder::Leaf l;
+        l.item = std::make_shared<SHAMapItem const>(
+            key, Blob(leaf.data().begin(), leaf.data().end()));
+        if (leaf.has_storageroot())
+            l.storageRoot = uint256{leaf.storageroot()};
+        leaves.push_back(std::move(l));
+    }
+
+    int const taken = leaves.size();
+    std::vector<SHAMapLeafBuilder::Leaf> build;
+    // Maps are never removed, so the map outlives the lock
+    Map* map;
+    {
+        std::lock_guard sl(mLock);
+
+        auto const it = mMaps.find(rootHash);
+        if (it == mMaps.end() || it->second.status != Status::pending)
+            return 0;
+
+        map = &it->second;
+        auto& range = map->ranges[index];
+        if (range.complete || range.after != after ||
+            range.bad.count(peer->id()) != 0)
+            return 0;
+
+        if (!leaves.empty())
+            range.after = leaves.back().item->key();
+        range.leaves.insert(
+            range.leaves.end(),
+            std::make_move_iterator(leaves.begin()),
+            std::make_move_iterator(leaves.end()));
+        range.progress = true;
+        range.peer = peer->id();
+        range.sources.emplace(peer->id(), peer);
+        map->leaves += taken;
+
+        if (!packet.complete())
+        {
+            request(rootHash, *map, index, peer);
+            return taken;
+        }
+
+        range.complete = true;
+        range.peer = 0;
+        build.swap(range.leaves);
+    }
+
+    // Build the range without the lock, other ranges build alongside
+    boost::optional<SHAMapHash> hash;
+    try
+    {
+        hash = map->builder.build(index, build);
+    }
+    catch (std::exception const& e)
+    {
+        JLOG(j_.warn()) << "Can't build range " << index << " of " << rootHash
+                        << ": " << e.what();
+    }
+
+    // Charged once the lock is released
+    std::vector<std::shared_ptr<Peer>> charge;
+    {
+        std::lock_guard sl(mLock);
+        if (map->status != Status::pending)
+            return taken;
+
+        auto& range = map->ranges[index];
+        if (!hash || *hash != map->expected[index])
+        {
+            JLOG(j_.warn()) << "Range " << index << " of " << rootHash
+                            << " from " << range.sources.size()
+                            << " peers doesn't build to its hash";
+
+            // Start the range over, from the other peers
+            for (auto const& [id, source] : range.sources)
+            {
+                range.bad.insert(id);
+                if (auto p = source.lock())
+                    charge.push_back(std::move(p));
+            }
+            range.sources.clear();
+            range.after = boost::none;
+            map->leaves -= build.size();
+            range.progress = false;
+            range.complete = false;
+
+            if (range.bad.size() >= snapshotBadPeersMax)
+            {
+                JLOG(j_.warn()) << "Giving up rebuilding " << rootHash
+                                << " in ledger " << mSeq
+                                << ", fetching it by nodes";
+                map->status = Status::failed;
+                finished = true;
+            }
+            else
+                retry = true;
+        }
+        else
+        {
+            JLOG(j_.trace()) << "Built range " << index << " of " << rootHash
+                             << " from " << build.size() << " leaves";
+
+            range.sources.clear();
+            if (++map->built == map->ranges.size())
+            {
+                finishMap(rootHash, *map);
+                finished = true;
+            }
+        }
+    }
+
+    for (auto const& p : charge)
+        p->charge(Resource::feeBadData);
+
+    return taken;
+}
+
+void
+StateSnapshotSync::request(
+    uint256 const& rootHash,
+    Map& map,
+    std::size_t range,
+    std::shared_ptr<Peer> const& peer)
+{
+    auto& r = map.ranges[range];
+    auto const last = map.builder.last(range);
+
+    protocol::TMGetStateLeaves packet;
+    packet.set_ledgerhash(mHash.begin(), mHash.size());
+    packet.set_roothash(rootHash.begin(), rootHash.size());
+    if (r.after)
+        packet.set_after(r.after->begin(), r.after->size());
+    packet.set_last(last.begin(), last.size());
+    packet.set_maxleaves(snapshotLeavesRequest);
+    packet.set_schemaid(app_.schemaId().begin(), uint256::size());
+
+    r.peer = peer->id();
+    peer->send(
+        std::make_shared<Message>(packet, protocol::mtGET_STATE_LEAVES));
+}
+
+void
+StateSnapshotSync::write(SHAMapAbstractNode const& node)
+{
+    Serializer s;
+    node.addRaw(s, snfPREFIX);
+    app_.getNodeFamily().db().store(
+        hotACCOUNT_NODE,
+        std::move(s.modData()),
+        node.getNodeHash().as_uint256(),
+        mSeq);
+}
+
+void
+StateSnapshotSync::finishMap(uint256 const& rootHash, Map& map)
+{
+    // Every range built to its hash, so this only fails if the top
+    // nodes in the store are wrong
+    auto const hash = map.builder.finish();
+    if (hash.as_uint256() != rootHash)
+    {
+        JLOG(j_.warn()) << "Leaves of " << rootHash << " in ledger " << mSeq
+                        << " hash to " << hash << ", fetching it by nodes";
+        map.status = Status::failed;
+        return;
+    }
+
+    JLOG(j_.info()) << "Rebuilt " << rootHash << " in ledger " << mSeq
+                    << " from " << map.leaves << " leaves";
+    map.status = Status::done;
+}
+
+Json::Value
+StateSnapshotSync::getJson() const
+{
+    std::lock_guard sl(mLock);
+
+    Json::Value ret(Json::arrayValue);
+    for (auto const& [rootHash, map] : mMaps)
+    {
+        Json::Value& entry = ret.append(Json::objectValue);
+        entry["root"] = to_string(rootHash);
+        entry["leaves"] = static_cast<Json::UInt>(map.leaves);
+        entry["ranges_built"] = static_cast<Json::UInt>(map.built);
+        entry["ranges"] = static_cast<Json::UInt>(map.ranges.size());
+        switch (map.status)
+        {
+            case Status::pending:
+                entry[jss::status] = "pending";
+                break;
+            case Status::done:
+                entry[jss::status] = "done";
+                break;
+            default:
+                entry[jss::status] = "failed";
+                break;
+        }
+    }
+    return ret;
+}
+
+}  // namespace ripple
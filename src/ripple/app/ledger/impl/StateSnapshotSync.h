@@ -0,0 +1,152 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_APP_LEDGER_STATESNAPSHOTSYNC_H_INCLUDED
+#define RIPPLE_APP_LEDGER_STATESNAPSHOTSYNC_H_INCLUDED
+
+#include <peersafe/schema/Schema.h>
+#include <ripple/json/json_value.h>
+#include <ripple/overlay/Peer.h>
+#include <ripple/shamap/SHAMapLeafBuilder.h>
+#include <map>
+#include <mutex>
+#include <set>
+
+namespace ripple {
+
+// Rebuilds the state map of a ledger, and its contract storage maps, from
+// their leaves instead of fetching them node by node.
+//
+// The top of each map, the root and for the state map the inner nodes
+// below it, is fetched node by node first; it names the hash every range
+// must build to. Peers then stream the leaves of each range in key order,
+// in large chunks. A range is built into the node store as soon as its
+// last leaves arrive, on the job that took them, so ranges are built in
+// parallel. The ledger hash is trusted, the peers are not: a range that
+// doesn't build to its hash is charged to the peers that sent it and asked
+// of another peer. A map with a range too many peers got wrong is failed
+// and InboundLedger fetches it node by node, finding the nodes that were
+// right in the store.
+//
+// Owned by an InboundLedger, which calls it with or without its own lock.
+class StateSnapshotSync
+{
+public:
+    enum class Status { none, pending, done, failed };
+
+    StateSnapshotSync(
+        Schema& app,
+        uint256 const& ledgerHash,
+        std::uint32_t seq,
+        beast::Journal journal);
+
+    /** Start rebuilding the map with this root. */
+    void
+    addMap(uint256 const& rootHash, bool contract);
+
+    Status
+    status(uint256 const& rootHash) const;
+
+    /** Read the top of a pending map from the node store.
+        @return the nodes to fetch before its ranges can be asked for,
+                empty once they are known. Fails the map if the top isn't
+                that of a map.
+    */
+    std::vector<SHAMapNodeID>
+    missingTop(uint256 const& rootHash);
+
+    /** Ask the peers for the ranges nobody is working on. On a timeout the
+        ranges that made no progress since the last one are given up first.
+    */
+    void
+    trigger(std::vector<std::shared_ptr<Peer>> const& peers, bool timeout);
+
+    /** Take a reply.
+        @return the number of leaves taken, -1 for an invalid reply
+        @param finished set when a map is done or failed
+        @param retry set when a range was given up and can go to another
+                     peer
+    */
+    int
+    takeLeaves(
+        std::shared_ptr<Peer> const& peer,
+        protocol::TMStateLeaves const& packet,
+        bool& finished,
+        bool& retry);
+
+    Json::Value
+    getJson() const;
+
+private:
+    struct Range
+    {
+        // The last key taken, the next request asks for keys above it
+        boost::optional<uint256> after;
+        std::vector<SHAMapLeafBuilder::Leaf> leaves;
+        // The peer working on the range, 0 for none
+        Peer::id_t peer = 0;
+        // The peers the leaves taken came from
+        std::map<Peer::id_t, std::weak_ptr<Peer>> sources;
+        // The peers that sent leaves not building to the range's hash
+        std::set<Peer::id_t> bad;
+        bool progress = false;
+        bool complete = false;
+    };
+
+    struct Map
+    {
+        Map(int rangeDepth, SHAMapLeafBuilder::Writer write)
+            : builder(rangeDepth, std::move(write)), ranges(builder.ranges())
+        {
+        }
+
+        SHAMapLeafBuilder builder;
+        std::vector<Range> ranges;
+        // The hash each range must build to, empty until the top is known
+        std::vector<SHAMapHash> expected;
+        std::size_t built = 0;
+        std::size_t leaves = 0;
+        Status status = Status::pending;
+    };
+
+    void
+    request(
+        uint256 const& rootHash,
+        Map& map,
+        std::size_t range,
+        std::shared_ptr<Peer> const& peer);
+
+    void
+    write(SHAMapAbstractNode const& node);
+
+    void
+    finishMap(uint256 const& rootHash, Map& map);
+
+    Schema& app_;
+    uint256 const mHash;
+    std::uint32_t const mSeq;
+    beast::Journal j_;
+
+    mutable std::mutex mLock;
+    std::map<uint256, Map> mMaps;
+};
+
+}  // namespace ripple
+
+#endif
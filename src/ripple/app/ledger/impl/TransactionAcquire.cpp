@@ -23,8 +23,13 @@
 #include <ripple/app/ledger/InboundTransactions.h>
 #include <peersafe/schema/Schema.h>
 #include <peersafe/schema/PeerManager.h>
+#include <ripple/overlay/Message.h>
 #include <ripple/overlay/Overlay.h>
 #include <ripple/app/misc/NetworkOPs.h>
+#include <ripple/app/misc/Transaction.h>
+#include <peersafe/app/misc/TxPool.h>
+#include <peersafe/app/util/Common.h>
+#include <algorithm>
 #include <memory>
 
 namespace ripple {
@@ -37,11 +42,24 @@ auto constexpr TX_ACQUIRE_TIMEOUT = 250ms;
 enum {
     NORM_TIMEOUTS = 4,
     MAX_TIMEOUTS = 20,
+
+    // Timeouts without an answer before fetching the set by nodes instead
+    RECONCILE_TIMEOUTS = 2,
+
+    // Replies without any tx we wanted before doing the same
+    RECONCILE_STALLS = 3,
+
+    // Short ids a set may have
+    MAX_SET_IDS = 262144,
 };
 
 TransactionAcquire::TransactionAcquire(Schema& app, uint256 const& hash)
     : PeerSet(app, hash, TX_ACQUIRE_TIMEOUT, app.journal("TransactionAcquire"))
     , mHaveRoot(false)
+    , mReconcile(app.config().RECONCILE_TX_SETS)
+    , mHaveIds(false)
+    , mRequested(false)
+    , mStalls(0)
 {
     mMap = std::make_shared<SHAMap>(
         SHAMapType::TRANSACTION, hash, app_.getNodeFamily());
@@ -96,7 +114,9 @@ TransactionAcquire::onTimer(bool progress, ScopedLockType& psl)
         return;
     }
 
-    if (mTimeouts >= NORM_TIMEOUTS)
+    if (mReconcile && !progress && mTimeouts >= RECONCILE_TIMEOUTS)
+        stopReconcile("no answer");
+    else if (mTimeouts >= NORM_TIMEOUTS)
         trigger(nullptr);
 
     addPeers(1);
@@ -122,6 +142,12 @@ TransactionAcquire::trigger(std::shared_ptr<Peer> const& peer)
         return;
     }
 
+    if (mReconcile)
+    {
+        triggerReconcile(peer);
+        return;
+    }
+
     if (!mHaveRoot)
     {
         JLOG(m_journal.trace()) << "TransactionAcquire::trigger "
@@ -244,6 +270,199 @@ TransactionAcquire::takeNodes(
     }
 }
 
+void
+TransactionAcquire::triggerReconcile(std::shared_ptr<Peer> const& peer)
+{
+    // One request at a time, the timer asks again if it goes unanswered
+    if (peer && mRequested)
+        return;
+
+    auto target = peer;
+    for (auto it = mPeers.begin(); !target && it != mPeers.end(); ++it)
+        target = app_.peerManager().findPeerByShortID(*it);
+    if (!target)
+        return;
+
+    protocol::TMGetTxSetIds packet;
+    packet.set_sethash(mHash.begin(), mHash.size());
+    packet.set_schemaid(app_.schemaId().begin(), uint256::size());
+
+    if (mHaveIds)
+    {
+        Serializer wanted;
+        for (auto const& [id, tx] : mTxs)
+        {
+            if (!tx)
+                wanted.add64(id);
+        }
+        packet.set_wanted(wanted.data(), wanted.size());
+    }
+
+    JLOG(m_journal.trace()) << "Asking peer " << target->id() << " for "
+                            << (mHaveIds ? "missing txs" : "short ids")
+                            << " of TX set " << mHash;
+
+    mRequested = true;
+    target->send(
+        std::make_shared<Message>(packet, protocol::mtGET_TX_SET_IDS));
+}
+
+std::size_t
+TransactionAcquire::matchPool()
+{
+    return matchTxSetIds(mHash, mTxs, [this](auto&& f) {
+        app_.getTxPool().forEachTx(
+            [&](std::shared_ptr<Transaction> const& tx) {
+                f(tx->getSTransaction());
+            });
+    });
+}
+
+void
+TransactionAcquire::buildFromIds()
+{
+    auto map = buildTxSet(mHash, mTxs, app_.getNodeFamily());
+    if (!map)
+    {
+        // A short id matched the wrong tx
+        stopReconcile("rebuilt set has another hash");
+        return;
+    }
+
+    JLOG(m_journal.debug()) << "Rebuilt TX set " << mHash << " from "
+                            << mTxs.size() << " short ids";
+    mTxs.clear();
+    mMap = std::move(map);
+    mHaveRoot = true;
+    mComplete = true;
+    done();
+}
+
+void
+TransactionAcquire::stopReconcile(char const* reason)
+{
+    JLOG(m_journal.debug()) << "Can't reconcile TX set " << mHash << ": "
+                            << reason << ", fetching it by nodes";
+    mReconcile = false;
+    mTxs.clear();
+    trigger(nullptr);
+}
+
+SHAMapAddNode
+TransactionAcquire::takeTxSetIds(
+    protocol::TMTxSetIds const& packet,
+    std::shared_ptr<Peer> const& peer)
+{
+    ScopedLockType sl(mLock);
+
+    if (mComplete || mFailed || !mReconcile)
+    {
+        JLOG(m_journal.trace()) << "TX set not reconciling";
+        return SHAMapAddNode();
+    }
+
+    if (packet.has_error())
+    {
+        JLOG(m_journal.debug())
+            << "Peer " << peer->id() << " doesn't have TX set " << mHash;
+        mRequested = false;
+        return SHAMapAddNode();
+    }
+
+    if (packet.has_shortids())
+    {
+        auto const& ids = packet.shortids();
+        if (ids.empty() || ids.size() % 8 != 0 ||
+            ids.size() / 8 > MAX_SET_IDS)
+            return SHAMapAddNode::invalid();
+
+        if (mHaveIds)
+        {
+            JLOG(m_journal.trace()) << "Got short ids, already have them";
+            return SHAMapAddNode::duplicate();
+        }
+
+        SerialIter sit(makeSlice(ids));
+        while (!sit.empty())
+        {
+            if (!mTxs.emplace(sit.get64(), nullptr).second)
+            {
+                // Two txs of the set share a short id
+                stopReconcile("short ids collide");
+                return SHAMapAddNode::useful();
+            }
+        }
+        mHaveIds = true;
+
+        auto const missing = matchPool();
+        JLOG(m_journal.debug())
+            << "TX set " << mHash << " has " << mTxs.size() << " txs, "
+            << missing << " not in the pool";
+    }
+    else if (!mHaveIds)
+    {
+        return SHAMapAddNode::invalid();
+    }
+
+    // The short ids are progress, after that only txs we still wanted are
+    bool progress = packet.has_shortids();
+    SHAMapAddNode ret = SHAMapAddNode::useful();
+    for (auto const& raw : packet.transactions())
+    {
+        std::shared_ptr<STTx const> stx;
+        try
+        {
+            stx = makeSTTx(makeSlice(raw));
+        }
+        catch (std::exception const&)
+        {
+            JLOG(m_journal.warn()) << "Peer sends us junky transaction";
+            return SHAMapAddNode::invalid();
+        }
+
+        auto const it =
+            mTxs.find(txSetShortId(mHash, stx->getTransactionID()));
+        if (it == mTxs.end())
+            return SHAMapAddNode::invalid();
+        if (it->second)
+        {
+            ret.incDuplicate();
+            continue;
+        }
+        it->second = stx;
+        progress = true;
+
+        // Not in our pool, so we likely haven't seen it
+        auto const pap = &app_;
+        app_.getJobQueue().addJob(
+            jtTRANSACTION, "TXS->TXN", [pap, stx](Job&) {
+                pap->getOPs().submitTransaction(stx);
+            }, app_.doJobCounter());
+    }
+
+    mRequested = false;
+
+    if (!progress)
+    {
+        // The timer asks again, unless the peers keep sending nothing new
+        if (++mStalls >= RECONCILE_STALLS)
+            stopReconcile("no progress");
+        return SHAMapAddNode::duplicate();
+    }
+
+    mProgress = true;
+    mStalls = 0;
+
+    auto const complete = std::all_of(
+        mTxs.begin(), mTxs.end(), [](auto const& p) { return !!p.second; });
+    if (complete)
+        buildFromIds();
+    else
+        trigger(peer);
+
+    return ret;
+}
+
 void
 TransactionAcquire::addPeers(std::size_t limit)
 {
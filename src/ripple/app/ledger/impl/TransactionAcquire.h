@@ -21,7 +21,10 @@
 #define RIPPLE_APP_LEDGER_TRANSACTIONACQUIRE_H_INCLUDED
 
 #include <peersafe/schema/Schema.h>
+#include <ripple/app/ledger/InboundTransactions.h>
 #include <ripple/overlay/PeerSet.h>
+#include <ripple/protocol/STTx.h>
+#include <ripple/protocol/messages.h>
 #include <ripple/shamap/SHAMap.h>
 
 namespace ripple {
@@ -52,6 +55,11 @@ public:
         const std::list<Blob>& data,
         std::shared_ptr<Peer> const&);
 
+    SHAMapAddNode
+    takeTxSetIds(
+        protocol::TMTxSetIds const& packet,
+        std::shared_ptr<Peer> const&);
+
     void
     init(int startPeers);
 
@@ -62,6 +70,15 @@ private:
     std::shared_ptr<SHAMap> mMap;
     bool mHaveRoot;
 
+    // Reconciling the set against the pool: the short ids of the set, each
+    // with its transaction once we have it
+    bool mReconcile;
+    bool mHaveIds;
+    bool mRequested;
+    // Replies in a row that gave us nothing we wanted
+    int mStalls;
+    TxSetTxs mTxs;
+
     void
     queueJob() override;
 
@@ -82,6 +99,19 @@ private:
 
     void
     trigger(std::shared_ptr<Peer> const&);
+
+    void
+    triggerReconcile(std::shared_ptr<Peer> const&);
+
+    std::size_t
+    matchPool();
+
+    void
+    buildFromIds();
+
+    void
+    stopReconcile(char const* reason);
+
     std::weak_ptr<PeerSet>
     pmDowncast() override;
 };
@@ -79,6 +79,7 @@
 #include <peersafe/app/misc/CACertSite.h>
 #include <peersafe/app/misc/CertList.h>
 #include <peersafe/app/misc/ContractHelper.h>
+#include <peersafe/app/misc/MemoryGovernor.h>
 #include <peersafe/app/misc/StateManager.h>
 #include <peersafe/app/misc/TxPool.h>
 #include <peersafe/app/sql/TxStore.h>
@@ -185,6 +186,7 @@ public:
     std::unique_ptr<ServerHandler> serverHandler_;
     std::unique_ptr<LoadManager> m_loadManager;
     std::unique_ptr<PromethExposer> m_promethExposer;
+    std::unique_ptr<MemoryGovernor> m_memoryGovernor;
     std::unique_ptr<SchemaManager> m_schemaManager;
     std::unique_ptr<Overlay> m_overlay;
     std::unique_ptr<PeerCertList> m_peerCertList;
@@ -286,6 +288,10 @@ public:
             toBase58(TokenType::NodePublic, validatorKeys_.publicKey),
             logs_->journal("PromethExposer")))
 
+        , m_memoryGovernor(std::make_unique<MemoryGovernor>(
+              *config_,
+              logs_->journal("MemoryGovernor")))
+
         , m_schemaManager(std::make_unique<SchemaManager>(
               *this,
               logs_->journal("SchemaManager")))
@@ -570,6 +576,12 @@ public:
         return *m_schemaManager;
     }
 
+    MemoryGovernor&
+    getMemoryGovernor() override
+    {
+        return *m_memoryGovernor;
+    }
+
     NetworkOPs&
     getOPs(SchemaID const& id = beast::zero) override
     {
@@ -617,7 +629,7 @@ public:
         return m_schemaManager->getSchema(id)->getInboundTransactions();
     }
 
-    TaggedCache<uint256, AcceptedLedger>&
+    ShardedTaggedCache<uint256, AcceptedLedger>&
     getAcceptedLedgerCache(SchemaID const& id) override
     {
         assert(m_schemaManager->contains(id));
@@ -1052,6 +1064,7 @@ public:
         m_schemaManager->foreach([](std::shared_ptr<Schema> schema) {
               schema->doSweep();
         });
+        m_memoryGovernor->rebalance();
         // Set timer to do another sweep later.
         setSweepTimer();
     }
@@ -22,6 +22,7 @@
 
 #include <ripple/shamap/FullBelowCache.h>
 #include <ripple/shamap/TreeNodeCache.h>
+#include <ripple/basics/ShardedTaggedCache.h>
 #include <ripple/basics/TaggedCache.h>
 #include <ripple/rpc/ServerHandler.h>
 #include <ripple/core/Config.h>
@@ -105,6 +106,7 @@ class SHAMapStore;
 class ResolverAsio;
 class ValidatorKeys;
 class SchemaManager;
+class MemoryGovernor;
 class PeerManager;
 class PeerReservationTable;
 
@@ -200,6 +202,9 @@ public:
     virtual SchemaManager&
     getSchemaManager() = 0;
 
+    virtual MemoryGovernor&
+    getMemoryGovernor() = 0;
+
     virtual bool
     hasSchema(SchemaID const& id = beast::zero) = 0;
     virtual Schema&
@@ -250,7 +255,7 @@ public:
     getInboundLedgers(SchemaID const& id = beast::zero) = 0;
     virtual InboundTransactions&
     getInboundTransactions(SchemaID const& id = beast::zero) = 0;
-    virtual TaggedCache<uint256, AcceptedLedger>&
+    virtual ShardedTaggedCache<uint256, AcceptedLedger>&
     getAcceptedLedgerCache(SchemaID const& id = beast::zero) = 0;
     virtual LedgerMaster&
     getLedgerMaster(SchemaID const& id = beast::zero) = 0;
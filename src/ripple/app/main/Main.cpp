@@ -182,12 +182,14 @@ printHelp(const po::options_description& desc)
            "     stop [<schemaid>]\n"
            "     submit <tx_blob>|[<private_key> <tx_json>]\n"
            "     submit_multisigned <tx_json>\n"
-           "     t_dump <sync> <path>\n"
+           "     t_dump <sync> <path> [<conditions>]\n"
            "     t_dumpstop <account> <tableName>\n"
            "     t_dumpposition <account> <tableName>\n"
-           "     t_audit <sync> <sqlSelect> <path>\n"
+           "     t_audit <sync> <sqlSelect>|<raw> <path>\n"
            "     t_auditstop <job_id>\n"
            "     t_auditposition <job_id>\n"
+           "     t_snapshot <account> <tableName> <path>\n"
+           "     t_snapshot_load <path>\n"
            "     tx_count\n"
            "     tx <id>\n"
            "     tx_merkle_proof <id> [binary]\n"
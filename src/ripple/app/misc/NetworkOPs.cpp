@@ -3204,6 +3204,40 @@ NetworkOPsImp::getAccountTxsB(
     return ret;
 }
 
+// Pages of account_tx read from the SQL tables
+static AccountTxSQLPage
+makeSQLPage(
+    Schema& app,
+    AccountID const& account,
+    bool forward,
+    std::uint32_t page_length)
+{
+    auto const page =
+        app.config().SAVE_TX_RAW ? accountTxPageSQL : accountTxPage;
+    return [&app, page, account, forward, page_length](
+               auto const& onTransaction,
+               std::int32_t minLedger,
+               std::int32_t maxLedger,
+               std::optional<NetworkOPs::AccountTxMarker>& marker,
+               int limit,
+               bool bAdmin) {
+        page(
+            app,
+            app.getTxnDB().connRead(),
+            app.accountIDCache(),
+            std::bind(saveLedgerAsync, std::ref(app), std::placeholders::_1),
+            onTransaction,
+            account,
+            minLedger,
+            maxLedger,
+            forward,
+            marker,
+            limit,
+            bAdmin,
+            page_length);
+    };
+}
+
 NetworkOPsImp::AccountTxs
 NetworkOPsImp::getTxsAccount(
     AccountID const& account,
@@ -3226,13 +3260,13 @@ NetworkOPsImp::getTxsAccount(
         convertBlobsToTxResult(ret, ledger_index, rawTxn, rawMeta, app);
     };
 
-    if (app_.config().SAVE_TX_RAW)
+    auto const sqlPage = makeSQLPage(app_, account, forward, page_length);
+    if (auto index = app_.getTxnDB().txIndex())
     {
-        accountTxPageSQL(
+        accountTxPageIndex(
             app_,
-            app_.getTxnDB().connRead(),
-            app_.accountIDCache(),
-            std::bind(saveLedgerAsync, std::ref(app_), std::placeholders::_1),
+            *index,
+            sqlPage,
             bound,
             account,
             minLedger,
@@ -3245,20 +3279,7 @@ NetworkOPsImp::getTxsAccount(
     }
     else
     {
-        accountTxPage(
-            app_,
-            app_.getTxnDB().connRead(),
-            app_.accountIDCache(),
-            std::bind(saveLedgerAsync, std::ref(app_), std::placeholders::_1),
-            bound,
-            account,
-            minLedger,
-            maxLedger,
-            forward,
-            marker,
-            limit,
-            bUnlimited,
-            page_length);
+        sqlPage(bound, minLedger, maxLedger, marker, limit, bUnlimited);
     }
     
 
@@ -3286,13 +3307,13 @@ NetworkOPsImp::getTxsAccountB(
         ret.emplace_back(strHex(rawTxn), strHex(rawMeta), ledgerIndex);
     };
 
-    if (app_.config().SAVE_TX_RAW)
+    auto const sqlPage = makeSQLPage(app_, account, forward, page_length);
+    if (auto index = app_.getTxnDB().txIndex())
     {
-        accountTxPageSQL(
+        accountTxPageIndex(
             app_,
-            app_.getTxnDB().connRead(),
-            app_.accountIDCache(),
-            std::bind(saveLedgerAsync, std::ref(app_), std::placeholders::_1),
+            *index,
+            sqlPage,
             bound,
             account,
             minLedger,
@@ -3305,20 +3326,7 @@ NetworkOPsImp::getTxsAccountB(
     }
     else
     {
-        accountTxPage(
-            app_,
-            app_.getTxnDB().connRead(),
-            app_.accountIDCache(),
-            std::bind(saveLedgerAsync, std::ref(app_), std::placeholders::_1),
-            bound,
-            account,
-            minLedger,
-            maxLedger,
-            forward,
-            marker,
-            limit,
-            bUnlimited,
-            page_length);
+        sqlPage(bound, minLedger, maxLedger, marker, limit, bUnlimited);
     }
 
     return ret;
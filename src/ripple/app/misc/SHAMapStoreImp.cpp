@@ -187,6 +187,12 @@ SHAMapStoreImp::SHAMapStoreImp(
 
     if (deleteInterval_)
     {
+        // Rotation works on directories, a shared DB has only one
+        if (get<int>(section, "shared") != 0)
+            Throw<std::runtime_error>(
+                "online_delete can not be used with a shared [" +
+                ConfigSection::nodeDatabase() + "]");
+
         // Configuration that affects the behavior of online delete
         get_if_exists(section, "delete_batch", deleteBatch_);
         std::uint32_t temp;
@@ -672,6 +678,12 @@ SHAMapStoreImp::clearPrior(LedgerIndex lastRotated)
 
     if (!app_.config().useTxTables())
         return;
+    if (auto index = app_.getTxnDB().txIndex())
+    {
+        index->deleteBefore(lastRotated);
+        if (health())
+            return;
+    }
     clearSql(
         *transactionDb_,
         lastRotated,
@@ -26,7 +26,11 @@
 #include <ripple/protocol/UintTypes.h>
 #include <peersafe/schema/Schema.h>
 #include <peersafe/app/util/Common.h>
+#include <peersafe/app/sql/TxIndex.h>
+#include <peersafe/app/sql/TxnDBConn.h>
 #include <boost/format.hpp>
+#include <algorithm>
+#include <limits>
 #include <memory>
 
 namespace ripple {
@@ -454,6 +458,176 @@ accountTxPageSQL(
 	return;
 }
 
+// The Transactions row of id, for an indexed ledger that isn't available
+static bool
+getRawMetaSQL(Schema& app, uint256 const& id, Blob& raw, Blob& meta)
+{
+    auto db = app.getTxnDB().checkoutDbRead();
+    auto const transID = to_string(id);
+    soci::blob txnData(*db);
+    soci::blob txnMeta(*db);
+    soci::indicator dataPresent, metaPresent;
+    *db << "SELECT RawTxn,TxnMeta FROM Transactions WHERE TransID = :id;",
+        soci::use(transID), soci::into(txnData, dataPresent),
+        soci::into(txnMeta, metaPresent);
+    if (!db->got_data() || dataPresent != soci::i_ok)
+        return false;
+
+    convert(txnData, raw);
+    if (metaPresent == soci::i_ok)
+        convert(txnMeta, meta);
+    else
+        meta.clear();
+    return true;
+}
+
+void
+accountTxPageIndex(
+    Schema& app,
+    TxIndex& index,
+    AccountTxSQLPage const& sqlPage,
+    std::function<
+        void(std::uint32_t, Blob&&, Blob&&)> const&
+        onTransaction,
+    AccountID const& account,
+    std::int32_t minLedger,
+    std::int32_t maxLedger,
+    bool forward,
+    std::optional<NetworkOPs::AccountTxMarker>& marker,
+    int limit,
+    bool bAdmin,
+    std::uint32_t page_length)
+{
+    std::uint32_t numberOfResults;
+
+    if (limit <= 0 || (limit > page_length && !bAdmin))
+        numberOfResults = page_length;
+    else
+        numberOfResults = limit;
+
+    // A marker with this txnSeq names only the ledger the next page starts
+    // at. It is handed out when a page ends where the index and SQL meet.
+    static std::uint32_t const ledgerMarker =
+        std::numeric_limits<std::uint32_t>::max();
+
+    LedgerIndex const first =
+        index.firstLedger().value_or(std::numeric_limits<LedgerIndex>::max());
+    LedgerIndex minSeq = minLedger < 0 ? 0 : minLedger;
+    LedgerIndex maxSeq = maxLedger < 0
+        ? std::numeric_limits<LedgerIndex>::max()
+        : static_cast<LedgerIndex>(maxLedger);
+    if (marker && marker->txnSeq == ledgerMarker)
+    {
+        if (forward)
+            minSeq = std::max(minSeq, marker->ledgerSeq);
+        else
+            maxSeq = std::min(maxSeq, marker->ledgerSeq);
+        marker.reset();
+    }
+
+    std::uint32_t found = 0;
+    auto const fromSQL = [&]() {
+        if (minSeq >= first)
+            return;
+        auto const counted =
+            [&](std::uint32_t seq, Blob&& rawTxn, Blob&& rawMeta) {
+                ++found;
+                onTransaction(seq, std::move(rawTxn), std::move(rawMeta));
+            };
+        LedgerIndex const maxSQL = std::min<LedgerIndex>(
+            {maxSeq, first - 1, std::numeric_limits<std::int32_t>::max()});
+        sqlPage(
+            counted,
+            static_cast<std::int32_t>(minSeq),
+            static_cast<std::int32_t>(maxSQL),
+            marker,
+            numberOfResults - found,
+            true);
+    };
+    auto const fromIndex = [&]() {
+        if (maxSeq < first)
+            return;
+        boost::optional<TxIndex::Location> location;
+        if (marker)
+            location = TxIndex::Location{marker->ledgerSeq, marker->txnSeq};
+
+        auto const entries = index.getAccountTxs(
+            account,
+            std::max(minSeq, first),
+            maxSeq,
+            forward,
+            location,
+            numberOfResults - found);
+        found += entries.size();
+
+        marker.reset();
+        if (location)
+            marker = {location->ledgerSeq, location->txnSeq};
+
+        std::shared_ptr<const ripple::Ledger> lgr;
+        for (std::size_t i = 0; i < entries.size(); ++i)
+        {
+            auto const& entry = entries[i];
+            if (!lgr || lgr->info().seq != entry.ledgerSeq)
+                lgr = app.getLedgerMaster().getLedgerBySeq(entry.ledgerSeq);
+
+            Blob txRaw, txMeta;
+            if ((lgr && getRawMeta(*lgr, entry.id, txRaw, txMeta)) ||
+                getRawMetaSQL(app, entry.id, txRaw, txMeta))
+            {
+                onTransaction(
+                    entry.ledgerSeq, std::move(txRaw), std::move(txMeta));
+                continue;
+            }
+
+            // Neither the ledger nor SQL has it, the page ends short with
+            // a marker at this transaction for the client to ask again.
+            JLOG(app.journal("AccountTxPaging").warn())
+                << "Indexed transaction " << entry.id << " of ledger "
+                << entry.ledgerSeq << " not found";
+            found -= entries.size() - i;
+            marker = {entry.ledgerSeq, entry.txnSeq};
+            break;
+        }
+    };
+
+    // Going forward the older ledgers in SQL come first, going backward
+    // the index does. A page that runs out of one side goes on with the
+    // other.
+    bool const onIndex = marker
+        ? marker->ledgerSeq >= first
+        : (forward ? minSeq >= first : maxSeq >= first);
+    auto const pageEnded = [&]() {
+        if (marker)
+            return true;
+        if (found < numberOfResults)
+            return false;
+        if (forward && maxSeq >= first)
+            marker = {first, ledgerMarker};
+        else if (!forward && minSeq < first)
+            marker = {first - 1, ledgerMarker};
+        return true;
+    };
+
+    if (forward && !onIndex)
+    {
+        fromSQL();
+        if (pageEnded())
+            return;
+    }
+    else if (!forward && onIndex)
+    {
+        fromIndex();
+        if (pageEnded())
+            return;
+    }
+
+    if (forward)
+        fromIndex();
+    else
+        fromSQL();
+}
+
 void
 contractTxPage(
     Schema& app,
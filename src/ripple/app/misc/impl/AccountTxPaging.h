@@ -30,6 +30,8 @@
 
 namespace ripple {
 
+class TxIndex;
+
 void
 convertBlobsToTxResult(
     NetworkOPs::AccountTxs& to,
@@ -77,6 +79,34 @@ accountTxPageSQL(
     bool bAdmin,
     std::uint32_t page_length);
 
+// A page read from SQL by accountTxPage or accountTxPageSQL
+using AccountTxSQLPage = std::function<void(
+    std::function<void(std::uint32_t, Blob&&, Blob&&)> const& onTransaction,
+    std::int32_t minLedger,
+    std::int32_t maxLedger,
+    std::optional<NetworkOPs::AccountTxMarker>& marker,
+    int limit,
+    bool bAdmin)>;
+
+// Same as accountTxPage, reading the [tx_index] instead of SQL for the
+// ledgers it holds and sqlPage for the older ones
+void
+accountTxPageIndex(
+    Schema& app,
+    TxIndex& index,
+    AccountTxSQLPage const& sqlPage,
+    std::function<
+        void(std::uint32_t, Blob&&, Blob&&)> const&
+        onTransaction,
+    AccountID const& account,
+    std::int32_t minLedger,
+    std::int32_t maxLedger,
+    bool forward,
+    std::optional<NetworkOPs::AccountTxMarker>& marker,
+    int limit,
+    bool bAdmin,
+    std::uint32_t page_length);
+
 void
 contractTxPage(
     Schema& app,
@@ -250,6 +250,19 @@ Transaction::load(
     }
     else 
     {
+        // Transactions of ledgers from before the index are only in SQL
+        if (auto index = app.getTxnDB().txIndex())
+        {
+            if (auto const location = index->getLocation(id))
+            {
+                // Only validated transactions are indexed
+                ledgerSeq = location->ledgerSeq;
+                status = std::string(1, txnSqlValidated);
+                return Transaction::transactionFromSHAMapValidated(
+                    ledgerSeq, status, id, app);
+            }
+        }
+
 		std::string sql = "SELECT LedgerSeq,Status "
 			"FROM Transactions WHERE TransID='";
 		sql.append(to_string(id));
@@ -22,6 +22,7 @@
 #include <ripple/app/paths/PathRequests.h>
 #include <ripple/basics/Log.h>
 #include <ripple/core/JobQueue.h>
+#include <ripple/json/Arena.h>
 #include <ripple/net/RPCErr.h>
 #include <ripple/protocol/ErrorCodes.h>
 #include <ripple/protocol/jss.h>
@@ -205,6 +206,9 @@ PathRequests::makePathRequest(
     std::shared_ptr<ReadView const> const& inLedger,
     Json::Value const& requestJson)
 {
+    // The request outlives the RPC call, keep it out of the request arena
+    Json::HeapScope heap;
+
     auto req = std::make_shared<PathRequest>(
         app_, subscriber, ++mLastIdentifier, *this, mJournal);
 
@@ -229,6 +233,9 @@ PathRequests::makeLegacyPathRequest(
     std::shared_ptr<ReadView const> const& inLedger,
     Json::Value const& request)
 {
+    // The request outlives the RPC call, keep it out of the request arena
+    Json::HeapScope heap;
+
     // This assignment must take place before the
     // completion function is called
     req = std::make_shared<PathRequest>(
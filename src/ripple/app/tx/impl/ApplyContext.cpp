@@ -171,12 +171,12 @@ ApplyContext::setDirtyValue(
 }
 
 void
-ApplyContext::setDirtyExistInDB(
+ApplyContext::setDirtyOriginal(
     AccountID const& contract,
     uint256 const& key,
-    bool exist)
+    boost::optional<uint256> const& original)
 {
-    view_->setDirtyExistInDB(contract, key, exist);
+    view_->setDirtyOriginal(contract, key, original);
 }
 
 boost::optional<ContractValueType>
@@ -119,11 +119,12 @@ public:
         uint256 const& key,
         uint256 const& value);
 
+    // What the slot holds in the storage map, none if it isn't there
     void
-    setDirtyExistInDB(
+    setDirtyOriginal(
         AccountID const& contract,
         uint256 const& key,
-        bool exist);
+        boost::optional<uint256> const& original);
 
     boost::optional<ContractValueType>
     fetchFromStateCache(AccountID const& contract, uint256 const& key);
@@ -0,0 +1,688 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_BASICS_SHARDEDTAGGEDCACHE_H_INCLUDED
+#define RIPPLE_BASICS_SHARDEDTAGGEDCACHE_H_INCLUDED
+
+#include <ripple/basics/Log.h>
+#include <ripple/basics/UnorderedContainers.h>
+#include <ripple/basics/hardened_hash.h>
+#include <ripple/beast/clock/abstract_clock.h>
+#include <ripple/beast/insight/Insight.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ripple {
+
+/** TaggedCache split into independently locked shards.
+
+    Offers the interface of TaggedCache, without peekMutex(), for the caches
+    that are hit from many threads at once. A key always maps to the same
+    shard, so lookups of different keys rarely wait for each other, and
+    sweep() locks one shard at a time instead of the whole cache.
+
+    Eviction is scan resistant: an entry that was not looked up again since
+    it was inserted, or since the previous sweep, is cold. When a shard is
+    over its share of the target size its cold entries are dropped first,
+    so one pass over a large data set, like a LedgerData walk or a table
+    dump, does not push out the entries that are used over and over. Apart
+    from that entries age out like in TaggedCache, with the age cut down in
+    proportion when a shard grows past its target, and an entry that is
+    still referenced elsewhere stays tracked until it is released. Entries
+    read ahead with canonicalize_prefetch() only turn hot on their second
+    lookup, as the first one is the read they were fetched for.
+
+    @note Callers must not modify data objects that are stored in the cache
+          unless they hold their own lock over all cache operations.
+*/
+template <
+    class Key,
+    class T,
+    class Hash = hardened_hash<>,
+    class KeyEqual = std::equal_to<Key>>
+class ShardedTaggedCache
+{
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using clock_type = beast::abstract_clock<std::chrono::steady_clock>;
+
+    static constexpr std::size_t defaultShards = 16;
+
+    ShardedTaggedCache(
+        std::string const& name,
+        int size,
+        clock_type::duration expiration,
+        clock_type& clock,
+        beast::Journal journal,
+        beast::insight::Collector::ptr const& collector =
+            beast::insight::NullCollector::New(),
+        std::size_t shards = defaultShards)
+        : m_journal(journal)
+        , m_clock(clock)
+        , m_stats(
+              name,
+              std::bind(&ShardedTaggedCache::collect_metrics, this),
+              collector)
+        , m_name(name)
+        , m_target_size(size)
+        , m_target_age(expiration)
+        , m_shards(std::max<std::size_t>(shards, 1))
+        , m_hits(0)
+        , m_misses(0)
+    {
+    }
+
+    ShardedTaggedCache(ShardedTaggedCache const&) = delete;
+    ShardedTaggedCache&
+    operator=(ShardedTaggedCache const&) = delete;
+
+    /** Return the clock associated with the cache. */
+    clock_type&
+    clock()
+    {
+        return m_clock;
+    }
+
+    int
+    getTargetSize() const
+    {
+        return m_target_size;
+    }
+
+    void
+    setTargetSize(int s)
+    {
+        m_target_size = s;
+
+        if (s > 0)
+        {
+            auto const perShard = shardTarget(s);
+            for (auto& shard : m_shards)
+            {
+                std::lock_guard lock(shard.mutex);
+                shard.cache.rehash(static_cast<std::size_t>(
+                    (perShard + (perShard >> 2)) /
+                        shard.cache.max_load_factor() +
+                    1));
+            }
+        }
+
+        JLOG(m_journal.debug()) << m_name << " target size set to " << s;
+    }
+
+    clock_type::duration
+    getTargetAge() const
+    {
+        return m_target_age;
+    }
+
+    void
+    setTargetAge(clock_type::duration s)
+    {
+        m_target_age = s;
+        JLOG(m_journal.debug())
+            << m_name << " target age set to " << s.count();
+    }
+
+    int
+    getCacheSize() const
+    {
+        int count = 0;
+        for (auto const& shard : m_shards)
+        {
+            std::lock_guard lock(shard.mutex);
+            count += shard.cacheCount;
+        }
+        return count;
+    }
+
+    int
+    getTrackSize() const
+    {
+        std::size_t count = 0;
+        for (auto const& shard : m_shards)
+        {
+            std::lock_guard lock(shard.mutex);
+            count += shard.cache.size();
+        }
+        return static_cast<int>(count);
+    }
+
+    std::uint64_t
+    getLookups() const
+    {
+        return m_hits + m_misses;
+    }
+
+    float
+    getHitRate()
+    {
+        std::uint64_t const hits = m_hits;
+        auto const total = static_cast<float>(hits + m_misses);
+        return hits * (100.0f / std::max(1.0f, total));
+    }
+
+    void
+    clear()
+    {
+        for (auto& shard : m_shards)
+        {
+            cache_type stuffToClear;
+            std::lock_guard lock(shard.mutex);
+            stuffToClear.swap(shard.cache);
+            shard.cacheCount = 0;
+        }
+    }
+
+    void
+    reset()
+    {
+        clear();
+        m_hits = 0;
+        m_misses = 0;
+    }
+
+    /** Age out entries, and the cold ones of the shards over their target.
+
+        Each shard is swept under its own lock, so lookups of the other
+        shards go on meanwhile.
+    */
+    void
+    sweep()
+    {
+        int cacheRemovals = 0;
+        int mapRemovals = 0;
+        clock_type::time_point const now(m_clock.now());
+        int const targetSize = shardTarget(m_target_size);
+        clock_type::duration const targetAge = m_target_age;
+        clock_type::duration const minimumAge(std::chrono::seconds(1));
+
+        // Cold entries younger than this are likely still being worked on
+        auto const when_cold = now - std::chrono::seconds(1);
+
+        for (auto& shard : m_shards)
+        {
+            // Keep references to all the stuff we sweep
+            // so that we can destroy them outside the lock.
+            std::vector<std::shared_ptr<mapped_type>> stuffToSweep;
+
+            std::lock_guard lock(shard.mutex);
+            bool const full = targetSize != 0 && shard.cacheCount > targetSize;
+
+            auto when_expire = now - targetAge;
+            if (full)
+            {
+                when_expire = now - targetAge * targetSize / shard.cacheCount;
+                if (when_expire > (now - minimumAge))
+                    when_expire = now - minimumAge;
+            }
+
+            stuffToSweep.reserve(shard.cache.size());
+            for (auto cit = shard.cache.begin(); cit != shard.cache.end();)
+            {
+                Entry& entry = cit->second;
+                if (entry.isWeak())
+                {
+                    if (entry.isExpired())
+                    {
+                        ++mapRemovals;
+                        cit = shard.cache.erase(cit);
+                        continue;
+                    }
+                }
+                else if (
+                    entry.last_access <= when_expire ||
+                    (full && !entry.referenced &&
+                     entry.last_access <= when_cold))
+                {
+                    --shard.cacheCount;
+                    ++cacheRemovals;
+                    stuffToSweep.push_back(std::move(entry.ptr));
+                    if (stuffToSweep.back().unique())
+                    {
+                        ++mapRemovals;
+                        cit = shard.cache.erase(cit);
+                        continue;
+                    }
+                }
+                else
+                {
+                    // Give the entry another round
+                    entry.referenced = false;
+                }
+                ++cit;
+            }
+        }
+
+        if (mapRemovals || cacheRemovals)
+        {
+            JLOG(m_journal.trace())
+                << m_name << ": cache = " << getCacheSize() << "-"
+                << cacheRemovals << ", map-=" << mapRemovals;
+        }
+    }
+
+    bool
+    del(const key_type& key, bool valid)
+    {
+        // Remove from cache, if !valid, remove from map too. Returns true if
+        // removed from cache
+        std::shared_ptr<mapped_type> data;
+        auto& shard = shardFor(key);
+        std::lock_guard lock(shard.mutex);
+
+        auto cit = shard.cache.find(key);
+
+        if (cit == shard.cache.end())
+            return false;
+
+        Entry& entry = cit->second;
+
+        bool ret = false;
+
+        if (entry.isCached())
+        {
+            --shard.cacheCount;
+            data = std::move(entry.ptr);
+            ret = true;
+        }
+
+        if (!valid || entry.isExpired())
+            shard.cache.erase(cit);
+
+        return ret;
+    }
+
+    /** Replace aliased objects with originals.
+
+        Due to concurrency it is possible for two separate objects with
+        the same content and referring to the same unique "thing" to exist.
+        This routine eliminates the duplicate and performs a replacement
+        on the callers shared pointer if needed.
+
+        @param key The key corresponding to the object
+        @param data A shared pointer to the data corresponding to the object.
+        @param replace `true` if `data` is the up to date version of the object.
+
+        @return `true` If the key already existed.
+    */
+private:
+    template <bool replace>
+    bool
+    canonicalize(
+        const key_type& key,
+        std::conditional_t<
+            replace,
+            std::shared_ptr<T> const,
+            std::shared_ptr<T>>& data,
+        bool prefetch = false)
+    {
+        // Return canonical value, store if needed, refresh in cache
+        // Return values: true=we had the data already
+        std::shared_ptr<mapped_type> replaced;
+        auto& shard = shardFor(key);
+        std::lock_guard lock(shard.mutex);
+
+        auto cit = shard.cache.find(key);
+
+        if (cit == shard.cache.end())
+        {
+            auto const it = shard.cache
+                                .emplace(
+                                    std::piecewise_construct,
+                                    std::forward_as_tuple(key),
+                                    std::forward_as_tuple(m_clock.now(), data))
+                                .first;
+            it->second.prefetched = prefetch;
+            ++shard.cacheCount;
+            return false;
+        }
+
+        Entry& entry = cit->second;
+        if (!prefetch)
+            entry.touch(m_clock.now());
+
+        if (entry.isCached())
+        {
+            if constexpr (replace)
+            {
+                replaced = std::move(entry.ptr);
+                entry.ptr = data;
+                entry.weak_ptr = data;
+            }
+            else
+            {
+                data = entry.ptr;
+            }
+
+            return true;
+        }
+
+        auto cachedData = entry.lock();
+
+        if (cachedData)
+        {
+            if constexpr (replace)
+            {
+                entry.ptr = data;
+                entry.weak_ptr = data;
+            }
+            else
+            {
+                entry.ptr = cachedData;
+                data = cachedData;
+            }
+
+            ++shard.cacheCount;
+            return true;
+        }
+
+        entry.ptr = data;
+        entry.weak_ptr = data;
+        ++shard.cacheCount;
+
+        return false;
+    }
+
+public:
+    bool
+    canonicalize_replace_cache(
+        const key_type& key,
+        std::shared_ptr<T> const& data)
+    {
+        return canonicalize<true>(key, data);
+    }
+
+    bool
+    canonicalize_replace_client(const key_type& key, std::shared_ptr<T>& data)
+    {
+        return canonicalize<false>(key, data);
+    }
+
+    /** Like canonicalize_replace_client, for an object read ahead of use.
+
+        The lookup the object was read for does not mark it as hot, and an
+        entry that is already tracked is not refreshed.
+    */
+    bool
+    canonicalize_prefetch(const key_type& key, std::shared_ptr<T>& data)
+    {
+        return canonicalize<false>(key, data, true);
+    }
+
+    std::shared_ptr<T>
+    fetch(const key_type& key)
+    {
+        // fetch us a shared pointer to the stored data object
+        auto& shard = shardFor(key);
+        std::lock_guard lock(shard.mutex);
+
+        auto cit = shard.cache.find(key);
+
+        if (cit == shard.cache.end())
+        {
+            ++m_misses;
+            return {};
+        }
+
+        Entry& entry = cit->second;
+        entry.touch(m_clock.now());
+
+        if (entry.isCached())
+        {
+            ++m_hits;
+            return entry.ptr;
+        }
+
+        entry.ptr = entry.lock();
+
+        if (entry.isCached())
+        {
+            // independent of cache size, so not counted as a hit
+            ++shard.cacheCount;
+            return entry.ptr;
+        }
+
+        shard.cache.erase(cit);
+        ++m_misses;
+        return {};
+    }
+
+    /** Insert the element into the container.
+        If the key already exists, nothing happens.
+        @return `true` If the element was inserted
+    */
+    bool
+    insert(key_type const& key, T const& value)
+    {
+        auto p = std::make_shared<T>(std::cref(value));
+        return canonicalize_replace_client(key, p);
+    }
+
+    bool
+    retrieve(const key_type& key, T& data)
+    {
+        // retrieve the value of the stored data
+        auto entry = fetch(key);
+
+        if (!entry)
+            return false;
+
+        data = *entry;
+        return true;
+    }
+
+    /** Refresh the expiration time on a key.
+
+        @param key The key to refresh.
+        @return `true` if the key was found and the object is cached.
+    */
+    bool
+    refreshIfPresent(const key_type& key)
+    {
+        bool found = false;
+
+        // If present, make current in cache
+        auto& shard = shardFor(key);
+        std::lock_guard lock(shard.mutex);
+
+        if (auto cit = shard.cache.find(key); cit != shard.cache.end())
+        {
+            Entry& entry = cit->second;
+
+            if (!entry.isCached())
+            {
+                // Convert weak to strong.
+                entry.ptr = entry.lock();
+
+                if (entry.isCached())
+                {
+                    // We just put the object back in cache
+                    ++shard.cacheCount;
+                    entry.touch(m_clock.now());
+                    found = true;
+                }
+                else
+                {
+                    // Couldn't get strong pointer,
+                    // object fell out of the cache so remove the entry.
+                    shard.cache.erase(cit);
+                }
+            }
+            else
+            {
+                // It's cached so update the timer
+                entry.touch(m_clock.now());
+                found = true;
+            }
+        }
+
+        return found;
+    }
+
+    std::vector<key_type>
+    getKeys() const
+    {
+        std::vector<key_type> v;
+
+        for (auto const& shard : m_shards)
+        {
+            std::lock_guard lock(shard.mutex);
+            v.reserve(v.size() + shard.cache.size());
+            for (auto const& _ : shard.cache)
+                v.push_back(_.first);
+        }
+
+        return v;
+    }
+
+private:
+    class Entry
+    {
+    public:
+        std::shared_ptr<mapped_type> ptr;
+        std::weak_ptr<mapped_type> weak_ptr;
+        clock_type::time_point last_access;
+        // Looked up since it was inserted or last swept
+        bool referenced = false;
+        // Read ahead and not looked up yet
+        bool prefetched = false;
+
+        Entry(
+            clock_type::time_point const& last_access_,
+            std::shared_ptr<mapped_type> const& ptr_)
+            : ptr(ptr_), weak_ptr(ptr_), last_access(last_access_)
+        {
+        }
+
+        bool
+        isWeak() const
+        {
+            return ptr == nullptr;
+        }
+        bool
+        isCached() const
+        {
+            return ptr != nullptr;
+        }
+        bool
+        isExpired() const
+        {
+            return weak_ptr.expired();
+        }
+        std::shared_ptr<mapped_type>
+        lock()
+        {
+            return weak_ptr.lock();
+        }
+        void
+        touch(clock_type::time_point const& now)
+        {
+            last_access = now;
+            if (prefetched)
+                prefetched = false;
+            else
+                referenced = true;
+        }
+    };
+
+    using cache_type = hardened_hash_map<key_type, Entry, Hash, KeyEqual>;
+
+    struct Shard
+    {
+        std::mutex mutable mutex;
+        cache_type cache;
+        // Number of items cached
+        int cacheCount = 0;
+    };
+
+    struct Stats
+    {
+        template <class Handler>
+        Stats(
+            std::string const& prefix,
+            Handler const& handler,
+            beast::insight::Collector::ptr const& collector)
+            : hook(collector->make_hook(handler))
+            , size(collector->make_gauge(prefix, "size"))
+            , hit_rate(collector->make_gauge(prefix, "hit_rate"))
+        {
+        }
+
+        beast::insight::Hook hook;
+        beast::insight::Gauge size;
+        beast::insight::Gauge hit_rate;
+    };
+
+    Shard&
+    shardFor(key_type const& key)
+    {
+        // The low bits pick the bucket within the shard, so use the high ones
+        auto const h = m_hash(key);
+        return m_shards[(h >> (sizeof(h) * 4)) % m_shards.size()];
+    }
+
+    int
+    shardTarget(int size) const
+    {
+        auto const shards = static_cast<int>(m_shards.size());
+        return size > 0 ? (size + shards - 1) / shards : 0;
+    }
+
+    void
+    collect_metrics()
+    {
+        m_stats.size.set(getCacheSize());
+
+        {
+            beast::insight::Gauge::value_type hit_rate(0);
+            std::uint64_t const hits = m_hits;
+            auto const total(hits + m_misses);
+            if (total != 0)
+                hit_rate = (hits * 100) / total;
+            m_stats.hit_rate.set(hit_rate);
+        }
+    }
+
+    beast::Journal m_journal;
+    clock_type& m_clock;
+    Stats m_stats;
+
+    // Used for logging
+    std::string m_name;
+
+    // Desired number of cache entries (0 = ignore)
+    std::atomic<int> m_target_size;
+
+    // Desired maximum cache age
+    std::atomic<clock_type::duration> m_target_age;
+
+    Hash m_hash;
+    std::vector<Shard> m_shards;
+    std::atomic<std::uint64_t> m_hits;
+    std::atomic<std::uint64_t> m_misses;
+};
+
+}  // namespace ripple
+
+#endif
@@ -148,6 +148,13 @@ public:
         return m_cache.size();
     }
 
+    std::uint64_t
+    getLookups() const
+    {
+        readlock_type lock(m_mutex);
+        return m_hits + m_misses;
+    }
+
     float
     getHitRate()
     {
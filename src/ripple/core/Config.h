@@ -206,6 +206,9 @@ public:
     // Compression
     bool COMPRESSION = false;
 
+    // Dictionary encoding of the transactions in batches and tx sets
+    bool COMPACT_TX = false;
+
     // Amendment majority time
     std::chrono::seconds AMENDMENT_MAJORITY_TIME = defaultAmendmentMajorityTime;
 
@@ -227,6 +230,7 @@ public:
 	bool						 ONLY_VALIDATE_FOR_SCHEMA = false;
     
     bool                         BATCH_BROADCAST = false;
+    bool                         RECONCILE_TX_SETS = false;
 
     //governance
     bool                        OPEN_ACCOUNT_DELAY = false;
@@ -242,6 +246,8 @@ public:
 
     std::uint32_t               REQ_MAP_COUNT;
     bool                        ENABLE_STATE_HASH_SET = false;
+    // Rebuild the state map of a far behind ledger from its leaves
+    bool                        STATE_SNAPSHOT_SYNC = false;
     bool                        REAL_NAME_AUTHORITY_ENABLED = false;
 
 public:
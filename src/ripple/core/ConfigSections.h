@@ -51,6 +51,26 @@ struct ConfigSection
         return "sync_tables";
     }
     static std::string
+    cacheTables()
+    {
+        return "cache_tables";
+    }
+    static std::string
+    memoryBudget()
+    {
+        return "memory_budget";
+    }
+    static std::string
+    jobQueue()
+    {
+        return "job_queue";
+    }
+    static std::string
+    txIndex()
+    {
+        return "tx_index";
+    }
+    static std::string
     autoSync()
     {
         return "auto_sync";
@@ -85,11 +105,17 @@ struct ConfigSection
     {
         return "remote_sync";
     }
+    static std::string
+    tableSync()
+    {
+        return "table_sync";
+    }
 };
 
 // VFALCO TODO Rename and replace these macros with variables.
 #define SECTION_AMENDMENTS "amendments"
 #define SECTION_CLUSTER_NODES "cluster_nodes"
+#define SECTION_COMPACT_TX "compact_tx"
 #define SECTION_COMPRESSION "compression"
 #define SECTION_DEBUG_LOGFILE "debug_logfile"
 #define SECTION_ELB_SUPPORT "elb_support"
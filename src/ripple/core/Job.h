@@ -62,8 +62,10 @@ enum JobType {
     jtTABLESTORAGE,  // storage tables
     jtTableCheckHash,// check tx hash
     jtOPERATESQL,    // write table sync info
+    jtTABLE_PREPARE, // parse and decrypt synced table transactions
     jtTABLELOCALSYNC,// local synchronize tables
     jtTABLESYNC,     // synchronize tables
+    jtTABLE_SNAPSHOT,// make or load a table snapshot
 
     jtSTOP_SCHEMA,   // Stop sub-chain
     jtFULLBELOW_TOUCH,
@@ -75,12 +77,14 @@ enum JobType {
 
 	jtLEDGER_REQ,    // Peer request ledger/txnset data
 	jtLEDGER_DATA,   // Received data for a ledger we're acquiring
+	jtLEDGER_DECODE, // Build received ledger nodes in parallel
 
 	jtSYNC_SCHEMA,	 // Recv view_change msg.
     jtTXN_DATA,      // Fetch a proposed set
     jtWAL,           // Write-ahead logging
     jtWRITE,         // Write out hashed objects
     jtACCEPT,        // Accept a consensus ledger
+    jtCONTRACT_FLUSH,// Flush contract storage of a ledger being built
     jtSWEEP,         // Sweep for stale structures
     jtMALLOC_TRIM,   // TRIM G_LIBC memory
     jtNETOP_CLUSTER, // NetworkOPs cluster peer report
@@ -146,6 +150,18 @@ public:
     JobType
     getType() const;
 
+    /** The JobQueue slot of the schema that added the job. */
+    int
+    getSchema() const;
+
+    /** Virtual start time, orders the jobs of one type across schemas. */
+    std::uint64_t
+    virtualStart() const;
+
+    /** Set by the JobQueue before the job is put in its ordered set. */
+    void
+    setSchedule(int schema, std::uint64_t virtualStart);
+
     CancelCallback
     getCancelCallback() const;
 
@@ -178,6 +194,8 @@ private:
     CancelCallback m_cancelCallback;
     JobType mType;
     std::uint64_t mJobIndex;
+    int mSchema;
+    std::uint64_t mVirtualStart;
     std::function<void(Job&)> mJob;
     std::shared_ptr<LoadEvent> m_loadEvent;
     std::string mName;
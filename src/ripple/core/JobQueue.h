@@ -60,6 +60,8 @@ public:
     {
     private:
         detail::LocalValues lvs_;
+        // The Json arena the coroutine had installed when it last yielded
+        Json::Arena* arena_ = nullptr;
         JobQueue& jq_;
         JobType type_;
         std::string name_;
@@ -183,11 +185,41 @@ public:
         if (auto optionalCountedJob = jobCounter.wrap(
                 std::forward<JobHandler>(jobHandler)))
         {
-            return addRefCountedJob(type, name, std::move(*optionalCountedJob));
+            return addRefCountedJob(
+                type, name, std::move(*optionalCountedJob), &jobCounter);
         }
         return false;
     }
-     
+
+    /** Tag the jobs added with a schema's JobCounter as that schema's.
+
+        Waiting jobs of one JobType are dispatched in weighted fair order
+        across schemas, so a backlog on one schema only delays the others
+        by its share. Jobs added without a registered JobCounter share
+        one untagged slot.
+
+        @param counter The JobCounter the schema adds its jobs with.
+        @param name Shown in the schema metrics.
+        @param weight Relative share of each JobType, at least 1.
+        @param maxRunning Jobs of the schema running at once, 0 for no
+       limit.
+    */
+    void
+    addSchema(
+        JobCounter const& counter,
+        std::string const& name,
+        int weight,
+        int maxRunning);
+
+    /** Stop tagging jobs added with this JobCounter. */
+    void
+    removeSchema(JobCounter const& counter);
+
+    /** Queue depth, running jobs and queue wait of each schema.
+     */
+    Json::Value
+    getSchemaJson();
+
     /** Creates a coroutine and adds a job to the queue which will run it.
 
         @param t The type of job.
@@ -243,20 +275,82 @@ public:
     void
     rendezvous();
 
+    /** Call f for 0 .. count - 1, spread over jobs of the given type.
+
+        The calling thread takes items as well, so this never waits on jobs
+        that have not started. Returns when every call has finished, then
+        rethrows the first exception f threw, if any.
+    */
+    void
+    parallelFor(
+        JobType type,
+        std::string const& name,
+        std::size_t count,
+        std::function<void(std::size_t)> const& f,
+        JobCounter& jobCounter);
+
 private:
     friend class Coro;
 
     using JobDataMap = std::map<JobType, JobTypeData>;
 
+    // Jobs tagged with one schema
+    struct SchemaJobData
+    {
+        std::string name;
+        int weight = 1;
+        // 0 means no limit
+        int maxRunning = 0;
+        bool removed = false;
+
+        int waiting = 0;
+        int running = 0;
+        std::uint64_t dispatched = 0;
+        std::chrono::microseconds totalWait{0};
+        std::chrono::microseconds peakWait{0};
+
+        // Virtual finish time of the last job queued, per JobType
+        std::map<JobType, std::uint64_t> finish;
+
+        // Waiting jobs, ordered by type, highest priority first, so the
+        // jobs of one type form a band that can be skipped as a whole.
+        // A schema at its limit is passed over without looking at them.
+        std::set<Job> jobs;
+    };
+
+    // A job added but not yet ordered into its schema's jobs
+    struct Submitted
+    {
+        Job job;
+        JobCounter const* counter;
+        Submitted* next;
+    };
+
     beast::Journal m_journal;
     mutable std::mutex m_mutex;
-    std::uint64_t m_lastJob;
-    std::set<Job> m_jobSet;
+    std::atomic<std::uint64_t> m_lastJob;
+
+    // Jobs are pushed here without taking m_mutex and moved into the jobs
+    // of their schema by the worker that picks up the next task, newest
+    // first.
+    std::atomic<Submitted*> m_submitted;
+
+    // Jobs added and not yet dispatched, in m_submitted or a schema's jobs
+    std::atomic<std::size_t> m_jobCount;
     JobDataMap m_jobData;
     JobTypeData m_invalidJobData;
 
+    // Slot 0 holds the jobs of no registered schema
+    std::map<JobCounter const*, int> m_schemaSlots;
+    std::map<int, SchemaJobData> m_schemaData;
+    int m_lastSchema;
+
+    // Worker tasks that found every waiting job held back by the limit of
+    // its type or schema, handed out again when a job finishes.
+    int m_parked;
+
     // The number of jobs currently in processTask()
-    int m_processCount;
+    std::atomic<int> m_processCount;
 
     // The number of suspended coroutines
     int nSuspend_ = 0;
@@ -277,6 +371,9 @@ private:
     JobTypeData&
     getJobTypeData(JobType type);
 
+    SchemaJobData&
+    getSchemaJobData(int schema);
+
     void
     onStop() override;
 
@@ -290,49 +387,44 @@ private:
     //    param name Name of the job.
     //    param func std::function with signature void (Job&).  Called when the
     //    job is executed.
+    //    param counter The JobCounter func was wrapped with, if any.
     //
     //    return true if func added to queue.
     bool
     addRefCountedJob(
         JobType type,
         std::string const& name,
-        JobFunction const& func);
+        JobFunction const& func,
+        JobCounter const* counter = nullptr);
 
-    // Signals an added Job for processing.
-    //
-    // Pre-conditions:
-    //  The JobType must be valid.
-    //  The Job must exist in mJobSet.
-    //  The Job must not have previously been queued.
+    // Moves the submitted jobs into mJobSet.
     //
     // Post-conditions:
-    //  Count of waiting jobs of that type will be incremented.
-    //  If JobQueue exists, and has at least one thread, Job will eventually
-    //  run.
+    //  m_submitted is empty.
+    //  Each job is tagged with its schema and virtual start time.
+    //  Count of waiting jobs of each schema is incremented.
     //
     // Invariants:
     //  The calling thread owns the JobLock
     void
-    queueJob(Job const& job, std::lock_guard<std::mutex> const& lock);
+    drainSubmitted(std::lock_guard<std::mutex> const& lock);
 
     // Returns the next Job we should run now.
     //
     // RunnableJob:
-    //  A Job in the JobSet whose slots count for its type is greater than zero.
-    //
-    // Pre-conditions:
-    //  mJobSet must not be empty.
-    //  mJobSet holds at least one RunnableJob
+    //  A waiting Job whose slots count for its type and for its schema
+    //  are greater than zero.
     //
     // Post-conditions:
+    //  false if no schema holds a RunnableJob, otherwise
     //  job is a valid Job object.
     //  job is removed from mJobQueue.
-    //  Waiting job count of its type is decremented
-    //  Running job count of its type is incremented
+    //  Waiting job count of its type and schema is decremented
+    //  Running job count of its type and schema is incremented
     //
     // Invariants:
     //  The calling thread owns the JobLock
-    void
+    bool
     getNextJob(Job& job);
 
     // Indicates that a running Job has completed its task.
@@ -342,14 +434,13 @@ private:
     //  The JobType must not be invalid.
     //
     // Post-conditions:
-    //  The running count of that JobType is decremented
-    //  A new task is signaled if there are more waiting Jobs than the limit, if
-    //  any.
+    //  The running count of that JobType and schema is decremented
+    //  A parked task is signaled again, if any.
     //
     // Invariants:
     //  <none>
     void
-    finishJob(JobType type);
+    finishJob(JobType type, int schema);
 
     // Runs the next appropriate waiting Job.
     //
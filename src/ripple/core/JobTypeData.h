@@ -23,6 +23,7 @@
 #include <ripple/basics/Log.h>
 #include <ripple/beast/insight/Collector.h>
 #include <ripple/core/JobTypeInfo.h>
+#include <atomic>
 
 namespace ripple {
 
@@ -38,14 +39,15 @@ public:
     /* The job category which we represent */
     JobTypeInfo const& info;
 
-    /* The number of jobs waiting */
-    int waiting;
+    /* The number of jobs waiting, counted when submitted without the
+       JobQueue lock */
+    std::atomic<int> waiting;
 
     /* The number presently running */
     int running;
 
-    /* And the number we deferred executing because of job limits */
-    int deferred;
+    /* Virtual start time of the last job dispatched, see JobQueue::addSchema */
+    std::uint64_t virtualTime;
 
     /* Notification callbacks */
     beast::insight::Event dequeue;
@@ -60,7 +62,7 @@ public:
         , info(info_)
         , waiting(0)
         , running(0)
-        , deferred(0)
+        , virtualTime(0)
     {
         m_load.setTargetLatency(
             info.getAverageLatency(), info.getPeakLatency());
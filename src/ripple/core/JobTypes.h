@@ -49,6 +49,7 @@ add(    jtCONSENSUS_ut,  "untrustedConsensus",      maxLimit, false, 2000ms,  50
 add(    jtTRANSACTION_l, "localTransaction",        maxLimit, false, 100ms,   500ms);
 add(    jtLEDGER_REQ,    "ledgerRequest",           2,        false, 0ms,     0ms);
 add(    jtLEDGER_DATA,   "ledgerData",              2,        false, 0ms,     0ms);
+add(    jtLEDGER_DECODE, "ledgerDecode",            maxLimit, false, 0ms,     0ms);
 add(    jtCLIENT,        "clientCommand",           maxLimit, false, 2000ms,  5000ms);
 add(    jtRPC,           "RPC",                     maxLimit, false, 0ms,     0ms);
 add(    jtUPDATE_PF,     "updatePaths",             maxLimit, false, 0ms,     0ms);
@@ -65,18 +66,21 @@ add(    jtWAL,           "writeAhead",              maxLimit, false, 1000ms,  25
 add(    jtCONSENSUS_t,   "trustedConsensus",        2,        false, 500ms,  1500ms);
 add(    jtWRITE,         "writeObjects",            maxLimit, false, 1750ms,  2500ms);
 add(    jtACCEPT,        "acceptLedger",            maxLimit, false, 0ms,     0ms);
+add(    jtCONTRACT_FLUSH,"contractFlush",           maxLimit, false, 0ms,     0ms);
 add(    jtSWEEP,         "sweep",                   maxLimit, false, 0ms,     0ms);
 add(    jtMALLOC_TRIM,   "malloc_trim",             1,        false, 0ms,     0ms);
 add(    jtNETOP_CLUSTER, "clusterReport",           1,        false, 9999ms,  9999ms);
 add(    jtNETOP_TIMER,   "heartbeat",               1,        false, 999ms,   999ms);
 add(    jtADMIN,         "administration",          maxLimit, false, 0ms,     0ms);
 add(    jtTABLESYNC,     "tableSync",               1,        false, 0ms,     0ms);
+add(    jtTABLE_SNAPSHOT,"tableSnapshot",           1,        false, 0ms,     0ms);
 add(    jtTABLESTORAGE,  "tableStorage",            1,        false, 0ms,     0ms);
 add(	jtTableCheckHash, "tableCheckHash",			1,		  false, 0ms,		0ms);
 add(	jtCheckSubTx,	  "checkSubTx",				1,		  false, 0ms,		0ms);
 add(    jtCheckLoadLedger, "checkLoadLedger",       1,        false, 1000ms,   15000ms);
 add(    jtTABLELOCALSYNC,"tableLocalSync",          1,        false, 0ms,     0ms);
 add(    jtOPERATESQL,    "operateSQL",              10,        false, 0ms,     0ms);
+add(    jtTABLE_PREPARE, "tablePrepare",            maxLimit,  false, 0ms,     0ms);
 add(    jtTABLE_REQ,     "tableRequest",            2,        false, 0ms,     0ms);
 add(    jtTABLE_DATA,    "tableData",               2,        false, 0ms,     0ms);
 add(    jtSKIPNODE,      "skipnode",                2,        false, 0ms,     0ms);
@@ -282,9 +282,23 @@ void Config::initSchemaConfig(Config& config, SchemaParams const& schemaParams)
 
     std::string const node_db_type{ get<std::string>(section(ConfigSection::nodeDatabase()), "type") };
 
-    // ./AB868A6CFEEC779C2FF845C0AF00A642259986AF40C01976A7F842B6918936C7/db/NuDB
-    auto node_db_path = CONFIG_DIR / node_db_type;
-    overwrite(ConfigSection::nodeDatabase(), "path", node_db_path.generic_string());
+    if (get<int>(section(ConfigSection::nodeDatabase()), "shared") != 0)
+    {
+        // Only RocksDB keeps schemas apart in column families
+        if (!boost::iequals(node_db_type, "RocksDB"))
+            Throw<std::runtime_error>(
+                "shared=1 in [" + ConfigSection::nodeDatabase() +
+                "] requires type=RocksDB, not " + node_db_type);
+
+        // Same RocksDB as the main chain, one column family per schema
+        overwrite(ConfigSection::nodeDatabase(), "column_family", to_string(schemaParams.schema_id));
+    }
+    else
+    {
+        // ./AB868A6CFEEC779C2FF845C0AF00A642259986AF40C01976A7F842B6918936C7/db/NuDB
+        auto node_db_path = CONFIG_DIR / node_db_type;
+        overwrite(ConfigSection::nodeDatabase(), "path", node_db_path.generic_string());
+    }
 
     auto database_path = CONFIG_DIR / "db";
     deprecatedClearSection("database_path");
@@ -310,6 +324,8 @@ void Config::initSchemaConfig(Config& config, SchemaParams const& schemaParams)
     removeSection("sync_db");        //need separate configuration
     removeSection("auto_sync");      //need separate configuration
     removeSection("sync_tables");    //need separate configuration
+    removeSection("cache_tables");   //need separate configuration
+    removeSection("job_queue");      //need separate configuration
     removeSection("prometheus");
     removeSection("voting");
     removeSection(SECTION_VALIDATOR_LIST_KEYS);
@@ -796,6 +812,9 @@ Config::loadFromString(std::string const& fileContents)
     if (getSingleSection(secConfig, SECTION_COMPRESSION, strTemp, j_))
         COMPRESSION = beast::lexicalCastThrow<bool>(strTemp);
 
+    if (getSingleSection(secConfig, SECTION_COMPACT_TX, strTemp, j_))
+        COMPACT_TX = beast::lexicalCastThrow<bool>(strTemp);
+
     if (getSingleSection(
             secConfig, SECTION_AMENDMENT_MAJORITY_TIME, strTemp, j_))
     {
@@ -1040,6 +1059,8 @@ Config::loadFromString(std::string const& fileContents)
     }
     get_if_exists(
         section(SECTION_CONSENSUS), "batch_broadcast", BATCH_BROADCAST);
+    get_if_exists(
+        section(SECTION_CONSENSUS), "reconcile_tx_sets", RECONCILE_TX_SETS);
 
     get_if_exists(
         section(SECTION_GOVERNANCE), "open_account_delay", OPEN_ACCOUNT_DELAY);
@@ -1080,6 +1101,7 @@ Config::loadFromString(std::string const& fileContents)
     Section ledgerSyncSection = section(SECTION_FETCH_LEDGER);
     REQ_MAP_COUNT = get(ledgerSyncSection, "request_map_count", getValueFor(SizedItem::requestMapCount));
     get_if_exists(ledgerSyncSection, "enable_state_hash_set", ENABLE_STATE_HASH_SET);
+    get_if_exists(ledgerSyncSection, "snapshot_sync", STATE_SNAPSHOT_SYNC);
 }
 
 boost::filesystem::path
@@ -23,11 +23,12 @@
 
 namespace ripple {
 
-Job::Job() : mType(jtINVALID), mJobIndex(0)
+Job::Job() : mType(jtINVALID), mJobIndex(0), mSchema(0), mVirtualStart(0)
 {
 }
 
-Job::Job(JobType type, std::uint64_t index) : mType(type), mJobIndex(index)
+Job::Job(JobType type, std::uint64_t index)
+    : mType(type), mJobIndex(index), mSchema(0), mVirtualStart(0)
 {
 }
 
@@ -41,6 +42,8 @@ Job::Job(
     : m_cancelCallback(cancelCallback)
     , mType(type)
     , mJobIndex(index)
+    , mSchema(0)
+    , mVirtualStart(0)
     , mJob(job)
     , mName(name)
     , m_queue_time(clock_type::now())
@@ -54,6 +57,25 @@ Job::getType() const
     return mType;
 }
 
+int
+Job::getSchema() const
+{
+    return mSchema;
+}
+
+std::uint64_t
+Job::virtualStart() const
+{
+    return mVirtualStart;
+}
+
+void
+Job::setSchedule(int schema, std::uint64_t virtualStart)
+{
+    mSchema = schema;
+    mVirtualStart = virtualStart;
+}
+
 Job::CancelCallback
 Job::getCancelCallback() const
 {
@@ -104,6 +126,9 @@ Job::operator>(const Job& j) const
     if (mType > j.mType)
         return false;
 
+    if (mVirtualStart != j.mVirtualStart)
+        return mVirtualStart > j.mVirtualStart;
+
     return mJobIndex > j.mJobIndex;
 }
 
@@ -116,6 +141,9 @@ Job::operator>=(const Job& j) const
     if (mType > j.mType)
         return false;
 
+    if (mVirtualStart != j.mVirtualStart)
+        return mVirtualStart > j.mVirtualStart;
+
     return mJobIndex >= j.mJobIndex;
 }
 
@@ -132,6 +160,10 @@ Job::operator<(const Job& j) const
             return true;
     //}
 
+    // Within a type, jobs run in weighted fair order across schemas
+    if (mVirtualStart != j.mVirtualStart)
+        return mVirtualStart < j.mVirtualStart;
+
     return mJobIndex < j.mJobIndex;
 }
 
@@ -144,6 +176,9 @@ Job::operator<=(const Job& j) const
     if (mType > j.mType)
         return true;
 
+    if (mVirtualStart != j.mVirtualStart)
+        return mVirtualStart < j.mVirtualStart;
+
     return mJobIndex <= j.mJobIndex;
 }
 
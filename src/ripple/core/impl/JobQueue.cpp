@@ -20,9 +20,16 @@
 #include <ripple/basics/PerfLog.h>
 #include <ripple/basics/contract.h>
 #include <ripple/core/JobQueue.h>
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <thread>
 
 namespace ripple {
 
+// Virtual time a job of a weight 1 schema takes, split by the weight
+static std::uint64_t const virtualJobCost = 1 << 16;
+
 JobQueue::JobQueue(
     beast::insight::Collector::ptr const& collector,
     Stoppable& parent,
@@ -32,7 +39,11 @@ JobQueue::JobQueue(
     : Stoppable("JobQueue", parent)
     , m_journal(journal)
     , m_lastJob(0)
+    , m_submitted(nullptr)
+    , m_jobCount(0)
     , m_invalidJobData(JobTypes::instance().getInvalid(), collector, logs)
+    , m_lastSchema(0)
+    , m_parked(0)
     , m_processCount(0)
     , m_workers(*this, &perfLog, "JobQueue", 0)
     , m_cancelCallback(std::bind(&Stoppable::isStopping, this))
@@ -57,6 +68,8 @@ JobQueue::JobQueue(
             assert(result.second == true);
             (void)result.second;
         }
+
+        m_schemaData[0].name = "untagged";
     }
 }
 
@@ -64,20 +77,23 @@ JobQueue::~JobQueue()
 {
     // Must unhook before destroying
     hook = beast::insight::Hook();
+
+    for (auto submitted = m_submitted.exchange(nullptr); submitted;)
+        delete std::exchange(submitted, submitted->next);
 }
 
 void
 JobQueue::collect()
 {
-    std::lock_guard lock(m_mutex);
-    job_count = m_jobSet.size();
+    job_count = m_jobCount;
 }
 
 bool
 JobQueue::addRefCountedJob(
     JobType type,
     std::string const& name,
-    JobFunction const& func)
+    JobFunction const& func,
+    JobCounter const* counter)
 {
     assert(type != jtINVALID);
 
@@ -92,39 +108,52 @@ JobQueue::addRefCountedJob(
     // do not add jobs to a queue with no threads
     assert(type == jtCLIENT || m_workers.getNumberOfThreads() > 0);
 
-    {
-        std::lock_guard lock(m_mutex);
+    // If this goes off it means that a child didn't follow
+    // the Stoppable API rules. A job may only be added if:
+    //
+    //  - The JobQueue has NOT stopped
+    //          AND
+    //      * We are currently processing jobs
+    //          OR
+    //      * We have have pending jobs
+    //          OR
+    //      * Not all children are stopped
+    //
+    assert(
+        !isStopped() &&
+        (m_processCount > 0 || m_jobCount > 0 || !areChildrenStopped()));
 
-        // If this goes off it means that a child didn't follow
-        // the Stoppable API rules. A job may only be added if:
-        //
-        //  - The JobQueue has NOT stopped
-        //          AND
-        //      * We are currently processing jobs
-        //          OR
-        //      * We have have pending jobs
-        //          OR
-        //      * Not all children are stopped
-        //
-        assert(
-            !isStopped() &&
-            (m_processCount > 0 || !m_jobSet.empty() || !areChildrenStopped()));
-
-        std::pair<std::set<Job>::iterator, bool> result(m_jobSet.insert(
-            Job(type, name, ++m_lastJob, data.load(), func, m_cancelCallback)));
-        queueJob(*result.first, lock);
-    }
+    // Adding a job doesn't take m_mutex, every job gets a task and the
+    // worker running it puts the job in order.
+    auto submitted = new Submitted{
+        Job(type, name, ++m_lastJob, data.load(), func, m_cancelCallback),
+        counter,
+        m_submitted.load(std::memory_order_relaxed)};
+
+    ++data.waiting;
+    // Counted before it is pushed and its task added, so a job no worker
+    // drained yet still holds off rendezvous and checkStopped. The count
+    // only drops under m_mutex, which is what they wait on.
+    ++m_jobCount;
+    perfLog_.jobQueue(type);
+
+    while (!m_submitted.compare_exchange_weak(
+        submitted->next,
+        submitted,
+        std::memory_order_release,
+        std::memory_order_relaxed))
+        ;
+
+    m_workers.addTask();
     return true;
 }
 
 int
 JobQueue::getJobCount(JobType t) const
 {
-    std::lock_guard lock(m_mutex);
-
     JobDataMap::const_iterator c = m_jobData.find(t);
 
-    return (c == m_jobData.end()) ? 0 : c->second.waiting;
+    return (c == m_jobData.end()) ? 0 : c->second.waiting.load();
 }
 
 int
@@ -154,6 +183,82 @@ JobQueue::getJobCountGE(JobType t) const
     return ret;
 }
 
+void
+JobQueue::addSchema(
+    JobCounter const& counter,
+    std::string const& name,
+    int weight,
+    int maxRunning)
+{
+    std::lock_guard lock(m_mutex);
+
+    auto const result = m_schemaSlots.emplace(&counter, 0);
+    if (result.second)
+        result.first->second = ++m_lastSchema;
+
+    SchemaJobData& data = m_schemaData[result.first->second];
+    data.name = name;
+    data.weight = std::max(weight, 1);
+    data.maxRunning = std::max(maxRunning, 0);
+
+    JLOG(m_journal.info()) << "Schema " << name << " jobs: weight "
+                           << data.weight << ", max running "
+                           << data.maxRunning;
+}
+
+void
+JobQueue::removeSchema(JobCounter const& counter)
+{
+    std::lock_guard lock(m_mutex);
+
+    auto const iter = m_schemaSlots.find(&counter);
+    if (iter == m_schemaSlots.end())
+        return;
+
+    int const schema = iter->second;
+    m_schemaSlots.erase(iter);
+
+    // Jobs already queued keep the slot until they are done
+    SchemaJobData& data = getSchemaJobData(schema);
+    data.removed = true;
+    if (data.waiting == 0 && data.running == 0)
+        m_schemaData.erase(schema);
+}
+
+Json::Value
+JobQueue::getSchemaJson()
+{
+    using namespace std::chrono;
+    Json::Value ret(Json::objectValue);
+
+    std::lock_guard lock(m_mutex);
+
+    // Count the jobs no worker has ordered yet with their schema
+    drainSubmitted(lock);
+
+    for (auto const& [schema, data] : m_schemaData)
+    {
+        if (schema == 0 && data.dispatched == 0 && data.waiting == 0)
+            continue;
+
+        Json::Value& s = ret[data.name];
+        s["weight"] = data.weight;
+        if (data.maxRunning != 0)
+            s["max_running"] = data.maxRunning;
+        s["waiting"] = data.waiting;
+        s["in_progress"] = data.running;
+        s["dispatched"] = static_cast<Json::UInt>(data.dispatched);
+        if (data.dispatched != 0)
+            s["avg_wait"] = static_cast<int>(
+                duration_cast<milliseconds>(data.totalWait).count() /
+                data.dispatched);
+        s["peak_wait"] = static_cast<int>(
+            duration_cast<milliseconds>(data.peakWait).count());
+    }
+
+    return ret;
+}
+
 void
 JobQueue::setThreadCount(int c, bool const standaloneMode)
 {
@@ -275,8 +380,75 @@ JobQueue::getJson(int c)
 void
 JobQueue::rendezvous()
 {
+    // m_jobCount includes jobs added but not drained yet, the task that
+    // drains and runs them notifies once they are done.
     std::unique_lock<std::mutex> lock(m_mutex);
-    cv_.wait(lock, [&] { return m_processCount == 0 && m_jobSet.empty(); });
+    cv_.wait(lock, [&] { return m_processCount == 0 && m_jobCount == 0; });
+}
+
+void
+JobQueue::parallelFor(
+    JobType type,
+    std::string const& name,
+    std::size_t count,
+    std::function<void(std::size_t)> const& f,
+    JobCounter& jobCounter)
+{
+    if (count == 0)
+        return;
+
+    struct State
+    {
+        std::atomic<std::size_t> next{0};
+        std::size_t done = 0;
+        // The first exception thrown by f
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+    auto state = std::make_shared<State>();
+
+    // A job that starts after all items were taken returns at once and
+    // never touches f, which may be gone by then. An item that throws still
+    // counts as done, so the caller is not left waiting for it.
+    auto work = [state, count, &f]() {
+        std::size_t finished = 0;
+        for (auto i = state->next++; i < count; i = state->next++)
+        {
+            try
+            {
+                f(i);
+            }
+            catch (...)
+            {
+                std::lock_guard lock(state->mutex);
+                if (!state->error)
+                    state->error = std::current_exception();
+            }
+            ++finished;
+        }
+        if (finished > 0)
+        {
+            std::lock_guard lock(state->mutex);
+            state->done += finished;
+            state->cv.notify_all();
+        }
+    };
+
+    auto const helpers = std::min<std::size_t>(
+        count - 1, std::max(1u, std::thread::hardware_concurrency()) - 1);
+    for (std::size_t i = 0; i < helpers; ++i)
+    {
+        if (!addJob(type, name, [work](Job&) { work(); }, jobCounter))
+            break;
+    }
+
+    // Take part so that nothing waits on jobs still queued
+    work();
+    std::unique_lock lock(state->mutex);
+    state->cv.wait(lock, [&] { return state->done == count; });
+    if (state->error)
+        std::rethrow_exception(state->error);
 }
 
 JobTypeData&
@@ -293,6 +465,18 @@ JobQueue::getJobTypeData(JobType type)
     return c->second;
 }
 
+JobQueue::SchemaJobData&
+JobQueue::getSchemaJobData(int schema)
+{
+    auto iter = m_schemaData.find(schema);
+    assert(iter != m_schemaData.end());
+
+    if (iter == m_schemaData.end())
+        return m_schemaData[0];
+
+    return iter->second;
+}
+
 void
 JobQueue::onStop()
 {
@@ -311,93 +495,157 @@ JobQueue::checkStopped(std::lock_guard<std::mutex> const& lock)
     //  4. There are no remaining Jobs in the job set
     //  5. There are no suspended coroutines
     //
+    // Jobs pushed since the last drain are moved in first, a job that is
+    // counted but still being pushed has a task coming that checks again.
+    drainSubmitted(lock);
     if (isStopping() && areChildrenStopped() && (m_processCount == 0) &&
-        m_jobSet.empty() && nSuspend_ == 0)
+        m_jobCount == 0 && nSuspend_ == 0)
     {
         stopped();
     }
 }
 
 void
-JobQueue::queueJob(Job const& job, std::lock_guard<std::mutex> const& lock)
+JobQueue::drainSubmitted(std::lock_guard<std::mutex> const& lock)
 {
-    JobType const type(job.getType());
-    assert(type != jtINVALID);
-    assert(m_jobSet.find(job) != m_jobSet.end());
-    perfLog_.jobQueue(type);
-
-    JobTypeData& data(getJobTypeData(type));
-
-    if (data.waiting + data.running < getJobLimit(type))
+    // Restore the order the jobs were added in
+    Submitted* ordered = nullptr;
+    for (auto list = m_submitted.exchange(nullptr, std::memory_order_acquire);
+         list;)
     {
-        m_workers.addTask();
+        auto next = list->next;
+        list->next = ordered;
+        ordered = list;
+        list = next;
     }
-    else
+
+    while (ordered)
     {
-        // defer the task until we go below the limit
-        //
-        ++data.deferred;
+        std::unique_ptr<Submitted> submitted(ordered);
+        ordered = ordered->next;
+
+        Job& job = submitted->job;
+        JobType const type(job.getType());
+        assert(type != jtINVALID);
+
+        JobTypeData& data(getJobTypeData(type));
+
+        int schema = 0;
+        if (submitted->counter)
+        {
+            auto const it = m_schemaSlots.find(submitted->counter);
+            if (it != m_schemaSlots.end())
+                schema = it->second;
+        }
+
+        // Start-time fair queuing: a job starts after the previous one of
+        // its schema would finish, but never before the type's virtual time
+        SchemaJobData& schemaData = getSchemaJobData(schema);
+        std::uint64_t& finish = schemaData.finish[type];
+        std::uint64_t const start = std::max(finish, data.virtualTime);
+        finish = start + virtualJobCost / schemaData.weight;
+
+        job.setSchedule(schema, start);
+        ++schemaData.waiting;
+        schemaData.jobs.insert(std::move(job));
     }
-    ++data.waiting;
 }
 
-void
+bool
 JobQueue::getNextJob(Job& job)
 {
-    assert(!m_jobSet.empty());
-
-    std::set<Job>::const_iterator iter;
-    for (iter = m_jobSet.begin(); iter != m_jobSet.end(); ++iter)
+    // Every schema below its limit offers its first job of a type below
+    // the type's limit, the first of those in Job order runs. This costs
+    // the number of schemas and types, not the number of waiting jobs.
+    SchemaJobData* best = nullptr;
+    std::set<Job>::iterator iter;
+    for (auto& entry : m_schemaData)
     {
-        JobTypeData& data(getJobTypeData(iter->getType()));
+        SchemaJobData& schemaData = entry.second;
+        if (schemaData.maxRunning != 0 &&
+            schemaData.running >= schemaData.maxRunning)
+            continue;
+
+        auto& jobs = schemaData.jobs;
+        auto it = jobs.begin();
+        while (it != jobs.end())
+        {
+            JobType const type = it->getType();
+            JobTypeData& data(getJobTypeData(type));
+
+            assert(data.running <= getJobLimit(type));
 
-        assert(data.running <= getJobLimit(data.type()));
+            if (data.running < getJobLimit(type))
+                break;
 
-        // Run this job if we're running below the limit.
-        if (data.running < getJobLimit(data.type()))
+            // Skip the rest of this type's band
+            it = jobs.lower_bound(Job(static_cast<JobType>(type - 1), 0));
+        }
+
+        if (it != jobs.end() && (best == nullptr || *it < *iter))
         {
-            assert(data.waiting > 0);
-            break;
+            best = &schemaData;
+            iter = it;
         }
     }
 
-    assert(iter != m_jobSet.end());
+    if (best == nullptr)
+        return false;
 
+    SchemaJobData& schemaData(*best);
     JobType const type = iter->getType();
     JobTypeData& data(getJobTypeData(type));
 
     assert(type != jtINVALID);
+    assert(data.waiting > 0);
+
+    auto const wait = std::chrono::duration_cast<std::chrono::microseconds>(
+        Job::clock_type::now() - iter->queue_time());
+    schemaData.totalWait += wait;
+    schemaData.peakWait = std::max(schemaData.peakWait, wait);
+    ++schemaData.dispatched;
+    --schemaData.waiting;
+    ++schemaData.running;
+
+    data.virtualTime = std::max(data.virtualTime, iter->virtualStart());
 
     job = *iter;
-    m_jobSet.erase(iter);
+    schemaData.jobs.erase(iter);
+    --m_jobCount;
 
     --data.waiting;
     ++data.running;
+    return true;
 }
 
 void
-JobQueue::finishJob(JobType type)
+JobQueue::finishJob(JobType type, int schema)
 {
     assert(type != jtINVALID);
 
     JobTypeData& data = getJobTypeData(type);
 
-    // Queue a deferred task if possible
-    if (data.deferred > 0)
-    {
-        assert(data.running + data.waiting >= getJobLimit(type));
+    --data.running;
+
+    SchemaJobData& schemaData = getSchemaJobData(schema);
+    --schemaData.running;
+    if (schemaData.removed && schemaData.waiting == 0 &&
+        schemaData.running == 0)
+        m_schemaData.erase(schema);
 
-        --data.deferred;
+    // A type or schema slot was freed, a parked task may find a job now
+    if (m_parked > 0)
+    {
+        --m_parked;
         m_workers.addTask();
     }
-
-    --data.running;
 }
 
 void
 JobQueue::processTask(int instance)
 {
     JobType type;
+    int schema;
 
     {
         using namespace std::chrono;
@@ -406,10 +654,17 @@ JobQueue::processTask(int instance)
             Job job;
             {
                 std::lock_guard lock(m_mutex);
-                getNextJob(job);
+                drainSubmitted(lock);
+                if (!getNextJob(job))
+                {
+                    // Every waiting job is held back by a limit
+                    ++m_parked;
+                    return;
+                }
                 ++m_processCount;
             }
             type = job.getType();
+            schema = job.getSchema();
             JobTypeData& data(getJobTypeData(type));
             JLOG(m_journal.trace()) << "Doing " << data.name() << "job";
 
@@ -438,8 +693,8 @@ JobQueue::processTask(int instance)
         // Job should be destroyed before calling checkStopped
         // otherwise destructors with side effects can access
         // parent objects that are already destroyed.
-        finishJob(type);
-        if (--m_processCount == 0 && m_jobSet.empty())
+        finishJob(type, schema);
+        if (--m_processCount == 0 && m_jobCount == 0)
             cv_.notify_all();
         checkStopped(lock);
     }
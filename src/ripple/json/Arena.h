@@ -0,0 +1,187 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_JSON_ARENA_H_INCLUDED
+#define RIPPLE_JSON_ARENA_H_INCLUDED
+
+#include <cstddef>
+#include <new>
+
+namespace Json {
+
+/** Memory for the Value trees built while serving one request.
+
+    While an arena is installed on a thread, the strings, member names and
+    object members of the Values created there are carved from large
+    blocks instead of being allocated one by one. A block is returned to
+    the heap when its last allocation is released, so a Value that
+    outlives the request stays valid, it just keeps its block alive.
+
+    Only the thread that installed an arena may allocate from it. Code
+    that suspends, like JobQueue::Coro, must take the arena with it, see
+    exchange().
+*/
+class Arena
+{
+public:
+    Arena() = default;
+    Arena(Arena const&) = delete;
+    Arena&
+    operator=(Arena const&) = delete;
+    ~Arena();
+
+    /** Install arena on the calling thread, null to use the heap.
+
+        @return the arena that was installed
+    */
+    static Arena*
+    exchange(Arena* arena) noexcept;
+
+    // Bytes handed out by this arena
+    std::size_t
+    allocated() const
+    {
+        return allocated_;
+    }
+
+    /** Memory from the arena of this thread, or the heap if there is none.
+
+        The result is aligned for any type with a fundamental alignment of
+        at most alignof(void*).
+    */
+    static void*
+    allocate(std::size_t size);
+
+    // Release memory from allocate(), from any thread.
+    static void
+    deallocate(void* p) noexcept;
+
+private:
+    struct Block;
+
+    void*
+    carve(std::size_t size);
+
+    void
+    retire() noexcept;
+
+    static void
+    release(Block* block) noexcept;
+
+    Block* block_ = nullptr;
+    char* next_ = nullptr;
+    char* end_ = nullptr;
+    std::size_t allocated_ = 0;
+};
+
+/** Installs an arena on the calling thread for its lifetime. */
+class ArenaScope
+{
+public:
+    ArenaScope() : previous_(Arena::exchange(&arena_))
+    {
+    }
+
+    ArenaScope(ArenaScope const&) = delete;
+    ArenaScope&
+    operator=(ArenaScope const&) = delete;
+
+    ~ArenaScope()
+    {
+        Arena::exchange(previous_);
+    }
+
+private:
+    Arena arena_;
+    Arena* previous_;
+};
+
+/** Puts the arena of the calling thread aside for its lifetime.
+
+    State a request leaves behind, like a path_find request or a
+    subscription, is built under it so that it doesn't hold on to the
+    blocks of the request that made it.
+*/
+class HeapScope
+{
+public:
+    HeapScope() : previous_(Arena::exchange(nullptr))
+    {
+    }
+
+    HeapScope(HeapScope const&) = delete;
+    HeapScope&
+    operator=(HeapScope const&) = delete;
+
+    ~HeapScope()
+    {
+        Arena::exchange(previous_);
+    }
+
+private:
+    Arena* previous_;
+};
+
+/** Standard allocator over Arena::allocate, for the containers of Value. */
+template <class T>
+struct ArenaAllocator
+{
+    static_assert(
+        alignof(T) <= alignof(void*),
+        "Arena memory is only aligned for pointers");
+
+    using value_type = T;
+
+    ArenaAllocator() = default;
+
+    template <class U>
+    ArenaAllocator(ArenaAllocator<U> const&) noexcept
+    {
+    }
+
+    T*
+    allocate(std::size_t n)
+    {
+        return static_cast<T*>(Arena::allocate(n * sizeof(T)));
+    }
+
+    void
+    deallocate(T* p, std::size_t) noexcept
+    {
+        Arena::deallocate(p);
+    }
+
+    template <class U>
+    bool
+    operator==(ArenaAllocator<U> const&) const noexcept
+    {
+        return true;
+    }
+
+    template <class U>
+    bool
+    operator!=(ArenaAllocator<U> const&) const noexcept
+    {
+        return false;
+    }
+};
+
+}  // namespace Json
+
+#endif
@@ -0,0 +1,582 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_JSON_SAXPARSER_H_INCLUDED
+#define RIPPLE_JSON_SAXPARSER_H_INCLUDED
+
+#include <ripple/json/json_value.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace Json {
+
+/** Single pass JSON parser that reports what it reads to a handler.
+
+    Nothing is built: the handler decides what to keep. Strings without
+    escapes are handed over as views into the input, escaped ones are
+    decoded into a buffer reused for the whole document, so a document
+    costs no allocation in the parser itself.
+
+    It accepts exactly what Json::Reader always accepted, including
+    comments, and applies the same number ranges and nesting limit.
+
+    Handler must provide
+
+        bool onNull();
+        bool onBool(bool);
+        bool onInt(Value::LargestInt);
+        bool onDouble(double);
+        bool onString(std::string_view);
+        bool onKey(std::string_view);
+        bool onObjectBegin();
+        bool onObjectEnd();
+        bool onArrayBegin();
+        bool onArrayEnd();
+        std::string error() const;
+
+    Returning false stops the parse, error() then tells why.
+*/
+template <class Handler>
+class SaxParser
+{
+public:
+    using Location = char const*;
+
+    SaxParser(Handler& handler, unsigned nestLimit)
+        : handler_(handler), nestLimit_(nestLimit)
+    {
+    }
+
+    /** Parse one value, anything after it is ignored.
+
+        @return false on error, see errorLocation() and errorMessage()
+    */
+    bool
+    parse(Location begin, Location end)
+    {
+        current_ = begin;
+        end_ = end;
+        errorLocation_ = nullptr;
+        errorMessage_.clear();
+        return readValue(0);
+    }
+
+    Location
+    errorLocation() const
+    {
+        return errorLocation_;
+    }
+
+    std::string const&
+    errorMessage() const
+    {
+        return errorMessage_;
+    }
+
+private:
+    bool
+    fail(std::string message, Location where)
+    {
+        if (!errorLocation_)
+        {
+            errorLocation_ = where;
+            errorMessage_ = std::move(message);
+        }
+        return false;
+    }
+
+    bool
+    handlerFailed(Location where)
+    {
+        return fail(handler_.error(), where);
+    }
+
+    // Whitespace and comments
+    bool
+    skipSpaces()
+    {
+        while (current_ != end_)
+        {
+            char const c = *current_;
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+            {
+                ++current_;
+            }
+            else if (c == '/')
+            {
+                Location const start = current_++;
+                if (current_ != end_ && *current_ == '*')
+                {
+                    ++current_;
+                    for (;;)
+                    {
+                        if (end_ - current_ < 2)
+                            return fail("Syntax error: unterminated comment.",
+                                start);
+                        if (current_[0] == '*' && current_[1] == '/')
+                            break;
+                        ++current_;
+                    }
+                    current_ += 2;
+                }
+                else if (current_ != end_ && *current_ == '/')
+                {
+                    while (current_ != end_ && *current_ != '\r' &&
+                           *current_ != '\n')
+                        ++current_;
+                }
+                else
+                {
+                    return fail(
+                        "Syntax error: value, object or array expected.",
+                        start);
+                }
+            }
+            else
+            {
+                break;
+            }
+        }
+        return true;
+    }
+
+    bool
+    match(char const* pattern, std::size_t length)
+    {
+        if (std::size_t(end_ - current_) < length ||
+            std::memcmp(current_, pattern, length) != 0)
+            return false;
+        current_ += length;
+        return true;
+    }
+
+    bool
+    readValue(unsigned depth)
+    {
+        if (!skipSpaces())
+            return false;
+
+        Location const start = current_;
+        if (depth > nestLimit_)
+            return fail("Syntax error: maximum nesting depth exceeded", start);
+
+        if (current_ == end_ || *current_ == 0)
+            return fail("Syntax error: value, object or array expected.", start);
+
+        switch (*current_++)
+        {
+            case '{':
+                return readObject(depth);
+
+            case '[':
+                return readArray(depth);
+
+            case '"': {
+                std::string_view s;
+                if (!readString(start, s))
+                    return false;
+                return handler_.onString(s) || handlerFailed(start);
+            }
+
+            case '0':
+            case '1':
+            case '2':
+            case '3':
+            case '4':
+            case '5':
+            case '6':
+            case '7':
+            case '8':
+            case '9':
+            case '-':
+                return readNumber(start);
+
+            case 't':
+                if (!match("rue", 3))
+                    break;
+                return handler_.onBool(true) || handlerFailed(start);
+
+            case 'f':
+                if (!match("alse", 4))
+                    break;
+                return handler_.onBool(false) || handlerFailed(start);
+
+            case 'n':
+                if (!match("ull", 3))
+                    break;
+                return handler_.onNull() || handlerFailed(start);
+
+            default:
+                break;
+        }
+
+        return fail("Syntax error: value, object or array expected.", start);
+    }
+
+    bool
+    readObject(unsigned depth)
+    {
+        Location const start = current_ - 1;
+        if (!handler_.onObjectBegin())
+            return handlerFailed(start);
+
+        if (!skipSpaces())
+            return false;
+        if (current_ != end_ && *current_ == '}')
+        {
+            ++current_;
+            return handler_.onObjectEnd() || handlerFailed(start);
+        }
+
+        for (;;)
+        {
+            if (!skipSpaces())
+                return false;
+
+            Location const name = current_;
+            if (current_ == end_ || *current_ != '"')
+                return fail("Missing '}' or object member name", name);
+            ++current_;
+
+            std::string_view key;
+            if (!readString(name, key))
+                return false;
+            if (!handler_.onKey(key))
+                return handlerFailed(name);
+
+            if (!skipSpaces())
+                return false;
+            if (current_ == end_ || *current_ != ':')
+                return fail("Missing ':' after object member name", current_);
+            ++current_;
+
+            if (!readValue(depth + 1))
+                return false;
+
+            if (!skipSpaces())
+                return false;
+            if (current_ != end_ && *current_ == ',')
+            {
+                ++current_;
+                continue;
+            }
+            if (current_ != end_ && *current_ == '}')
+            {
+                ++current_;
+                return handler_.onObjectEnd() || handlerFailed(start);
+            }
+            return fail("Missing ',' or '}' in object declaration", current_);
+        }
+    }
+
+    bool
+    readArray(unsigned depth)
+    {
+        Location const start = current_ - 1;
+        if (!handler_.onArrayBegin())
+            return handlerFailed(start);
+
+        if (!skipSpaces())
+            return false;
+        if (current_ != end_ && *current_ == ']')
+        {
+            ++current_;
+            return handler_.onArrayEnd() || handlerFailed(start);
+        }
+
+        for (;;)
+        {
+            if (!readValue(depth + 1))
+                return false;
+
+            if (!skipSpaces())
+                return false;
+            if (current_ != end_ && *current_ == ',')
+            {
+                ++current_;
+                continue;
+            }
+            if (current_ != end_ && *current_ == ']')
+            {
+                ++current_;
+                return handler_.onArrayEnd() || handlerFailed(start);
+            }
+            return fail("Missing ',' or ']' in array declaration", current_);
+        }
+    }
+
+    // current_ is past the opening quote. The result points into the
+    // input or into buffer_ and is valid until the next string is read.
+    bool
+    readString(Location start, std::string_view& result)
+    {
+        // Fast path: find the closing quote, most strings have no escapes
+        Location p = current_;
+        while (p != end_ && *p != '"' && *p != '\\')
+            ++p;
+
+        if (p == end_)
+            return fail("Syntax error: unterminated string.", start);
+
+        if (*p == '"')
+        {
+            result = std::string_view(current_, p - current_);
+            current_ = p + 1;
+            return true;
+        }
+
+        buffer_.assign(current_, p);
+        current_ = p;
+        while (current_ != end_)
+        {
+            char const c = *current_++;
+            if (c == '"')
+            {
+                result = buffer_;
+                return true;
+            }
+            if (c != '\\')
+            {
+                buffer_ += c;
+                continue;
+            }
+
+            if (current_ == end_)
+                break;
+
+            switch (char const escape = *current_++)
+            {
+                case '"':
+                case '/':
+                case '\\':
+                    buffer_ += escape;
+                    break;
+                case 'b':
+                    buffer_ += '\b';
+                    break;
+                case 'f':
+                    buffer_ += '\f';
+                    break;
+                case 'n':
+                    buffer_ += '\n';
+                    break;
+                case 'r':
+                    buffer_ += '\r';
+                    break;
+                case 't':
+                    buffer_ += '\t';
+                    break;
+                case 'u': {
+                    unsigned int unicode;
+                    if (!readCodePoint(start, unicode))
+                        return false;
+                    appendUTF8(unicode);
+                    break;
+                }
+                default:
+                    return fail("Bad escape sequence in string", current_);
+            }
+        }
+        return fail("Syntax error: unterminated string.", start);
+    }
+
+    bool
+    readHex4(unsigned int& unicode)
+    {
+        if (end_ - current_ < 4)
+            return fail(
+                "Bad unicode escape sequence in string: four digits expected.",
+                current_);
+
+        unicode = 0;
+        for (int index = 0; index < 4; ++index)
+        {
+            char const c = *current_++;
+            unicode *= 16;
+
+            if (c >= '0' && c <= '9')
+                unicode += c - '0';
+            else if (c >= 'a' && c <= 'f')
+                unicode += c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                unicode += c - 'A' + 10;
+            else
+                return fail(
+                    "Bad unicode escape sequence in string: hexadecimal "
+                    "digit expected.",
+                    current_);
+        }
+        return true;
+    }
+
+    bool
+    readCodePoint(Location start, unsigned int& unicode)
+    {
+        if (!readHex4(unicode))
+            return false;
+
+        if (unicode >= 0xD800 && unicode <= 0xDBFF)
+        {
+            // surrogate pairs
+            if (end_ - current_ < 6)
+                return fail(
+                    "additional six characters expected to parse unicode "
+                    "surrogate pair.",
+                    current_);
+
+            if (current_[0] != '\\' || current_[1] != 'u')
+                return fail(
+                    "expecting another \\u token to begin the second half of "
+                    "a unicode surrogate pair",
+                    current_);
+            current_ += 2;
+
+            unsigned int surrogatePair;
+            if (!readHex4(surrogatePair))
+                return false;
+            unicode =
+                0x10000 + ((unicode & 0x3FF) << 10) + (surrogatePair & 0x3FF);
+        }
+        return true;
+    }
+
+    void
+    appendUTF8(unsigned int cp)
+    {
+        if (cp <= 0x7f)
+        {
+            buffer_ += static_cast<char>(cp);
+        }
+        else if (cp <= 0x7FF)
+        {
+            buffer_ += static_cast<char>(0xC0 | (0x1f & (cp >> 6)));
+            buffer_ += static_cast<char>(0x80 | (0x3f & cp));
+        }
+        else if (cp <= 0xFFFF)
+        {
+            buffer_ += static_cast<char>(0xE0 | (0xf & (cp >> 12)));
+            buffer_ += static_cast<char>(0x80 | (0x3f & (cp >> 6)));
+            buffer_ += static_cast<char>(0x80 | (0x3f & cp));
+        }
+        else if (cp <= 0x10FFFF)
+        {
+            buffer_ += static_cast<char>(0xF0 | (0x7 & (cp >> 18)));
+            buffer_ += static_cast<char>(0x80 | (0x3f & (cp >> 12)));
+            buffer_ += static_cast<char>(0x80 | (0x3f & (cp >> 6)));
+            buffer_ += static_cast<char>(0x80 | (0x3f & cp));
+        }
+    }
+
+    // start is at the first character, current_ past it.
+    bool
+    readNumber(Location start)
+    {
+        // A number is everything made of digits and . e E + -
+        bool isDouble = false;
+        while (current_ != end_)
+        {
+            char const c = *current_;
+            if (c >= '0' && c <= '9')
+                ;
+            else if (c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-')
+                isDouble = true;
+            else
+                break;
+            ++current_;
+        }
+
+        std::string_view const token(start, current_ - start);
+        if (isDouble)
+            return readDouble(token, start);
+
+        bool const isNegative = token[0] == '-';
+        std::size_t i = isNegative ? 1 : 0;
+        if (i == token.size())
+            return fail(
+                "'" + std::string(token) + "' is not a valid number.", start);
+
+        // The existing Json integers are 32-bit so using a 64-bit value
+        // here avoids overflows in the conversion code below.
+        std::int64_t value = 0;
+        for (; i < token.size(); ++i)
+        {
+            int const digit = token[i] - '0';
+            if (value > (Value::maxLargestInt - digit) / 10)
+                return fail(
+                    "'" + std::string(token) + "' exceeds the allowable range.",
+                    start);
+            value = value * 10 + digit;
+        }
+
+        if (isNegative)
+        {
+            value = -value;
+            if (value < Value::minInt)
+                return fail(
+                    "'" + std::string(token) + "' exceeds the allowable range.",
+                    start);
+        }
+
+        return handler_.onInt(static_cast<Value::LargestInt>(value)) ||
+            handlerFailed(start);
+    }
+
+    bool
+    readDouble(std::string_view token, Location start)
+    {
+        // strtod needs a terminated string
+        char buffer[33];
+        std::string large;
+        char const* s;
+        if (token.size() < sizeof(buffer))
+        {
+            std::memcpy(buffer, token.data(), token.size());
+            buffer[token.size()] = 0;
+            s = buffer;
+        }
+        else
+        {
+            large.assign(token);
+            s = large.c_str();
+        }
+
+        char* parsed = nullptr;
+        double const value = std::strtod(s, &parsed);
+        if (parsed == s)
+            return fail(
+                "'" + std::string(token) + "' is not a number.", start);
+
+        return handler_.onDouble(value) || handlerFailed(start);
+    }
+
+    Handler& handler_;
+    unsigned const nestLimit_;
+    Location current_ = nullptr;
+    Location end_ = nullptr;
+    Location errorLocation_ = nullptr;
+    std::string errorMessage_;
+    std::string buffer_;
+};
+
+}  // namespace Json
+
+#endif
@@ -0,0 +1,132 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/json/Arena.h>
+#include <atomic>
+#include <cstdlib>
+
+namespace Json {
+
+// Every allocation is preceded by the block it was carved from, null for
+// the ones from the heap.
+struct Arena::Block
+{
+    std::atomic<std::size_t> refs{1};
+};
+
+static constexpr std::size_t blockSize = 64 * 1024;
+
+// Anything larger goes to the heap so a block is never mostly one string
+static constexpr std::size_t maxCarve = blockSize / 8;
+
+static constexpr std::size_t headerSize = sizeof(void*);
+
+static thread_local Arena* current = nullptr;
+
+void
+Arena::release(Block* block) noexcept
+{
+    if (block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        block->~Block();
+        std::free(block);
+    }
+}
+
+Arena::~Arena()
+{
+    retire();
+}
+
+Arena*
+Arena::exchange(Arena* arena) noexcept
+{
+    Arena* const previous = current;
+    current = arena;
+    return previous;
+}
+
+void*
+Arena::allocate(std::size_t size)
+{
+    if (current)
+    {
+        if (void* p = current->carve(size))
+            return p;
+    }
+
+    auto const header = static_cast<Block**>(std::malloc(headerSize + size));
+    if (!header)
+        throw std::bad_alloc();
+    *header = nullptr;
+    return header + 1;
+}
+
+void
+Arena::deallocate(void* p) noexcept
+{
+    if (!p)
+        return;
+
+    auto const header = static_cast<Block**>(p) - 1;
+    if (*header)
+        release(*header);
+    else
+        std::free(header);
+}
+
+void*
+Arena::carve(std::size_t size)
+{
+    std::size_t const need =
+        headerSize + (size + headerSize - 1) / headerSize * headerSize;
+    if (need > maxCarve)
+        return nullptr;
+
+    if (std::size_t(end_ - next_) < need)
+    {
+        retire();
+
+        void* const memory = std::malloc(blockSize);
+        if (!memory)
+            throw std::bad_alloc();
+        block_ = new (memory) Block;
+        next_ = static_cast<char*>(memory) +
+            (sizeof(Block) + headerSize - 1) / headerSize * headerSize;
+        end_ = static_cast<char*>(memory) + blockSize;
+    }
+
+    auto const header = reinterpret_cast<Block**>(next_);
+    *header = block_;
+    block_->refs.fetch_add(1, std::memory_order_relaxed);
+    next_ += need;
+    allocated_ += size;
+    return header + 1;
+}
+
+void
+Arena::retire() noexcept
+{
+    if (block_)
+        release(block_);
+    block_ = nullptr;
+    next_ = end_ = nullptr;
+}
+
+}  // namespace Json
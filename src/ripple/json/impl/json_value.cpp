@@ -59,7 +59,7 @@ public:
         if (length == unknown)
             length = value ? (unsigned int)strlen(value) : 0;
 
-        char* newString = static_cast<char*>(malloc(length + 1));
+        char* newString = static_cast<char*>(Arena::allocate(length + 1));
         if (value)
             memcpy(newString, value, length);
         newString[length] = 0;
@@ -69,8 +69,7 @@ public:
     void
     releaseStringValue(char* value) override
     {
-        if (value)
-            free(value);
+        Arena::deallocate(value);
     }
 };
 
@@ -267,6 +266,14 @@ Value::Value(const char* value) : type_(stringValue), allocated_(true)
 	length_ = strlen(value);
 }
 
+Value::Value(const char* begin, const char* end)
+    : type_(stringValue), allocated_(true)
+{
+    value_.string_ = valueAllocator()->duplicateStringValue(
+        begin, (unsigned int)(end - begin));
+    length_ = end - begin;
+}
+
 Value::Value(std::string const& value) : type_(stringValue), allocated_(true)
 {
     value_.string_ = valueAllocator()->duplicateStringValue(
@@ -25,7 +25,8 @@
 #include <ripple/json/json_forwards.h>
 #include <ripple/json/json_value.h>
 #include <boost/asio/buffer.hpp>
-#include <stack>
+#include <iterator>
+#include <string>
 
 namespace Json {
 
@@ -90,121 +91,17 @@ public:
     static constexpr unsigned nest_limit{25};
 
 private:
-    enum TokenType {
-        tokenEndOfStream = 0,
-        tokenObjectBegin,
-        tokenObjectEnd,
-        tokenArrayBegin,
-        tokenArrayEnd,
-        tokenString,
-        tokenInteger,
-        tokenDouble,
-        tokenTrue,
-        tokenFalse,
-        tokenNull,
-        tokenArraySeparator,
-        tokenMemberSeparator,
-        tokenComment,
-        tokenError
-    };
-
-    class Token
-    {
-    public:
-        explicit Token() = default;
-
-        TokenType type_;
-        Location start_;
-        Location end_;
-    };
-
-    class ErrorInfo
-    {
-    public:
-        explicit ErrorInfo() = default;
-
-        Token token_;
-        std::string message_;
-        Location extra_;
-    };
+    class ValueBuilder;
 
-    using Errors = std::deque<ErrorInfo>;
-
-    bool
-    expectToken(TokenType type, Token& token, const char* message);
-    bool
-    readToken(Token& token);
-    void
-    skipSpaces();
-    bool
-    match(Location pattern, int patternLength);
-    bool
-    readComment();
-    bool
-    readCStyleComment();
-    bool
-    readCppStyleComment();
-    bool
-    readString();
-    Reader::TokenType
-    readNumber();
-    bool
-    readValue(unsigned depth);
-    bool
-    readObject(Token& token, unsigned depth);
-    bool
-    readArray(Token& token, unsigned depth);
-    bool
-    decodeNumber(Token& token);
-    bool
-    decodeString(Token& token);
-    bool
-    decodeString(Token& token, std::string& decoded);
-    bool
-    decodeDouble(Token& token);
-    bool
-    decodeUnicodeCodePoint(
-        Token& token,
-        Location& current,
-        Location end,
-        unsigned int& unicode);
-    bool
-    decodeUnicodeEscapeSequence(
-        Token& token,
-        Location& current,
-        Location end,
-        unsigned int& unicode);
-    bool
-    addError(std::string const& message, Token& token, Location extra = 0);
-    bool
-    recoverFromError(TokenType skipUntilToken);
-    bool
-    addErrorAndRecover(
-        std::string const& message,
-        Token& token,
-        TokenType skipUntilToken);
-    void
-    skipUntilSpace();
-    Value&
-    currentValue();
-    Char
-    getNextChar();
-    void
-    getLocationLineAndColumn(Location location, int& line, int& column) const;
     std::string
-    getLocationLineAndColumn(Location location) const;
-    void
-    skipCommentTokens(Token& token);
-
-    using Nodes = std::stack<Value*>;
-    Nodes nodes_;
-    Errors errors_;
-    std::string document_;
-    Location begin_;
-    Location end_;
-    Location current_;
-    Location lastValueEnd_;
-    Value* lastValue_;
+    getLocationLineAndColumn(
+        Location begin,
+        Location end,
+        Location location) const;
+
+    // Formatted when the error is found so nothing refers to the document
+    // once parse returns.
+    std::string errors_;
 };
 
 template <class BufferSequence>
@@ -212,6 +109,17 @@ bool
 Reader::parse(Value& root, BufferSequence const& bs)
 {
     using namespace boost::asio;
+
+    // The usual case, one buffer, is parsed where it is.
+    auto it = buffer_sequence_begin(bs);
+    auto const last = buffer_sequence_end(bs);
+    if (it != last && std::next(it) == last)
+    {
+        auto const b = const_buffer(*it);
+        auto const begin = static_cast<char const*>(b.data());
+        return parse(begin, begin + b.size(), root);
+    }
+
     std::string s;
     s.reserve(buffer_size(bs));
     for (auto const& b : bs)
@@ -20,6 +20,7 @@
 #ifndef RIPPLE_JSON_JSON_VALUE_H_INCLUDED
 #define RIPPLE_JSON_JSON_VALUE_H_INCLUDED
 
+#include <ripple/json/Arena.h>
 #include <ripple/json/json_forwards.h>
 #include <cstring>
 #include <map>
@@ -208,7 +209,11 @@ private:
     };
 
 public:
-    using ObjectValues = std::map<CZString, Value>;
+    using ObjectValues = std::map<
+        CZString,
+        Value,
+        std::less<CZString>,
+        ArenaAllocator<std::pair<const CZString, Value>>>;
 
 public:
     /** \brief Create a default Value of the given type.
@@ -235,6 +240,8 @@ public:
 #endif // if defined(JSON_HAS_INT64)
     Value(double value);
     Value(const char* value);
+    /// Copy of [begin, end), which needn't be null terminated.
+    Value(const char* begin, const char* end);
     /** \brief Constructs a value from a static string.
 
      * Like other value string constructor but do not duplicate the string for
@@ -210,6 +210,12 @@ std::string
 valueToString(Int value);
 std::string
 valueToString(UInt value);
+#if defined(JSON_HAS_INT64)
+std::string
+valueToString(LargestInt value);
+std::string
+valueToString(LargestUInt value);
+#endif  // if defined(JSON_HAS_INT64)
 std::string
 valueToString(double value);
 std::string
@@ -234,6 +240,59 @@ write_string(Write const& write, std::string const& s)
     write(s.data(), s.size());
 }
 
+// Escapes straight to the output, most strings have nothing to escape
+template <class Write>
+void
+write_quoted(Write const& write, char const* s)
+{
+    write("\"", 1);
+    char const* run = s;
+    for (; *s != 0; ++s)
+    {
+        auto const c = static_cast<unsigned char>(*s);
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+
+        if (s != run)
+            write(run, s - run);
+        run = s + 1;
+        switch (c)
+        {
+            case '"':
+                write("\\\"", 2);
+                break;
+            case '\\':
+                write("\\\\", 2);
+                break;
+            case '\b':
+                write("\\b", 2);
+                break;
+            case '\f':
+                write("\\f", 2);
+                break;
+            case '\n':
+                write("\\n", 2);
+                break;
+            case '\r':
+                write("\\r", 2);
+                break;
+            case '\t':
+                write("\\t", 2);
+                break;
+            default: {
+                static char const hex[] = "0123456789ABCDEF";
+                char const escaped[] = {
+                    '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                write(escaped, sizeof(escaped));
+                break;
+            }
+        }
+    }
+    if (s != run)
+        write(run, s - run);
+    write("\"", 1);
+}
+
 template <class Write>
 void
 write_value(Write const& write, Value const& value)
@@ -245,11 +304,11 @@ write_value(Write const& write, Value const& value)
             break;
 
         case intValue:
-            write_string(write, valueToString(value.asInt()));
+            write_string(write, valueToString(value.asLargestInt()));
             break;
 
         case uintValue:
-            write_string(write, valueToString(value.asUInt()));
+            write_string(write, valueToString(value.asLargestUInt()));
             break;
 
         case realValue:
@@ -257,7 +316,7 @@ write_value(Write const& write, Value const& value)
             break;
 
         case stringValue:
-            write_string(write, valueToQuotedString(value.asCString()));
+            write_quoted(write, value.asCString());
             break;
 
         case booleanValue:
@@ -265,30 +324,34 @@ write_value(Write const& write, Value const& value)
             break;
 
         case arrayValue: {
+            // Indexes that were never set are written as null
             write("[", 1);
-            int const size = value.size();
-            for (int index = 0; index < size; ++index)
+            Value::UInt index = 0;
+            for (auto it = value.begin(); it != value.end(); ++it)
             {
+                for (auto const next = it.index(); index < next; ++index)
+                    write(index > 0 ? ",null" : "null", index > 0 ? 5 : 4);
                 if (index > 0)
                     write(",", 1);
-                write_value(write, value[index]);
+                write_value(write, *it);
+                ++index;
             }
+            for (auto const size = value.size(); index < size; ++index)
+                write(index > 0 ? ",null" : "null", index > 0 ? 5 : 4);
             write("]", 1);
             break;
         }
 
         case objectValue: {
-            Value::Members const members = value.getMemberNames();
             write("{", 1);
-            for (auto it = members.begin(); it != members.end(); ++it)
+            for (auto it = value.begin(); it != value.end(); ++it)
             {
-                std::string const& name = *it;
-                if (it != members.begin())
+                if (it != value.begin())
                     write(",", 1);
 
-                write_string(write, valueToQuotedString(name.c_str()));
+                write_quoted(write, it.memberName());
                 write(":", 1);
-                write_value(write, value[name]);
+                write_value(write, *it);
             }
             write("}", 1);
             break;
@@ -148,10 +148,10 @@ public:
         uint256 const& value);
 
     void
-    setDirtyExistInDB(
+    setDirtyOriginal(
         AccountID const& contract,
         uint256 const& key,
-        bool exist);
+        boost::optional<uint256> const& original);
 
 protected:
     ApplyFlags flags_;
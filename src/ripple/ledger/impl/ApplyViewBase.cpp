@@ -201,12 +201,14 @@ ApplyViewBase::setDirtyValue(
 }
 
 void
-ApplyViewBase::setDirtyExistInDB(
+ApplyViewBase::setDirtyOriginal(
     AccountID const& contract,
     uint256 const& key,
-    bool exist)
+    boost::optional<uint256> const& original)
 {
-    mDirtyCache[contract][key].existInDB = exist;
+    auto& slot = mDirtyCache[contract][key];
+    slot.existInDB = original != boost::none;
+    slot.original = original.value_or(uint256(0));
 }
 
 //---
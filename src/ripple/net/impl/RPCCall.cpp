@@ -1752,12 +1752,14 @@ public:
             {   "r_update",            &RPCParser::parseSignSubmit,            2,  2 },
             {   "r_delete",            &RPCParser::parseSignSubmit,            2,  3 },
 			{   "r_get",               &RPCParser::parseQueryTable,            1,  1 },
-            {   "t_dump",              &RPCParser::parseDumpTable,             2,  2 },
+            {   "t_dump",              &RPCParser::parseDumpTable,             2,  3 },
 			{   "t_dumpstop",          &RPCParser::parseDumpStop,              2,  2 },
             {   "t_dumpposition",      &RPCParser::parseDumpStop,              2,  2 },
             {   "t_audit",             &RPCParser::parseAuditTable,            3,  3 },
             {   "t_auditstop",         &RPCParser::parseAuditStop,             1,  1 },
             {   "t_auditposition",     &RPCParser::parseAuditStop,             1,  1 },
+            {   "t_snapshot",          &RPCParser::parseAuditTable,            3,  3 },
+            {   "t_snapshot_load",     &RPCParser::parseAuditStop,             1,  1 },
             {   "g_dbname",            &RPCParser::parseGetDBName,             1,  1 },
 			{	"g_cryptraw",		   &RPCParser::parseCryptRaw,			   1,  1 },
 			{   "table_auth",		   &RPCParser::parseTableAuth,			   2,  2 },
@@ -1765,6 +1767,7 @@ public:
 			{	"ledger_objects",	   &RPCParser::parseLedgerId,			   1,  1 },
             {   "node_size",		   &RPCParser::parseNodeSize, 			   0,  1 },
             {   "malloc_trim",		   &RPCParser::parseAsIs, 			       0,  0 },
+            {   "cache_usage",		   &RPCParser::parseAsIs, 			       0,  0 },
 			{   "schema_list",		   &RPCParser::parseSchemaList,  	       0,  2 },
 			{   "schema_info",		   &RPCParser::parseSchemaID,    	       1,  1 },
 			{   "schema_accept",	   &RPCParser::parseSchemaID,		       1,  1 },
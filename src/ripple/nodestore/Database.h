@@ -30,6 +30,7 @@
 #include <ripple/nodestore/impl/Tuning.h>
 #include <ripple/protocol/SystemParameters.h>
 
+#include <fstream>
 #include <thread>
 
 namespace ripple {
@@ -128,6 +129,21 @@ public:
     virtual std::shared_ptr<NodeObject>
     fetch(uint256 const& hash, std::uint32_t seq) = 0;
 
+    /** Fetch a batch of objects.
+        Equivalent to calling fetch for each hash, but the objects that are
+        not cached are read together: with a single multi-get when the
+        backend supports it, otherwise with the help of the async read
+        threads.
+
+        @note This can be called concurrently.
+        @param hashes The keys of the objects to retrieve.
+        @param seq The sequence of the ledger where the objects are stored.
+        @return The objects in the order of hashes, nullptr for the ones
+                that couldn't be retrieved.
+    */
+    virtual std::vector<std::shared_ptr<NodeObject>>
+    fetchBatch(std::vector<uint256> const& hashes, std::uint32_t seq);
+
     /** Fetch an object without waiting.
         If I/O is required to determine whether or not the object is present,
         `false` is returned. Otherwise, `true` is returned and `object` is set
@@ -248,10 +264,12 @@ protected:
     stopThreads();
 
     void
-    storeStats(size_t sz)
+    storeStats(NodeObject const& nObj, std::uint32_t seq)
     {
         ++storeCount_;
-        storeSz_ += sz;
+        storeSz_ += nObj.getData().size();
+        if (trace_)
+            traceStore(nObj, seq);
     }
 
     // Called by the public asyncFetch function
@@ -266,6 +284,12 @@ protected:
     std::shared_ptr<NodeObject>
     fetchInternal(uint256 const& hash, std::shared_ptr<Backend> backend);
 
+    // Called by fetchBatchFrom
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatchInternal(
+        std::vector<uint256> const& hashes,
+        std::shared_ptr<Backend> backend);
+
     // Called by the public import function
     void
     importInternal(Backend& dstBackend, Database& srcDB);
@@ -278,6 +302,18 @@ protected:
         KeyCache<uint256>& nCache,
         bool isAsync);
 
+    /*  Called by the public fetchBatch function.
+        parallel: the backend can't read a batch, let the async read threads
+        share the work.
+    */
+    std::vector<std::shared_ptr<NodeObject>>
+    doFetchBatch(
+        std::vector<uint256> const& hashes,
+        std::uint32_t seq,
+        std::shared_ptr<TaggedCache<uint256, NodeObject>> const& pCache,
+        std::shared_ptr<KeyCache<uint256>> const& nCache,
+        bool parallel);
+
     // Called by the public storeLedger function
     bool
     storeLedger(
@@ -320,9 +356,36 @@ private:
     // allowed sequence. Alternate networks may set this value.
     std::uint32_t const earliestLedgerSeq_;
 
+    // Access trace in the format NodeStore.Replay reads, see Benchmarks.md.
+    // Only opened when the node_db section has a trace setting.
+    std::mutex traceMutex_;
+    std::unique_ptr<std::ofstream> trace_;
+
+    std::shared_ptr<NodeObject>
+    fetchCached(
+        uint256 const& hash,
+        std::uint32_t seq,
+        TaggedCache<uint256, NodeObject>& pCache,
+        KeyCache<uint256>& nCache,
+        bool isAsync);
+
+    void
+    traceStore(NodeObject const& nObj, std::uint32_t seq);
+
+    void
+    traceFetch(
+        char const* kind,
+        uint256 const* hashes,
+        std::size_t count,
+        std::uint32_t seq);
+
     virtual std::shared_ptr<NodeObject>
     fetchFrom(uint256 const& hash, std::uint32_t seq) = 0;
 
+    // Read objects bypassing the caches, one by one unless overridden
+    virtual std::vector<std::shared_ptr<NodeObject>>
+    fetchBatchFrom(std::vector<uint256> const& hashes, std::uint32_t seq);
+
     /** Visit every object in the database
         This is usually called during import.
 
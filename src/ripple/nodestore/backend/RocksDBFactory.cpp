@@ -31,7 +31,9 @@
 #include <ripple/nodestore/impl/DecodedBlob.h>
 #include <ripple/nodestore/impl/EncodedBlob.h>
 #include <atomic>
+#include <map>
 #include <memory>
+#include <mutex>
 
 namespace ripple {
 namespace NodeStore {
@@ -80,6 +82,143 @@ public:
 
 //------------------------------------------------------------------------------
 
+/*  One RocksDB instance used by every backend configured with shared=1 and
+    the same path. Each backend keeps its objects in its own column family,
+    so the schemas of a node share the block cache, the compaction threads,
+    the write ahead log and the open files instead of each running a DB.
+*/
+class RocksDBShared
+{
+public:
+    static std::shared_ptr<RocksDBShared>
+    get(std::string const& path)
+    {
+        static std::mutex mutex;
+        static std::map<std::string, std::weak_ptr<RocksDBShared>> dbs;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& weak = dbs[path];
+        auto shared = weak.lock();
+        if (!shared)
+        {
+            shared = std::make_shared<RocksDBShared>(path);
+            weak = shared;
+        }
+        return shared;
+    }
+
+    explicit RocksDBShared(std::string const& path) : path_(path)
+    {
+    }
+
+    ~RocksDBShared()
+    {
+        if (db_)
+        {
+            for (auto& family : families_)
+                db_->DestroyColumnFamilyHandle(family.second.handle);
+            db_.reset();
+        }
+    }
+
+    // The first backend to open the DB sets the DB wide options and the
+    // block cache, all later ones get them from here.
+    std::shared_ptr<rocksdb::Cache>
+    blockCache(std::shared_ptr<rocksdb::Cache> const& cache)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!blockCache_)
+            blockCache_ = cache;
+        return blockCache_;
+    }
+
+    rocksdb::DB*
+    open(
+        rocksdb::Options const& options,
+        std::string const& name,
+        rocksdb::ColumnFamilyHandle** handle)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (!db_)
+        {
+            // Every family already in the DB has to be opened with it
+            std::vector<std::string> names;
+            if (!rocksdb::DB::ListColumnFamilies(options, path_, &names).ok())
+                names = {rocksdb::kDefaultColumnFamilyName};
+
+            std::vector<rocksdb::ColumnFamilyDescriptor> descriptors;
+            for (auto const& n : names)
+                descriptors.emplace_back(
+                    n, rocksdb::ColumnFamilyOptions(options));
+
+            std::vector<rocksdb::ColumnFamilyHandle*> handles;
+            rocksdb::DB* db = nullptr;
+            auto const status = rocksdb::DB::Open(
+                rocksdb::DBOptions(options), path_, descriptors, &handles, &db);
+            if (!status.ok() || !db)
+                Throw<std::runtime_error>(
+                    std::string("Unable to open/create RocksDB: ") +
+                    status.ToString());
+            db_.reset(db);
+
+            for (std::size_t i = 0; i < handles.size(); ++i)
+                families_[names[i]].handle = handles[i];
+        }
+
+        auto& family = families_[name];
+        if (family.users)
+            Throw<std::runtime_error>(
+                "RocksDB column family " + name + " is already open");
+
+        if (!family.handle)
+        {
+            auto const status = db_->CreateColumnFamily(
+                rocksdb::ColumnFamilyOptions(options), name, &family.handle);
+            if (!status.ok())
+                Throw<std::runtime_error>(
+                    "Unable to create RocksDB column family " + name + ": " +
+                    status.ToString());
+        }
+
+        ++family.users;
+        *handle = family.handle;
+        return db_.get();
+    }
+
+    void
+    close(std::string const& name, bool drop)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = families_.find(name);
+        if (it == families_.end() || !it->second.users)
+            return;
+
+        --it->second.users;
+        if (drop && name != rocksdb::kDefaultColumnFamilyName)
+        {
+            db_->DropColumnFamily(it->second.handle);
+            db_->DestroyColumnFamilyHandle(it->second.handle);
+            families_.erase(it);
+        }
+    }
+
+private:
+    struct Family
+    {
+        rocksdb::ColumnFamilyHandle* handle = nullptr;
+        int users = 0;
+    };
+
+    std::string const path_;
+    std::mutex mutex_;
+    std::unique_ptr<rocksdb::DB> db_;
+    std::shared_ptr<rocksdb::Cache> blockCache_;
+    std::map<std::string, Family> families_;
+};
+
+//------------------------------------------------------------------------------
+
 class RocksDBBackend : public Backend, public BatchWriter::Callback
 {
 private:
@@ -91,7 +230,12 @@ public:
     Scheduler& m_scheduler;
     BatchWriter m_batch;
     std::string m_name;
-    std::unique_ptr<rocksdb::DB> m_db;
+    // Either owned by the backend or by the shared instance
+    rocksdb::DB* m_db = nullptr;
+    std::unique_ptr<rocksdb::DB> m_ownedDb;
+    std::shared_ptr<RocksDBShared> m_shared;
+    std::string m_family = rocksdb::kDefaultColumnFamilyName;
+    rocksdb::ColumnFamilyHandle* m_cf = nullptr;
     int fdRequired_ = 2048;
     rocksdb::Options m_options;
     rocksdb::BlockBasedTableOptions m_table_options;
@@ -111,6 +255,12 @@ public:
         if (!get_if_exists(keyValues, "path", m_name))
             Throw<std::runtime_error>("Missing path in RocksDBFactory backend");
 
+        if (get<int>(keyValues, "shared") != 0)
+        {
+            m_shared = RocksDBShared::get(m_name);
+            get_if_exists(keyValues, "column_family", m_family);
+        }
+
         rocksdb::BlockBasedTableOptions& table_options = m_table_options;
         m_options.env = env;
 
@@ -118,6 +268,16 @@ public:
             table_options.block_cache = rocksdb::NewLRUCache(
                 get<int>(keyValues, "cache_mb") * megabytes(1));
 
+        if (m_shared)
+            table_options.block_cache =
+                m_shared->blockCache(table_options.block_cache);
+
+        // Limits the disk bandwidth flushes and compactions may use, so
+        // they don't starve the reads of the node store.
+        if (auto const mb = get<int>(keyValues, "compaction_rate_mb"))
+            m_options.rate_limiter.reset(
+                rocksdb::NewGenericRateLimiter(mb * megabytes(1)));
+
         if (auto const v = get<int>(keyValues, "filter_bits"))
         {
             bool const filter_blocks = !keyValues.exists("filter_full") ||
@@ -214,9 +374,9 @@ public:
         std::cout << "block_cache usage: "
                   << m_table_options.block_cache->GetUsage()<<std::endl;
         std::string out;
-        m_db->GetProperty("rocksdb.estimate-table-readers-mem", &out);
+        m_db->GetProperty(m_cf, "rocksdb.estimate-table-readers-mem", &out);
         std::cout << "index and filter usage: " << out << std::endl;
-        m_db->GetProperty("rocksdb.cur-size-all-mem-tables", &out);
+        m_db->GetProperty(m_cf, "rocksdb.cur-size-all-mem-tables", &out);
         std::cout << "memtable usage: " << out << std::endl;
         std::cout << "pinned_usage: "
                   << m_table_options.block_cache->GetPinnedUsage() << std::endl;
@@ -231,33 +391,53 @@ public:
             JLOG(m_journal.error()) << "database is already open";
             return;
         }
-        rocksdb::DB* db = nullptr;
         m_options.create_if_missing = createIfMissing;
+
+        if (m_shared)
+        {
+            m_db = m_shared->open(m_options, m_family, &m_cf);
+            return;
+        }
+
+        rocksdb::DB* db = nullptr;
         rocksdb::Status status = rocksdb::DB::Open(m_options, m_name, &db);
         if (!status.ok() || !db)
             Throw<std::runtime_error>(
                 std::string("Unable to open/create RocksDB: ") +
                 status.ToString());
-        m_db.reset(db);
+        m_ownedDb.reset(db);
+        m_db = db;
+        m_cf = m_db->DefaultColumnFamily();
     }
 
     void
     close() override
     {
-        if (m_db)
+        if (!m_db)
+            return;
+
+        m_db = nullptr;
+        m_cf = nullptr;
+        if (m_shared)
         {
-            m_db.reset();
-            if (m_deletePath)
-            {
-                boost::filesystem::path dir = m_name;
-                boost::filesystem::remove_all(dir);
-            }
+            // The DB itself closes with the last backend using it
+            m_shared->close(m_family, m_deletePath);
+            return;
+        }
+
+        m_ownedDb.reset();
+        if (m_deletePath)
+        {
+            boost::filesystem::path dir = m_name;
+            boost::filesystem::remove_all(dir);
         }
     }
 
     std::string
     getName() override
     {
+        if (m_shared)
+            return m_name + ":" + m_family;
         return m_name;
     }
 
@@ -276,7 +456,7 @@ public:
 
         std::string string;
 
-        rocksdb::Status getStatus = m_db->Get(options, slice, &string);
+        rocksdb::Status getStatus = m_db->Get(options, m_cf, slice, &string);
 
         if (getStatus.ok())
         {
@@ -317,14 +497,47 @@ public:
     bool
     canFetchBatch() override
     {
-        return false;
+        return true;
     }
 
     std::vector<std::shared_ptr<NodeObject>>
     fetchBatch(std::size_t n, void const* const* keys) override
     {
-        Throw<std::runtime_error>("pure virtual called");
-        return {};
+        assert(m_db);
+
+        // One MultiGet lets RocksDB look up the keys of a block together
+        // and read the blocks in parallel.
+        std::vector<rocksdb::Slice> slices;
+        slices.reserve(n);
+        for (std::size_t i = 0; i < n; ++i)
+            slices.emplace_back(static_cast<char const*>(keys[i]), m_keyBytes);
+
+        std::vector<std::string> values;
+        auto const statuses = m_db->MultiGet(
+            rocksdb::ReadOptions{},
+            std::vector<rocksdb::ColumnFamilyHandle*>(n, m_cf),
+            slices,
+            &values);
+
+        std::vector<std::shared_ptr<NodeObject>> objects(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (statuses[i].ok())
+            {
+                DecodedBlob decoded(keys[i], values[i].data(), values[i].size());
+
+                if (decoded.wasOk())
+                    objects[i] = decoded.createObject();
+                else
+                    JLOG(m_journal.fatal()) << "Corrupt NodeObject #"
+                                            << uint256::fromVoid(keys[i]);
+            }
+            else if (!statuses[i].IsNotFound())
+            {
+                JLOG(m_journal.error()) << statuses[i].ToString();
+            }
+        }
+        return objects;
     }
 
     void
@@ -346,6 +559,7 @@ public:
             encoded.prepare(e);
 
             wb.Put(
+                m_cf,
                 rocksdb::Slice(
                     reinterpret_cast<char const*>(encoded.getKey()),
                     m_keyBytes),
@@ -368,7 +582,8 @@ public:
         assert(m_db);
         rocksdb::ReadOptions const options;
 
-        std::unique_ptr<rocksdb::Iterator> it(m_db->NewIterator(options));
+        std::unique_ptr<rocksdb::Iterator> it(
+            m_db->NewIterator(options, m_cf));
 
         for (it->SeekToFirst(); it->Valid(); it->Next())
         {
@@ -42,6 +42,14 @@ Database::Database(
     if (earliestLedgerSeq_ < 1)
         Throw<std::runtime_error>("Invalid earliest_seq");
 
+    if (auto const path = get<std::string>(config, "trace"); !path.empty())
+    {
+        trace_ = std::make_unique<std::ofstream>(path, std::ios::app);
+        if (!*trace_)
+            Throw<std::runtime_error>("Unable to open node store trace " + path);
+        JLOG(j_.warn()) << "Recording node store accesses to " << path;
+    }
+
     while (readThreads-- > 0)
         readThreads_.emplace_back(&Database::threadEntry, this);
 }
@@ -154,6 +162,46 @@ Database::fetchInternal(uint256 const& hash, std::shared_ptr<Backend> backend)
     return nObj;
 }
 
+std::vector<std::shared_ptr<NodeObject>>
+Database::fetchBatchInternal(
+    std::vector<uint256> const& hashes,
+    std::shared_ptr<Backend> backend)
+{
+    std::vector<std::shared_ptr<NodeObject>> objects;
+    if (!backend->canFetchBatch())
+    {
+        objects.reserve(hashes.size());
+        for (auto const& hash : hashes)
+            objects.push_back(fetchInternal(hash, backend));
+        return objects;
+    }
+
+    std::vector<void const*> keys;
+    keys.reserve(hashes.size());
+    for (auto const& hash : hashes)
+        keys.push_back(hash.begin());
+
+    try
+    {
+        objects = backend->fetchBatch(keys.size(), keys.data());
+    }
+    catch (std::exception const& e)
+    {
+        JLOG(j_.fatal()) << "Exception, " << e.what();
+        Rethrow();
+    }
+
+    for (auto const& nObj : objects)
+    {
+        if (nObj)
+        {
+            ++fetchHitCount_;
+            fetchSz_ += nObj->getData().size();
+        }
+    }
+    return objects;
+}
+
 void
 Database::importInternal(Backend& dstBackend, Database& srcDB)
 {
@@ -179,7 +227,6 @@ Database::importInternal(Backend& dstBackend, Database& srcDB)
         dstBackend.storeBatch(b);
 }
 
-// Perform a fetch and report the time it took
 std::shared_ptr<NodeObject>
 Database::doFetch(
     uint256 const& hash,
@@ -187,6 +234,21 @@ Database::doFetch(
     TaggedCache<uint256, NodeObject>& pCache,
     KeyCache<uint256>& nCache,
     bool isAsync)
+{
+    // The read threads only prefetch, the caller's fetch is traced
+    if (trace_ && !isAsync)
+        traceFetch("fetch", &hash, 1, seq);
+    return fetchCached(hash, seq, pCache, nCache, isAsync);
+}
+
+// Perform a fetch and report the time it took
+std::shared_ptr<NodeObject>
+Database::fetchCached(
+    uint256 const& hash,
+    std::uint32_t seq,
+    TaggedCache<uint256, NodeObject>& pCache,
+    KeyCache<uint256>& nCache,
+    bool isAsync)
 {
     FetchReport report;
     report.isAsync = isAsync;
@@ -226,6 +288,102 @@ Database::doFetch(
     return nObj;
 }
 
+std::vector<std::shared_ptr<NodeObject>>
+Database::fetchBatch(std::vector<uint256> const& hashes, std::uint32_t seq)
+{
+    std::vector<std::shared_ptr<NodeObject>> objects;
+    objects.reserve(hashes.size());
+    for (auto const& hash : hashes)
+        objects.push_back(fetch(hash, seq));
+    return objects;
+}
+
+std::vector<std::shared_ptr<NodeObject>>
+Database::fetchBatchFrom(std::vector<uint256> const& hashes, std::uint32_t seq)
+{
+    std::vector<std::shared_ptr<NodeObject>> objects;
+    objects.reserve(hashes.size());
+    for (auto const& hash : hashes)
+        objects.push_back(fetchFrom(hash, seq));
+    return objects;
+}
+
+std::vector<std::shared_ptr<NodeObject>>
+Database::doFetchBatch(
+    std::vector<uint256> const& hashes,
+    std::uint32_t seq,
+    std::shared_ptr<TaggedCache<uint256, NodeObject>> const& pCache,
+    std::shared_ptr<KeyCache<uint256>> const& nCache,
+    bool parallel)
+{
+    if (trace_)
+        traceFetch("batch", hashes.data(), hashes.size(), seq);
+
+    std::vector<std::shared_ptr<NodeObject>> objects(hashes.size());
+
+    // Only the objects that aren't cached go to the backend
+    std::vector<uint256> missing;
+    std::vector<std::size_t> missingIndex;
+    for (std::size_t i = 0; i < hashes.size(); ++i)
+    {
+        objects[i] = pCache->fetch(hashes[i]);
+        if (!objects[i] && !nCache->touch_if_exists(hashes[i]))
+        {
+            missing.push_back(hashes[i]);
+            missingIndex.push_back(i);
+        }
+    }
+    if (missing.empty())
+        return objects;
+
+    if (parallel && missing.size() > 1 && !readThreads_.empty())
+    {
+        // The read threads load the rest while this one reads in order,
+        // by the time it gets there most are in the cache.
+        for (std::size_t i = 1; i < missing.size(); ++i)
+            asyncFetch(missing[i], seq, pCache, nCache);
+        for (std::size_t i = 0; i < missing.size(); ++i)
+            objects[missingIndex[i]] =
+                fetchCached(missing[i], seq, *pCache, *nCache, false);
+        return objects;
+    }
+
+    FetchReport report;
+    report.isAsync = false;
+    report.wentToDisk = true;
+    report.wasFound = false;
+
+    using namespace std::chrono;
+    auto const before = steady_clock::now();
+
+    auto fetched = fetchBatchFrom(missing, seq);
+    fetchTotalCount_ += missing.size();
+    for (std::size_t i = 0; i < missing.size(); ++i)
+    {
+        auto& nObj = fetched[i];
+        if (!nObj)
+        {
+            // Just in case a write occurred
+            nObj = pCache->fetch(missing[i]);
+            if (!nObj)
+                nCache->insert(missing[i]);
+        }
+        else
+        {
+            // Ensure all threads get the same object
+            pCache->canonicalize_replace_client(missing[i], nObj);
+        }
+
+        if (nObj)
+            report.wasFound = true;
+        objects[missingIndex[i]] = std::move(nObj);
+    }
+
+    report.elapsed = duration_cast<milliseconds>(steady_clock::now() - before);
+    scheduler_.onFetch(report);
+    return objects;
+}
+
 bool
 Database::storeLedger(
     Ledger const& srcLedger,
@@ -259,7 +417,7 @@ Database::storeLedger(
             {
                 dstPCache->canonicalize_replace_cache(nObj->getHash(), nObj);
                 dstNCache->erase(nObj->getHash());
-                storeStats(nObj->getData().size());
+                storeStats(*nObj, srcLedger.info().seq);
             }
         }
         dstBackend->storeBatch(batch);
@@ -336,6 +494,31 @@ Database::storeLedger(
 }
 
 // Entry point for async read threads
+void
+Database::traceStore(NodeObject const& nObj, std::uint32_t seq)
+{
+    std::lock_guard lock(traceMutex_);
+    *trace_ << "store " << seq << ' ' << nObj.getHash() << ' '
+            << nObj.getData().size() << ' '
+            << static_cast<int>(nObj.getType()) << '\n';
+}
+
+void
+Database::traceFetch(
+    char const* kind,
+    uint256 const* hashes,
+    std::size_t count,
+    std::uint32_t seq)
+{
+    if (count == 0)
+        return;
+    std::lock_guard lock(traceMutex_);
+    *trace_ << kind << ' ' << seq;
+    for (std::size_t i = 0; i < count; ++i)
+        *trace_ << ' ' << hashes[i];
+    *trace_ << '\n';
+}
+
 void
 Database::threadEntry()
 {
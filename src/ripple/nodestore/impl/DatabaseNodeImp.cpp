@@ -35,7 +35,7 @@ DatabaseNodeImp::store(
     pCache_->canonicalize_replace_cache(hash, nObj);
     backend_->store(nObj);
     nCache_->erase(hash);
-    storeStats(nObj->getData().size());
+    storeStats(*nObj, seq);
 }
 
 bool
@@ -97,6 +97,13 @@ public:
         return doFetch(hash, seq, *pCache_, *nCache_, false);
     }
 
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatch(std::vector<uint256> const& hashes, std::uint32_t seq) override
+    {
+        return doFetchBatch(
+            hashes, seq, pCache_, nCache_, !backend_->canFetchBatch());
+    }
+
     bool
     asyncFetch(
         uint256 const& hash,
@@ -147,6 +154,13 @@ private:
         return fetchInternal(hash, backend_);
     }
 
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatchFrom(std::vector<uint256> const& hashes, std::uint32_t seq)
+        override
+    {
+        return fetchBatchInternal(hashes, backend_);
+    }
+
     void
     for_each(std::function<void(std::shared_ptr<NodeObject>)> f) override
     {
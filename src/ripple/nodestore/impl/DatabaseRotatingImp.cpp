@@ -122,7 +122,7 @@ DatabaseRotatingImp::store(
     backend->store(nObj);
 
     nCache_->erase(hash);
-    storeStats(nObj->getData().size());
+    storeStats(*nObj, seq);
 }
 
 bool
@@ -141,6 +141,19 @@ DatabaseRotatingImp::asyncFetch(
     return false;
 }
 
+std::vector<std::shared_ptr<NodeObject>>
+DatabaseRotatingImp::fetchBatch(
+    std::vector<uint256> const& hashes,
+    std::uint32_t seq)
+{
+    bool const canFetchBatch = [&] {
+        std::lock_guard lock(mutex_);
+        return writableBackend_->canFetchBatch() &&
+            archiveBackend_->canFetchBatch();
+    }();
+    return doFetchBatch(hashes, seq, pCache_, nCache_, !canFetchBatch);
+}
+
 void
 DatabaseRotatingImp::tune(int size, std::chrono::seconds age)
 {
@@ -187,6 +200,52 @@ DatabaseRotatingImp::fetchFrom(uint256 const& hash, std::uint32_t seq)
     return nObj;
 }
 
+std::vector<std::shared_ptr<NodeObject>>
+DatabaseRotatingImp::fetchBatchFrom(
+    std::vector<uint256> const& hashes,
+    std::uint32_t seq)
+{
+    auto [writable, archive] = [&] {
+        std::lock_guard lock(mutex_);
+        return std::make_pair(writableBackend_, archiveBackend_);
+    }();
+
+    // Try to fetch from the writable backend
+    auto objects = fetchBatchInternal(hashes, writable);
+
+    // Otherwise try to fetch from the archive backend
+    std::vector<uint256> missing;
+    std::vector<std::size_t> missingIndex;
+    for (std::size_t i = 0; i < objects.size(); ++i)
+    {
+        if (!objects[i])
+        {
+            missing.push_back(hashes[i]);
+            missingIndex.push_back(i);
+        }
+    }
+    if (missing.empty())
+        return objects;
+
+    auto archived = fetchBatchInternal(missing, archive);
+    {
+        // Refresh the writable backend pointer
+        std::lock_guard lock(mutex_);
+        writable = writableBackend_;
+    }
+    for (std::size_t i = 0; i < archived.size(); ++i)
+    {
+        if (auto& nObj = archived[i])
+        {
+            // Update writable backend with data from the archive backend
+            writable->store(nObj);
+            nCache_->erase(missing[i]);
+            objects[missingIndex[i]] = std::move(nObj);
+        }
+    }
+    return objects;
+}
+
 void
 DatabaseRotatingImp::for_each(
     std::function<void(std::shared_ptr<NodeObject>)> f)
@@ -76,6 +76,10 @@ public:
         return doFetch(hash, seq, *pCache_, *nCache_, false);
     }
 
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatch(std::vector<uint256> const& hashes, std::uint32_t seq)
+        override;
+
     bool
     asyncFetch(
         uint256 const& hash,
@@ -126,6 +130,10 @@ private:
     std::shared_ptr<NodeObject>
     fetchFrom(uint256 const& hash, std::uint32_t seq) override;
 
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatchFrom(std::vector<uint256> const& hashes, std::uint32_t seq)
+        override;
+
     void
     for_each(std::function<void(std::shared_ptr<NodeObject>)> f) override;
 };
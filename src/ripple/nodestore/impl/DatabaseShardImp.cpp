@@ -896,7 +896,7 @@ DatabaseShardImp::store(
     backend->store(nObj);
     nCache->erase(hash);
 
-    storeStats(nObj->getData().size());
+    storeStats(*nObj, seq);
 }
 
 std::shared_ptr<NodeObject>
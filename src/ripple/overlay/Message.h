@@ -20,7 +20,9 @@
 #ifndef RIPPLE_OVERLAY_MESSAGE_H_INCLUDED
 #define RIPPLE_OVERLAY_MESSAGE_H_INCLUDED
 
+#include <ripple/basics/ByteUtilities.h>
 #include <ripple/overlay/Compression.h>
+#include <ripple/overlay/TxDictionary.h>
 #include <ripple/protocol/messages.h>
 #include <boost/asio/buffer.hpp>
 #include <boost/asio/buffers_iterator.hpp>
@@ -33,6 +35,9 @@
 
 namespace ripple {
 
+/** Largest protocol message, compressed or not, that is accepted. */
+constexpr std::size_t maximumMessageSize = megabytes(64);
+
 // VFALCO NOTE If we forward declare Message and write out shared_ptr
 //             instead of using the in-class type alias, we can remove the
 //             entire ripple.pb.h from the main headers.
@@ -63,10 +68,14 @@ public:
      * the message is not compressible then the uncompressed buffer is returned.
      * @param compressed Request compressed (Compress::On) or
      *     uncompressed (Compress::Off) payload buffer
+     * @param compactTx Request the transactions the message carries in the
+     *     compact encoding (CompactTx::On) if it makes the message smaller
      * @return Payload buffer
      */
     std::vector<uint8_t> const&
-    getBuffer(Compressed tryCompressed);
+    getBuffer(
+        Compressed tryCompressed,
+        CompactTx compactTx = CompactTx::Off);
 
     /** Get the traffic category */
     std::size_t
@@ -78,8 +87,14 @@ public:
 private:
     std::vector<uint8_t> buffer_;
     std::vector<uint8_t> bufferCompressed_;
+    std::vector<uint8_t> bufferCompact_;
+    std::vector<uint8_t> bufferCompactCompressed_;
     std::size_t category_;
+    // Carries transactions that may be encoded compactly
+    bool compactable_ = false;
     std::once_flag once_flag_;
+    std::once_flag compactOnceFlag_;
+    std::once_flag compactCompressOnceFlag_;
 
     /** Set the payload header
      * @param in Pointer to the payload
@@ -100,9 +115,21 @@ private:
     /** Try to compress the payload.
      * Can be called concurrently by multiple peers but is compressed once.
      * If the message is not compressible then the serialized buffer_ is used.
+     * @param buffer Packed message to compress
+     * @param compressed Set to the compressed message, left empty if the
+     *   message is not compressible
+     */
+    void
+    compress(
+        std::vector<uint8_t> const& buffer,
+        std::vector<uint8_t>& compressed);
+
+    /** Try to encode the transactions the message carries compactly.
+     * Called once, bufferCompact_ is left empty if the message carries no
+     * transactions or it doesn't pay.
      */
     void
-    compress();
+    compact();
 
     /** Get the message type from the payload header.
      * First four bytes are the compression/algorithm flag and the payload size.
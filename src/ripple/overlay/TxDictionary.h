@@ -0,0 +1,95 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_OVERLAY_TXDICTIONARY_H_INCLUDED
+#define RIPPLE_OVERLAY_TXDICTIONARY_H_INCLUDED
+
+#include <ripple/basics/Blob.h>
+#include <ripple/basics/Slice.h>
+#include <ripple/basics/UnorderedContainers.h>
+#include <ripple/protocol/messages.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ripple {
+
+/** Whether a peer takes transactions in the compact encoding.
+    Negotiated at handshake with the X-Offer-Compact-Tx header.
+*/
+enum class CompactTx : std::uint8_t { On, Off };
+
+/** Compact encoding of the serialized transactions of one message.
+
+    Table transactions repeat the same few values: the account and owner,
+    table names and their names in the database. Each such field is written
+    in full the first time it appears in a message and as an index into the
+    values seen so far after that. Every other field is copied as it is, so
+    decoding gives back the exact bytes that were signed.
+
+    The dictionary lives as long as one message: Message objects are shared
+    by every peer they are sent to, and a message can be dropped or reordered
+    against others relayed on its behalf.
+*/
+class TxDictionaryEncoder
+{
+public:
+    Blob
+    encode(Slice const& tx);
+
+private:
+    hash_map<std::string, std::uint32_t> entries_;
+};
+
+class TxDictionaryDecoder
+{
+public:
+    /** Throws if the data is not a valid encoding, or if the transactions
+        decoded so far would add up to more than the largest message.
+    */
+    Blob
+    decode(Slice const& data);
+
+private:
+    std::vector<Blob> entries_;
+    // Bytes of the transactions decoded so far
+    std::size_t decoded_ = 0;
+};
+
+/** Encode the transactions a message carries.
+    @return false if the message has none to encode
+*/
+bool
+compactTxs(protocol::TMTransactions& m);
+
+bool
+compactTxs(protocol::TMLedgerData& m);
+
+/** Decode the transactions of a message taken in the compact encoding.
+    @return false if the encoding is invalid
+*/
+bool
+expandTxs(protocol::TMTransactions& m);
+
+bool
+expandTxs(protocol::TMLedgerData& m);
+
+}  // namespace ripple
+
+#endif
@@ -205,7 +205,9 @@ ConnectAttempt::onHandshake(error_code ec)
         return close();  // makeSharedValue logs
 
     req_ = makeRequest(
-        !overlay_.peerFinder().config().peerPrivate, app_.config().COMPRESSION);
+        !overlay_.peerFinder().config().peerPrivate,
+        app_.config().COMPRESSION,
+        app_.config().COMPACT_TX);
 
     buildHandshake(
         req_,
@@ -285,7 +287,10 @@ ConnectAttempt::onShutdown(error_code ec)
 //--------------------------------------------------------------------------
 
 auto
-ConnectAttempt::makeRequest(bool crawl, bool compressionEnabled) -> request_type
+ConnectAttempt::makeRequest(
+    bool crawl,
+    bool compressionEnabled,
+    bool compactTxEnabled) -> request_type
 {
     request_type m;
     m.method(boost::beast::http::verb::get);
@@ -298,6 +303,8 @@ ConnectAttempt::makeRequest(bool crawl, bool compressionEnabled) -> request_type
     m.insert("Crawl", crawl ? "public" : "private");
     if (compressionEnabled)
         m.insert("X-Offer-Compression", "lz4");
+    if (compactTxEnabled)
+        m.insert("X-Offer-Compact-Tx", "dict");
     return m;
 }
 
@@ -42,15 +42,24 @@ Message::Message(::google::protobuf::Message const& message, int type)
 
     if (messageBytes != 0)
         message.SerializeToArray(buffer_.data() + headerBytes, messageBytes);
+
+    // Only candidate tx sets among the ledger data replies carry
+    // transactions, tell them apart here rather than parsing every reply
+    if (type == protocol::mtTRANSACTIONS)
+        compactable_ = true;
+    else if (auto msg = dynamic_cast<protocol::TMLedgerData const*>(&message))
+        compactable_ = msg->type() == protocol::liTS_CANDIDATE;
 }
 
 void
-Message::compress()
+Message::compress(
+    std::vector<uint8_t> const& buffer,
+    std::vector<uint8_t>& compressed)
 {
     using namespace ripple::compression;
-    auto const messageBytes = buffer_.size() - headerBytes;
+    auto const messageBytes = buffer.size() - headerBytes;
 
-    auto type = getType(buffer_.data());
+    auto type = getType(buffer.data());
 
     bool const compressible = [&] {
         if (messageBytes <= 70)
@@ -67,6 +76,10 @@ Message::compress()
             case protocol::mtSYNC_SCHEMA:
             case protocol::mtCONSENSUS:
             case protocol::mtTRANSACTIONS:
+            case protocol::mtTABLE_RANGE:
+            case protocol::mtSTATE_LEAVES:
+            case protocol::mtGET_TX_SET_IDS:
+            case protocol::mtTX_SET_IDS:
                 return true;
             case protocol::mtPING:
             case protocol::mtCLUSTER:
@@ -83,29 +96,78 @@ Message::compress()
 
     if (compressible)
     {
-        auto payload = static_cast<void const*>(buffer_.data() + headerBytes);
+        auto payload = static_cast<void const*>(buffer.data() + headerBytes);
 
         auto compressedSize = ripple::compression::compress(
             payload,
             messageBytes,
             [&](std::size_t inSize) {  // size of required compressed buffer
-                bufferCompressed_.resize(inSize + headerBytesCompressed);
-                return (bufferCompressed_.data() + headerBytesCompressed);
+                compressed.resize(inSize + headerBytesCompressed);
+                return (compressed.data() + headerBytesCompressed);
             });
 
         if (compressedSize <
             (messageBytes - (headerBytesCompressed - headerBytes)))
         {
-            bufferCompressed_.resize(headerBytesCompressed + compressedSize);
+            compressed.resize(headerBytesCompressed + compressedSize);
             setHeader(
-                bufferCompressed_.data(),
+                compressed.data(),
                 compressedSize,
                 type,
                 Algorithm::LZ4,
                 messageBytes);
         }
         else
-            bufferCompressed_.resize(0);
+            compressed.resize(0);
+    }
+}
+
+void
+Message::compact()
+{
+    using namespace ripple::compression;
+    if (!compactable_)
+        return;
+
+    auto const payload = buffer_.data() + headerBytes;
+    auto const messageBytes = buffer_.size() - headerBytes;
+    auto const type = getType(buffer_.data());
+
+    auto encode = [&](auto& message) {
+        if (!message.ParseFromArray(payload, messageBytes) ||
+            !compactTxs(message))
+            return;
+
+#if defined(GOOGLE_PROTOBUF_VERSION) && (GOOGLE_PROTOBUF_VERSION >= 3011000)
+        auto const compactBytes = message.ByteSizeLong();
+#else
+        unsigned const compactBytes = message.ByteSize();
+#endif
+
+        if (compactBytes >= messageBytes)
+            return;
+
+        bufferCompact_.resize(headerBytes + compactBytes);
+        setHeader(
+            bufferCompact_.data(), compactBytes, type, Algorithm::None, 0);
+        message.SerializeToArray(
+            bufferCompact_.data() + headerBytes, compactBytes);
+    };
+
+    switch (type)
+    {
+        case protocol::mtTRANSACTIONS: {
+            protocol::TMTransactions message;
+            encode(message);
+            break;
+        }
+        case protocol::mtLEDGER_DATA: {
+            protocol::TMLedgerData message;
+            encode(message);
+            break;
+        }
+        default:
+            break;
     }
 }
 
@@ -175,12 +237,33 @@ Message::setHeader(
 }
 
 std::vector<uint8_t> const&
-Message::getBuffer(Compressed tryCompressed)
+Message::getBuffer(Compressed tryCompressed, CompactTx compactTx)
 {
+    if (compactTx == CompactTx::On)
+    {
+        std::call_once(compactOnceFlag_, &Message::compact, this);
+
+        if (bufferCompact_.size() > 0)
+        {
+            if (tryCompressed == Compressed::Off)
+                return bufferCompact_;
+
+            std::call_once(compactCompressOnceFlag_, [this] {
+                compress(bufferCompact_, bufferCompactCompressed_);
+            });
+
+            if (bufferCompactCompressed_.size() > 0)
+                return bufferCompactCompressed_;
+            else
+                return bufferCompact_;
+        }
+    }
+
     if (tryCompressed == Compressed::Off)
         return buffer_;
 
-    std::call_once(once_flag_, &Message::compress, this);
+    std::call_once(
+        once_flag_, [this] { compress(buffer_, bufferCompressed_); });
 
     if (bufferCompressed_.size() > 0)
         return bufferCompressed_;
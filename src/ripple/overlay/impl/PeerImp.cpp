@@ -36,9 +36,11 @@
 #include <ripple/beast/core/SemanticVersion.h>
 #include <ripple/nodestore/DatabaseShard.h>
 #include <ripple/overlay/Cluster.h>
+#include <ripple/overlay/TxDictionary.h>
 #include <ripple/overlay/impl/PeerImp.h>
 #include <ripple/overlay/impl/Tuning.h>
 #include <ripple/overlay/predicates.h>
+#include <ripple/protocol/STTxView.h>
 #include <ripple/protocol/digest.h>
 #include <boost/algorithm/clamp.hpp>
 #include <boost/algorithm/string.hpp>
@@ -99,6 +101,10 @@ PeerImp::PeerImp(
     , compressionEnabled_(
           headers_["X-Offer-Compression"] == "lz4" ? Compressed::On
                                                    : Compressed::Off)
+    , compactTxEnabled_(
+          headers_["X-Offer-Compact-Tx"] == "dict" && app_.config().COMPACT_TX
+              ? CompactTx::On
+              : CompactTx::Off)
 {
 }
 
@@ -294,7 +300,8 @@ PeerImp::send(std::shared_ptr<Message> const& m)
     overlay_.reportTraffic(
         safe_cast<TrafficCount::category>(m->getCategory()),
         false,
-        static_cast<int>(m->getBuffer(compressionEnabled_).size()));
+        static_cast<int>(
+            m->getBuffer(compressionEnabled_, compactTxEnabled_).size()));
 
     auto sendq_size = send_queue_.size();
 
@@ -322,8 +329,8 @@ PeerImp::send(std::shared_ptr<Message> const& m)
 
     boost::asio::async_write(
         stream_,
-        boost::asio::buffer(
-            send_queue_.front()->getBuffer(compressionEnabled_)),
+        boost::asio::buffer(send_queue_.front()->getBuffer(
+            compressionEnabled_, compactTxEnabled_)),
         bind_executor(
             strand_,
             std::bind(
@@ -958,6 +965,8 @@ PeerImp::makeResponse(
     resp.insert("Crawl", crawl ? "public" : "private");
     if (req["X-Offer-Compression"] == "lz4" && app_.config().COMPRESSION)
         resp.insert("X-Offer-Compression", "lz4");
+    if (req["X-Offer-Compact-Tx"] == "dict" && app_.config().COMPACT_TX)
+        resp.insert("X-Offer-Compact-Tx", "dict");
 
     buildHandshake(
         resp,
@@ -1151,8 +1160,8 @@ PeerImp::onWriteMessage(error_code ec, std::size_t bytes_transferred)
         // Timeout on writes only
         return boost::asio::async_write(
             stream_,
-            boost::asio::buffer(
-                send_queue_.front()->getBuffer(compressionEnabled_)),
+            boost::asio::buffer(send_queue_.front()->getBuffer(
+                compressionEnabled_, compactTxEnabled_)),
             bind_executor(
                 strand_,
                 std::bind(
@@ -1673,13 +1682,23 @@ PeerImp::onMessage(std::shared_ptr<protocol::TMTransaction> const& m)
         return;
     }
 
-    //SerialIter sit(makeSlice(m->rawtransaction()));
-
     try
     {
-        //auto stx = std::make_shared<STTx const>(sit);
-        auto stx = makeSTTx(makeSlice(m->rawtransaction()));
-        uint256 txID = stx->getTransactionID();
+        // Most txs relayed to us are ones we have seen, tell from the hash
+        // of their bytes before paying to parse them
+        auto const raw = makeSlice(m->rawtransaction());
+        std::shared_ptr<STTx const> stx;
+        uint256 txID;
+        if (STTxView::canView(raw))
+        {
+            txID = STTxView(raw).getTransactionID();
+        }
+        else
+        {
+            stx = makeSTTx(raw);
+            txID = stx->getTransactionID();
+        }
+
         if (app_.getTxPool(schemaId).txExists(txID))
         {
             return;
@@ -1700,6 +1719,22 @@ PeerImp::onMessage(std::shared_ptr<protocol::TMTransaction> const& m)
             return;
         }
 
+        if (!stx)
+        {
+            stx = makeSTTx(raw);
+
+            // The view hashes the bytes as sent. They only hash to another id
+            // than the parsed tx if they are not canonical, and such a tx
+            // must not get past the checks above under an id of its own.
+            if (stx->getTransactionID() != txID)
+            {
+                JLOG(p_journal_.warn())
+                    << "Transaction not canonically encoded " << txID;
+                fee_ = Resource::feeInvalidRequest;
+                return;
+            }
+        }
+
         JLOG(p_journal_.debug()) << "Got tx " << txID;
 
         bool checkSignature = true;
@@ -1745,7 +1780,7 @@ PeerImp::onMessage(std::shared_ptr<protocol::TMTransaction> const& m)
                     if (auto peer = weak.lock())
                         peer->checkTransaction(
                             schemaId, flags, checkSignature, stx);
-                });
+                }, app_.getSchema(schemaId).doJobCounter());
         }
     }
     catch (std::exception const&)
@@ -1769,15 +1804,39 @@ PeerImp::onMessage(std::shared_ptr<protocol::TMTransactions> const& m)
         return;
     }
 
+    if (!expandTxs(*m))
+    {
+        JLOG(p_journal_.warn()) << "TMTransactions invalid compact txs";
+        fee_ = Resource::feeInvalidRequest;
+        return;
+    }
+
     try
     {
 	    JLOG(p_journal_.info()) << "Got txs: " << m->transactions().size();
         for (int i = 0; i < m->transactions().size(); ++i)
         {
-            //SerialIter sit(makeSlice(m->transactions(i).rawtransaction()));
-            //auto stx = std::make_shared<STTx const>(sit);
-            auto stx = makeSTTx(makeSlice(m->transactions(i).rawtransaction()));
+            auto const raw = makeSlice(m->transactions(i).rawtransaction());
+            boost::optional<uint256> viewID;
+            if (STTxView::canView(raw))
+            {
+                viewID = STTxView(raw).getTransactionID();
+                if (app_.getTxPool(schemaId).txExists(*viewID))
+                    return;
+            }
+
+            auto stx = makeSTTx(raw);
             uint256 txID = stx->getTransactionID();
+
+            // As for TMTransaction, bytes that are not canonical
+            if (viewID && *viewID != txID)
+            {
+                JLOG(p_journal_.warn())
+                    << "Transaction not canonically encoded " << *viewID;
+                fee_ = Resource::feeInvalidRequest;
+                return;
+            }
+
             if (app_.getTxPool(schemaId).txExists(txID))
             {
                 return;
@@ -1830,7 +1889,7 @@ PeerImp::onMessage(std::shared_ptr<protocol::TMTransactions> const& m)
                         if (auto peer = weak.lock())
                             peer->checkTransaction(
                                 schemaId, flags, checkSignature, stx);
-                    });
+                    }, app_.getSchema(schemaId).doJobCounter());
             }
         }
     }
@@ -1857,6 +1916,13 @@ PeerImp::onMessage(std::shared_ptr<protocol::TMLedgerData> const& m)
 {
     protocol::TMLedgerData& packet = *m;
 
+    if (!expandTxs(packet))
+    {
+        JLOG(p_journal_.warn()) << "Ledger/TXset data with invalid compact txs";
+        fee_ = Resource::feeInvalidRequest;
+        return;
+    }
+
     if (m->type() == protocol::liSKIP_NODE)
     {
         auto hash = m->ledgerhash();
@@ -1938,7 +2004,8 @@ PeerImp::onMessage(std::shared_ptr<protocol::TMLedgerData> const& m)
 void
 PeerImp::onMessage(std::shared_ptr<protocol::TMGetTable> const& m)
 {
-    fee_ = Resource::feeLightPeer;
+    // A bulk request is answered with every ledger of the range at once
+    fee_ = m->bulk() ? Resource::feeHighBurdenPeer : Resource::feeLightPeer;
     std::weak_ptr<PeerImp> weak = shared_from_this();
 
     auto tup = getSchemaInfo("TMGetTable:", m->schemaid());
@@ -1951,7 +2018,7 @@ PeerImp::onMessage(std::shared_ptr<protocol::TMGetTable> const& m)
     app_.getJobQueue().addJob(
         jtTABLE_REQ, "tableRequest", [pap, weak, m](Job&) {
             pap->getTableSync().SeekTableTxLedger(m, weak);
-        });
+        }, pap->doJobCounter());
 }
 
 void
@@ -1969,7 +2036,103 @@ PeerImp::onMessage(std::shared_ptr<protocol::TMTableData> const& m)
 
     app_.getJobQueue().addJob(jtTABLE_REQ, "tableData", [pap, weak, m](Job&) {
         pap->getTableSync().GotSyncReply(m, weak);
-    });
+    }, pap->doJobCounter());
+}
+
+void
+PeerImp::onMessage(std::shared_ptr<protocol::TMTableRange> const& m)
+{
+    fee_ = Resource::feeLightPeer;
+    std::weak_ptr<PeerImp> weak = shared_from_this();
+
+    auto tup = getSchemaInfo("TMTableRange:", m->schemaid());
+    if (!get<0>(tup))
+        return;
+    uint256 schemaId = get<1>(tup);
+
+    auto const pap = &app_.getSchema(schemaId);
+
+    app_.getJobQueue().addJob(jtTABLE_REQ, "tableRange", [pap, weak, m](Job&) {
+        if (!pap->getTableSync().GotSyncRange(m, weak))
+        {
+            if (auto peer = weak.lock())
+                peer->charge(Resource::feeInvalidRequest);
+        }
+    }, pap->doJobCounter());
+}
+
+void
+PeerImp::onMessage(std::shared_ptr<protocol::TMGetStateLeaves> const& m)
+{
+    // Answering walks up to Tuning::maxReplyLeaves leaves of a state map
+    fee_ = Resource::feeHighBurdenPeer;
+    std::weak_ptr<PeerImp> weak = shared_from_this();
+    app_.getJobQueue().addJob(
+        jtLEDGER_REQ, "recvGetStateLeaves", [weak, m](Job&) {
+            if (auto peer = weak.lock())
+                peer->getStateLeaves(m);
+        });
+}
+
+void
+PeerImp::onMessage(std::shared_ptr<protocol::TMStateLeaves> const& m)
+{
+    auto tup = getSchemaInfo("TMStateLeaves:", m->schemaid());
+    if (!get<0>(tup))
+        return;
+    uint256 schemaId = get<1>(tup);
+
+    if (!stringIsUint256Sized(m->ledgerhash()))
+    {
+        JLOG(p_journal_.warn()) << "State leaves with invalid hash size";
+        fee_ = Resource::feeInvalidRequest;
+        return;
+    }
+
+    uint256 const hash{m->ledgerhash()};
+    if (!app_.getInboundLedgers(schemaId).gotStateLeaves(
+            hash, shared_from_this(), m))
+    {
+        JLOG(p_journal_.trace()) << "Got state leaves for unwanted ledger";
+        fee_ = Resource::feeUnwantedData;
+    }
+}
+
+void
+PeerImp::onMessage(std::shared_ptr<protocol::TMGetTxSetIds> const& m)
+{
+    fee_ = Resource::feeLightPeer;
+    std::weak_ptr<PeerImp> weak = shared_from_this();
+    app_.getJobQueue().addJob(
+        jtTXN_DATA, "recvGetTxSetIds", [weak, m](Job&) {
+            if (auto peer = weak.lock())
+                peer->getTxSetIds(m);
+        });
+}
+
+void
+PeerImp::onMessage(std::shared_ptr<protocol::TMTxSetIds> const& m)
+{
+    auto tup = getSchemaInfo("TMTxSetIds:", m->schemaid());
+    if (!get<0>(tup))
+        return;
+    uint256 schemaId = get<1>(tup);
+
+    if (!stringIsUint256Sized(m->sethash()))
+    {
+        JLOG(p_journal_.warn()) << "Tx set ids with invalid hash size";
+        fee_ = Resource::feeInvalidRequest;
+        return;
+    }
+
+    uint256 const hash{m->sethash()};
+    std::weak_ptr<PeerImp> weak = shared_from_this();
+    app_.getJobQueue().addJob(
+        jtTXN_DATA, "recvTxSetIds", [weak, hash, m, schemaId](Job&) {
+            if (auto peer = weak.lock())
+                peer->app_.getInboundTransactions(schemaId).gotTxSetIds(
+                    hash, peer, m);
+        });
 }
 
 void
@@ -3410,6 +3573,208 @@ PeerImp::getLedger(std::shared_ptr<protocol::TMGetLedger> const& m)
     send(oPacket);
 }
 
+void
+PeerImp::getStateLeaves(std::shared_ptr<protocol::TMGetStateLeaves> const& m)
+{
+    protocol::TMGetStateLeaves& packet = *m;
+
+    auto tup = getSchemaInfo("TMGetStateLeaves:", packet.schemaid());
+    if (!get<0>(tup))
+        return;
+    uint256 schemaId = get<1>(tup);
+
+    if (!stringIsUint256Sized(packet.ledgerhash()) ||
+        !stringIsUint256Sized(packet.roothash()) ||
+        !stringIsUint256Sized(packet.last()) ||
+        (packet.has_after() && !stringIsUint256Sized(packet.after())))
+    {
+        charge(Resource::feeInvalidRequest);
+        JLOG(p_journal_.warn()) << "GetStateLeaves: Invalid request";
+        return;
+    }
+
+    if (send_queue_.size() >= Tuning::dropSendQueue)
+    {
+        JLOG(p_journal_.debug()) << "GetStateLeaves: Large send queue";
+        return;
+    }
+
+    if (app_.getFeeTrack(schemaId).isLoadedLocal() && !cluster())
+    {
+        JLOG(p_journal_.debug()) << "GetStateLeaves: Too busy";
+        return;
+    }
+
+    uint256 const ledgerHash{packet.ledgerhash()};
+    uint256 const rootHash{packet.roothash()};
+    uint256 const last{packet.last()};
+    boost::optional<uint256> after;
+    if (packet.has_after())
+        after = uint256{packet.after()};
+
+    protocol::TMStateLeaves reply;
+    reply.set_ledgerhash(packet.ledgerhash());
+    reply.set_roothash(packet.roothash());
+    if (after)
+        reply.set_after(packet.after());
+    reply.set_last(packet.last());
+    reply.set_schemaid(schemaId.begin(), uint256::size());
+    reply.set_complete(false);
+
+    auto const ledger =
+        app_.getLedgerMaster(schemaId).getLedgerByHash(ledgerHash);
+    std::shared_ptr<SHAMap> map;
+    if (ledger)
+    {
+        if (rootHash == ledger->info().accountHash)
+            map = ledger->stateMapPtr();
+        else
+            map = ledger->contractStorageMap(rootHash);
+    }
+
+    if (!map)
+    {
+        JLOG(p_journal_.debug())
+            << "GetStateLeaves: Don't have " << ledgerHash << " map "
+            << rootHash;
+        reply.set_error(protocol::reNO_LEDGER);
+        send(std::make_shared<Message>(reply, protocol::mtSTATE_LEAVES));
+        return;
+    }
+
+    std::size_t const maxLeaves = std::min<std::size_t>(
+        packet.has_maxleaves() ? packet.maxleaves() : Tuning::maxReplyLeaves,
+        Tuning::maxReplyLeaves);
+    std::size_t bytes = 0;
+    bool complete = true;
+
+    try
+    {
+        map->visitLeafNodes(after, [&](SHAMapTreeNode const& leaf) {
+            auto const& item = leaf.peekItem();
+            if (item->key() > last)
+                return false;
+
+            if (reply.leaves_size() >= maxLeaves ||
+                bytes >= Tuning::maxReplyLeavesByteSize)
+            {
+                complete = false;
+                return false;
+            }
+
+            auto const storageRoot = leaf.getStorageRoot();
+            auto node = reply.add_leaves();
+            node->set_key(item->key().begin(), item->key().size());
+            node->set_data(item->peekData().data(), item->peekData().size());
+            if (storageRoot)
+                node->set_storageroot(storageRoot->begin(), storageRoot->size());
+            bytes += item->peekData().size() + item->key().size();
+            return true;
+        });
+    }
+    catch (std::exception const& e)
+    {
+        JLOG(p_journal_.warn())
+            << "GetStateLeaves: exception walking " << rootHash << ": "
+            << e.what();
+        reply.clear_leaves();
+        reply.set_error(protocol::reNO_NODE);
+        complete = false;
+    }
+
+    reply.set_complete(complete);
+
+    JLOG(p_journal_.debug())
+        << "GetStateLeaves: return " << reply.leaves_size() << " leaves of "
+        << rootHash << (complete ? ", complete" : "");
+
+    send(std::make_shared<Message>(reply, protocol::mtSTATE_LEAVES));
+}
+
+void
+PeerImp::getTxSetIds(std::shared_ptr<protocol::TMGetTxSetIds> const& m)
+{
+    protocol::TMGetTxSetIds& packet = *m;
+
+    auto tup = getSchemaInfo("TMGetTxSetIds:", packet.schemaid());
+    if (!get<0>(tup))
+        return;
+    uint256 schemaId = get<1>(tup);
+
+    if (!stringIsUint256Sized(packet.sethash()) ||
+        packet.wanted().size() % 8 != 0)
+    {
+        charge(Resource::feeInvalidRequest);
+        JLOG(p_journal_.warn()) << "GetTxSetIds: Invalid request";
+        return;
+    }
+
+    if (send_queue_.size() >= Tuning::dropSendQueue)
+    {
+        JLOG(p_journal_.debug()) << "GetTxSetIds: Large send queue";
+        return;
+    }
+
+    if (app_.getFeeTrack(schemaId).isLoadedLocal() && !cluster())
+    {
+        JLOG(p_journal_.debug()) << "GetTxSetIds: Too busy";
+        return;
+    }
+
+    uint256 const setHash{packet.sethash()};
+
+    protocol::TMTxSetIds reply;
+    reply.set_sethash(packet.sethash());
+    reply.set_schemaid(schemaId.begin(), uint256::size());
+
+    auto const map =
+        app_.getInboundTransactions(schemaId).getSet(setHash, false);
+    if (!map)
+    {
+        JLOG(p_journal_.debug()) << "GetTxSetIds: Don't have " << setHash;
+        reply.set_error(protocol::reNO_LEDGER);
+        send(std::make_shared<Message>(reply, protocol::mtTX_SET_IDS));
+        return;
+    }
+
+    if (!packet.has_wanted())
+    {
+        // All the ids, in key order
+        Serializer ids;
+        map->visitLeaves([&](std::shared_ptr<SHAMapItem const> const& item) {
+            ids.add64(txSetShortId(setHash, item->key()));
+        });
+        reply.set_shortids(ids.data(), ids.size());
+
+        JLOG(p_journal_.debug()) << "GetTxSetIds: return "
+                                 << ids.size() / 8 << " ids of " << setHash;
+    }
+    else
+    {
+        hash_set<std::uint64_t> wanted;
+        SerialIter sit(makeSlice(packet.wanted()));
+        while (!sit.empty())
+            wanted.insert(sit.get64());
+
+        std::size_t bytes = 0;
+        map->visitLeaves([&](std::shared_ptr<SHAMapItem const> const& item) {
+            if (bytes >= Tuning::maxReplyTxSetBytes ||
+                wanted.count(txSetShortId(setHash, item->key())) == 0)
+                return;
+
+            reply.add_transactions(
+                item->peekData().data(), item->peekData().size());
+            bytes += item->peekData().size();
+        });
+
+        JLOG(p_journal_.debug())
+            << "GetTxSetIds: return " << reply.transactions_size() << " of "
+            << wanted.size() << " wanted txs of " << setHash;
+    }
+
+    send(std::make_shared<Message>(reply, protocol::mtTX_SET_IDS));
+}
+
 int
 PeerImp::getScore(bool haveItem) const
 {
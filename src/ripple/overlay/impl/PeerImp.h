@@ -226,6 +226,7 @@ private:
     // hash_map<PublicKey, ShardInfo> shardInfo_;
 
     Compressed compressionEnabled_ = Compressed::Off;
+    CompactTx compactTxEnabled_ = CompactTx::Off;
 
     friend class OverlayImpl;
 	friend class PeerManagerImpl;
@@ -601,6 +602,16 @@ public:
     void
     onMessage(std::shared_ptr<protocol::TMTableData> const& m);
     void
+    onMessage(std::shared_ptr<protocol::TMTableRange> const& m);
+    void
+    onMessage(std::shared_ptr<protocol::TMGetStateLeaves> const& m);
+    void
+    onMessage(std::shared_ptr<protocol::TMStateLeaves> const& m);
+    void
+    onMessage(std::shared_ptr<protocol::TMGetTxSetIds> const& m);
+    void
+    onMessage(std::shared_ptr<protocol::TMTxSetIds> const& m);
+    void
     onMessage(std::shared_ptr<protocol::TMConsensus> const& m);
     void
     onMessage(std::shared_ptr<protocol::TMSyncSchema> const& m);
@@ -651,6 +662,12 @@ private:
 
     void
     getLedger(std::shared_ptr<protocol::TMGetLedger> const& packet);
+
+    void
+    getStateLeaves(std::shared_ptr<protocol::TMGetStateLeaves> const& packet);
+
+    void
+    getTxSetIds(std::shared_ptr<protocol::TMGetTxSetIds> const& packet);
 };
 
 
@@ -698,6 +715,10 @@ PeerImp::PeerImp(
           headers_["X-Offer-Compression"] == "lz4" && app_.config().COMPRESSION
               ? Compressed::On
               : Compressed::Off)
+    , compactTxEnabled_(
+          headers_["X-Offer-Compact-Tx"] == "dict" && app_.config().COMPACT_TX
+              ? CompactTx::On
+              : CompactTx::Off)
 {
     read_buffer_.commit (boost::asio::buffer_copy(read_buffer_.prepare(
         boost::asio::buffer_size(buffers)), buffers));
@@ -77,6 +77,16 @@ protocolMessageName(int type)
             return "get_table";
         case protocol::mtTABLE_DATA:
             return "table_data";
+        case protocol::mtTABLE_RANGE:
+            return "table_range";
+        case protocol::mtGET_STATE_LEAVES:
+            return "get_state_leaves";
+        case protocol::mtSTATE_LEAVES:
+            return "state_leaves";
+        case protocol::mtGET_TX_SET_IDS:
+            return "get_tx_set_ids";
+        case protocol::mtTX_SET_IDS:
+            return "tx_set_ids";
         case protocol::mtCONSENSUS:
             return "consensus";
         case protocol::mtSYNC_SCHEMA:
@@ -288,8 +298,8 @@ invokeProtocolMessage(Buffers const& buffers, Handler& handler)
     // whose size exceeds this may result in the connection being dropped. A
     // larger message size may be supported in the future or negotiated as
     // part of a protocol upgrade.
-    if (header->payload_wire_size > megabytes(64) ||
-        header->uncompressed_size > megabytes(64))
+    if (header->payload_wire_size > maximumMessageSize ||
+        header->uncompressed_size > maximumMessageSize)
     {
         result.second = make_error_code(boost::system::errc::message_size);
         return result;
@@ -385,6 +395,26 @@ invokeProtocolMessage(Buffers const& buffers, Handler& handler)
             success = detail::invoke<protocol::TMTableData>(
                 *header, buffers, handler);
             break;
+        case protocol::mtTABLE_RANGE:
+            success = detail::invoke<protocol::TMTableRange>(
+                *header, buffers, handler);
+            break;
+        case protocol::mtGET_STATE_LEAVES:
+            success = detail::invoke<protocol::TMGetStateLeaves>(
+                *header, buffers, handler);
+            break;
+        case protocol::mtSTATE_LEAVES:
+            success = detail::invoke<protocol::TMStateLeaves>(
+                *header, buffers, handler);
+            break;
+        case protocol::mtGET_TX_SET_IDS:
+            success = detail::invoke<protocol::TMGetTxSetIds>(
+                *header, buffers, handler);
+            break;
+        case protocol::mtTX_SET_IDS:
+            success = detail::invoke<protocol::TMTxSetIds>(
+                *header, buffers, handler);
+            break;
         case protocol::mtCONSENSUS:
             success = detail::invoke<protocol::TMConsensus>(
                 *header, buffers, handler);
@@ -54,6 +54,15 @@ enum {
         reply */
     maxReplyByteSize = 33554432,
 
+    /** The maximum number of state map leaves in a single reply */
+    maxReplyLeaves = 16384,
+
+    /** The maximum byte size of state map leaves in a single reply */
+    maxReplyLeavesByteSize = 8388608,
+
+    /** The maximum byte size of the transactions in a tx set ids reply */
+    maxReplyTxSetBytes = 8388608,
+
 
     /** How often we check connections (seconds) */
     checkSeconds = 32,
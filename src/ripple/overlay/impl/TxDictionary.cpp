@@ -0,0 +1,354 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/basics/contract.h>
+#include <ripple/overlay/Message.h>
+#include <ripple/overlay/TxDictionary.h>
+#include <ripple/protocol/SField.h>
+#include <ripple/protocol/Serializer.h>
+
+namespace ripple {
+
+enum {
+    // The first byte of an encoded transaction
+    txLiteral = 0,
+    txCompact = 1
+
+    // Values past this many are written in full without being remembered
+    ,
+    maxEntries = 65536
+
+    // Longest table name a transaction can carry
+    ,
+    maxTableName = 64
+
+    // The wire type that ends the node of a transaction in a tx set
+    ,
+    wireTypeTransaction = 0
+};
+
+static void
+addIndex(Serializer& s, std::uint32_t index)
+{
+    while (index >= 0x80)
+    {
+        s.add8(static_cast<unsigned char>(index | 0x80));
+        index >>= 7;
+    }
+    s.add8(static_cast<unsigned char>(index));
+}
+
+static std::uint32_t
+getIndex(SerialIter& sit)
+{
+    std::uint32_t index = 0;
+    for (int shift = 0; shift < 21; shift += 7)
+    {
+        auto const b = sit.get8();
+        index |= static_cast<std::uint32_t>(b & 0x7f) << shift;
+        if ((b & 0x80) == 0)
+            return index;
+    }
+    Throw<std::runtime_error>("TxDictionary: invalid index");
+    return 0;
+}
+
+// Whether the value of a field goes through the dictionary
+static bool
+isDictionaryField(int type, int name)
+{
+    return type == STI_ACCOUNT || type == STI_HASH160 ||
+        (type == STI_VL && name == sfTableName.fieldValue);
+}
+
+static void
+copyRaw(SerialIter& sit, Serializer& out, std::size_t bytes)
+{
+    auto const raw = sit.getSlice(bytes);
+    out.addRaw(raw.data(), raw.size());
+}
+
+// Read a dictionary value as it is serialized. Values are no longer than
+// the field allows, so a reference never expands to more than that.
+static Blob
+getValue(int type, SerialIter& sit)
+{
+    Serializer s;
+    if (type == STI_HASH160)
+    {
+        copyRaw(sit, s, 20);
+    }
+    else
+    {
+        auto const length = sit.getVLDataLength();
+        if (type == STI_ACCOUNT ? length != 20 : length > maxTableName)
+            Throw<std::runtime_error>("TxDictionary: invalid value size");
+        s.addVL(sit.getSlice(length));
+    }
+    return std::move(s.modData());
+}
+
+// Copy a serialized object field by field. The values of dictionary fields
+// are handed to the callback, which reads them and writes their encoding.
+template <class F>
+static void
+walkFields(SerialIter& sit, Serializer& out, F&& dictionaryField)
+{
+    while (!sit.empty())
+    {
+        int type, name;
+        sit.getFieldID(type, name);
+        out.addFieldID(type, name);
+
+        if (isDictionaryField(type, name))
+        {
+            dictionaryField(type, sit, out);
+            continue;
+        }
+
+        switch (type)
+        {
+            case STI_OBJECT:
+            case STI_ARRAY:
+                // Members and end markers follow as fields of their own
+                break;
+            case STI_UINT8:
+                out.add8(sit.get8());
+                break;
+            case STI_UINT16:
+                out.add16(sit.get16());
+                break;
+            case STI_UINT32:
+                out.add32(sit.get32());
+                break;
+            case STI_UINT64:
+                out.add64(sit.get64());
+                break;
+            case STI_HASH128:
+                copyRaw(sit, out, 16);
+                break;
+            case STI_HASH256:
+                copyRaw(sit, out, 32);
+                break;
+            case STI_AMOUNT: {
+                auto const value = sit.get64();
+                out.add64(value);
+                // Issued amounts carry their currency and issuer
+                if (value & 0x8000000000000000ull)
+                    copyRaw(sit, out, 40);
+                break;
+            }
+            case STI_VL:
+            case STI_VECTOR256:
+                out.addVL(sit.getSlice(sit.getVLDataLength()));
+                break;
+            default:
+                Throw<std::runtime_error>(
+                    "TxDictionary: unsupported field type " +
+                    std::to_string(type));
+        }
+    }
+}
+
+Blob
+TxDictionaryEncoder::encode(Slice const& tx)
+{
+    Serializer out(tx.size());
+    out.add8(txCompact);
+
+    // The values this transaction adds, taken back if it is sent as it is
+    std::vector<std::string> added;
+    try
+    {
+        SerialIter sit(tx);
+        walkFields(sit, out, [&](int type, SerialIter& sit, Serializer& s) {
+            auto const value = getValue(type, sit);
+            std::string key(value.begin(), value.end());
+
+            auto const it = entries_.find(key);
+            if (it != entries_.end())
+            {
+                addIndex(s, it->second + 1);
+                return;
+            }
+
+            addIndex(s, 0);
+            s.addRaw(value);
+            if (entries_.size() < maxEntries)
+            {
+                added.push_back(key);
+                entries_.emplace(std::move(key), entries_.size());
+            }
+        });
+    }
+    catch (std::exception const&)
+    {
+        // Paths and the like are not worth walking, such a transaction is
+        // sent as it is and the decoder remembers none of its values
+        for (auto const& key : added)
+            entries_.erase(key);
+
+        out.erase();
+        out.add8(txLiteral);
+        out.addRaw(tx.data(), tx.size());
+    }
+
+    return std::move(out.modData());
+}
+
+Blob
+TxDictionaryDecoder::decode(Slice const& data)
+{
+    if (data.empty())
+        Throw<std::runtime_error>("TxDictionary: empty transaction");
+
+    // Only references expand, this stops a message full of them
+    auto const reserve = [this](std::size_t bytes) {
+        decoded_ += bytes;
+        if (decoded_ > maximumMessageSize)
+            Throw<std::runtime_error>("TxDictionary: message too large");
+    };
+
+    Slice body(data.data() + 1, data.size() - 1);
+    if (data[0] == txLiteral)
+    {
+        reserve(body.size());
+        return Blob(body.begin(), body.end());
+    }
+    if (data[0] != txCompact)
+        Throw<std::runtime_error>("TxDictionary: unknown encoding");
+
+    reserve(body.size());
+    Serializer out(body.size());
+    SerialIter sit(body);
+    walkFields(sit, out, [&](int type, SerialIter& sit, Serializer& s) {
+        auto const index = getIndex(sit);
+        if (index == 0)
+        {
+            auto value = getValue(type, sit);
+            s.addRaw(value);
+            if (entries_.size() < maxEntries)
+                entries_.push_back(std::move(value));
+            return;
+        }
+
+        if (index > entries_.size())
+            Throw<std::runtime_error>("TxDictionary: index out of range");
+        reserve(entries_[index - 1].size());
+        s.addRaw(entries_[index - 1]);
+    });
+
+    return std::move(out.modData());
+}
+
+//------------------------------------------------------------------------------
+
+bool
+compactTxs(protocol::TMTransactions& m)
+{
+    if (m.compact() || m.transactions_size() == 0)
+        return false;
+
+    TxDictionaryEncoder encoder;
+    for (auto& tx : *m.mutable_transactions())
+    {
+        auto const encoded = encoder.encode(makeSlice(tx.rawtransaction()));
+        tx.set_rawtransaction(encoded.data(), encoded.size());
+    }
+    m.set_compact(true);
+    return true;
+}
+
+bool
+compactTxs(protocol::TMLedgerData& m)
+{
+    if (m.compact() || m.type() != protocol::liTS_CANDIDATE ||
+        m.nodes_size() == 0)
+        return false;
+
+    TxDictionaryEncoder encoder;
+    for (auto& node : *m.mutable_nodes())
+    {
+        auto const& data = node.nodedata();
+        if (data.size() < 2 || data.back() != wireTypeTransaction)
+            continue;
+
+        auto encoded = encoder.encode(Slice(data.data(), data.size() - 1));
+        encoded.push_back(wireTypeTransaction);
+        node.set_nodedata(encoded.data(), encoded.size());
+    }
+    m.set_compact(true);
+    return true;
+}
+
+bool
+expandTxs(protocol::TMTransactions& m)
+{
+    if (!m.compact())
+        return true;
+
+    try
+    {
+        TxDictionaryDecoder decoder;
+        for (auto& tx : *m.mutable_transactions())
+        {
+            auto const decoded = decoder.decode(makeSlice(tx.rawtransaction()));
+            tx.set_rawtransaction(decoded.data(), decoded.size());
+        }
+    }
+    catch (std::exception const&)
+    {
+        return false;
+    }
+
+    m.clear_compact();
+    return true;
+}
+
+bool
+expandTxs(protocol::TMLedgerData& m)
+{
+    if (!m.compact())
+        return true;
+
+    try
+    {
+        TxDictionaryDecoder decoder;
+        for (auto& node : *m.mutable_nodes())
+        {
+            auto const& data = node.nodedata();
+            if (data.size() < 2 || data.back() != wireTypeTransaction)
+                continue;
+
+            auto decoded =
+                decoder.decode(Slice(data.data(), data.size() - 1));
+            decoded.push_back(wireTypeTransaction);
+            node.set_nodedata(decoded.data(), decoded.size());
+        }
+    }
+    catch (std::exception const&)
+    {
+        return false;
+    }
+
+    m.clear_compact();
+    return true;
+}
+
+}  // namespace ripple
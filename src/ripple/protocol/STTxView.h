@@ -0,0 +1,128 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#ifndef RIPPLE_PROTOCOL_STTXVIEW_H_INCLUDED
+#define RIPPLE_PROTOCOL_STTXVIEW_H_INCLUDED
+
+#include <ripple/basics/Slice.h>
+#include <ripple/basics/base_uint.h>
+#include <ripple/protocol/AccountID.h>
+#include <ripple/protocol/SField.h>
+#include <ripple/protocol/TxFormats.h>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ripple {
+
+class STTx;
+
+/** A read-only view of a serialized transaction.
+
+    Fields are read straight from the serialized bytes when asked for,
+    without building the STObject tree of an STTx. The top level fields
+    are indexed the first time one of them is read, the id is hashed the
+    first time it is asked for.
+
+    The view does not own the bytes, and caches what it has read, so it
+    must not outlive them nor be shared between threads.
+*/
+class STTxView
+{
+public:
+    /** Whether the bytes are a transaction the view can read.
+        Ethereum transactions are RLP encoded and are not.
+    */
+    static bool
+    canView(Slice const& data);
+
+    explicit STTxView(Slice const& data);
+
+    Slice const&
+    data() const
+    {
+        return data_;
+    }
+
+    /** The id of the transaction.
+        The same as the id of its STTx when the fields are serialized in
+        canonical order, as every server serializes them.
+    */
+    uint256 const&
+    getTransactionID() const;
+
+    // The field getters throw if the transaction is malformed or the
+    // field is missing or of another type
+
+    TxType
+    getTxnType() const;
+
+    bool
+    isFieldPresent(SField const& field) const;
+
+    std::uint8_t
+    getFieldU8(SField const& field) const;
+
+    std::uint16_t
+    getFieldU16(SField const& field) const;
+
+    std::uint32_t
+    getFieldU32(SField const& field) const;
+
+    std::uint64_t
+    getFieldU64(SField const& field) const;
+
+    uint256
+    getFieldH256(SField const& field) const;
+
+    AccountID
+    getAccountID(SField const& field) const;
+
+    Slice
+    getFieldVL(SField const& field) const;
+
+    /** Parse the whole transaction.
+        Throws if it is malformed.
+    */
+    std::shared_ptr<STTx const>
+    toSTTx() const;
+
+private:
+    struct Field
+    {
+        int code;
+        Slice value;
+    };
+
+    void
+    index() const;
+
+    Slice
+    getField(SField const& field, SerializedTypeID type) const;
+
+    Slice data_;
+    mutable boost::optional<uint256> tid_;
+    mutable boost::optional<std::vector<Field>> fields_;
+};
+
+}  // namespace ripple
+
+#endif
@@ -0,0 +1,259 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <ripple/basics/contract.h>
+#include <ripple/basics/safe_cast.h>
+#include <ripple/protocol/HashPrefix.h>
+#include <ripple/protocol/STPathSet.h>
+#include <ripple/protocol/STTx.h>
+#include <ripple/protocol/STTxView.h>
+#include <ripple/protocol/Serializer.h>
+#include <ripple/protocol/digest.h>
+#include <cstring>
+
+namespace ripple {
+
+// Skip the value of a path set, which runs to its end byte
+static void
+skipPathSet(SerialIter& sit)
+{
+    for (;;)
+    {
+        auto const type = sit.get8();
+        if (type == STPathElement::typeNone)
+            return;
+        if (type == STPathElement::typeBoundary)
+            continue;
+
+        if (type & ~STPathElement::typeAll)
+            Throw<std::runtime_error>("STTxView: bad path element");
+        if (type & STPathElement::typeAccount)
+            sit.skip(20);
+        if (type & STPathElement::typeCurrency)
+            sit.skip(20);
+        if (type & STPathElement::typeIssuer)
+            sit.skip(20);
+    }
+}
+
+bool
+STTxView::canView(Slice const& data)
+{
+    return !data.empty() && data[0] != 0;
+}
+
+STTxView::STTxView(Slice const& data) : data_(data)
+{
+}
+
+uint256 const&
+STTxView::getTransactionID() const
+{
+    if (!tid_)
+        tid_ = sha512Half(HashPrefix::transactionID, data_);
+    return *tid_;
+}
+
+void
+STTxView::index() const
+{
+    std::vector<Field> fields;
+    fields.reserve(24);
+
+    // Inner objects and arrays are skipped over, only top level fields
+    // are indexed
+    int depth = 0;
+    SerialIter sit(data_);
+    while (!sit.empty())
+    {
+        int type, name;
+        sit.getFieldID(type, name);
+
+        auto const start = data_.size() - sit.getBytesLeft();
+        switch (type)
+        {
+            case STI_OBJECT:
+            case STI_ARRAY:
+                if (name == 1)
+                {
+                    // End marker
+                    if (depth == 0)
+                        Throw<std::runtime_error>(
+                            "STTxView: unexpected end marker");
+                    --depth;
+                    continue;
+                }
+                if (depth++ == 0)
+                    fields.push_back({field_code(type, name), Slice()});
+                continue;
+            case STI_UINT8:
+                sit.skip(1);
+                break;
+            case STI_UINT16:
+                sit.skip(2);
+                break;
+            case STI_UINT32:
+                sit.skip(4);
+                break;
+            case STI_UINT64:
+                sit.skip(8);
+                break;
+            case STI_HASH128:
+                sit.skip(16);
+                break;
+            case STI_HASH160:
+                sit.skip(20);
+                break;
+            case STI_HASH256:
+                sit.skip(32);
+                break;
+            case STI_AMOUNT:
+                // Issued amounts carry their currency and issuer
+                sit.skip((sit.get8() & 0x80) ? 47 : 7);
+                break;
+            case STI_VL:
+            case STI_ACCOUNT:
+            case STI_VECTOR256: {
+                auto const size = sit.getVLDataLength();
+                auto const value = sit.getSlice(size);
+                if (depth == 0)
+                    fields.push_back({field_code(type, name), value});
+                continue;
+            }
+            case STI_PATHSET:
+                skipPathSet(sit);
+                break;
+            default:
+                Throw<std::runtime_error>(
+                    "STTxView: unsupported field type " +
+                    std::to_string(type));
+        }
+
+        if (depth == 0)
+        {
+            auto const end = data_.size() - sit.getBytesLeft();
+            fields.push_back({field_code(type, name),
+                              Slice(data_.data() + start, end - start)});
+        }
+    }
+
+    if (depth != 0)
+        Throw<std::runtime_error>("STTxView: unterminated object");
+
+    fields_ = std::move(fields);
+}
+
+Slice
+STTxView::getField(SField const& field, SerializedTypeID type) const
+{
+    if (field.fieldType != type)
+        Throw<std::runtime_error>(
+            "STTxView: wrong type for field " + field.getName());
+
+    if (!fields_)
+        index();
+
+    for (auto const& f : *fields_)
+    {
+        if (f.code == field.fieldCode)
+            return f.value;
+    }
+
+    Throw<std::runtime_error>("STTxView: field not found " + field.getName());
+    return {};
+}
+
+bool
+STTxView::isFieldPresent(SField const& field) const
+{
+    if (!fields_)
+        index();
+
+    for (auto const& f : *fields_)
+    {
+        if (f.code == field.fieldCode)
+            return true;
+    }
+    return false;
+}
+
+TxType
+STTxView::getTxnType() const
+{
+    return safe_cast<TxType>(getFieldU16(sfTransactionType));
+}
+
+std::uint8_t
+STTxView::getFieldU8(SField const& field) const
+{
+    return SerialIter(getField(field, STI_UINT8)).get8();
+}
+
+std::uint16_t
+STTxView::getFieldU16(SField const& field) const
+{
+    return SerialIter(getField(field, STI_UINT16)).get16();
+}
+
+std::uint32_t
+STTxView::getFieldU32(SField const& field) const
+{
+    return SerialIter(getField(field, STI_UINT32)).get32();
+}
+
+std::uint64_t
+STTxView::getFieldU64(SField const& field) const
+{
+    return SerialIter(getField(field, STI_UINT64)).get64();
+}
+
+uint256
+STTxView::getFieldH256(SField const& field) const
+{
+    return SerialIter(getField(field, STI_HASH256)).get256();
+}
+
+AccountID
+STTxView::getAccountID(SField const& field) const
+{
+    auto const value = getField(field, STI_ACCOUNT);
+
+    // A default account is serialized empty
+    AccountID id;
+    if (value.size() == id.size())
+        std::memcpy(id.data(), value.data(), id.size());
+    else if (!value.empty())
+        Throw<std::runtime_error>("STTxView: bad account size");
+    return id;
+}
+
+Slice
+STTxView::getFieldVL(SField const& field) const
+{
+    return getField(field, STI_VL);
+}
+
+std::shared_ptr<STTx const>
+STTxView::toSTTx() const
+{
+    return std::make_shared<STTx const>(SerialIter{data_});
+}
+
+}  // namespace ripple
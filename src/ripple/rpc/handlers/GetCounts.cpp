@@ -20,10 +20,12 @@
 #include <ripple/app/ledger/AcceptedLedger.h>
 #include <ripple/app/ledger/InboundLedgers.h>
 #include <ripple/app/ledger/LedgerMaster.h>
+#include <ripple/app/ledger/PendingSaves.h>
 #include <peersafe/schema/Schema.h>
 #include <ripple/app/misc/NetworkOPs.h>
 #include <ripple/basics/UptimeClock.h>
 #include <ripple/core/DatabaseCon.h>
+#include <ripple/core/JobQueue.h>
 #include <ripple/json/json_value.h>
 #include <ripple/ledger/CachedSLEs.h>
 #include <ripple/net/RPCErr.h>
@@ -34,6 +36,7 @@
 #include <ripple/rpc/Context.h>
 #include <ripple/shamap/ShardFamily.h>
 #include <peersafe/app/misc/ConnectionPool.h>
+#include <peersafe/app/misc/ContractHelper.h>
 #include <peersafe/app/sql/TxnDBConn.h>
 
 namespace ripple {
@@ -111,6 +114,12 @@ getCountsJson(Schema& app, int minObjectCount)
     ret["LedgerHistorySize"] =
         app.getLedgerMaster().getLedgerHistory().getCacheSize();
     ret["HeldTransactionSize"] = app.getLedgerMaster().heldTransactionSize();
+    ret["contract_storage_hit_rate"] =
+        app.getContractHelper().getStorageHitRate();
+    ret["contract_storage_cache_size"] = static_cast<Json::UInt>(
+        app.getContractHelper().getStorageCacheSize());
+    ret["schema_jobs"] = app.getJobQueue().getSchemaJson();
+    ret["ledger_saves"] = app.pendingSaves().getJson();
 
     ret["state_leafset_cache_size"] =
         static_cast<int> (app.getNodeFamily().getStateNodeHashSet()->size());
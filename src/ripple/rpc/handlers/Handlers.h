@@ -173,6 +173,7 @@ Json::Value doTxCount				(RPC::JsonContext&);
 Json::Value doLedgerObjects			(RPC::JsonContext&);
 Json::Value doNodeSize              (RPC::JsonContext&);
 Json::Value doMallocTrim            (RPC::JsonContext&);
+Json::Value doCacheUsage            (RPC::JsonContext&);
 Json::Value doSchemaList			(RPC::JsonContext&);
 Json::Value doSchemaInfo            (RPC::JsonContext&);
 Json::Value doSchemaAccept          (RPC::JsonContext&);
@@ -184,6 +185,8 @@ Json::Value getDumpCurPos(RPC::JsonContext& context);
 Json::Value doTableAudit(RPC::JsonContext&);
 Json::Value doTableAuditStop(RPC::JsonContext&);
 Json::Value getAuditCurPos(RPC::JsonContext& context);
+Json::Value doTableSnapshot(RPC::JsonContext&);
+Json::Value doTableSnapshotLoad(RPC::JsonContext&);
 Json::Value doTableAuthority(RPC::JsonContext&);
 Json::Value doRpcSubmit(RPC::JsonContext&);
 Json::Value doCreateFromRaw(RPC::JsonContext&);
@@ -22,6 +22,7 @@
 #include <ripple/app/main/Application.h>
 #include <ripple/app/misc/NetworkOPs.h>
 #include <ripple/basics/Log.h>
+#include <ripple/json/Arena.h>
 #include <ripple/ledger/ReadView.h>
 #include <ripple/net/RPCErr.h>
 #include <ripple/net/RPCSub.h>
@@ -38,6 +39,9 @@ namespace ripple {
 Json::Value
 doSubscribe(RPC::JsonContext& context)
 {
+    // Subscriptions outlive the RPC call, keep them out of the request arena
+    Json::HeapScope heap;
+
     InfoSub::pointer ispSub;
     Json::Value jvResult(Json::objectValue);
 
@@ -201,6 +201,8 @@ Handler const handlerArray[]{
     {"t_audit", byRef(&doTableAudit), Role::ADMIN, NO_CONDITION},
     {"t_auditstop", byRef(&doTableAuditStop), Role::ADMIN, NO_CONDITION},
     {"t_auditposition", byRef(&getAuditCurPos), Role::ADMIN, NO_CONDITION},
+    {"t_snapshot", byRef(&doTableSnapshot), Role::ADMIN, NO_CONDITION},
+    {"t_snapshot_load", byRef(&doTableSnapshotLoad), Role::ADMIN, NO_CONDITION},
     {"table_auth", byRef(&doTableAuthority), Role::USER, NO_CONDITION},
     {"tx_count", byRef(&doTxCount), Role::USER, NO_CONDITION},
     {"tx_crossget", byRef(&doGetCrossChainTx), Role::USER, NO_CONDITION},
@@ -214,6 +216,7 @@ Handler const handlerArray[]{
     {"ledger_objects", byRef(&doLedgerObjects), Role::USER, NO_CONDITION},
     {"node_size", byRef(&doNodeSize), Role::ADMIN, NO_CONDITION},
     {"malloc_trim", byRef(&doMallocTrim), Role::ADMIN, NO_CONDITION},
+    {"cache_usage", byRef(&doCacheUsage), Role::ADMIN, NO_CONDITION},
     {"schema_list", byRef(&doSchemaList), Role::USER, NO_CONDITION},
     {"schema_info", byRef(&doSchemaInfo), Role::USER, NO_CONDITION},
     {"schema_accept", byRef(&doSchemaAccept), Role::ADMIN, NO_CONDITION},
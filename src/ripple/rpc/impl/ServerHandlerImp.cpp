@@ -27,6 +27,7 @@
 #include <ripple/beast/rfc2616.h>
 #include <ripple/core/JobQueue.h>
 #include <ripple/json/json_reader.h>
+#include <ripple/json/json_writer.h>
 #include <ripple/json/to_string.h>
 #include <ripple/net/RPCErr.h>
 #include <ripple/overlay/Overlay.h>
@@ -48,6 +49,7 @@
 #include <eth/api/utils/Helpers.h>
 // #include <beast/core/detail/base64.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/beast/core/buffers_prefix.hpp>
 #include <boost/beast/http/fields.hpp>
 #include <boost/beast/http/string_body.hpp>
 #include <boost/optional.hpp>
@@ -347,12 +349,13 @@ ServerHandlerImp::onWSMessage(
         "WS-Client",
         [this, session, jv = std::move(jv)](
             std::shared_ptr<JobQueue::Coro> const& coro) {
+            Json::ArenaScope arena;
             auto const jr = this->processSession(session, coro, jv);
-            auto const s = to_string(jr);
-            auto const n = s.length();
-            boost::beast::multi_buffer sb(n);
-            sb.commit(boost::asio::buffer_copy(
-                sb.prepare(n), boost::asio::buffer(s.c_str(), n)));
+            boost::beast::multi_buffer sb;
+            Json::stream(jr, [&sb](auto const p, auto const n) {
+                sb.commit(boost::asio::buffer_copy(
+                    sb.prepare(n), boost::asio::buffer(p, n)));
+            });
             session->send(
                 std::make_shared<StreambufWSMsg<decltype(sb)>>(std::move(sb)));
             session->complete();
@@ -636,6 +639,9 @@ ServerHandlerImp::processRequest(
 {
     auto rpcJ = app_.journal("RPC");
 
+    // The request, the reply and everything in between come from one arena
+    Json::ArenaScope arena;
+
     Json::Value jsonOrig;
     {
         Json::Reader reader;
@@ -1055,7 +1061,8 @@ ServerHandlerImp::processRequest(
 			}
 			if (result.isMember(jss::request) && result[jss::request].isMember(jss::tx_json))
 			{
-				if (strMethod == "t_dump" || strMethod == "t_dumpstop" || strMethod == "t_audit" || strMethod == "t_auditstop")
+				if (strMethod == "t_dump" || strMethod == "t_dumpstop" || strMethod == "t_audit" || strMethod == "t_auditstop" ||
+                    strMethod == "t_snapshot" || strMethod == "t_snapshot_load")
 				{
 					for (int i = 0; i < result[jss::request][jss::tx_json].size(); i++)
 					{
@@ -1088,22 +1095,24 @@ ServerHandlerImp::processRequest(
             << "doRpcCommand:" << strMethod << ":" << reply;
     }
     
-    auto response = to_string(reply);
+    // Streamed into chunks, a large reply never needs one contiguous copy
+    boost::beast::multi_buffer response;
+    Json::stream(reply, [&response](auto const p, auto const n) {
+        response.commit(boost::asio::buffer_copy(
+            response.prepare(n), boost::asio::buffer(p, n)));
+    });
 
     rpc_time_.notify(std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::high_resolution_clock::now() - start));
     ++rpc_requests_;
     rpc_size_.notify(beast::insight::Event::value_type{response.size()});
 
-    response += '\n';
-
     if (auto stream = m_journal.debug())
     {
         static const int maxSize = 10000;
-        if (response.size() <= maxSize)
-            stream << "Reply: " << response;
-        else
-            stream << "Reply: " << response.substr(0, maxSize);
+        stream << "Reply: "
+               << buffers_to_string(
+                      boost::beast::buffers_prefix(maxSize, response.data()));
     }
 
     HTTPReply(200, response, output, rpcJ, app_.config().IS_ALLOW_REMOTE);
@@ -24,6 +24,7 @@
 #include <ripple/protocol/jss.h>
 #include <ripple/server/impl/JSONRPCUtil.h>
 #include <boost/algorithm/string.hpp>
+#include <boost/beast/core/buffers_to_string.hpp>
 
 namespace ripple {
 
@@ -52,50 +53,14 @@ getHTTPHeaderTimestamp()
     return std::string(buffer);
 }
 
-void
-HTTPReply(
+// Everything but the body, for the statuses other than 401
+static void
+writeHeaders(
     int nStatus,
-    std::string const& content,
+    std::size_t contentLength,
     Json::Output const& output,
-    beast::Journal j,
     bool isAllowRemote)
 {
-    JLOG(j.trace()) << "HTTP Reply " << nStatus << " " << content;
-
-    if (nStatus == 401)
-    {
-        output("HTTP/1.0 401 Authorization Required\r\n");
-        output(getHTTPHeaderTimestamp());
-
-        // CHECKME this returns a different version than the replies below. Is
-        //         this by design or an accident or should it be using
-        //         BuildInfo::getFullVersionString () as well?
-        output("Server: " + systemName() + "-json-rpc/v1");
-        output("\r\n");
-
-        // Be careful in modifying this! If you change the contents you MUST
-        // update the Content-Length header as well to indicate the correct
-        // size of the data.
-        output(
-            "WWW-Authenticate: Basic realm=\"jsonrpc\"\r\n"
-            "Content-Type: text/html\r\n"
-            "Content-Length: 296\r\n"
-            "\r\n"
-            "<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.01 "
-            "Transitional//EN\"\r\n"
-            "\"http://www.w3.org/TR/1999/REC-html401-19991224/loose.dtd"
-            "\">\r\n"
-            "<HTML>\r\n"
-            "<HEAD>\r\n"
-            "<TITLE>Error</TITLE>\r\n"
-            "<META HTTP-EQUIV='Content-Type' "
-            "CONTENT='text/html; charset=ISO-8859-1'>\r\n"
-            "</HEAD>\r\n"
-            "<BODY><H1>401 Unauthorized.</H1></BODY>\r\n");
-
-        return;
-    }
-
     switch (nStatus)
     {
         case 200:
@@ -133,7 +98,7 @@ HTTPReply(
         "Connection: Keep-Alive\r\n"
         "Content-Length: ");
 
-    output(std::to_string(content.size() + 2));
+    output(std::to_string(contentLength));
     output(
         "\r\n"
         "Content-Type: application/json; charset=UTF-8\r\n");
@@ -143,8 +108,73 @@ HTTPReply(
     output(
         "\r\n"
         "\r\n");
+}
+
+void
+HTTPReply(
+    int nStatus,
+    std::string const& content,
+    Json::Output const& output,
+    beast::Journal j,
+    bool isAllowRemote)
+{
+    JLOG(j.trace()) << "HTTP Reply " << nStatus << " " << content;
+
+    if (nStatus == 401)
+    {
+        output("HTTP/1.0 401 Authorization Required\r\n");
+        output(getHTTPHeaderTimestamp());
+
+        // CHECKME this returns a different version than the replies below. Is
+        //         this by design or an accident or should it be using
+        //         BuildInfo::getFullVersionString () as well?
+        output("Server: " + systemName() + "-json-rpc/v1");
+        output("\r\n");
+
+        // Be careful in modifying this! If you change the contents you MUST
+        // update the Content-Length header as well to indicate the correct
+        // size of the data.
+        output(
+            "WWW-Authenticate: Basic realm=\"jsonrpc\"\r\n"
+            "Content-Type: text/html\r\n"
+            "Content-Length: 296\r\n"
+            "\r\n"
+            "<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.01 "
+            "Transitional//EN\"\r\n"
+            "\"http://www.w3.org/TR/1999/REC-html401-19991224/loose.dtd"
+            "\">\r\n"
+            "<HTML>\r\n"
+            "<HEAD>\r\n"
+            "<TITLE>Error</TITLE>\r\n"
+            "<META HTTP-EQUIV='Content-Type' "
+            "CONTENT='text/html; charset=ISO-8859-1'>\r\n"
+            "</HEAD>\r\n"
+            "<BODY><H1>401 Unauthorized.</H1></BODY>\r\n");
+
+        return;
+    }
+
+    writeHeaders(nStatus, content.size() + 2, output, isAllowRemote);
     output(content);
     output("\r\n");
 }
 
+void
+HTTPReply(
+    int nStatus,
+    boost::beast::multi_buffer const& content,
+    Json::Output const& output,
+    beast::Journal j,
+    bool isAllowRemote)
+{
+    if (auto stream = j.trace())
+        stream << "HTTP Reply " << nStatus << " "
+               << boost::beast::buffers_to_string(content.data());
+
+    writeHeaders(nStatus, content.size() + 2, output, isAllowRemote);
+    for (auto const& b : content.data())
+        output({static_cast<char const*>(b.data()), b.size()});
+    output("\r\n");
+}
+
 }  // namespace ripple
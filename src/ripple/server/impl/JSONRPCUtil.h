@@ -22,6 +22,7 @@
 
 #include <ripple/json/Output.h>
 #include <ripple/json/json_value.h>
+#include <boost/beast/core/multi_buffer.hpp>
 
 namespace ripple {
 
@@ -33,6 +34,19 @@ HTTPReply(
     beast::Journal j,
     bool isAllowRemote = false);
 
+/** Reply with a body already serialized into buffers.
+
+    Used for large replies, which are streamed into a multi_buffer rather
+    than built into one string. Not for status 401.
+*/
+void
+HTTPReply(
+    int nStatus,
+    boost::beast::multi_buffer const& content,
+    Json::Output const&,
+    beast::Journal j,
+    bool isAllowRemote = false);
+
 }  // namespace ripple
 
 #endif
@@ -220,6 +220,17 @@ public:
         std::function<void(std::shared_ptr<SHAMapItem const> const&)> const&)
         const;
 
+    /**  Visit the leaf nodes in key order, from the first one with a key
+         above `after`, or from the first one if there is no `after`
+
+         @param function called with every leaf node visited.
+         If function returns false, visitLeafNodes exits.
+    */
+    void
+    visitLeafNodes(
+        boost::optional<uint256> const& after,
+        std::function<bool(SHAMapTreeNode const&)> const& function) const;
+
     // comparison/sync functions
 
     /** Check for nodes in the SHAMap not available
@@ -257,6 +268,15 @@ public:
         SHAMapNodeID const& nodeID,
         Slice const& rawNode,
         SHAMapSyncFilter* filter);
+    /** Same, with a node already built from its wire form.
+        Building the node hashes it, so callers can do that without the
+        map's lock held.
+    */
+    SHAMapAddNode
+    addKnownNode(
+        SHAMapNodeID const& nodeID,
+        std::shared_ptr<SHAMapAbstractNode> node,
+        SHAMapSyncFilter* filter);
 
     // status functions
     void
@@ -330,6 +350,8 @@ private:
     // database operations
     std::shared_ptr<SHAMapAbstractNode>
     fetchNodeFromDB(SHAMapHash const& hash) const;
+    void
+    prefetchChildren(std::vector<SHAMapInnerNode*> const& parents) const;
     std::shared_ptr<SHAMapAbstractNode>
     fetchNodeNT(SHAMapHash const& hash) const;
     std::shared_ptr<SHAMapAbstractNode>
@@ -423,6 +445,9 @@ private:
     peekFirstItem(SharedPtrNodeStack& stack) const;
     SHAMapTreeNode const*
     peekNextItem(uint256 const& id, SharedPtrNodeStack& stack) const;
+    /** The first leaf with a key above id, the stack leading to it */
+    SHAMapTreeNode const*
+    peekUpperBound(uint256 const& id, SharedPtrNodeStack& stack) const;
     bool
     walkBranch(
         SHAMapAbstractNode* node,
@@ -0,0 +1,126 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_SHAMAP_SHAMAPLEAFBUILDER_H_INCLUDED
+#define RIPPLE_SHAMAP_SHAMAPLEAFBUILDER_H_INCLUDED
+
+#include <ripple/shamap/SHAMapItem.h>
+#include <ripple/shamap/SHAMapNodeID.h>
+#include <ripple/shamap/SHAMapTreeNode.h>
+#include <boost/optional.hpp>
+#include <functional>
+#include <vector>
+
+namespace ripple {
+
+/** Builds the nodes of a state map from its leaves.
+
+    The key space is split in 16 or 256 ranges by the first one or two
+    nibbles of the key. The leaves of each range are given in key order
+    and the range is built bottom up, every node hashed once and handed to
+    the writer, so ranges can be built on different threads as they
+    arrive. Once every range is built, finish() joins them below the root.
+
+    The result is the tree SHAMap would hold for the same leaves, so the
+    root hash tells whether the leaves were complete and correct.
+*/
+class SHAMapLeafBuilder
+{
+public:
+    struct Leaf
+    {
+        std::shared_ptr<SHAMapItem const> item;
+        // Set for the account leaves of contracts in the state map
+        boost::optional<uint256> storageRoot;
+    };
+
+    using Writer = std::function<void(SHAMapAbstractNode const&)>;
+
+    /** @param rangeDepth 1 for 16 ranges, 2 for 256 */
+    SHAMapLeafBuilder(int rangeDepth, Writer write);
+
+    std::size_t
+    ranges() const
+    {
+        return subtrees_.size();
+    }
+
+    /** The range a key belongs to */
+    std::size_t
+    rangeOf(uint256 const& key) const;
+
+    /** The lowest and highest keys of a range */
+    uint256
+    first(std::size_t range) const;
+    uint256
+    last(std::size_t range) const;
+
+    /** Build one range from all its leaves, sorted by key.
+        Different ranges may be built at the same time. A range may be
+        built again, the last build is the one joined.
+        @return the hash of the range's subtree, zero for no leaves
+    */
+    SHAMapHash
+    build(std::size_t range, std::vector<Leaf> const& leaves);
+
+    /** Join the built ranges and return the root hash */
+    SHAMapHash
+    finish();
+
+    using Fetch = std::function<std::shared_ptr<SHAMapAbstractNode>(
+        SHAMapHash const&)>;
+
+    /** The hash each range must build to, read from the top of the map:
+        the root and, with 256 ranges, the inner nodes below it.
+        @param fetch returns the node with a hash, nullptr if unknown
+        @param hashes set to the hash of every range when nothing is missing
+        @param missing the nodes fetch didn't know
+        @return false if the nodes aren't those of a map
+    */
+    bool
+    rangeHashes(
+        SHAMapHash const& root,
+        Fetch const& fetch,
+        std::vector<SHAMapHash>& hashes,
+        std::vector<SHAMapNodeID>& missing) const;
+
+private:
+    struct Subtree
+    {
+        SHAMapHash hash;
+        std::size_t leaves = 0;
+    };
+
+    SHAMapHash
+    buildLeaf(Leaf const& leaf);
+
+    SHAMapHash
+    buildInner(int depth, Leaf const* begin, Leaf const* end);
+
+    SHAMapHash
+    writeInner(std::array<SHAMapHash, 16> const& hashes);
+
+    int const rangeDepth_;
+    Writer write_;
+    std::vector<Subtree> subtrees_;
+};
+
+}  // namespace ripple
+
+#endif
@@ -339,7 +339,7 @@ public:  // public only to SHAMap
     updateHash(CommonKey::HashType hashType = CommonKey::chainHashTypeG) override;
 
     boost::optional<uint256>
-    getStorageRoot();
+    getStorageRoot() const;
 };
 
 // SHAMapAbstractNode
@@ -20,20 +20,12 @@
 #ifndef RIPPLE_SHAMAP_TREENODECACHE_H_INCLUDED
 #define RIPPLE_SHAMAP_TREENODECACHE_H_INCLUDED
 
+#include <ripple/basics/ShardedTaggedCache.h>
 #include <ripple/shamap/SHAMapTreeNode.h>
-#include <shared_mutex>
 
 namespace ripple {
 
-using TreeNodeCache = TaggedCache<
-    uint256, 
-    SHAMapAbstractNode,
-    hardened_hash<>,
-    std::equal_to<uint256>,
-    std::shared_mutex,
-    std::shared_lock<std::shared_mutex>,
-    std::unique_lock<std::shared_mutex>
->;
+using TreeNodeCache = ShardedTaggedCache<uint256, SHAMapAbstractNode>;
 
 }  // namespace ripple
 
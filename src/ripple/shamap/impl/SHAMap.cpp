@@ -357,6 +357,56 @@ SHAMap::fetchNodeFromDB(SHAMapHash const& hash) const
     return node;
 }
 
+// Read the children of parents that are neither hooked up nor cached in one
+// batch, so a cold walk waits for the node store once per batch instead of
+// once per node. Missing children are left to the usual fetch.
+void
+SHAMap::prefetchChildren(std::vector<SHAMapInnerNode*> const& parents) const
+{
+    if (!backed_)
+        return;
+
+    std::vector<uint256> hashes;
+    for (auto parent : parents)
+    {
+        for (int branch = 0; branch < 16; ++branch)
+        {
+            if (parent->isEmptyBranch(branch) ||
+                parent->getChildPointer(branch))
+                continue;
+
+            auto const& hash = parent->getChildHash(branch);
+            if (!getCache(hash))
+                hashes.push_back(hash.as_uint256());
+        }
+    }
+
+    // A single read gains nothing from a batch
+    if (hashes.size() < 2)
+        return;
+
+    auto const objects = f_.db().fetchBatch(hashes, ledgerSeq_);
+    for (std::size_t i = 0; i < objects.size(); ++i)
+    {
+        if (!objects[i])
+            continue;
+
+        SHAMapHash const hash{hashes[i]};
+        try
+        {
+            auto node = SHAMapAbstractNode::makeFromPrefix(
+                makeSlice(objects[i]->getData()), hash);
+            if (node)
+                f_.getTreeNodeCache(ledgerSeq_)
+                    ->canonicalize_prefetch(hash.as_uint256(), node);
+        }
+        catch (std::exception const&)
+        {
+            JLOG(journal_.warn()) << "Invalid DB node " << hash;
+        }
+    }
+}
+
 // See if a sync filter has a node
 std::shared_ptr<SHAMapAbstractNode>
 SHAMap::checkFilter(SHAMapHash const& hash, SHAMapSyncFilter* filter) const
@@ -764,6 +814,14 @@ SHAMap::upper_bound(uint256 const& id) const
     // Get a const_iterator to the next item in the tree after a given item
     // item need not be in tree
     SharedPtrNodeStack stack;
+    if (auto leaf = peekUpperBound(id, stack))
+        return const_iterator(this, leaf->peekItem().get(), std::move(stack));
+    return end();
+}
+
+SHAMapTreeNode const*
+SHAMap::peekUpperBound(uint256 const& id, SharedPtrNodeStack& stack) const
+{
     walkTowardsKey(id, &stack);
     while (!stack.empty())
     {
@@ -772,8 +830,7 @@ SHAMap::upper_bound(uint256 const& id) const
         {
             auto leaf = static_cast<SHAMapTreeNode*>(node.get());
             if (leaf->peekItem()->key() > id)
-                return const_iterator(
-                    this, leaf->peekItem().get(), std::move(stack));
+                return leaf;
         }
         else
         {
@@ -787,14 +844,24 @@ SHAMap::upper_bound(uint256 const& id) const
                     auto leaf = firstBelow(node, stack, branch);
                     if (!leaf)
                         Throw<SHAMapMissingNode>(type_, id);
-                    return const_iterator(
-                        this, leaf->peekItem().get(), std::move(stack));
+                    return leaf;
                 }
             }
         }
         stack.pop();
     }
-    return end();
+    return nullptr;
+}
+
+void
+SHAMap::visitLeafNodes(
+    boost::optional<uint256> const& after,
+    std::function<bool(SHAMapTreeNode const&)> const& function) const
+{
+    SharedPtrNodeStack stack;
+    auto leaf = after ? peekUpperBound(*after, stack) : peekFirstItem(stack);
+    while (leaf && function(*leaf))
+        leaf = peekNextItem(leaf->peekItem()->key(), stack);
 }
 
 bool
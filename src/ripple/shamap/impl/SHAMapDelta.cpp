@@ -22,6 +22,9 @@
 
 namespace ripple {
 
+// Inner nodes whose missing children walkMap reads in one batch
+static constexpr std::size_t walkBatchSize = 16;
+
 // This code is used to compare another node's transaction tree
 // to our own. It returns a map containing all items that are different
 // between two SHA maps. It is optimized not to descend down tree
@@ -258,46 +261,64 @@ SHAMap::walkMap(std::vector<SHAMapMissingNode>& missingNodes, int maxMissing)
 
     nodeStack.push(std::static_pointer_cast<SHAMapInnerNode>(root_));
 
+    // Take the nodes a few at a time and read all their missing children in
+    // one batch: a cold walk is then bound by the throughput of the node
+    // store rather than by the latency of each read.
+    std::vector<std::shared_ptr<SHAMapInnerNode>> batch;
+    std::vector<SHAMapInnerNode*> parents;
+
     while (!nodeStack.empty())
     {
-        std::shared_ptr<SHAMapInnerNode> node = std::move(nodeStack.top());
-        nodeStack.pop();
+        batch.clear();
+        parents.clear();
+        while (!nodeStack.empty() && batch.size() < walkBatchSize)
+        {
+            batch.push_back(std::move(nodeStack.top()));
+            parents.push_back(batch.back().get());
+            nodeStack.pop();
+        }
+        prefetchChildren(parents);
 
-        for (int i = 0; i < 16; ++i)
+        for (auto& node : batch)
         {
-            if (!node->isEmptyBranch(i))
+            for (int i = 0; i < 16; ++i)
             {
-                std::shared_ptr<SHAMapAbstractNode> nextNode =
-                    descendNoStore(node, i);
-
-                if (nextNode)
+                if (!node->isEmptyBranch(i))
                 {
-                    if (nextNode->isInner())
-                        nodeStack.push(
-                            std::static_pointer_cast<SHAMapInnerNode>(
-                                nextNode));
-                    else if (nextNode->isContract())
+                    std::shared_ptr<SHAMapAbstractNode> nextNode =
+                        descendNoStore(node, i);
+
+                    if (nextNode)
                     {
-                        //Add storage root to stack,to do walk successively.
-                        auto treeNode =
-                            std::static_pointer_cast<SHAMapTreeNode>(nextNode);
-                        auto rootHash = treeNode->getStorageRoot();
-                        auto storageRoot = getContractRootNode(rootHash);
-                        if (storageRoot)
-                            nodeStack.push(storageRoot);
-                        else if (rootHash)
+                        if (nextNode->isInner())
+                            nodeStack.push(
+                                std::static_pointer_cast<SHAMapInnerNode>(
+                                    nextNode));
+                        else if (nextNode->isContract())
                         {
-                            missingNodes.emplace_back(type_, *rootHash);
-                            if (--maxMissing <= 0)
-                                return;
+                            //Add storage root to stack,to do walk successively.
+                            auto treeNode =
+                                std::static_pointer_cast<SHAMapTreeNode>(
+                                    nextNode);
+                            auto rootHash = treeNode->getStorageRoot();
+                            auto storageRoot = getContractRootNode(rootHash);
+                            if (storageRoot)
+                                nodeStack.push(storageRoot);
+                            else if (rootHash)
+                            {
+                                missingNodes.emplace_back(type_, *rootHash);
+                                if (--maxMissing <= 0)
+                                    return;
+                            }
                         }
                     }
-                }
-                else
-                {
-                    missingNodes.emplace_back(type_, node->getChildHash(i));
-                    if (--maxMissing <= 0)
-                        return;
+                    else
+                    {
+                        missingNodes.emplace_back(
+                            type_, node->getChildHash(i));
+                        if (--maxMissing <= 0)
+                            return;
+                    }
                 }
             }
         }
@@ -0,0 +1,252 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/basics/contract.h>
+#include <ripple/shamap/SHAMapLeafBuilder.h>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace ripple {
+
+// The branch a key takes below an inner node at the given depth
+static int
+selectBranch(uint256 const& key, int depth)
+{
+    int branch = *(key.begin() + (depth / 2));
+
+    if (depth & 1)
+        branch &= 0xf;
+    else
+        branch >>= 4;
+
+    return branch;
+}
+
+SHAMapLeafBuilder::SHAMapLeafBuilder(int rangeDepth, Writer write)
+    : rangeDepth_(rangeDepth)
+    , write_(std::move(write))
+    , subtrees_(rangeDepth == 1 ? 16 : 256)
+{
+    assert(rangeDepth == 1 || rangeDepth == 2);
+}
+
+std::size_t
+SHAMapLeafBuilder::rangeOf(uint256 const& key) const
+{
+    std::size_t const prefix = *key.begin();
+    return rangeDepth_ == 1 ? (prefix >> 4) : prefix;
+}
+
+uint256
+SHAMapLeafBuilder::first(std::size_t range) const
+{
+    uint256 key;
+    *key.begin() =
+        static_cast<unsigned char>(rangeDepth_ == 1 ? (range << 4) : range);
+    return key;
+}
+
+uint256
+SHAMapLeafBuilder::last(std::size_t range) const
+{
+    uint256 key;
+    std::memset(key.begin(), 0xff, key.size());
+    *key.begin() = static_cast<unsigned char>(
+        rangeDepth_ == 1 ? ((range << 4) | 0x0f) : range);
+    return key;
+}
+
+SHAMapHash
+SHAMapLeafBuilder::build(std::size_t range, std::vector<Leaf> const& leaves)
+{
+    assert(range < subtrees_.size());
+
+    Subtree subtree;
+    subtree.leaves = leaves.size();
+    if (leaves.size() == 1)
+        subtree.hash = buildLeaf(leaves.front());
+    else if (!leaves.empty())
+        subtree.hash = buildInner(
+            rangeDepth_, leaves.data(), leaves.data() + leaves.size());
+    subtrees_[range] = subtree;
+    return subtree.hash;
+}
+
+SHAMapHash
+SHAMapLeafBuilder::finish()
+{
+    std::vector<Subtree> level = subtrees_;
+
+    // Join the ranges of two nibbles into the inner nodes below the root.
+    // A single leaf hangs from the highest inner node it can.
+    while (level.size() > 16)
+    {
+        std::vector<Subtree> up(level.size() / 16);
+        for (std::size_t i = 0; i < up.size(); ++i)
+        {
+            std::array<SHAMapHash, 16> hashes;
+            for (int branch = 0; branch < 16; ++branch)
+            {
+                auto const& below = level[i * 16 + branch];
+                hashes[branch] = below.hash;
+                up[i].leaves += below.leaves;
+                if (below.leaves == 1)
+                    up[i].hash = below.hash;
+            }
+
+            if (up[i].leaves > 1)
+                up[i].hash = writeInner(hashes);
+        }
+        level.swap(up);
+    }
+
+    std::array<SHAMapHash, 16> hashes;
+    std::size_t leaves = 0;
+    for (int branch = 0; branch < 16; ++branch)
+    {
+        hashes[branch] = level[branch].hash;
+        leaves += level[branch].leaves;
+    }
+
+    if (leaves == 0)
+        return SHAMapHash{};
+
+    return writeInner(hashes);
+}
+
+bool
+SHAMapLeafBuilder::rangeHashes(
+    SHAMapHash const& root,
+    Fetch const& fetch,
+    std::vector<SHAMapHash>& hashes,
+    std::vector<SHAMapNodeID>& missing) const
+{
+    std::vector<SHAMapHash> ret(subtrees_.size());
+    missing.clear();
+    if (root.isZero())
+    {
+        hashes.swap(ret);
+        return true;
+    }
+
+    auto const top = fetch(root);
+    if (!top)
+    {
+        missing.push_back(SHAMapNodeID());
+        return true;
+    }
+    if (!top->isInner())
+        return false;
+    auto const& rootNode = static_cast<SHAMapInnerNode const&>(*top);
+
+    for (int branch = 0; branch < 16; ++branch)
+    {
+        if (rootNode.isEmptyBranch(branch))
+            continue;
+        auto const& hash = rootNode.getChildHash(branch);
+        if (rangeDepth_ == 1)
+        {
+            ret[branch] = hash;
+            continue;
+        }
+
+        auto const node = fetch(hash);
+        if (!node)
+        {
+            missing.push_back(SHAMapNodeID().getChildNodeID(branch));
+            continue;
+        }
+
+        // A single leaf below a branch of the root hangs from the root,
+        // it is all its range holds
+        if (node->isLeaf())
+        {
+            auto const range = rangeOf(node->key());
+            if (range / 16 != branch)
+                return false;
+            ret[range] = hash;
+            continue;
+        }
+
+        auto const& inner = static_cast<SHAMapInnerNode const&>(*node);
+        for (int i = 0; i < 16; ++i)
+        {
+            if (!inner.isEmptyBranch(i))
+                ret[branch * 16 + i] = inner.getChildHash(i);
+        }
+    }
+
+    if (missing.empty())
+        hashes.swap(ret);
+    return true;
+}
+
+SHAMapHash
+SHAMapLeafBuilder::buildLeaf(Leaf const& leaf)
+{
+    SHAMapTreeNode node(
+        leaf.item,
+        leaf.storageRoot ? SHAMapTreeNode::tnCONTRACT_STATE
+                         : SHAMapTreeNode::tnACCOUNT_STATE,
+        0,
+        leaf.storageRoot);
+    write_(node);
+    return node.getNodeHash();
+}
+
+SHAMapHash
+SHAMapLeafBuilder::buildInner(int depth, Leaf const* begin, Leaf const* end)
+{
+    // Two leaves can only share every nibble if they have the same key
+    if (depth >= 64)
+        Throw<std::runtime_error>("SHAMapLeafBuilder: duplicate key");
+
+    std::array<SHAMapHash, 16> hashes;
+    while (begin != end)
+    {
+        int const branch = selectBranch(begin->item->key(), depth);
+        auto const next = std::find_if(begin, end, [&](Leaf const& leaf) {
+            return selectBranch(leaf.item->key(), depth) != branch;
+        });
+
+        if (next - begin == 1)
+            hashes[branch] = buildLeaf(*begin);
+        else
+            hashes[branch] = buildInner(depth + 1, begin, next);
+        begin = next;
+    }
+
+    return writeInner(hashes);
+}
+
+SHAMapHash
+SHAMapLeafBuilder::writeInner(std::array<SHAMapHash, 16> const& hashes)
+{
+    Serializer s(512);
+    for (auto const& hash : hashes)
+        s.addBitString(hash.as_uint256());
+
+    auto const node =
+        SHAMapInnerNode::makeFullInner(s.slice(), 0, SHAMapHash{}, false);
+    write_(*node);
+    return node->getNodeHash();
+}
+
+}  // namespace ripple
@@ -58,6 +58,9 @@ SHAMap::visitNodes(
 
     while (1)
     {
+        if (pos == 0)
+            prefetchChildren({node.get()});
+
         while (pos < 16)
         {
             uint256 childHash;
@@ -598,6 +601,21 @@ SHAMap::addKnownNode(
     const SHAMapNodeID& node,
     Slice const& rawNode,
     SHAMapSyncFilter* filter)
+{
+    if (!isSynching())
+    {
+        JLOG(journal_.trace()) << "AddKnownNode while not synching";
+        return SHAMapAddNode::duplicate();
+    }
+
+    return addKnownNode(node, SHAMapAbstractNode::makeFromWire(rawNode), filter);
+}
+
+SHAMapAddNode
+SHAMap::addKnownNode(
+    const SHAMapNodeID& node,
+    std::shared_ptr<SHAMapAbstractNode> newNode,
+    SHAMapSyncFilter* filter)
 {
     // return value: true=okay, false=error
     assert(!node.isRoot());
@@ -609,7 +627,6 @@ SHAMap::addKnownNode(
     }
 
     auto const generation = f_.getFullBelowCache(ledgerSeq_)->getGeneration();
-    auto newNode = SHAMapAbstractNode::makeFromWire(rawNode);
     SHAMapNodeID iNodeID;
     auto iNode = root_.get();
 
@@ -470,7 +470,7 @@ SHAMapTreeNode::updateHash(CommonKey::HashType hashType)
 }
 
 boost::optional<uint256>
-SHAMapTreeNode::getStorageRoot()
+SHAMapTreeNode::getStorageRoot() const
 {
     return mStorageRoot;
 }
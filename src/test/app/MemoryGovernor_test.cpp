@@ -0,0 +1,122 @@
+//------------------------------------------------------------------------------
+/*
+ This file is part of chainsqld: https://github.com/chainsql/chainsqld
+ Copyright (c) 2016-2018 Peersafe Technology Co., Ltd.
+
+	chainsqld is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	chainsqld is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//==============================================================================
+
+
+#include <ripple/beast/unit_test.h>
+#include <ripple/core/Config.h>
+#include <ripple/core/ConfigSections.h>
+#include <peersafe/app/misc/MemoryGovernor.h>
+
+namespace ripple {
+namespace test {
+
+class MemoryGovernor_test : public beast::unit_test::suite
+{
+    // A cache that only counts lookups
+    struct FakeCache
+    {
+        int target;
+        std::uint64_t lookups = 0;
+        float hitRate = 0;
+
+        MemoryGovernor::Cache
+        governed(int base)
+        {
+            target = base;
+            return {
+                base,
+                [this] { return target; },
+                [this](int size) { target = size; },
+                [this] { return lookups; },
+                [this] { return hitRate; }};
+        }
+    };
+
+    void
+    testNoBudget()
+    {
+        testcase("no budget");
+
+        Config config;
+        MemoryGovernor governor(config, beast::Journal{beast::Journal::getNullSink()});
+
+        FakeCache a, b;
+        governor.add(SchemaID(1), "a", "tree_node", a.governed(1000));
+        governor.add(SchemaID(2), "b", "tree_node", b.governed(1000));
+
+        a.lookups = 5000;
+        a.hitRate = 90;
+        governor.rebalance();
+
+        // Without [memory_budget] every cache keeps its node_size
+        BEAST_EXPECT(a.target == 1000);
+        BEAST_EXPECT(b.target == 1000);
+
+        auto const json = governor.getJson();
+        BEAST_EXPECT(json["budget_schemas"].asInt() == 0);
+        BEAST_EXPECT(json["schemas"]["a"]["tree_node"]["size"].asInt() == 1000);
+        BEAST_EXPECT(json["schemas"]["a"]["tree_node"]["recent_hits"] == 2250);
+    }
+
+    void
+    testRebalance()
+    {
+        testcase("rebalance");
+
+        Config config;
+        config.overwrite(ConfigSection::memoryBudget(), "schemas", "1");
+        MemoryGovernor governor(config, beast::Journal{beast::Journal::getNullSink()});
+
+        FakeCache busy, idle;
+        governor.add(SchemaID(1), "busy", "tree_node", busy.governed(1000));
+        governor.add(SchemaID(2), "idle", "tree_node", idle.governed(1000));
+
+        // No hits yet, the budget of one schema is split evenly
+        governor.rebalance();
+        BEAST_EXPECT(busy.target == 500);
+        BEAST_EXPECT(idle.target == 500);
+
+        // Hits move everything but the floor to the busy schema
+        busy.lookups = 10000;
+        busy.hitRate = 80;
+        governor.rebalance();
+        BEAST_EXPECT(busy.target == 875);
+        BEAST_EXPECT(idle.target == 125);
+        BEAST_EXPECT(busy.target + idle.target <= 1000);
+
+        // Once a schema is gone the other one gets all it asked for
+        governor.remove(SchemaID(2));
+        governor.rebalance();
+        BEAST_EXPECT(busy.target == 1000);
+        BEAST_EXPECT(!governor.getJson()["schemas"].isMember("idle"));
+    }
+
+public:
+    void
+    run() override
+    {
+        testNoBudget();
+        testRebalance();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(MemoryGovernor, app, ripple);
+
+}  // namespace test
+}  // namespace ripple
@@ -0,0 +1,131 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012-2015 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/app/ledger/NodeRequestSizes.h>
+#include <ripple/basics/chrono.h>
+#include <ripple/beast/unit_test.h>
+
+namespace ripple {
+namespace test {
+
+class NodeRequestSizes_test : public beast::unit_test::suite
+{
+    void
+    testGrow()
+    {
+        testcase("grow");
+
+        using namespace std::chrono_literals;
+        TestStopwatch clock;
+        NodeRequestSizes sizes(128, 32, 512, 500ms, 1500ms);
+
+        // Peers start at the initial size
+        BEAST_EXPECT(sizes.limit(1) == 128);
+        BEAST_EXPECT(sizes.request(1, 1000, clock.now()) == 128);
+
+        // A full and fast answer doubles the next request
+        clock.advance(100ms);
+        BEAST_EXPECT(sizes.reply(1, 128, clock.now()));
+        BEAST_EXPECT(sizes.limit(1) == 256);
+
+        // Only one answer counts for a request
+        BEAST_EXPECT(!sizes.reply(1, 128, clock.now()));
+        BEAST_EXPECT(sizes.limit(1) == 256);
+
+        // Up to the maximum
+        for (int i = 0; i < 3; ++i)
+        {
+            BEAST_EXPECT(sizes.request(1, 1000, clock.now()) == sizes.limit(1));
+            clock.advance(100ms);
+            sizes.reply(1, sizes.limit(1), clock.now());
+        }
+        BEAST_EXPECT(sizes.limit(1) == 512);
+
+        // Other peers are sized on their own
+        BEAST_EXPECT(sizes.limit(2) == 128);
+        BEAST_EXPECT(!sizes.reply(2, 128, clock.now()));
+    }
+
+    void
+    testShrink()
+    {
+        testcase("shrink");
+
+        using namespace std::chrono_literals;
+        TestStopwatch clock;
+        NodeRequestSizes sizes(128, 32, 512, 500ms, 1500ms);
+
+        // A slow answer halves the next request
+        BEAST_EXPECT(sizes.request(1, 1000, clock.now()) == 128);
+        clock.advance(2s);
+        BEAST_EXPECT(sizes.reply(1, 128, clock.now()));
+        BEAST_EXPECT(sizes.limit(1) == 64);
+
+        // Down to the minimum
+        for (int i = 0; i < 3; ++i)
+        {
+            sizes.request(1, 1000, clock.now());
+            clock.advance(2s);
+            sizes.reply(1, 0, clock.now());
+        }
+        BEAST_EXPECT(sizes.limit(1) == 32);
+    }
+
+    void
+    testKeep()
+    {
+        testcase("keep");
+
+        using namespace std::chrono_literals;
+        TestStopwatch clock;
+        NodeRequestSizes sizes(128, 32, 512, 500ms, 1500ms);
+
+        // A fast answer with some of the nodes missing
+        sizes.request(1, 1000, clock.now());
+        clock.advance(100ms);
+        BEAST_EXPECT(sizes.reply(1, 100, clock.now()));
+        BEAST_EXPECT(sizes.limit(1) == 128);
+
+        // An answer in between
+        sizes.request(1, 1000, clock.now());
+        clock.advance(1s);
+        BEAST_EXPECT(sizes.reply(1, 128, clock.now()));
+        BEAST_EXPECT(sizes.limit(1) == 128);
+
+        // Asked for fewer than the limit, a full answer is all of those
+        BEAST_EXPECT(sizes.request(1, 10, clock.now()) == 10);
+        clock.advance(100ms);
+        BEAST_EXPECT(sizes.reply(1, 10, clock.now()));
+        BEAST_EXPECT(sizes.limit(1) == 256);
+    }
+
+public:
+    void
+    run() override
+    {
+        testGrow();
+        testShrink();
+        testKeep();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(NodeRequestSizes, app, ripple);
+
+}  // namespace test
+}  // namespace ripple
@@ -0,0 +1,244 @@
+//------------------------------------------------------------------------------
+/*
+ This file is part of chainsqld: https://github.com/chainsql/chainsqld
+ Copyright (c) 2016-2018 Peersafe Technology Co., Ltd.
+
+	chainsqld is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	chainsqld is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//==============================================================================
+
+#include <ripple/beast/unit_test.h>
+#include <ripple/json/json_reader.h>
+#include <peersafe/app/table/TableColumnCache.h>
+
+namespace ripple {
+namespace test {
+
+class TableColumnCache_test : public beast::unit_test::suite
+{
+    using ColumnTable = TableColumnCache::ColumnTable;
+
+    static Json::Value
+    parse(std::string const& s)
+    {
+        Json::Value v;
+        Json::Reader().parse(s, v);
+        return v;
+    }
+
+    void
+    fill(ColumnTable& t)
+    {
+        BEAST_EXPECT(t.define(parse(
+            R"([{"field":"id","type":"int","PK":1},)"
+            R"({"field":"name","type":"varchar","length":32},)"
+            R"({"field":"age","type":"int"},)"
+            R"({"field":"born","type":"datetime"}])")));
+        BEAST_EXPECT(t.insert(parse(
+            R"([{"id":1,"name":"alice","age":30},)"
+            R"({"id":2,"name":"bob","age":"25"},)"
+            R"({"id":3,"name":"Carol"},)"
+            R"({"id":4,"name":"dave","age":41}])")));
+        BEAST_EXPECT(t.rows() == 4);
+    }
+
+    void
+    testSelect()
+    {
+        testcase("select");
+        ColumnTable t;
+        fill(t);
+
+        // every column would include the datetime one, ask the DB
+        BEAST_EXPECT(!t.select(parse(R"([[]])"), 200));
+
+        auto r = t.select(
+            parse(R"([["id","age"],{"age":{"$gt":26}},)"
+                  R"({"$order":[{"age":"desc"}]}])"),
+            200);
+        BEAST_EXPECT(r && (*r)["lines"].size() == 2);
+        BEAST_EXPECT(r && (*r)["lines"][0u]["id"].asInt() == 4);
+        BEAST_EXPECT(r && (*r)["lines"][1u]["id"].asInt() == 1);
+
+        r = t.select(
+            parse(R"([["id"],{"id":{"$in":[1,3,5]}},)"
+                  R"({"$limit":{"index":1,"total":5}}])"),
+            200);
+        BEAST_EXPECT(r && (*r)["lines"].size() == 1);
+        BEAST_EXPECT(r && (*r)["lines"][0u]["id"].asInt() == 3);
+
+        // select_limit caps the rows returned
+        r = t.select(parse(R"([["id"]])"), 2);
+        BEAST_EXPECT(r && (*r)["lines"].size() == 2);
+
+        r = t.select(parse(R"([["name"],{"name":{"$regex":"/av/"}}])"), 200);
+        BEAST_EXPECT(r && (*r)["lines"].size() == 1);
+        BEAST_EXPECT(r && (*r)["lines"][0u]["name"].asString() == "dave");
+
+        r = t.select(
+            parse(R"j([["count(*)","count(age)","max(age)","min(name)"]])j"),
+            200);
+        BEAST_EXPECT(r && (*r)["lines"].size() == 1);
+        BEAST_EXPECT(r && (*r)["lines"][0u]["count(*)"].asInt() == 4);
+        BEAST_EXPECT(r && (*r)["lines"][0u]["count(age)"].asInt() == 3);
+        BEAST_EXPECT(r && (*r)["lines"][0u]["max(age)"].asInt() == 41);
+        BEAST_EXPECT(r && (*r)["lines"][0u]["min(name)"].asString() == "Carol");
+
+        // anything the cache does not know goes to the DB
+        BEAST_EXPECT(!t.select(parse(R"j([["id","count(*)"]])j"), 200));
+        BEAST_EXPECT(!t.select(parse(R"([["nope"]])"), 200));
+        BEAST_EXPECT(!t.select(parse(R"([["id"],{"born":"2020"}])"), 200));
+        BEAST_EXPECT(!t.select(parse(R"([["id"],{"$group":["age"]}])"), 200));
+    }
+
+    void
+    testOrder()
+    {
+        testcase("natural order");
+        ColumnTable t;
+        fill(t);
+
+        // without $order rows come back in primary key order, as the DB
+        // scans them, ties under $order as well
+        BEAST_EXPECT(t.insert(parse(R"([{"id":0,"name":"zed","age":30}])")));
+        auto r = t.select(parse(R"([["id"]])"), 200);
+        BEAST_EXPECT(r && (*r)["lines"].size() == 5);
+        BEAST_EXPECT(r && (*r)["lines"][0u]["id"].asInt() == 0);
+        BEAST_EXPECT(r && (*r)["lines"][4u]["id"].asInt() == 4);
+        r = t.select(parse(R"([["id"],{"$order":[{"age":"desc"}]}])"), 200);
+        BEAST_EXPECT(r && (*r)["lines"][1u]["id"].asInt() == 0);
+        BEAST_EXPECT(r && (*r)["lines"][2u]["id"].asInt() == 1);
+
+        // an index may answer the conditions in its own order
+        ColumnTable indexed;
+        BEAST_EXPECT(indexed.define(parse(
+            R"([{"field":"id","type":"int","PK":1},)"
+            R"({"field":"age","type":"int","index":1}])")));
+        BEAST_EXPECT(indexed.insert(parse(
+            R"([{"id":2,"age":30},{"id":1,"age":20},{"id":3,"age":30}])")));
+        BEAST_EXPECT(!indexed.select(parse(R"([["id"]])"), 200));
+        BEAST_EXPECT(
+            !indexed.select(parse(R"([["id"],{"$order":[{"age":"asc"}]}])"), 200));
+        r = indexed.select(parse(R"([["id"],{"$order":[{"id":"desc"}]}])"), 200);
+        BEAST_EXPECT(r && (*r)["lines"][0u]["id"].asInt() == 3);
+        r = indexed.select(parse(R"([["id"],{"age":20}])"), 200);
+        BEAST_EXPECT(r && (*r)["lines"].size() == 1);
+    }
+
+    void
+    testWrite()
+    {
+        testcase("write");
+        ColumnTable t;
+        fill(t);
+
+        BEAST_EXPECT(t.update(parse(R"([{"age":26},{"name":"bob"}])")));
+        auto r = t.select(parse(R"([["age"],{"id":2}])"), 200);
+        BEAST_EXPECT(r && (*r)["lines"][0u]["age"].asInt() == 26);
+
+        BEAST_EXPECT(t.erase(parse(R"([{"age":{"$ge":30}}])")));
+        BEAST_EXPECT(t.rows() == 2);
+        r = t.select(parse(R"([["id"],{"$order":[{"id":"asc"}]}])"), 200);
+        BEAST_EXPECT(r && (*r)["lines"].size() == 2);
+        BEAST_EXPECT(r && (*r)["lines"][0u]["id"].asInt() == 2);
+        BEAST_EXPECT(r && (*r)["lines"][1u]["id"].asInt() == 3);
+
+        // unknown column, value the DB would convert, missing primary key
+        BEAST_EXPECT(!t.insert(parse(R"([{"id":5,"x":1}])")));
+        BEAST_EXPECT(!t.update(parse(R"([{"age":"old"},{"id":2}])")));
+        BEAST_EXPECT(!t.insert(parse(R"([{"name":"eve","age":1}])")));
+
+        // the DB keeps its own form of opaque values, writes go through it
+        BEAST_EXPECT(!t.insert(parse(R"([{"id":6,"born":"2020-01-01"}])")));
+        BEAST_EXPECT(!t.update(parse(R"([{"born":"2020-01-01"},{"id":2}])")));
+    }
+
+    void
+    testMysql()
+    {
+        testcase("mysql semantics");
+        ColumnTable t(true);
+        fill(t);
+
+        auto r = t.select(parse(R"([["id"],{"name":"CAROL"}])"), 200);
+        BEAST_EXPECT(r && (*r)["lines"].size() == 1);
+
+        // trailing spaces count or not depending on the collation
+        BEAST_EXPECT(!t.select(parse(R"([["id"],{"name":"CAROL "}])"), 200));
+        BEAST_EXPECT(t.insert(parse(R"([{"id":5,"name":"eve "}])")));
+        BEAST_EXPECT(!t.select(parse(R"([["id"],{"name":"eve"}])"), 200));
+
+        // ordering and ranges follow the collation, left to the DB
+        BEAST_EXPECT(
+            !t.select(parse(R"([["id"],{"$order":[{"name":"asc"}]}])"), 200));
+        BEAST_EXPECT(
+            !t.select(parse(R"([["id"],{"name":{"$gt":"b"}}])"), 200));
+        BEAST_EXPECT(!t.select(parse(R"j([["sum(age)"]])j"), 200));
+    }
+
+    void
+    testProgram()
+    {
+        testcase("condition program");
+        ColumnTable t;
+        fill(t);
+
+        auto r = t.select2d(
+            parse(R"([["name","id"],{"$or":[{"age":{"$lt":26}},)"
+                  R"({"name":"dave"}]}])"),
+            200);
+        BEAST_EXPECT(r && r->size() == 2);
+        BEAST_EXPECT(r && (*r)[0].size() == 2);
+        BEAST_EXPECT(r && (*r)[0][0]["name"].asString() == "bob");
+        BEAST_EXPECT(r && (*r)[1][1]["id"].asInt() == 4);
+
+        conditionProgram program;
+        conditionProgram::Mask mask;
+        BEAST_EXPECT(program.compile(parse(R"([{"nope":1}])")).first == 0);
+        BEAST_EXPECT(!t.match(parse(R"([{"nope":1}])")));
+        BEAST_EXPECT(program.compile(parse(R"({"id":1})")).first != 0);
+
+        // kinds guessed from written values only trust equality
+        conditionRows rows(parse(R"([{"id":1,"name":"ab"},{"id":2,"name":"cd"}])"));
+        BEAST_EXPECT(rows.size() == 2);
+        BEAST_EXPECT(program.compile(parse(R"([{"id":{"$in":[2,3]}}])")).first == 0);
+        BEAST_EXPECT(program.eval(rows.size(), rows.lookup(), false, mask));
+        BEAST_EXPECT(mask == conditionProgram::Mask({0, 1}));
+        BEAST_EXPECT(program.compile(parse(R"([{"id":{"$gt":1}}])")).first == 0);
+        BEAST_EXPECT(!program.eval(rows.size(), rows.lookup(), false, mask));
+        BEAST_EXPECT(program.compile(parse(R"([{"name":{"$ne":"cd"}}])")).first == 0);
+        BEAST_EXPECT(program.eval(rows.size(), rows.lookup(), false, mask));
+        BEAST_EXPECT(mask == conditionProgram::Mask({1, 0}));
+        BEAST_EXPECT(!program.eval(rows.size(), rows.lookup(), true, mask));
+
+        conditionRows numeric(parse(R"([{"name":"12"}])"));
+        BEAST_EXPECT(program.compile(parse(R"([{"name":"12"}])")).first == 0);
+        BEAST_EXPECT(!program.eval(numeric.size(), numeric.lookup(), false, mask));
+    }
+
+public:
+    void
+    run() override
+    {
+        testSelect();
+        testOrder();
+        testWrite();
+        testMysql();
+        testProgram();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(TableColumnCache, app, ripple);
+
+}  // namespace test
+}  // namespace ripple
@@ -0,0 +1,277 @@
+//------------------------------------------------------------------------------
+/*
+ This file is part of chainsqld: https://github.com/chainsql/chainsqld
+ Copyright (c) 2016-2018 Peersafe Technology Co., Ltd.
+
+	chainsqld is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	chainsqld is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//==============================================================================
+
+#include <ripple/beast/unit_test.h>
+#include <ripple/core/SociDB.h>
+#include <ripple/json/json_reader.h>
+#include <peersafe/app/table/TableSnapshot.h>
+#include <sstream>
+
+namespace ripple {
+namespace test {
+
+class TableSnapshot_test : public beast::unit_test::suite
+{
+    using Header = TableSnapshot::Header;
+
+    static Json::Value
+    parse(std::string const& s)
+    {
+        Json::Value v;
+        Json::Reader().parse(s, v);
+        return v;
+    }
+
+    static Header
+    makeHeader()
+    {
+        Header h;
+        h.sDBType = "sqlite";
+        h.owner = AccountID(0x5e60);
+        h.sTableName = "users";
+        h.sNameInDB = "1C2F5E6095324E2E08838F221A72AB4F2A1B3C4D";
+        h.uLedgerSeq = 120;
+        h.uLedgerHash = uint256(1);
+        h.uTxnLedgerSeq = 110;
+        h.uTxnLedgerHash = uint256(2);
+        h.sTxnLedgerTime = "640000000";
+        h.vecColumns = {"id", "name", "data"};
+        h.vecTypes = {soci::dt_integer, soci::dt_string, soci::dt_blob};
+        return h;
+    }
+
+    static std::vector<Json::Value>
+    makeRows()
+    {
+        return {
+            parse(R"(["1","616C696365","00FF"])"),
+            parse(R"(["2","626F62",null])"),
+            parse(R"(["3",null,"0102"])")};
+    }
+
+    static std::string
+    write(Header const& h, std::vector<Json::Value> const& rows)
+    {
+        std::ostringstream out;
+        TableSnapshot::Writer writer(out, h);
+        for (auto const& row : rows)
+            writer.add(row);
+        writer.finish();
+        return out.str();
+    }
+
+    // reads the header and all the rows of s, returns the error if any
+    static std::string
+    read(std::string const& s)
+    {
+        std::istringstream in(s);
+        TableSnapshot::Reader reader(in);
+        Header h;
+        auto ret = reader.readHeader(h);
+        if (!ret.first)
+            return ret.second;
+        std::size_t n = 0;
+        ret = reader.readRows(h.vecColumns.size(), {}, n);
+        return ret.second;
+    }
+
+    void
+    testRoundTrip()
+    {
+        testcase("round trip");
+        auto const h = makeHeader();
+        auto const rows = makeRows();
+        auto const s = write(h, rows);
+
+        std::istringstream in(s);
+        TableSnapshot::Reader reader(in);
+        Header r;
+        BEAST_EXPECT(reader.readHeader(r).first);
+        BEAST_EXPECT(r.sDBType == h.sDBType);
+        BEAST_EXPECT(r.owner == h.owner);
+        BEAST_EXPECT(r.sTableName == h.sTableName);
+        BEAST_EXPECT(r.sNameInDB == h.sNameInDB);
+        BEAST_EXPECT(r.uLedgerSeq == h.uLedgerSeq);
+        BEAST_EXPECT(r.uLedgerHash == h.uLedgerHash);
+        BEAST_EXPECT(r.uTxnLedgerSeq == h.uTxnLedgerSeq);
+        BEAST_EXPECT(r.uTxnLedgerHash == h.uTxnLedgerHash);
+        BEAST_EXPECT(r.uTxnUpdateHash.isZero());
+        BEAST_EXPECT(r.sTxnLedgerTime == h.sTxnLedgerTime);
+        BEAST_EXPECT(r.vecColumns == h.vecColumns);
+        BEAST_EXPECT(r.vecTypes == h.vecTypes);
+
+        // Load reads the rows twice, once to check and once to insert
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            std::vector<Json::Value> got;
+            std::size_t n = 0;
+            auto const ret = reader.readRows(
+                r.vecColumns.size(),
+                [&](Json::Value const& row) {
+                    got.push_back(row);
+                    return std::string();
+                },
+                n);
+            BEAST_EXPECT(ret.first);
+            BEAST_EXPECT(n == rows.size());
+            BEAST_EXPECT(got == rows);
+        }
+
+        // an empty table still has a trailer
+        BEAST_EXPECT(read(write(h, {})).empty());
+
+        // an error of the callback stops the read
+        std::size_t n = 0;
+        auto const ret = reader.readRows(
+            r.vecColumns.size(),
+            [](Json::Value const&) { return std::string("stop"); },
+            n);
+        BEAST_EXPECT(!ret.first && ret.second == "stop" && n == 0);
+    }
+
+    void
+    testTruncated()
+    {
+        testcase("truncated");
+        auto const s = write(makeHeader(), makeRows());
+        BEAST_EXPECT(read(s).empty());
+
+        // without the trailer
+        auto const noTrailer = s.substr(0, s.rfind('\n', s.size() - 2) + 1);
+        BEAST_EXPECT(read(noTrailer) == "the snapshot is truncated.");
+
+        // in the middle of a row
+        BEAST_EXPECT(!read(noTrailer.substr(0, noTrailer.size() - 5)).empty());
+
+        // without the last row
+        auto const lastRow = noTrailer.rfind('\n', noTrailer.size() - 2) + 1;
+        auto const noLastRow =
+            noTrailer.substr(0, lastRow) + s.substr(noTrailer.size());
+        BEAST_EXPECT(
+            read(noLastRow) == "the snapshot doesn't match its trailer.");
+
+        // a changed value
+        auto changed = s;
+        changed.replace(changed.find("626F62"), 6, "626F63");
+        BEAST_EXPECT(read(changed) == "the snapshot doesn't match its trailer.");
+
+        // a row after the trailer
+        BEAST_EXPECT(
+            read(s + R"(["4","",null])" + "\n") ==
+            "data after the end of the snapshot.");
+
+        // a row with a missing column
+        auto shortRow = s;
+        shortRow.replace(shortRow.find(R"(,"0102")"), 7, "");
+        BEAST_EXPECT(!read(shortRow).empty());
+    }
+
+    void
+    testMalformedHeader()
+    {
+        testcase("malformed header");
+        auto const rows = makeRows();
+        BEAST_EXPECT(!read("").empty());
+        BEAST_EXPECT(!read("not json\n").empty());
+        BEAST_EXPECT(!read("[1,2,3]\n").empty());
+
+        auto const withHeader = [&](std::string const& from,
+                                    std::string const& to) {
+            auto s = write(makeHeader(), rows);
+            auto const pos = s.find(from);
+            BEAST_EXPECT(pos != std::string::npos && pos < s.find('\n'));
+            s.replace(pos, from.size(), to);
+            return read(s);
+        };
+        BEAST_EXPECT(!withHeader(R"("version":2)", R"("version":1)").empty());
+        BEAST_EXPECT(!withHeader(
+                          R"("owner":")" + toBase58(AccountID(0x5e60)),
+                          R"("owner":"nobody)")
+                          .empty());
+        BEAST_EXPECT(!withHeader(
+                          R"("name_in_db":"1C2F5E6095324E2E08838F221A72AB4F2A1B3C4D")",
+                          R"("name_in_db":"t_x; drop table t_y")")
+                          .empty());
+        BEAST_EXPECT(!withHeader(R"("name":"name")", R"("name":"na`me")")
+                          .empty());
+        BEAST_EXPECT(!withHeader(R"("type":)", R"("kind":)").empty());
+        BEAST_EXPECT(
+            !withHeader(R"("ledger_hash":")", R"("ledger_hash":"Z)").empty());
+
+        // a header changed with the rest of the file intact is caught by
+        // the trailer
+        auto const s = write(makeHeader(), rows);
+        auto changed = s;
+        changed.replace(changed.find(R"("users")"), 7, R"("other")");
+        BEAST_EXPECT(read(changed) == "the snapshot doesn't match its trailer.");
+    }
+
+    void
+    testWrongLedger()
+    {
+        testcase("wrong ledger");
+        auto const h = makeHeader();
+        auto const check = [&](LedgerIndex validIndex,
+                               std::string const& nameInDB,
+                               LedgerIndex createSeq,
+                               boost::optional<uint256> const& ledgerHash,
+                               boost::optional<LedgerIndex> const& txnSeq) {
+            return TableSnapshot::checkPosition(
+                       h, validIndex, nameInDB, createSeq, ledgerHash, txnSeq)
+                .first;
+        };
+        auto const name = h.sNameInDB;
+        auto const hash = h.uLedgerHash;
+
+        BEAST_EXPECT(check(200, name, 100, hash, h.uTxnLedgerSeq));
+        // the ledger isn't available here
+        BEAST_EXPECT(check(200, name, 100, boost::none, boost::none));
+
+        // another chain
+        BEAST_EXPECT(!check(200, name, 100, uint256(3), h.uTxnLedgerSeq));
+        // no validated ledger, or one before the snapshot
+        BEAST_EXPECT(!check(0, name, 100, hash, h.uTxnLedgerSeq));
+        BEAST_EXPECT(!check(119, name, 100, hash, h.uTxnLedgerSeq));
+        // the table was dropped and created again since
+        BEAST_EXPECT(!check(
+            200,
+            "0000000000000000000000000000000000000001",
+            100,
+            hash,
+            h.uTxnLedgerSeq));
+        BEAST_EXPECT(!check(200, name, 115, hash, h.uTxnLedgerSeq));
+        // the table has transactions the snapshot doesn't
+        BEAST_EXPECT(!check(200, name, 100, hash, h.uTxnLedgerSeq + 5));
+    }
+
+public:
+    void
+    run() override
+    {
+        testRoundTrip();
+        testTruncated();
+        testMalformedHeader();
+        testWrongLedger();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(TableSnapshot, app, ripple);
+
+}  // namespace test
+}  // namespace ripple
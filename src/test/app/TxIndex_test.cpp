@@ -0,0 +1,210 @@
+//------------------------------------------------------------------------------
+/*
+ This file is part of chainsqld: https://github.com/chainsql/chainsqld
+ Copyright (c) 2016-2018 Peersafe Technology Co., Ltd.
+
+	chainsqld is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	chainsqld is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//==============================================================================
+
+
+#include <ripple/beast/unit_test.h>
+#include <ripple/protocol/jss.h>
+#include <peersafe/app/sql/TxIndex.h>
+#include <peersafe/app/sql/TxnDBConn.h>
+#include <test/jtx.h>
+
+namespace ripple {
+namespace test {
+
+class TxIndex_test : public beast::unit_test::suite
+{
+    std::unique_ptr<TxIndex>
+    makeIndex()
+    {
+        Section section;
+        section.set("type", "memory");
+        return make_TxIndex(
+            section, "", beast::Journal{beast::Journal::getNullSink()});
+    }
+
+    // Ledgers 10..19, each with 3 transactions touching alice,
+    // the second one also touching bob.
+    void
+    fill(TxIndex& index, AccountID const& alice, AccountID const& bob)
+    {
+        for (LedgerIndex seq = 10; seq < 20; ++seq)
+        {
+            std::vector<TxIndex::Transaction> txs;
+            for (std::uint32_t i = 0; i < 3; ++i)
+            {
+                TxIndex::Transaction tx{uint256(seq * 10 + i), i, {alice}};
+                if (i == 1)
+                    tx.accounts.push_back(bob);
+                txs.push_back(tx);
+            }
+            index.saveLedger(seq, txs);
+        }
+    }
+
+    void
+    testPaging()
+    {
+        testcase("paging");
+
+        auto index = makeIndex();
+        AccountID const alice(1), bob(2);
+        fill(*index, alice, bob);
+
+        auto loc = index->getLocation(uint256(151));
+        BEAST_EXPECT(loc && loc->ledgerSeq == 15 && loc->txnSeq == 1);
+        BEAST_EXPECT(!index->getLocation(uint256(5)));
+
+        // Forward through all of alice's transactions, 7 at a time
+        boost::optional<TxIndex::Location> marker;
+        std::vector<TxIndex::Entry> all;
+        do
+        {
+            auto page = index->getAccountTxs(alice, 0, 100, true, marker, 7);
+            BEAST_EXPECT(page.size() <= 7);
+            all.insert(all.end(), page.begin(), page.end());
+        } while (marker);
+        BEAST_EXPECT(all.size() == 30);
+        BEAST_EXPECT(all.front().id == uint256(100));
+        BEAST_EXPECT(all.back().id == uint256(192));
+        for (std::size_t i = 1; i < all.size(); ++i)
+            BEAST_EXPECT(all[i - 1].id < all[i].id);
+
+        // Backward within a ledger range
+        auto page = index->getAccountTxs(bob, 12, 14, false, marker, 2);
+        BEAST_EXPECT(page.size() == 2);
+        BEAST_EXPECT(page[0].ledgerSeq == 14 && page[1].ledgerSeq == 13);
+        BEAST_EXPECT(marker && marker->ledgerSeq == 12);
+        page = index->getAccountTxs(bob, 12, 14, false, marker, 2);
+        BEAST_EXPECT(page.size() == 1 && page[0].id == uint256(121));
+        BEAST_EXPECT(!marker);
+    }
+
+    void
+    testSaveAgainAndDelete()
+    {
+        testcase("save again and delete");
+
+        auto index = makeIndex();
+        AccountID const alice(1), bob(2);
+        fill(*index, alice, bob);
+
+        // Saving a ledger again replaces what it indexed
+        index->saveLedger(12, {{uint256(999), 0, {bob}}});
+        BEAST_EXPECT(!index->getLocation(uint256(121)));
+        BEAST_EXPECT(index->getLocation(uint256(999))->ledgerSeq == 12);
+        boost::optional<TxIndex::Location> marker;
+        BEAST_EXPECT(
+            index->getAccountTxs(alice, 12, 12, true, marker, 10).empty());
+        BEAST_EXPECT(
+            index->getAccountTxs(bob, 12, 12, true, marker, 10).size() == 1);
+
+        index->deleteBefore(15);
+        BEAST_EXPECT(!index->getLocation(uint256(999)));
+        BEAST_EXPECT(!index->getLocation(uint256(140)));
+        BEAST_EXPECT(index->getLocation(uint256(150)));
+        auto const rest = index->getAccountTxs(alice, 0, 100, true, marker, 100);
+        BEAST_EXPECT(rest.size() == 15);
+        BEAST_EXPECT(rest.front().ledgerSeq == 15);
+    }
+
+    // Hashes of the account_tx pages of account, limit at a time
+    std::vector<std::string>
+    pageAll(jtx::Env& env, jtx::Account const& account, bool forward)
+    {
+        std::vector<std::string> hashes;
+        Json::Value params;
+        params[jss::account] = account.human();
+        params[jss::limit] = 3;
+        params[jss::forward] = forward;
+        for (int pages = 0; pages < 20; ++pages)
+        {
+            auto const result =
+                env.rpc("json", "account_tx", to_string(params))[jss::result];
+            if (!BEAST_EXPECT(result[jss::status] == "success"))
+                break;
+            BEAST_EXPECT(result[jss::transactions].size() <= 3);
+            for (auto const& tx : result[jss::transactions])
+                hashes.push_back(tx[jss::tx][jss::hash].asString());
+            if (!result.isMember(jss::marker))
+                break;
+            params[jss::marker] = result[jss::marker];
+        }
+        return hashes;
+    }
+
+    void
+    testPopulated()
+    {
+        testcase("enabled on a populated database");
+
+        using namespace jtx;
+        Env env{*this};
+        Account const alice{"alice"};
+        env.fund(ZXC(10000), alice);
+        env.close();
+        for (int i = 0; i < 4; ++i)
+        {
+            env(pay(env.master, alice, ZXC(1)));
+            env.close();
+        }
+        auto const before = pageAll(env, alice, true);
+        BEAST_EXPECT(before.size() >= 5);
+
+        // These ledgers are only in SQL
+        auto& txnDB = env.app().getTxnDB();
+        txnDB.setTxIndex(makeIndex());
+        BEAST_EXPECT(
+            txnDB.txIndex()->firstLedger() == env.closed()->info().seq + 1);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            env(pay(env.master, alice, ZXC(1)));
+            env.close();
+        }
+
+        auto const forward = pageAll(env, alice, true);
+        BEAST_EXPECT(forward.size() == before.size() + 4);
+        BEAST_EXPECT(std::equal(before.begin(), before.end(), forward.begin()));
+
+        auto backward = pageAll(env, alice, false);
+        std::reverse(backward.begin(), backward.end());
+        BEAST_EXPECT(backward == forward);
+
+        // Found below and above the first indexed ledger
+        for (auto const& hash : {forward.front(), forward.back()})
+        {
+            auto const result = env.rpc("tx", hash)[jss::result];
+            BEAST_EXPECT(result[jss::hash] == hash);
+        }
+    }
+
+public:
+    void
+    run() override
+    {
+        testPaging();
+        testSaveAgainAndDelete();
+        testPopulated();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(TxIndex, app, ripple);
+
+}  // namespace test
+}  // namespace ripple
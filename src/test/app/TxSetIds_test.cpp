@@ -0,0 +1,168 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012-2015 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/app/ledger/InboundTransactions.h>
+#include <ripple/beast/unit_test.h>
+#include <ripple/protocol/STTx.h>
+#include <test/jtx/Account.h>
+#include <test/shamap/common.h>
+#include <test/unit_test/SuiteJournal.h>
+
+namespace ripple {
+namespace test {
+
+class TxSetIds_test : public beast::unit_test::suite
+{
+    static std::shared_ptr<STTx const>
+    makeTx(std::uint32_t seq)
+    {
+        return std::make_shared<STTx const>(ttPAYMENT, [seq](STObject& obj) {
+            obj.setAccountID(sfAccount, jtx::Account("alice").id());
+            obj.setAccountID(sfDestination, jtx::Account("bob").id());
+            obj.setFieldU32(sfSequence, seq);
+            obj.setFieldAmount(sfFee, STAmount(10));
+            obj.setFieldAmount(sfAmount, STAmount(1000));
+        });
+    }
+
+    // The hash of the set of txs, built the way a peer builds it
+    static uint256
+    setHash(
+        std::vector<std::shared_ptr<STTx const>> const& txs,
+        Family& family)
+    {
+        SHAMap map(SHAMapType::TRANSACTION, family);
+        map.setUnbacked();
+        for (auto const& tx : txs)
+        {
+            Serializer s;
+            tx->add(s);
+            map.addItem(
+                SHAMapItem(tx->getTransactionID(), std::move(s)), true, false);
+        }
+        return map.getHash().as_uint256();
+    }
+
+    static TxSetTxs
+    wanted(uint256 const& hash, std::vector<std::shared_ptr<STTx const>> txs)
+    {
+        TxSetTxs ids;
+        for (auto const& tx : txs)
+            ids.emplace(txSetShortId(hash, tx->getTransactionID()), nullptr);
+        return ids;
+    }
+
+    void
+    testShortId()
+    {
+        testcase("short id");
+
+        auto const a = makeTx(1)->getTransactionID();
+        auto const b = makeTx(2)->getTransactionID();
+        uint256 const set1(1);
+        uint256 const set2 = ~set1;
+
+        BEAST_EXPECT(txSetShortId(set1, a) == txSetShortId(set1, a));
+        BEAST_EXPECT(txSetShortId(set1, a) != txSetShortId(set1, b));
+
+        // Keyed by the set, so the ids change from one set to the next
+        BEAST_EXPECT(txSetShortId(set1, a) != txSetShortId(set2, a));
+    }
+
+    void
+    testMatch(Family& family)
+    {
+        testcase("match");
+
+        std::vector<std::shared_ptr<STTx const>> txs;
+        for (std::uint32_t seq = 1; seq <= 12; ++seq)
+            txs.push_back(makeTx(seq));
+        std::vector<std::shared_ptr<STTx const>> const set(
+            txs.begin(), txs.begin() + 8);
+        auto const hash = setHash(set, family);
+
+        // The pool has six of the set and four txs that are not in it
+        std::vector<std::shared_ptr<STTx const>> pool(
+            txs.begin() + 2, txs.end());
+        auto ids = wanted(hash, set);
+        BEAST_EXPECT(
+            matchTxSetIds(hash, ids, [&](auto&& f) {
+                for (auto const& tx : pool)
+                    f(tx);
+            }) == 2);
+        for (auto const& tx : set)
+        {
+            auto const& found =
+                ids.at(txSetShortId(hash, tx->getTransactionID()));
+            BEAST_EXPECT(found == (tx->getSequence() > 2 ? tx : nullptr));
+        }
+
+        // Two pool txs with the short id of one in the set can't tell
+        // which of them it is, so it is left for the peer to send
+        auto const twin = std::make_shared<STTx const>(*set[4]);
+        ids = wanted(hash, set);
+        BEAST_EXPECT(
+            matchTxSetIds(hash, ids, [&](auto&& f) {
+                for (auto const& tx : pool)
+                    f(tx);
+                f(twin);
+            }) == 3);
+        BEAST_EXPECT(!ids.at(txSetShortId(hash, set[4]->getTransactionID())));
+    }
+
+    void
+    testBuild(Family& family)
+    {
+        testcase("build");
+
+        std::vector<std::shared_ptr<STTx const>> set;
+        for (std::uint32_t seq = 1; seq <= 8; ++seq)
+            set.push_back(makeTx(seq));
+        auto const hash = setHash(set, family);
+
+        TxSetTxs ids;
+        for (auto const& tx : set)
+            ids.emplace(txSetShortId(hash, tx->getTransactionID()), tx);
+
+        auto const map = buildTxSet(hash, ids, family);
+        BEAST_EXPECT(map && map->getHash().as_uint256() == hash);
+
+        // A short id matched with the wrong tx gives another root, and the
+        // acquire falls back to fetching the set by nodes
+        ids.begin()->second = makeTx(100);
+        BEAST_EXPECT(!buildTxSet(hash, ids, family));
+    }
+
+public:
+    void
+    run() override
+    {
+        SuiteJournal journal("TxSetIds_test", *this);
+        tests::TestNodeFamily family(journal);
+
+        testShortId();
+        testMatch(family);
+        testBuild(family);
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(TxSetIds, app, ripple);
+
+}  // namespace test
+}  // namespace ripple
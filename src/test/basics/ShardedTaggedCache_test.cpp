@@ -0,0 +1,303 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/basics/ShardedTaggedCache.h>
+#include <ripple/basics/chrono.h>
+#include <ripple/beast/clock/manual_clock.h>
+#include <ripple/beast/unit_test.h>
+#include <test/unit_test/SuiteJournal.h>
+#include <thread>
+
+namespace ripple {
+
+class ShardedTaggedCache_test : public beast::unit_test::suite
+{
+public:
+    using Key = int;
+    using Value = std::string;
+    using Cache = ShardedTaggedCache<Key, Value>;
+
+    void
+    testBasics(beast::Journal journal)
+    {
+        testcase("basics");
+
+        using namespace std::chrono_literals;
+        TestStopwatch clock;
+        clock.set(0);
+
+        Cache c("test", 1, 1s, clock, journal);
+
+        // Insert an item, retrieve it, and age it so it gets purged.
+        {
+            BEAST_EXPECT(c.getCacheSize() == 0);
+            BEAST_EXPECT(c.getTrackSize() == 0);
+            BEAST_EXPECT(!c.insert(1, "one"));
+            BEAST_EXPECT(c.getCacheSize() == 1);
+            BEAST_EXPECT(c.getTrackSize() == 1);
+
+            {
+                std::string s;
+                BEAST_EXPECT(c.retrieve(1, s));
+                BEAST_EXPECT(s == "one");
+            }
+
+            ++clock;
+            c.sweep();
+            BEAST_EXPECT(c.getCacheSize() == 0);
+            BEAST_EXPECT(c.getTrackSize() == 0);
+        }
+
+        // Keep a strong pointer, age the entry and verify that it is
+        // still tracked until the pointer is gone.
+        {
+            BEAST_EXPECT(!c.insert(2, "two"));
+
+            {
+                auto p = c.fetch(2);
+                BEAST_EXPECT(p != nullptr);
+                ++clock;
+                c.sweep();
+                BEAST_EXPECT(c.getCacheSize() == 0);
+                BEAST_EXPECT(c.getTrackSize() == 1);
+
+                // Canonicalizing a new object gives back the original
+                auto p2 = std::make_shared<Value>("two");
+                BEAST_EXPECT(c.canonicalize_replace_client(2, p2));
+                BEAST_EXPECT(c.getCacheSize() == 1);
+                BEAST_EXPECT(p.get() == p2.get());
+            }
+
+            ++clock;
+            c.sweep();
+            ++clock;
+            c.sweep();
+            BEAST_EXPECT(c.getCacheSize() == 0);
+            BEAST_EXPECT(c.getTrackSize() == 0);
+        }
+
+        // Delete and replace entries
+        {
+            BEAST_EXPECT(!c.insert(3, "three"));
+            BEAST_EXPECT(c.del(3, false));
+            BEAST_EXPECT(c.getTrackSize() == 0);
+            BEAST_EXPECT(!c.refreshIfPresent(3));
+
+            BEAST_EXPECT(!c.insert(4, "four"));
+            auto const p = std::make_shared<Value>("FOUR");
+            BEAST_EXPECT(c.canonicalize_replace_cache(4, p));
+            BEAST_EXPECT(c.fetch(4) == p);
+            BEAST_EXPECT(c.getKeys() == std::vector<Key>{4});
+            c.reset();
+            BEAST_EXPECT(c.getTrackSize() == 0);
+            BEAST_EXPECT(c.getLookups() == 0);
+        }
+    }
+
+    void
+    testScanResistance(beast::Journal journal)
+    {
+        testcase("scan resistance");
+
+        using namespace std::chrono_literals;
+        TestStopwatch clock;
+        clock.set(0);
+
+        Cache c(
+            "test",
+            10,
+            60s,
+            clock,
+            journal,
+            beast::insight::NullCollector::New(),
+            1);
+
+        // The hot set is looked up again after it is inserted
+        for (Key k = 0; k < 10; ++k)
+        {
+            c.insert(k, std::to_string(k));
+            BEAST_EXPECT(c.fetch(k) != nullptr);
+        }
+
+        // A scan touches every entry of a larger data set once
+        clock.advance(2s);
+        for (Key k = 100; k < 120; ++k)
+            c.insert(k, std::to_string(k));
+        BEAST_EXPECT(c.getCacheSize() == 30);
+
+        // The scan is evicted first, the hot set survives
+        clock.advance(2s);
+        c.sweep();
+        BEAST_EXPECT(c.getCacheSize() == 10);
+        for (Key k = 0; k < 10; ++k)
+            BEAST_EXPECT(c.fetch(k) != nullptr);
+
+        // Within the target size cold entries only age out
+        c.setTargetSize(20);
+        c.insert(2000, "cold");
+        clock.advance(2s);
+        c.sweep();
+        BEAST_EXPECT(c.getCacheSize() == 11);
+        clock.advance(60s);
+        c.sweep();
+        BEAST_EXPECT(c.getCacheSize() == 0);
+    }
+
+    void
+    testAgeCompression(beast::Journal journal)
+    {
+        testcase("age compression");
+
+        using namespace std::chrono_literals;
+        TestStopwatch clock;
+        clock.set(0);
+
+        Cache c(
+            "test",
+            10,
+            60s,
+            clock,
+            journal,
+            beast::insight::NullCollector::New(),
+            1);
+
+        // Four times the target size cuts the age down to 15s, even for
+        // the entries that are in use
+        for (Key k = 0; k < 40; ++k)
+        {
+            c.insert(k, std::to_string(k));
+            BEAST_EXPECT(c.fetch(k) != nullptr);
+        }
+        clock.advance(14s);
+        c.sweep();
+        BEAST_EXPECT(c.getCacheSize() == 40);
+        for (Key k = 0; k < 40; ++k)
+            BEAST_EXPECT(c.fetch(k) != nullptr);
+        clock.advance(16s);
+        c.sweep();
+        BEAST_EXPECT(c.getCacheSize() == 0);
+
+        // The age is never cut below a second
+        for (Key k = 0; k < 2000; ++k)
+        {
+            c.insert(k, std::to_string(k));
+            BEAST_EXPECT(c.fetch(k) != nullptr);
+        }
+        clock.advance(500ms);
+        c.sweep();
+        BEAST_EXPECT(c.getCacheSize() == 2000);
+        clock.advance(500ms);
+        c.sweep();
+        BEAST_EXPECT(c.getCacheSize() == 0);
+    }
+
+    void
+    testPrefetch(beast::Journal journal)
+    {
+        testcase("prefetch");
+
+        using namespace std::chrono_literals;
+        TestStopwatch clock;
+        clock.set(0);
+
+        Cache c(
+            "test",
+            10,
+            60s,
+            clock,
+            journal,
+            beast::insight::NullCollector::New(),
+            1);
+
+        // A batch read ahead, each entry then looked up for the walk
+        for (Key k = 0; k < 20; ++k)
+        {
+            auto p = std::make_shared<Value>(std::to_string(k));
+            BEAST_EXPECT(!c.canonicalize_prefetch(k, p));
+        }
+        for (Key k = 0; k < 20; ++k)
+            BEAST_EXPECT(c.fetch(k) != nullptr);
+
+        // Reading an entry ahead again gives back the tracked object
+        {
+            auto const p = c.fetch(0);
+            auto p2 = std::make_shared<Value>("0");
+            BEAST_EXPECT(c.canonicalize_prefetch(0, p2));
+            BEAST_EXPECT(p.get() == p2.get());
+        }
+
+        // Only the entries looked up again are hot
+        for (Key k = 0; k < 5; ++k)
+            BEAST_EXPECT(c.fetch(k) != nullptr);
+
+        clock.advance(2s);
+        c.sweep();
+        BEAST_EXPECT(c.getCacheSize() == 5);
+        for (Key k = 0; k < 5; ++k)
+            BEAST_EXPECT(c.fetch(k) != nullptr);
+    }
+
+    void
+    testConcurrency(beast::Journal journal)
+    {
+        testcase("concurrency");
+
+        using namespace std::chrono_literals;
+        TestStopwatch clock;
+        clock.set(0);
+
+        Cache c("test", 1000, 60s, clock, journal);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+            threads.emplace_back([&c, t] {
+                for (Key k = 0; k < 1000; ++k)
+                {
+                    auto p = std::make_shared<Value>(std::to_string(k));
+                    c.canonicalize_replace_client(k, p);
+                    if (!c.fetch(k) || *p != std::to_string(k))
+                        return;
+                    if (k % 100 == t)
+                        c.sweep();
+                }
+            });
+        for (auto& t : threads)
+            t.join();
+
+        BEAST_EXPECT(c.getCacheSize() == 1000);
+        BEAST_EXPECT(c.getTrackSize() == 1000);
+        BEAST_EXPECT(c.getKeys().size() == 1000);
+        BEAST_EXPECT(c.getLookups() == 4000);
+    }
+
+    void
+    run() override
+    {
+        test::SuiteJournal journal("ShardedTaggedCache_test", *this);
+        testBasics(journal);
+        testScanResistance(journal);
+        testAgeCompression(journal);
+        testPrefetch(journal);
+        testConcurrency(journal);
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(ShardedTaggedCache, common, ripple);
+
+}  // namespace ripple
@@ -17,9 +17,15 @@
 */
 //==============================================================================
 
+#include <ripple/basics/contract.h>
 #include <ripple/beast/unit_test.h>
 #include <ripple/core/JobQueue.h>
 #include <test/jtx/Env.h>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
 
 namespace ripple {
 namespace test {
@@ -154,12 +160,236 @@ class JobQueue_test : public beast::unit_test::suite
         }
     }
 
+    void
+    testSchemaFairness()
+    {
+        jtx::Env env{*this};
+
+        JobQueue& jQueue = env.app().getJobQueue();
+        jQueue.setThreadCount(0, true);
+
+        JobCounter light;
+        JobCounter heavy;
+        jQueue.addSchema(light, "light", 1, 0);
+        jQueue.addSchema(heavy, "heavy", 3, 0);
+
+        // Hold the only worker so that the jobs below are queued together
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool release = false;
+        std::atomic<bool> holding{false};
+        jQueue.addJob(jtCLIENT, "SchemaHold", [&](Job&) {
+            holding = true;
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return release; });
+        });
+        while (!holding)
+            ;
+
+        std::vector<std::string> order;
+        for (int i = 0; i < 8; ++i)
+        {
+            jQueue.addJob(
+                jtCLIENT,
+                "SchemaLight",
+                [&](Job&) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    order.push_back("light");
+                },
+                light);
+        }
+        for (int i = 0; i < 8; ++i)
+        {
+            jQueue.addJob(
+                jtCLIENT,
+                "SchemaHeavy",
+                [&](Job&) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    order.push_back("heavy");
+                },
+                heavy);
+        }
+
+        auto const queued = jQueue.getSchemaJson();
+        BEAST_EXPECT(queued["light"]["waiting"].asInt() == 8);
+        BEAST_EXPECT(queued["heavy"]["waiting"].asInt() == 8);
+        BEAST_EXPECT(queued["heavy"]["weight"].asInt() == 3);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            release = true;
+        }
+        cv.notify_all();
+        jQueue.rendezvous();
+
+        // The heavy schema gets three jobs for each light one although
+        // all the light jobs were queued first.
+        BEAST_EXPECT(order.size() == 16);
+        BEAST_EXPECT(
+            std::count(order.begin(), order.begin() + 8, "heavy") == 6);
+
+        auto const done = jQueue.getSchemaJson();
+        BEAST_EXPECT(done["light"]["dispatched"].asUInt() == 8);
+        BEAST_EXPECT(done["heavy"]["waiting"].asInt() == 0);
+
+        jQueue.removeSchema(light);
+        jQueue.removeSchema(heavy);
+        BEAST_EXPECT(!jQueue.getSchemaJson().isMember("light"));
+    }
+
+    void
+    testSchemaLimit()
+    {
+        jtx::Env env{*this};
+
+        JobQueue& jQueue = env.app().getJobQueue();
+        jQueue.setThreadCount(4, false);
+
+        JobCounter limited;
+        jQueue.addSchema(limited, "limited", 1, 1);
+
+        std::atomic<int> running{0};
+        std::atomic<int> peak{0};
+        std::atomic<int> finished{0};
+        for (int i = 0; i < 8; ++i)
+        {
+            jQueue.addJob(
+                jtCLIENT,
+                "SchemaLimit",
+                [&](Job&) {
+                    int const now = ++running;
+                    int old = peak;
+                    while (old < now && !peak.compare_exchange_weak(old, now))
+                        ;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                    --running;
+                    ++finished;
+                },
+                limited);
+        }
+        while (finished < 8)
+            ;
+
+        // Never more than one job of the schema at once
+        BEAST_EXPECT(peak == 1);
+        BEAST_EXPECT(
+            jQueue.getSchemaJson()["limited"]["max_running"].asInt() == 1);
+
+        jQueue.removeSchema(limited);
+    }
+
+    void
+    testConcurrentAdd()
+    {
+        jtx::Env env{*this};
+
+        JobQueue& jQueue = env.app().getJobQueue();
+        jQueue.setThreadCount(4, false);
+
+        // Jobs added from several threads at once all run, and a type
+        // never runs more jobs at once than its limit.
+        int const limit = JobTypes::instance().get(jtLEDGER_DATA).limit();
+        std::atomic<int> running{0};
+        std::atomic<int> peak{0};
+        std::atomic<int> finished{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&] {
+                for (int i = 0; i < 250; ++i)
+                {
+                    jQueue.addJob(jtLEDGER_DATA, "ConcurrentAdd", [&](Job&) {
+                        int const now = ++running;
+                        int old = peak;
+                        while (old < now &&
+                               !peak.compare_exchange_weak(old, now))
+                            ;
+                        --running;
+                        ++finished;
+                    });
+                    jQueue.addJob(jtCLIENT, "ConcurrentAdd", [&](Job&) {
+                        ++finished;
+                    });
+                }
+            });
+        }
+        // Waiting while other threads still add jobs neither hangs nor
+        // returns with a counted job left behind.
+        for (int i = 0; i < 10; ++i)
+            jQueue.rendezvous();
+        for (auto& thread : threads)
+            thread.join();
+        jQueue.rendezvous();
+
+        BEAST_EXPECT(finished == 2000);
+        BEAST_EXPECT(peak <= limit);
+        BEAST_EXPECT(jQueue.getJobCountTotal(jtLEDGER_DATA) == 0);
+    }
+
+    void
+    testParallelFor()
+    {
+        jtx::Env env{*this};
+
+        JobQueue& jQueue = env.app().getJobQueue();
+        jQueue.setThreadCount(4, false);
+
+        // Every index is visited exactly once before parallelFor returns
+        std::vector<std::atomic<int>> visits(1000);
+        jQueue.parallelFor(
+            jtCONTRACT_FLUSH,
+            "ParallelFor",
+            visits.size(),
+            [&](std::size_t i) { ++visits[i]; },
+            jQueue.jobCounter());
+        BEAST_EXPECT(std::all_of(
+            visits.begin(), visits.end(), [](auto const& v) {
+                return v == 1;
+            }));
+
+        // Nothing to do returns at once
+        jQueue.parallelFor(
+            jtCONTRACT_FLUSH,
+            "ParallelFor",
+            0,
+            [&](std::size_t) { fail(); },
+            jQueue.jobCounter());
+
+        // A throwing item does not stop the others, and the exception
+        // reaches the caller once all of them are done
+        std::atomic<int> calls{0};
+        try
+        {
+            jQueue.parallelFor(
+                jtCONTRACT_FLUSH,
+                "ParallelFor",
+                100,
+                [&](std::size_t i) {
+                    ++calls;
+                    if (i % 10 == 3)
+                        Throw<std::runtime_error>("parallelFor");
+                },
+                jQueue.jobCounter());
+            fail("no exception");
+        }
+        catch (std::runtime_error const& e)
+        {
+            BEAST_EXPECT(std::string(e.what()) == "parallelFor");
+        }
+        BEAST_EXPECT(calls == 100);
+        jQueue.rendezvous();
+    }
+
 public:
     void
     run() override
     {
         testAddJob();
         testPostCoro();
+        testSchemaFairness();
+        testSchemaLimit();
+        testConcurrentAdd();
+        testParallelFor();
     }
 };
 
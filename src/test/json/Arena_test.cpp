@@ -0,0 +1,150 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/beast/unit_test.h>
+#include <ripple/json/Arena.h>
+#include <ripple/json/json_value.h>
+#include <ripple/json/json_writer.h>
+#include <ripple/json/to_string.h>
+#include <string>
+#include <thread>
+
+namespace Json {
+
+class Arena_test : public beast::unit_test::suite
+{
+    static Value
+    makeTree()
+    {
+        Value v(objectValue);
+        v["string"] = "a \"quoted\"\tstring\x01";
+        v["int"] = -42;
+        v["large"] = Value::maxLargestInt;
+        v["uint"] = 7u;
+        v["double"] = 2.5;
+        v["bool"] = true;
+        v["null"] = Value();
+        v["array"][2u] = "gap";
+        v["array"][4u] = Value(objectValue);
+        for (int i = 0; i < 1000; ++i)
+            v["many"].append("item " + std::to_string(i));
+        return v;
+    }
+
+    static std::string
+    streamed(Value const& v)
+    {
+        std::string s;
+        stream(v, [&s](void const* p, std::size_t n) {
+            s.append(static_cast<char const*>(p), n);
+        });
+        return s;
+    }
+
+public:
+    void
+    testScope()
+    {
+        testcase("scope");
+
+        BEAST_EXPECT(Arena::exchange(nullptr) == nullptr);
+
+        Value copy;
+        Value outlived;
+        std::string expected;
+        {
+            ArenaScope scope;
+            Arena* const arena = Arena::exchange(nullptr);
+            BEAST_EXPECT(arena != nullptr);
+            Arena::exchange(arena);
+
+            Value v = makeTree();
+            BEAST_EXPECT(arena->allocated() > 1000 * sizeof(void*));
+            expected = to_string(v);
+            outlived = std::move(v);
+        }
+        BEAST_EXPECT(Arena::exchange(nullptr) == nullptr);
+
+        // The blocks stay alive for the values that outlive the scope
+        BEAST_EXPECT(to_string(outlived) == expected);
+        copy = outlived;
+        outlived = Value();
+        BEAST_EXPECT(to_string(copy) == expected);
+        BEAST_EXPECT(copy == makeTree());
+
+        // and can be released from another thread
+        {
+            ArenaScope scope;
+            Value v = makeTree();
+            std::thread([v = std::move(v)]() mutable { v = Value(); }).join();
+        }
+    }
+
+    void
+    testNested()
+    {
+        testcase("nested");
+
+        Arena outer;
+        Arena::exchange(&outer);
+        {
+            ArenaScope inner;
+            Value v("inner");
+            BEAST_EXPECT(outer.allocated() == 0);
+        }
+        BEAST_EXPECT(Arena::exchange(nullptr) == &outer);
+
+        Arena::exchange(&outer);
+        Value v("outer");
+        BEAST_EXPECT(outer.allocated() > 0);
+        auto const allocated = outer.allocated();
+        {
+            // Values meant to outlive the request come from the heap
+            HeapScope heap;
+            BEAST_EXPECT(Arena::exchange(nullptr) == nullptr);
+            Value kept = makeTree();
+            BEAST_EXPECT(outer.allocated() == allocated);
+        }
+        BEAST_EXPECT(Arena::exchange(nullptr) == &outer);
+    }
+
+    void
+    testStream()
+    {
+        testcase("stream");
+
+        Value const v = makeTree();
+        BEAST_EXPECT(streamed(v) == to_string(v) + "\n");
+        BEAST_EXPECT(streamed(Value(arrayValue)) == "[]\n");
+        BEAST_EXPECT(streamed(Value(objectValue)) == "{}\n");
+        BEAST_EXPECT(streamed(Value("\\")) == "\"\\\\\"\n");
+    }
+
+    void
+    run() override
+    {
+        testScope();
+        testNested();
+        testStream();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(Arena, json, ripple);
+
+}  // namespace Json
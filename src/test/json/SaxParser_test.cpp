@@ -0,0 +1,214 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/beast/unit_test.h>
+#include <ripple/json/SaxParser.h>
+#include <ripple/json/json_reader.h>
+#include <ripple/json/json_writer.h>
+#include <string>
+
+namespace Json {
+
+class SaxParser_test : public beast::unit_test::suite
+{
+    // Writes the events back out, one per token
+    struct Recorder
+    {
+        std::string out;
+        std::string stopAt;
+
+        bool
+        add(std::string s)
+        {
+            out += s + ' ';
+            return s != stopAt;
+        }
+
+        bool
+        onNull()
+        {
+            return add("null");
+        }
+        bool
+        onBool(bool b)
+        {
+            return add(b ? "true" : "false");
+        }
+        bool
+        onInt(Value::LargestInt i)
+        {
+            return add("i" + std::to_string(i));
+        }
+        bool
+        onDouble(double d)
+        {
+            return add("d" + std::to_string(d));
+        }
+        bool
+        onString(std::string_view s)
+        {
+            return add("\"" + std::string(s) + "\"");
+        }
+        bool
+        onKey(std::string_view s)
+        {
+            return add(std::string(s) + ":");
+        }
+        bool
+        onObjectBegin()
+        {
+            return add("{");
+        }
+        bool
+        onObjectEnd()
+        {
+            return add("}");
+        }
+        bool
+        onArrayBegin()
+        {
+            return add("[");
+        }
+        bool
+        onArrayEnd()
+        {
+            return add("]");
+        }
+        std::string
+        error() const
+        {
+            return "stopped";
+        }
+    };
+
+    std::string
+    events(std::string const& json)
+    {
+        Recorder r;
+        SaxParser<Recorder> parser(r, Reader::nest_limit);
+        if (!parser.parse(json.data(), json.data() + json.size()))
+            return "error: " + parser.errorMessage();
+        return r.out;
+    }
+
+public:
+    void
+    testEvents()
+    {
+        testcase("events");
+
+        BEAST_EXPECT(events("{}") == "{ } ");
+        BEAST_EXPECT(events("[]") == "[ ] ");
+        BEAST_EXPECT(
+            events(R"({"a" : [1, -2, true, false, null], "b" : {"c" : "d"}})") ==
+            "{ a: [ i1 i-2 true false null ] b: { c: \"d\" } } ");
+        BEAST_EXPECT(events("[1.5, 2e1]") == "[ d1.500000 d20.000000 ] ");
+        BEAST_EXPECT(
+            events("/* c */ [ // line\n 1 /* x */ ]") == "[ i1 ] ");
+        BEAST_EXPECT(
+            events(R"(["a\"b\\c\/\n", "é😀"])") ==
+            "[ \"a\"b\\c/\n\" \"\xc3\xa9\xf0\x9f\x98\x80\" ] ");
+    }
+
+    void
+    testErrors()
+    {
+        testcase("errors");
+
+        BEAST_EXPECT(
+            events("") ==
+            "error: Syntax error: value, object or array expected.");
+        BEAST_EXPECT(
+            events("[1 2]") ==
+            "error: Missing ',' or ']' in array declaration");
+        BEAST_EXPECT(
+            events(R"({"a" 1})") ==
+            "error: Missing ':' after object member name");
+        BEAST_EXPECT(
+            events(R"({"a" : 1,})") ==
+            "error: Missing '}' or object member name");
+        BEAST_EXPECT(
+            events(R"(["abc)") == "error: Syntax error: unterminated string.");
+        BEAST_EXPECT(
+            events(R"(["\q"])") == "error: Bad escape sequence in string");
+        BEAST_EXPECT(
+            events("[-]") == "error: '-' is not a valid number.");
+        BEAST_EXPECT(
+            events("[9223372036854775808]") ==
+            "error: '9223372036854775808' exceeds the allowable range.");
+        BEAST_EXPECT(
+            events("[-2147483649]") ==
+            "error: '-2147483649' exceeds the allowable range.");
+        BEAST_EXPECT(events("[tru]").find("error") == 0);
+
+        // The handler can stop the parse
+        Recorder r;
+        r.stopAt = "b:";
+        SaxParser<Recorder> parser(r, Reader::nest_limit);
+        std::string const json = R"({"a" : 1, "b" : 2})";
+        BEAST_EXPECT(!parser.parse(json.data(), json.data() + json.size()));
+        BEAST_EXPECT(parser.errorMessage() == "stopped");
+        BEAST_EXPECT(parser.errorLocation() == json.data() + 10);
+    }
+
+    void
+    testReader()
+    {
+        testcase("reader");
+
+        Reader reader;
+        Value v;
+        std::string const json =
+            R"({"s" : "x\ty", "n" : [1, 2.5], "o" : {"k" : null}})";
+        BEAST_EXPECT(reader.parse(json, v));
+        BEAST_EXPECT(v["s"].asString() == "x\ty");
+        BEAST_EXPECT(v["n"].size() == 2);
+        BEAST_EXPECT(v["n"][0u].asInt() == 1);
+        BEAST_EXPECT(v["n"][1u].asDouble() == 2.5);
+        BEAST_EXPECT(v["o"]["k"].isNull());
+        BEAST_EXPECT(reader.getFormatedErrorMessages().empty());
+
+        // Errors stay readable after the document is gone
+        {
+            std::string const bad = "{\n  \"a\" : 1,\n  \"a\" : 2\n}";
+            BEAST_EXPECT(!reader.parse(bad, v));
+        }
+        BEAST_EXPECT(
+            reader.getFormatedErrorMessages() ==
+            "* Line 3, Column 3\n  Key 'a' appears twice.\n");
+
+        BEAST_EXPECT(!reader.parse("\"a\"", v));
+        BEAST_EXPECT(
+            reader.getFormatedErrorMessages() ==
+            "* Line 1, Column 1\n  A valid JSON document must be either an "
+            "array or an object value.\n");
+    }
+
+    void
+    run() override
+    {
+        testEvents();
+        testErrors();
+        testReader();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(SaxParser, json, ripple);
+
+}  // namespace Json
@@ -555,6 +555,20 @@ public:
             std::unique_ptr<Database> db = Manager::instance().make_Database(
                 "test", scheduler, 2, parent, nodeParams, journal_);
 
+            {
+                // Read it back in one batch, with a key that isn't there
+                std::vector<uint256> hashes;
+                for (auto const& object : batch)
+                    hashes.push_back(object->getHash());
+                hashes.push_back(uint256{});
+
+                auto const objects = db->fetchBatch(hashes, 0);
+                BEAST_EXPECT(objects.size() == hashes.size());
+                BEAST_EXPECT(!objects.back());
+                BEAST_EXPECT(areBatchesEqual(
+                    batch, Batch(objects.begin(), std::prev(objects.end()))));
+            }
+
             // Read it back in
             Batch copy;
             fetchCopyOfBatch(*db, &copy, batch);
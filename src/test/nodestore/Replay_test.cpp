@@ -0,0 +1,692 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/basics/BasicConfig.h>
+#include <ripple/basics/safe_cast.h>
+#include <ripple/beast/unit_test.h>
+#include <ripple/beast/utility/temp_dir.h>
+#include <ripple/beast/xor_shift_engine.h>
+#include <ripple/core/Stoppable.h>
+#include <ripple/nodestore/DummyScheduler.h>
+#include <ripple/nodestore/Manager.h>
+#include <ripple/unity/rocksdb.h>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
+#include <algorithm>
+#include <atomic>
+#include <beast/unit_test/thread.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <test/unit_test/SuiteJournal.h>
+
+namespace ripple {
+namespace NodeStore {
+
+/*  Replays node store access traces against backend and cache
+    configurations, see Benchmarks.md.
+
+    A trace is a text file with one operation per line:
+
+        store <seq> <hash> <size> <type>
+        fetch <seq> <hash>
+        batch <seq> <hash> <hash>...
+
+    A store writes an object of size bytes and NodeObjectType type, a fetch
+    reads one object and a batch reads several with one fetchBatch call, the
+    way SHAMap walks do. Blank lines and lines starting with '#' are ignored.
+
+    Without a trace file the built in workloads are replayed:
+
+        close       Ledger close: every ledger stores its header and the new
+                    state and transaction nodes, then reads some of them back.
+        inbound     InboundLedger: recent ledgers are acquired, reading their
+                    nodes in batches, some of which are not in the store.
+        contract    Contract storage: skewed reads of a population of small
+                    storage leaves, with some of them rewritten.
+*/
+class Replay_test : public beast::unit_test::suite
+{
+public:
+#ifndef NDEBUG
+    std::size_t const default_ledgers = 200;
+#else
+    std::size_t const default_ledgers = 2000;  // release
+#endif
+
+    using clock_type = std::chrono::steady_clock;
+
+    struct Op
+    {
+        enum Kind : std::uint8_t { store, fetch };
+
+        Kind kind;
+        NodeObjectType type;
+        std::uint32_t size;
+        std::uint32_t seq;
+        uint256 hash;
+    };
+
+    struct Trace
+    {
+        std::string name;
+
+        // Stores that populate the database before the timed part
+        std::vector<Op> setup;
+
+        std::vector<Op> ops;
+
+        // Ranges of ops issued by a single call
+        std::vector<std::pair<std::size_t, std::size_t>> steps;
+
+        void
+        add(Op const& op)
+        {
+            steps.emplace_back(ops.size(), ops.size() + 1);
+            ops.push_back(op);
+        }
+
+        void
+        addBatch(std::vector<Op> const& batch)
+        {
+            steps.emplace_back(ops.size(), ops.size() + batch.size());
+            ops.insert(ops.end(), batch.begin(), batch.end());
+        }
+    };
+
+    struct Result
+    {
+        std::size_t objects = 0;
+        std::size_t found = 0;
+        std::size_t fetched = 0;
+        std::uint64_t written = 0;
+        std::uint64_t onDisk = 0;
+        // Bytes the process sent to storage, if the system reports them
+        boost::optional<std::uint64_t> deviceWritten;
+        clock_type::duration elapsed{};
+
+        // Latency of every call, in microseconds
+        std::vector<std::uint32_t> latency;
+    };
+
+    //--------------------------------------------------------------------------
+
+    // Returns the key of the n-th object of a generated trace
+    static uint256
+    key(std::size_t n)
+    {
+        beast::xor_shift_engine gen(n + 1);
+        uint256 result;
+        for (auto p = result.begin(); p != result.end(); p += sizeof(gen()))
+        {
+            auto const v = gen();
+            std::memcpy(&*p, &v, sizeof(v));
+        }
+        return result;
+    }
+
+    static Op
+    makeStore(
+        std::uint32_t seq,
+        std::size_t n,
+        NodeObjectType type,
+        std::uint32_t size)
+    {
+        return {Op::store, type, size, seq, key(n)};
+    }
+
+    static Op
+    makeFetch(std::uint32_t seq, std::size_t n)
+    {
+        return {Op::fetch, hotUNKNOWN, 0, seq, key(n)};
+    }
+
+    // Sizes of serialized inner nodes and state leaves
+    template <class Generator>
+    static std::uint32_t
+    innerSize(Generator& g)
+    {
+        return std::uniform_int_distribution<std::uint32_t>(80, 520)(g);
+    }
+
+    template <class Generator>
+    static std::uint32_t
+    leafSize(Generator& g)
+    {
+        return std::uniform_int_distribution<std::uint32_t>(100, 400)(g);
+    }
+
+    /*  Stores of one ledger: its header, then the modified state and
+        transaction nodes, each leaf with the inner nodes above it.
+        Returns the index of the first object.
+    */
+    template <class Generator>
+    static std::size_t
+    closeLedger(
+        std::vector<Op>& ops,
+        std::uint32_t seq,
+        std::size_t& next,
+        Generator& g)
+    {
+        auto const first = next;
+        ops.push_back(makeStore(seq, next++, hotLEDGER, 118));
+
+        std::uniform_int_distribution<int> txs(20, 120);
+        for (auto i = txs(g); i--;)
+        {
+            ops.push_back(
+                makeStore(seq, next++, hotTRANSACTION_NODE, leafSize(g) * 2));
+            for (int depth = 0; depth < 3; ++depth)
+                ops.push_back(makeStore(
+                    seq, next++, hotTRANSACTION_NODE, innerSize(g)));
+            for (int accounts = 0; accounts < 2; ++accounts)
+            {
+                ops.push_back(
+                    makeStore(seq, next++, hotACCOUNT_NODE, leafSize(g)));
+                for (int depth = 0; depth < 4; ++depth)
+                    ops.push_back(makeStore(
+                        seq, next++, hotACCOUNT_NODE, innerSize(g)));
+            }
+        }
+        return first;
+    }
+
+    Trace
+    makeClose(std::size_t ledgers)
+    {
+        Trace trace;
+        trace.name = "close";
+        beast::xor_shift_engine g(1);
+        std::size_t next = 0;
+        std::vector<Op> stores;
+        for (std::uint32_t seq = 1; seq <= ledgers; ++seq)
+        {
+            stores.clear();
+            auto const first = closeLedger(stores, seq, next, g);
+            for (auto const& op : stores)
+                trace.add(op);
+
+            // Building the next open ledger reads back recent nodes
+            std::uniform_int_distribution<std::size_t> recent(first, next - 1);
+            for (int i = 0; i < 32; ++i)
+                trace.add(makeFetch(seq, recent(g)));
+        }
+        return trace;
+    }
+
+    Trace
+    makeInbound(std::size_t ledgers)
+    {
+        Trace trace;
+        trace.name = "inbound";
+        beast::xor_shift_engine g(2);
+        std::size_t next = 0;
+        std::vector<std::size_t> firsts;
+        for (std::uint32_t seq = 1; seq <= ledgers; ++seq)
+            firsts.push_back(closeLedger(trace.setup, seq, next, g));
+        firsts.push_back(next);
+
+        // Acquire the recent ledgers, newest first, fetching the nodes of
+        // each one in batches. One in five nodes is one we never stored.
+        std::vector<Op> batch;
+        std::uniform_int_distribution<int> missing(0, 4);
+        auto const count = std::max<std::size_t>(ledgers / 4, 1);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto const seq = static_cast<std::uint32_t>(ledgers - i);
+            for (auto n = firsts[seq - 1]; n < firsts[seq]; ++n)
+            {
+                batch.push_back(
+                    makeFetch(seq, missing(g) == 0 ? next + n : n));
+                if (batch.size() == 16)
+                {
+                    trace.addBatch(batch);
+                    batch.clear();
+                }
+            }
+            if (!batch.empty())
+            {
+                trace.addBatch(batch);
+                batch.clear();
+            }
+        }
+        return trace;
+    }
+
+    Trace
+    makeContract(std::size_t ledgers)
+    {
+        Trace trace;
+        trace.name = "contract";
+        beast::xor_shift_engine g(3);
+        std::size_t const population = ledgers * 50;
+        std::uniform_int_distribution<std::uint32_t> slotSize(64, 256);
+        for (std::size_t n = 0; n < population; ++n)
+            trace.setup.push_back(
+                makeStore(1, n, hotACCOUNT_NODE, slotSize(g)));
+
+        // Storage reads follow a Zipf distribution: a few hot contracts
+        // account for most of the traffic.
+        std::vector<double> weights;
+        weights.reserve(population);
+        for (std::size_t n = 1; n <= population; ++n)
+            weights.push_back(1.0 / std::pow(n, 1.1));
+        std::discrete_distribution<std::size_t> slot(
+            weights.begin(), weights.end());
+        std::uniform_int_distribution<int> write(0, 9);
+
+        std::size_t next = population;
+        for (std::uint32_t seq = 2; seq <= ledgers + 1; ++seq)
+        {
+            for (int i = 0; i < 200; ++i)
+            {
+                trace.add(makeFetch(seq, slot(g)));
+                if (write(g) == 0)
+                    trace.add(makeStore(
+                        seq, next++, hotACCOUNT_NODE, slotSize(g)));
+            }
+        }
+        return trace;
+    }
+
+    //--------------------------------------------------------------------------
+
+    static Trace
+    loadTrace(std::string const& path)
+    {
+        std::ifstream in(path);
+        if (!in)
+            throw std::runtime_error("can't open trace " + path);
+
+        Trace trace;
+        trace.name = boost::filesystem::path(path).filename().string();
+
+        auto parseHash = [&](std::string const& s) {
+            uint256 hash;
+            if (!hash.SetHexExact(s))
+                throw std::runtime_error("bad hash in trace: " + s);
+            return hash;
+        };
+
+        std::string line;
+        std::vector<Op> batch;
+        while (std::getline(in, line))
+        {
+            boost::trim(line);
+            if (line.empty() || line[0] == '#')
+                continue;
+
+            std::istringstream ss(line);
+            std::string kind;
+            std::uint32_t seq = 0;
+            std::string hash;
+            ss >> kind >> seq >> hash;
+            if (!ss)
+                throw std::runtime_error("bad trace line: " + line);
+
+            if (kind == "store")
+            {
+                std::uint32_t size = 0;
+                std::uint32_t type = hotUNKNOWN;
+                ss >> size >> type;
+                if (!ss)
+                    throw std::runtime_error("bad trace line: " + line);
+                trace.add(
+                    {Op::store,
+                     static_cast<NodeObjectType>(type),
+                     size,
+                     seq,
+                     parseHash(hash)});
+            }
+            else if (kind == "fetch")
+            {
+                trace.add({Op::fetch, hotUNKNOWN, 0, seq, parseHash(hash)});
+            }
+            else if (kind == "batch")
+            {
+                batch.clear();
+                do
+                {
+                    batch.push_back(
+                        {Op::fetch, hotUNKNOWN, 0, seq, parseHash(hash)});
+                } while (ss >> hash);
+                trace.addBatch(batch);
+            }
+            else
+            {
+                throw std::runtime_error("bad trace line: " + line);
+            }
+        }
+        return trace;
+    }
+
+    //--------------------------------------------------------------------------
+
+    // The contents of a stored object, derived from its key
+    static Blob
+    makeData(Op const& op)
+    {
+        std::uint64_t seed;
+        std::memcpy(&seed, op.hash.data(), sizeof(seed));
+        beast::xor_shift_engine gen(seed);
+        Blob data(op.size);
+        for (auto& b : data)
+            b = static_cast<std::uint8_t>(gen());
+        return data;
+    }
+
+    static std::uint64_t
+    diskUsage(std::string const& path)
+    {
+        namespace fs = boost::filesystem;
+        std::uint64_t total = 0;
+        boost::system::error_code ec;
+        for (fs::recursive_directory_iterator it(path, ec), end; it != end;
+             it.increment(ec))
+        {
+            if (ec)
+                break;
+            if (fs::is_regular_file(it->path(), ec))
+                total += fs::file_size(it->path(), ec);
+        }
+        return total;
+    }
+
+    // Bytes this process caused to be written to storage so far, this
+    // includes the flushes and compactions of the backend threads.
+    static boost::optional<std::uint64_t>
+    storageWrites()
+    {
+        std::ifstream in("/proc/self/io");
+        std::string name;
+        std::uint64_t value;
+        while (in >> name >> value)
+            if (name == "write_bytes:")
+                return value;
+        return boost::none;
+    }
+
+    void
+    replay(
+        Section const& config,
+        Trace const& trace,
+        std::size_t threads,
+        Result& result,
+        beast::Journal journal)
+    {
+        DummyScheduler scheduler;
+        RootStoppable parent("ReplayRootStoppable");
+        std::atomic<std::uint64_t> written{0};
+        auto const writesBefore = storageWrites();
+        {
+            auto db = Manager::instance().make_Database(
+                "replay", scheduler, 4, parent, config, journal);
+            if (config.exists("cache_size") || config.exists("cache_age"))
+                db->tune(
+                    get<int>(config, "cache_size", 0),
+                    std::chrono::seconds(get<int>(config, "cache_age", 60)));
+
+            for (auto const& op : trace.setup)
+                db->store(op.type, makeData(op), op.hash, op.seq);
+            db->sweep();
+
+            std::atomic<std::size_t> next{0};
+            std::atomic<std::size_t> found{0};
+            std::atomic<std::size_t> fetched{0};
+            std::vector<std::vector<std::uint32_t>> latency(threads);
+
+            auto const work = [&](std::size_t id) {
+                std::vector<uint256> hashes;
+                auto& samples = latency[id];
+                for (;;)
+                {
+                    auto const i = next++;
+                    if (i >= trace.steps.size())
+                        break;
+                    auto const& step = trace.steps[i];
+                    auto const& op = trace.ops[step.first];
+
+                    // Blobs are built ahead so only node store work is timed
+                    Blob data;
+                    if (op.kind == Op::store)
+                        data = makeData(op);
+
+                    auto const start = clock_type::now();
+                    if (op.kind == Op::store)
+                    {
+                        db->store(op.type, std::move(data), op.hash, op.seq);
+                        written += op.size;
+                    }
+                    else if (step.second - step.first == 1)
+                    {
+                        ++fetched;
+                        if (db->fetch(op.hash, op.seq))
+                            ++found;
+                    }
+                    else
+                    {
+                        hashes.clear();
+                        for (auto j = step.first; j < step.second; ++j)
+                            hashes.push_back(trace.ops[j].hash);
+                        fetched += hashes.size();
+                        for (auto const& obj : db->fetchBatch(hashes, op.seq))
+                            if (obj)
+                                ++found;
+                    }
+                    samples.push_back(static_cast<std::uint32_t>(
+                        std::chrono::duration_cast<std::chrono::microseconds>(
+                            clock_type::now() - start)
+                            .count()));
+                }
+            };
+
+            auto const start = clock_type::now();
+            std::vector<beast::unit_test::thread> t;
+            t.reserve(threads);
+            for (std::size_t id = 0; id < threads; ++id)
+                t.emplace_back(*this, work, id);
+            for (auto& _ : t)
+                _.join();
+            result.elapsed = clock_type::now() - start;
+
+            result.objects = trace.ops.size();
+            result.found = found;
+            result.fetched = fetched;
+            for (auto& samples : latency)
+                result.latency.insert(
+                    result.latency.end(), samples.begin(), samples.end());
+        }
+
+        // The database is closed, so everything it wrote is on disk
+        for (auto const& op : trace.setup)
+            written += op.size;
+        result.written = written;
+        result.onDisk = diskUsage(get<std::string>(config, "path"));
+        auto const writesAfter = storageWrites();
+        if (writesBefore && writesAfter)
+            result.deviceWritten = *writesAfter - *writesBefore;
+    }
+
+    //--------------------------------------------------------------------------
+
+    static std::string
+    to_string(Section const& config)
+    {
+        std::string s;
+        for (auto iter = config.begin(); iter != config.end(); ++iter)
+            if (iter->first != "path" && iter->first != "trace")
+                s += (s.empty() ? "" : ",") + iter->first + "=" +
+                    iter->second;
+        return s;
+    }
+
+    static Section
+    parse(std::string s)
+    {
+        Section section;
+        std::vector<std::string> v;
+        boost::split(v, s, boost::algorithm::is_any_of(","));
+        section.append(v);
+        return section;
+    }
+
+    static std::string
+    ratio(std::uint64_t n, std::uint64_t d)
+    {
+        if (d == 0)
+            return "-";
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(2) << double(n) / d;
+        return ss.str();
+    }
+
+    static std::string
+    percentile(std::vector<std::uint32_t> const& sorted, double p)
+    {
+        if (sorted.empty())
+            return "-";
+        auto const i = std::min(
+            sorted.size() - 1,
+            static_cast<std::size_t>(std::ceil(p * sorted.size())) - 1);
+        return std::to_string(sorted[i]) + "us";
+    }
+
+    void
+    report(
+        Section const& config,
+        Trace const& trace,
+        std::size_t threads,
+        Result& result)
+    {
+        using std::setw;
+        std::sort(result.latency.begin(), result.latency.end());
+        auto const seconds =
+            std::chrono::duration<double>(result.elapsed).count();
+
+        std::stringstream ss;
+        ss << std::left << setw(10) << get(config, "type", std::string())
+           << setw(10) << trace.name << std::right << setw(4) << threads
+           << std::fixed << std::setprecision(0) << setw(12)
+           << (seconds > 0 ? result.objects / seconds : 0) << setw(9)
+           << percentile(result.latency, 0.5) << setw(9)
+           << percentile(result.latency, 0.99) << setw(9)
+           << percentile(result.latency, 0.999) << setw(10)
+           << percentile(result.latency, 1.0) << setw(7)
+           << (result.deviceWritten
+                   ? ratio(*result.deviceWritten, result.written)
+                   : std::string("-"))
+           << setw(7) << ratio(result.onDisk, result.written)
+           << std::setprecision(1) << setw(7)
+           << (result.fetched ? 100.0 * result.found / result.fetched : 0)
+           << "%   " << to_string(config);
+        log << ss.str() << std::endl;
+    }
+
+    void
+    run() override
+    {
+        testcase("Replay", beast::unit_test::abort_on_fail);
+
+        /*  Parameters:
+
+            Configurations are separated by ';', their settings by ','.
+            Besides the backend settings a configuration takes
+
+            trace           Trace file to replay, instead of the built in
+                            workloads
+            threads         Number of threads issuing calls, default 4
+            cache_size      Target size of the node store caches
+            cache_age       Target age of the cache entries, in seconds
+        */
+        std::string default_args =
+            "type=nudb"
+            ";type=nudb,cache_size=0,cache_age=0"
+#if RIPPLE_ROCKSDB_AVAILABLE
+            ";type=rocksdb,open_files=2000,filter_bits=12,cache_mb=256,"
+            "file_size_mb=8,file_size_mult=2"
+            ";type=rocksdb,open_files=2000,filter_bits=12,cache_mb=256,"
+            "file_size_mb=8,file_size_mult=2,cache_size=0,cache_age=0"
+#endif
+            ;
+
+        auto args = arg().empty() ? default_args : arg();
+        std::vector<std::string> config_strings;
+        boost::split(config_strings, args, boost::algorithm::is_any_of(";"));
+
+        log << std::left << std::setw(10) << "Backend" << std::setw(10)
+            << "Trace" << std::right << std::setw(4) << "Thr" << std::setw(12)
+            << "Objects/s" << std::setw(9) << "p50" << std::setw(9) << "p99"
+            << std::setw(9) << "p99.9" << std::setw(10) << "max"
+            << std::setw(7) << "WA" << std::setw(7) << "SA" << std::setw(8)
+            << "Found" << std::endl;
+
+        test::SuiteJournal journal("Replay_test", *this);
+
+        try
+        {
+            for (auto const& config_string : config_strings)
+            {
+                if (config_string.empty())
+                    continue;
+
+                Section config = parse(config_string);
+                std::vector<Trace> traces;
+                if (auto const path = get<std::string>(config, "trace");
+                    !path.empty())
+                {
+                    traces.push_back(loadTrace(path));
+                }
+                else
+                {
+                    traces.push_back(makeClose(default_ledgers));
+                    traces.push_back(makeInbound(default_ledgers));
+                    traces.push_back(makeContract(default_ledgers));
+                }
+                // Keep the database from recording into the trace it replays
+                config = parse(to_string(config));
+
+                auto const threads = std::max<std::size_t>(
+                    get<std::size_t>(config, "threads", 4), 1);
+                for (auto const& trace : traces)
+                {
+                    beast::temp_dir tempDir;
+                    config.set("path", tempDir.path());
+                    Result result;
+                    replay(config, trace, threads, result, journal);
+                    report(config, trace, threads, result);
+                }
+            }
+        }
+        catch (std::exception const& e)
+        {
+            fail(e.what());
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL_PRIO(Replay, NodeStore, ripple, 1);
+
+}  // namespace NodeStore
+}  // namespace ripple
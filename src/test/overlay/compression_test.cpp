@@ -25,10 +25,12 @@
 #include <ripple/core/TimeKeeper.h>
 #include <ripple/overlay/Compression.h>
 #include <ripple/overlay/Message.h>
+#include <ripple/overlay/TxDictionary.h>
 #include <ripple/overlay/impl/ProtocolMessage.h>
 #include <ripple/overlay/impl/ZeroCopyStream.h>
 #include <ripple/protocol/HashPrefix.h>
 #include <ripple/protocol/PublicKey.h>
+#include <ripple/protocol/STTx.h>
 #include <ripple/protocol/SecretKey.h>
 #include <ripple/protocol/Sign.h>
 #include <ripple/protocol/digest.h>
@@ -354,6 +356,54 @@ public:
         return list;
     }
 
+    std::shared_ptr<protocol::TMTableRange>
+    buildTableRange(int n)
+    {
+        auto range = std::make_shared<protocol::TMTableRange>();
+        std::string const account = "zHb9CJAWyB4zj91VRWn96DkukG4bwdtyTh";
+        std::string const nameInDB =
+            to_string(uint160(ripple::sha512Half(std::string("table"))));
+        uint256 const schemaId;
+
+        sha512_half_hasher checksum;
+        for (int i = 0; i < n; i++)
+        {
+            protocol::TMTableData data;
+            uint256 hash(ripple::sha512Half(i));
+            uint256 lastHash(ripple::sha512Half(i - 1));
+            data.set_ledgerseq(1000 + i);
+            data.set_ledgerhash(hash.data(), hash.size());
+            data.set_ledgercheckhash(hash.data(), hash.size());
+            data.set_lastledgerseq(999 + i);
+            data.set_lastledgerhash(lastHash.data(), lastHash.size());
+            data.set_nameindb(nameInDB);
+            data.set_account(account);
+            data.set_seekstop(i == n - 1);
+            data.set_etargettype(0);
+            data.set_schemaid(schemaId.data(), schemaId.size());
+            // every other ledger is a skip reply without transactions
+            if (i % 2 == 0)
+            {
+                std::string sql = "[{\"id\":" + std::to_string(i) +
+                    ",\"name\":\"row" + std::to_string(i) + "\"}]";
+                data.add_txnodes()->set_nodedata(sql);
+            }
+
+            auto s = range->add_replies();
+            data.SerializeToString(s);
+            checksum(s->data(), s->size());
+        }
+        auto const sum = static_cast<uint256>(checksum);
+        range->set_nameindb(nameInDB);
+        range->set_account(account);
+        range->set_firstseq(999);
+        range->set_lastseq(999 + n);
+        range->set_checksum(sum.data(), sum.size());
+        range->set_etargettype(0);
+        range->set_schemaid(schemaId.data(), schemaId.size());
+        return range;
+    }
+
     void
     testProtocol()
     {
@@ -428,13 +478,245 @@ public:
             protocol::mtVALIDATORLIST,
             4,
             "TMValidatorList");
+        // 241KB
+        doTest(
+            buildTableRange(1000),
+            protocol::mtTABLE_RANGE,
+            20,
+            "TMTableRange1000");
+    }
+
+    // A table insert as sent by a client
+    Blob
+    buildTableTx(
+        AccountID const& account,
+        AccountID const& owner,
+        std::string const& table,
+        std::uint32_t seq)
+    {
+        auto const signing = randomKeyPair(KeyType::secp256k1);
+        STTx tx(ttSQLSTATEMENT, [&](STObject& obj) {
+            obj.setAccountID(sfAccount, account);
+            obj.setAccountID(sfOwner, owner);
+            obj.setFieldU32(sfSequence, seq);
+            obj.setFieldU16(sfOpType, 6);
+            obj.setFieldAmount(sfFee, STAmount(10));
+            obj.setFieldVL(sfSigningPubKey, std::get<0>(signing).slice());
+
+            STArray tables;
+            STObject entry(sfTable);
+            entry.setFieldVL(sfTableName, makeSlice(table));
+            entry.setFieldH160(sfNameInDB, uint160(ripple::sha512Half(table)));
+            tables.push_back(entry);
+            obj.setFieldArray(sfTables, tables);
+
+            obj.setFieldVL(
+                sfRaw,
+                makeSlice(
+                    "[{\"id\":" + std::to_string(seq) + ",\"name\":\"row" +
+                    std::to_string(seq) + "\"}]"));
+        });
+
+        Serializer s;
+        tx.add(s);
+        return s.getData();
+    }
+
+    // A payment along a path, which is sent as it is
+    Blob
+    buildPathTx(
+        AccountID const& account,
+        AccountID const& destination,
+        std::uint32_t seq)
+    {
+        auto const usd = to_currency("USD");
+        STTx tx(ttPAYMENT, [&](STObject& obj) {
+            obj.setAccountID(sfAccount, account);
+            obj.setAccountID(sfDestination, destination);
+            obj.setFieldU32(sfSequence, seq);
+            obj.setFieldAmount(sfFee, STAmount(10));
+            obj.setFieldAmount(sfAmount, STAmount(Issue(usd, account), 10));
+
+            STPath path;
+            path.emplace_back(STPathElement(destination, usd, account));
+            STPathSet paths;
+            paths.push_back(path);
+            obj.setFieldPathSet(sfPaths, paths);
+        });
+
+        Serializer s;
+        tx.add(s);
+        return s.getData();
+    }
+
+    std::vector<Blob>
+    buildTableTxs(int n)
+    {
+        std::vector<AccountID> const accounts{
+            Account("alice").id(), Account("bob").id(), Account("carol").id()};
+        auto const dave = Account("dave").id();
+
+        std::vector<Blob> txs;
+        for (int i = 0; i < n; i++)
+        {
+            // Dave's first values are not walked and must not be remembered
+            if (i == n / 2)
+                txs.push_back(buildPathTx(dave, accounts[0], i));
+            if (i == n / 2 + 1)
+                txs.push_back(buildTableTx(dave, dave, "dave", i));
+
+            txs.push_back(buildTableTx(
+                accounts[i % accounts.size()],
+                accounts[0],
+                "table" + std::to_string(i % 4),
+                i));
+        }
+        return txs;
+    }
+
+    template <class T>
+    std::shared_ptr<T>
+    parseCompact(Message& m, int mt)
+    {
+        auto const& full = m.getBuffer(Compressed::Off);
+        auto const& compact = m.getBuffer(Compressed::Off, CompactTx::On);
+        BEAST_EXPECT(compact.size() < full.size());
+
+        auto const header = compression::headerBytes;
+        BEAST_EXPECT(
+            ((compact[4] << 8) | compact[5]) == ((full[4] << 8) | full[5]));
+        BEAST_EXPECT(((full[4] << 8) | full[5]) == mt);
+
+        auto proto = std::make_shared<T>();
+        BEAST_EXPECT(proto->ParseFromArray(
+            compact.data() + header, compact.size() - header));
+        BEAST_EXPECT(proto->compact());
+
+        // Compression applies on top
+        auto const& compressed = m.getBuffer(Compressed::On, CompactTx::On);
+        BEAST_EXPECT(compressed.size() <= compact.size());
+
+        return proto;
+    }
+
+    void
+    testCompactTx()
+    {
+        testcase("Compact transactions");
+
+        auto const blobs = buildTableTxs(200);
+
+        {
+            protocol::TMTransactions txs;
+            for (auto const& blob : blobs)
+                txs.add_transactions()->set_rawtransaction(
+                    blob.data(), blob.size());
+            uint256 const schemaId;
+            txs.set_schemaid(schemaId.data(), schemaId.size());
+
+            Message m(txs, protocol::mtTRANSACTIONS);
+            auto proto = parseCompact<protocol::TMTransactions>(
+                m, protocol::mtTRANSACTIONS);
+            BEAST_EXPECT(expandTxs(*proto));
+            BEAST_EXPECT(!proto->compact());
+            BEAST_EXPECT(proto->transactions_size() == blobs.size());
+            for (int i = 0; i < proto->transactions_size(); ++i)
+                BEAST_EXPECT(
+                    makeSlice(proto->transactions(i).rawtransaction()) ==
+                    makeSlice(blobs[i]));
+        }
+
+        {
+            // A candidate tx set: transaction nodes and an inner node
+            protocol::TMLedgerData data;
+            uint256 const hash(ripple::sha512Half(123));
+            data.set_ledgerhash(hash.data(), hash.size());
+            data.set_ledgerseq(0);
+            data.set_type(protocol::liTS_CANDIDATE);
+            data.set_schemaid(hash.data(), hash.size());
+
+            Serializer inner;
+            for (int i = 0; i < 16; ++i)
+                inner.addBitString(ripple::sha512Half(i));
+            inner.add8(2);
+            data.add_nodes()->set_nodedata(inner.data(), inner.size());
+
+            for (auto const& blob : blobs)
+            {
+                auto node = blob;
+                node.push_back(0);
+                data.add_nodes()->set_nodedata(node.data(), node.size());
+            }
+
+            Message m(data, protocol::mtLEDGER_DATA);
+            auto proto = parseCompact<protocol::TMLedgerData>(
+                m, protocol::mtLEDGER_DATA);
+            BEAST_EXPECT(expandTxs(*proto));
+            BEAST_EXPECT(proto->nodes_size() == blobs.size() + 1);
+            BEAST_EXPECT(
+                makeSlice(proto->nodes(0).nodedata()) == inner.slice());
+            for (int i = 1; i < proto->nodes_size(); ++i)
+            {
+                auto const& node = proto->nodes(i).nodedata();
+                BEAST_EXPECT(
+                    Slice(node.data(), node.size() - 1) ==
+                    makeSlice(blobs[i - 1]));
+            }
+        }
+
+        {
+            // Other messages and other ledger data are left alone
+            auto ledgerData = buildLedgerData(10, *logs_);
+            Message m(*ledgerData, protocol::mtLEDGER_DATA);
+            BEAST_EXPECT(
+                m.getBuffer(Compressed::Off, CompactTx::On) ==
+                m.getBuffer(Compressed::Off));
+        }
+
+        {
+            // A reference to a value never sent
+            protocol::TMTransactions txs;
+            std::string const raw{'\x01', '\x81', '\x05'};
+            txs.add_transactions()->set_rawtransaction(raw);
+            txs.set_compact(true);
+            BEAST_EXPECT(!expandTxs(txs));
+        }
+
+        {
+            // An account longer than an account can be
+            protocol::TMTransactions txs;
+            std::string raw{'\x01', '\x81', '\x00', '\x15'};
+            raw.append(21, 'a');
+            txs.add_transactions()->set_rawtransaction(raw);
+            txs.set_compact(true);
+            BEAST_EXPECT(!expandTxs(txs));
+        }
+
+        {
+            // References that would expand past the largest message
+            protocol::TMTransactions txs;
+            std::string raw{'\x01', '\x81', '\x00', '\x14'};
+            raw.append(20, 'a');
+            auto const references = maximumMessageSize / 21 + 1;
+            raw.reserve(raw.size() + 2 * references);
+            for (std::size_t i = 0; i < references; ++i)
+                raw.append({'\x81', '\x01'});
+            txs.add_transactions()->set_rawtransaction(raw);
+            txs.set_compact(true);
+            BEAST_EXPECT(!expandTxs(txs));
+        }
     }
 
     void
     run() override
     {
+        logs_ = std::make_unique<Logs>(beast::severities::kInfo);
         testProtocol();
+        testCompactTx();
     }
+
+private:
+    std::unique_ptr<Logs> logs_;
 };
 
 BEAST_DEFINE_TESTSUITE_MANUAL_PRIO(compression, ripple_data, ripple, 20);
@@ -0,0 +1,148 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <ripple/beast/unit_test.h>
+#include <ripple/protocol/STAmount.h>
+#include <ripple/protocol/STArray.h>
+#include <ripple/protocol/STPathSet.h>
+#include <ripple/protocol/STTx.h>
+#include <ripple/protocol/STTxView.h>
+#include <ripple/protocol/SecretKey.h>
+#include <ripple/protocol/UintTypes.h>
+
+namespace ripple {
+
+class STTxView_test : public beast::unit_test::suite
+{
+    // A payment with an issued amount, paths and memos: fields of every
+    // kind the view has to step over
+    STTx
+    makePayment()
+    {
+        auto const keypair = randomKeyPair(KeyType::secp256k1);
+        auto const issuer =
+            calcAccountID(randomKeyPair(KeyType::secp256k1).first);
+        auto const usd = to_currency("USD");
+
+        STTx tx(ttPAYMENT, [&](auto& obj) {
+            obj.setAccountID(sfAccount, calcAccountID(keypair.first));
+            obj.setAccountID(sfDestination, issuer);
+            obj.setFieldU32(sfSequence, 42);
+            obj.setFieldAmount(sfFee, STAmount(10));
+            obj.setFieldAmount(sfAmount, STAmount({usd, issuer}, 5, -1));
+            obj.setFieldAmount(sfSendMax, STAmount({usd, issuer}, 6, -1));
+
+            STPathSet paths;
+            STPath path;
+            path.emplace_back(issuer, usd, issuer);
+            path.emplace_back(boost::none, usd, boost::none);
+            paths.push_back(path);
+            paths.push_back(path);
+            obj.setFieldPathSet(sfPaths, paths);
+
+            STArray memos(sfMemos);
+            for (char const* text : {"first", "second"})
+            {
+                STObject memo(sfMemo);
+                memo.setFieldVL(sfMemoData, makeSlice(std::string(text)));
+                memos.push_back(std::move(memo));
+            }
+            obj.setFieldArray(sfMemos, memos);
+        });
+        tx.sign(keypair.first, keypair.second);
+        return tx;
+    }
+
+    void
+    testFields()
+    {
+        testcase("fields");
+
+        auto const tx = makePayment();
+        Serializer s;
+        tx.add(s);
+
+        STTxView const view(s.slice());
+        BEAST_EXPECT(STTxView::canView(s.slice()));
+        BEAST_EXPECT(view.getTransactionID() == tx.getTransactionID());
+        BEAST_EXPECT(view.getTxnType() == ttPAYMENT);
+        BEAST_EXPECT(
+            view.getAccountID(sfAccount) == tx.getAccountID(sfAccount));
+        BEAST_EXPECT(
+            view.getAccountID(sfDestination) ==
+            tx.getAccountID(sfDestination));
+        BEAST_EXPECT(view.getFieldU32(sfSequence) == 42);
+        BEAST_EXPECT(
+            view.getFieldVL(sfSigningPubKey) ==
+            makeSlice(tx.getFieldVL(sfSigningPubKey)));
+        BEAST_EXPECT(
+            view.getFieldVL(sfTxnSignature) ==
+            makeSlice(tx.getFieldVL(sfTxnSignature)));
+
+        // Inner fields are not top level fields
+        BEAST_EXPECT(view.isFieldPresent(sfMemos));
+        BEAST_EXPECT(view.isFieldPresent(sfPaths));
+        BEAST_EXPECT(!view.isFieldPresent(sfMemoData));
+        BEAST_EXPECT(!view.isFieldPresent(sfDestinationTag));
+
+        except([&] { view.getFieldU32(sfDestinationTag); });
+        except([&] { view.getFieldU16(sfSequence); });
+
+        auto const full = view.toSTTx();
+        BEAST_EXPECT(*full == tx);
+        BEAST_EXPECT(full->getTransactionID() == view.getTransactionID());
+    }
+
+    void
+    testMalformed()
+    {
+        testcase("malformed");
+
+        auto const tx = makePayment();
+        Serializer s;
+        tx.add(s);
+
+        // The id needs no parsing, the fields do
+        STTxView const view(Slice(s.data(), s.size() - 5));
+        view.getTransactionID();
+        except([&] { view.getAccountID(sfAccount); });
+
+        // An object end marker out of place
+        Serializer bad(s.data(), s.size());
+        bad.addFieldID(STI_OBJECT, 1);
+        except([&] { STTxView(bad.slice()).getFieldU32(sfSequence); });
+
+        // Ethereum transactions start with a zero byte
+        Blob eth{0, 0xf8, 0x6c};
+        BEAST_EXPECT(!STTxView::canView(makeSlice(eth)));
+        BEAST_EXPECT(!STTxView::canView(Slice()));
+    }
+
+    void
+    run() override
+    {
+        testFields();
+        testMalformed();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(STTxView, protocol, ripple);
+
+}  // namespace ripple
@@ -0,0 +1,232 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/basics/random.h>
+#include <ripple/beast/unit_test.h>
+#include <ripple/beast/xor_shift_engine.h>
+#include <ripple/nodestore/Database.h>
+#include <ripple/shamap/SHAMap.h>
+#include <ripple/shamap/SHAMapLeafBuilder.h>
+#include <test/shamap/common.h>
+#include <test/unit_test/SuiteJournal.h>
+
+namespace ripple {
+namespace tests {
+
+class SHAMapLeafBuilder_test : public beast::unit_test::suite
+{
+public:
+    beast::xor_shift_engine eng_;
+
+    std::shared_ptr<SHAMapItem const>
+    makeRandomAS()
+    {
+        Serializer s;
+
+        for (int d = 0; d < 3; ++d)
+            s.add32(rand_int<std::uint32_t>(eng_));
+
+        return std::make_shared<SHAMapItem>(s.getSHA512Half(), s.peekData());
+    }
+
+    // Fill a state map, every tenth leaf the account of a contract
+    void
+    fill(SHAMap& map, int items)
+    {
+        for (int i = 0; i < items; ++i)
+        {
+            boost::optional<uint256> storageRoot;
+            if (i % 10 == 0)
+                storageRoot = makeRandomAS()->key();
+            map.addGiveItem(makeRandomAS(), false, false, storageRoot);
+        }
+    }
+
+    static SHAMapLeafBuilder::Fetch
+    fetcher(Family& family)
+    {
+        return [&family](SHAMapHash const& hash)
+                   -> std::shared_ptr<SHAMapAbstractNode> {
+            auto const obj = family.db().fetch(hash.as_uint256(), 0);
+            if (!obj)
+                return nullptr;
+            return SHAMapAbstractNode::makeFromPrefix(
+                makeSlice(obj->getData()), hash);
+        };
+    }
+
+    // Rebuild the map from its leaves into the store of another family
+    SHAMapHash
+    rebuild(
+        SHAMap const& map,
+        int rangeDepth,
+        Family& family,
+        boost::optional<uint256> const& skip = boost::none)
+    {
+        SHAMapLeafBuilder builder(
+            rangeDepth, [&family](SHAMapAbstractNode const& node) {
+                Serializer s;
+                node.addRaw(s, snfPREFIX);
+                family.db().store(
+                    hotACCOUNT_NODE,
+                    std::move(s.modData()),
+                    node.getNodeHash().as_uint256(),
+                    0);
+            });
+
+        std::vector<std::vector<SHAMapLeafBuilder::Leaf>> ranges(
+            builder.ranges());
+        map.visitLeafNodes(boost::none, [&](SHAMapTreeNode const& leaf) {
+            auto const& key = leaf.peekItem()->key();
+            if (skip && key == *skip)
+                return true;
+
+            auto const range = builder.rangeOf(key);
+            BEAST_EXPECT(key >= builder.first(range));
+            BEAST_EXPECT(key <= builder.last(range));
+            ranges[range].push_back({leaf.peekItem(), leaf.getStorageRoot()});
+            return true;
+        });
+
+        // Ranges are independent, build them out of order
+        std::vector<SHAMapHash> built(ranges.size());
+        for (std::size_t i = ranges.size(); i-- > 0;)
+            built[i] = builder.build(i, ranges[i]);
+
+        auto const hash = builder.finish();
+
+        // The top of the map tells what every range builds to
+        std::vector<SHAMapHash> hashes;
+        std::vector<SHAMapNodeID> missing;
+        BEAST_EXPECT(
+            builder.rangeHashes(hash, fetcher(family), hashes, missing));
+        BEAST_EXPECT(missing.empty());
+        BEAST_EXPECT(hashes == built);
+
+        return hash;
+    }
+
+    void
+    testRebuild(int items, int rangeDepth)
+    {
+        testcase(
+            "rebuild " + std::to_string(items) + " leaves in " +
+            std::to_string(rangeDepth == 1 ? 16 : 256) + " ranges");
+
+        test::SuiteJournal journal("SHAMapLeafBuilder_test", *this);
+        TestNodeFamily f(journal), f2(journal);
+
+        SHAMap source(SHAMapType::STATE, f);
+        fill(source, items);
+        source.setImmutable();
+
+        auto const hash = rebuild(source, rangeDepth, f2);
+        BEAST_EXPECT(hash == source.getHash());
+
+        if (items == 0)
+            return;
+
+        // The nodes written make up the whole map
+        SHAMap destination(SHAMapType::STATE, f2);
+        BEAST_EXPECT(destination.fetchRoot(hash, nullptr));
+
+        std::vector<SHAMapMissingNode> missingNodes;
+        destination.walkMap(missingNodes, 16);
+        BEAST_EXPECT(missingNodes.empty());
+
+        int count = 0;
+        destination.visitLeaves([&count](auto const&) { ++count; });
+        BEAST_EXPECT(count == items);
+
+        // Without the top of the map the root is asked for first
+        {
+            TestNodeFamily empty(journal);
+            SHAMapLeafBuilder builder(rangeDepth, nullptr);
+            std::vector<SHAMapHash> hashes;
+            std::vector<SHAMapNodeID> missing;
+            BEAST_EXPECT(
+                builder.rangeHashes(hash, fetcher(empty), hashes, missing));
+            BEAST_EXPECT(hashes.empty());
+            BEAST_EXPECT(missing.size() == 1 && missing[0].isRoot());
+        }
+
+        // A missing leaf shows in the root
+        auto const first = source.begin()->key();
+        TestNodeFamily f3(journal);
+        BEAST_EXPECT(rebuild(source, rangeDepth, f3, first) != hash);
+    }
+
+    void
+    testVisitLeafNodes()
+    {
+        testcase("visit leaf nodes");
+
+        test::SuiteJournal journal("SHAMapLeafBuilder_test", *this);
+        TestNodeFamily f(journal);
+
+        SHAMap map(SHAMapType::STATE, f);
+        fill(map, 1000);
+        map.setImmutable();
+
+        std::vector<uint256> keys;
+        for (auto const& item : map)
+            keys.push_back(item.key());
+
+        // From after a key in the map, and after one that is not
+        auto notInMap = keys[499];
+        ++notInMap;
+        for (auto const& after : {keys[499], notInMap})
+        {
+            std::vector<uint256> visited;
+            map.visitLeafNodes(after, [&](SHAMapTreeNode const& leaf) {
+                visited.push_back(leaf.peekItem()->key());
+                return visited.size() < 100;
+            });
+            BEAST_EXPECT(visited.size() == 100);
+            BEAST_EXPECT(std::equal(
+                visited.begin(), visited.end(), keys.begin() + 500));
+        }
+
+        std::size_t count = 0;
+        map.visitLeafNodes(keys.back(), [&](SHAMapTreeNode const&) {
+            ++count;
+            return true;
+        });
+        BEAST_EXPECT(count == 0);
+    }
+
+    void
+    run() override
+    {
+        testVisitLeafNodes();
+
+        for (int rangeDepth : {1, 2})
+        {
+            testRebuild(0, rangeDepth);
+            testRebuild(1, rangeDepth);
+            testRebuild(20, rangeDepth);
+            testRebuild(5000, rangeDepth);
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(SHAMapLeafBuilder, shamap, ripple);
+
+}  // namespace tests
+}  // namespace ripple
@@ -85,6 +85,95 @@ public:
         return true;
     }
 
+    // Sync a map from nodes built from their wire form up front, the way
+    // InboundLedger does before it takes the map's lock
+    void
+    testBuiltNodes(beast::Journal journal)
+    {
+        testcase("built nodes");
+
+        TestNodeFamily f(journal), f2(journal);
+        SHAMap source(SHAMapType::FREE, f);
+        SHAMap destination(SHAMapType::FREE, f2);
+
+        for (int i = 0; i < 1000; ++i)
+            source.addItem(std::move(*makeRandomAS()), false, false);
+        source.setImmutable();
+
+        destination.setSynching();
+        {
+            std::vector<SHAMapNodeID> gotNodeIDs;
+            std::vector<Blob> gotNodes;
+            BEAST_EXPECT(source.getNodeFat(
+                SHAMapNodeID(), gotNodeIDs, gotNodes, false, 0));
+            BEAST_EXPECT(destination
+                             .addRootNode(
+                                 source.getHash(),
+                                 makeSlice(gotNodes.front()),
+                                 nullptr)
+                             .isGood());
+        }
+
+        bool checked = false;
+        do
+        {
+            f.clock().advance(std::chrono::seconds(1));
+
+            auto nodesMissing = destination.getMissingNodes(2048, nullptr);
+            if (nodesMissing.empty())
+                break;
+
+            std::vector<SHAMapNodeID> gotNodeIDs;
+            std::vector<Blob> gotNodes;
+            for (auto& it : nodesMissing)
+            {
+                if (!source.getNodeFat(
+                        it.first, gotNodeIDs, gotNodes, false, 0))
+                    fail("", __FILE__, __LINE__);
+            }
+
+            if (!checked)
+            {
+                checked = true;
+
+                // A node that could not be built is rejected
+                BEAST_EXPECT(destination
+                                 .addKnownNode(
+                                     gotNodeIDs.front(), nullptr, nullptr)
+                                 .isInvalid());
+
+                // So is one that does not match the hash its parent has
+                Blob corrupt = gotNodes.front();
+                corrupt.front() ^= 0xff;
+                BEAST_EXPECT(destination
+                                 .addKnownNode(
+                                     gotNodeIDs.front(),
+                                     SHAMapAbstractNode::makeFromWire(
+                                         makeSlice(corrupt)),
+                                     nullptr)
+                                 .isInvalid());
+            }
+
+            for (std::size_t i = 0; i < gotNodeIDs.size(); ++i)
+            {
+                // Not BEAST_EXPECT, the number of rounds is not deterministic
+                if (!destination
+                         .addKnownNode(
+                             gotNodeIDs[i],
+                             SHAMapAbstractNode::makeFromWire(
+                                 makeSlice(gotNodes[i])),
+                             nullptr)
+                         .isUseful())
+                    fail("", __FILE__, __LINE__);
+            }
+        } while (true);
+
+        destination.clearSynching();
+
+        BEAST_EXPECT(checked);
+        BEAST_EXPECT(source.deepCompare(destination));
+    }
+
     void
     run() override
     {
@@ -198,6 +287,8 @@ public:
 
         log << "Checking destination invariants..." << std::endl;
         destination.invariants();
+
+        testBuiltNodes(journal);
     }
 };
 